@@ -0,0 +1,201 @@
+/*
+***************************************************************************
+*
+* Author: Teunis van Beelen
+*
+* Copyright (C) 2015 - 2024 Teunis van Beelen
+*
+* Email: teuniz@protonmail.com
+*
+***************************************************************************
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+***************************************************************************
+*/
+
+
+
+
+
+#include "instr_poll.h"
+
+
+
+// sends the queries to one device, stops at the first one that fails
+static void ipoll_device(struct instr_poll_dev *pdev)
+{
+  int i;
+
+  for(i=0; i<pdev->qry_cnt; i++)
+  {
+    pdev->resp[i][0] = 0;
+  }
+
+  pdev->err = 0;
+
+  for(i=0; i<pdev->qry_cnt; i++)
+  {
+    if(tmc_write(pdev->device, pdev->qry[i]) != (int)strlen(pdev->qry[i]))
+    {
+      pdev->err = i + 1;
+
+      return;
+    }
+
+    if(tmc_read(pdev->device) < 0)
+    {
+      pdev->err = i + 1;
+
+      return;
+    }
+
+    strlcpy(pdev->resp[i], pdev->device->buf, IPOLL_RESP_LEN);
+  }
+}
+
+
+// takes devices until all of them are polled
+static void ipoll_run_items(void *data)
+{
+  int k;
+
+  struct instr_poll_job *job = (struct instr_poll_job *)data;
+
+  while((k = job->item_next.fetchAndAddOrdered(1)) < job->cnt)
+  {
+    ipoll_device(job->dev[k]);
+  }
+}
+
+
+instr_poll::instr_poll()
+{
+  int i;
+
+  for(i=0; i<IPOLL_MAX_DEVS; i++)
+  {
+    job.dev[i] = &devs[i];
+  }
+
+  memset(devs, 0, sizeof(devs));
+  job.cnt = 0;
+}
+
+
+int instr_poll::add_device(struct tmcdev *dev)
+{
+  if((dev == NULL) || (job.cnt >= IPOLL_MAX_DEVS))
+  {
+    return -1;
+  }
+
+  memset(&devs[job.cnt], 0, sizeof(struct instr_poll_dev));
+
+  devs[job.cnt].device = dev;
+
+  return job.cnt++;
+}
+
+
+void instr_poll::clear()
+{
+  job.cnt = 0;
+}
+
+
+int instr_poll::get_device_cnt()
+{
+  return job.cnt;
+}
+
+
+int instr_poll::set_queries(int idx, const char * const *qry, int cnt)
+{
+  int i, j;
+
+  if((idx < -1) || (idx >= job.cnt) || (cnt < 0) || (cnt > IPOLL_MAX_QRYS))
+  {
+    return -1;
+  }
+
+  for(i=0; i<job.cnt; i++)
+  {
+    if((idx >= 0) && (i != idx))
+    {
+      continue;
+    }
+
+    for(j=0; j<cnt; j++)
+    {
+      devs[i].qry[j] = qry[j];
+    }
+
+    devs[i].qry_cnt = cnt;
+  }
+
+  return 0;
+}
+
+
+int instr_poll::poll(int thread_cnt)
+{
+  int i, err_cnt=0;
+
+  job.item_next.storeRelease(0);
+
+  if((thread_cnt < 1) || (thread_cnt > job.cnt))
+  {
+    thread_cnt = job.cnt;
+  }
+
+  pool.run(ipoll_run_items, &job, thread_cnt);
+
+  for(i=0; i<job.cnt; i++)
+  {
+    if(devs[i].err)
+    {
+      err_cnt++;
+    }
+  }
+
+  return err_cnt;
+}
+
+
+const char * instr_poll::get_response(int idx, int qry)
+{
+  if((idx < 0) || (idx >= job.cnt) || (qry < 0) || (qry >= devs[idx].qry_cnt))
+  {
+    return NULL;
+  }
+
+  if(devs[idx].err && (qry >= (devs[idx].err - 1)))
+  {
+    return NULL;
+  }
+
+  return devs[idx].resp[qry];
+}
+
+
+int instr_poll::get_error(int idx)
+{
+  if((idx < 0) || (idx >= job.cnt))
+  {
+    return -1;
+  }
+
+  return devs[idx].err;
+}
@@ -0,0 +1,129 @@
+/*
+***************************************************************************
+*
+* Author: Teunis van Beelen
+*
+* Copyright (C) 2015 - 2024 Teunis van Beelen
+*
+* Email: teuniz@protonmail.com
+*
+***************************************************************************
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+***************************************************************************
+*/
+
+
+
+#ifndef DEF_INSTR_POLL_H
+#define DEF_INSTR_POLL_H
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <QAtomicInt>
+
+#include "../global.h"
+#include "../connection.h"
+#include "../work_pool.h"
+
+
+#define IPOLL_MAX_DEVS     (64)
+#define IPOLL_MAX_QRYS     (8)
+#define IPOLL_RESP_LEN     (128)
+
+
+struct instr_poll_dev
+{
+  struct tmcdev *device;
+  const char *qry[IPOLL_MAX_QRYS];            /* queries of this device, not copied */
+  int qry_cnt;
+  char resp[IPOLL_MAX_QRYS][IPOLL_RESP_LEN];  /* responses of the last poll, empty when they failed */
+  int err;                                    /* 0, or the number of the first query that failed plus one */
+};
+
+
+struct instr_poll_job
+{
+  struct instr_poll_dev *dev[IPOLL_MAX_DEVS];
+  int cnt;
+  QAtomicInt item_next;
+};
+
+
+/*
+ * Polls a rack of instruments concurrently, used by poll_bench. Every device
+ * has its own list of queries, the workers take the next device that is not
+ * polled yet, so a device is only used by one worker at a time and a slow
+ * device doesn't hold up the others. The exchanges are I/O bound, that's why
+ * there is one worker per device by default instead of one per core.
+ * The workers are kept between the polls. The devices must not be used by
+ * another thread during a poll(), in DSRemote a scope belongs to its screen thread.
+ */
+class instr_poll
+{
+public:
+
+  instr_poll();
+
+  /* returns the index of the device or -1 when the rack is full */
+  int add_device(struct tmcdev *);
+  void clear();
+  int get_device_cnt();
+
+  /* sets the queries of device idx, or of all devices that were added if idx is -1, */
+  /* the queries are not copied, returns 0 on success */
+  int set_queries(int, const char * const *, int);
+
+  /* polls every device once with at most thread_cnt workers, the calling thread is one of them, */
+  /* thread_cnt < 1 is one worker per device, returns the number of devices that failed */
+  int poll(int thread_cnt=0);
+
+  /* response of query qry of device idx, NULL when there is none */
+  const char * get_response(int, int);
+
+  int get_error(int);
+
+private:
+
+  work_pool pool;
+
+  struct instr_poll_dev devs[IPOLL_MAX_DEVS];
+
+  struct instr_poll_job job;
+};
+
+
+#endif
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
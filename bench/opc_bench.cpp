@@ -0,0 +1,229 @@
+/*
+***************************************************************************
+*
+* Author: Teunis van Beelen
+*
+* Copyright (C) 2015 - 2024 Teunis van Beelen
+*
+* Email: teuniz@protonmail.com
+*
+***************************************************************************
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+***************************************************************************
+*/
+
+
+
+/*
+ * Measures the setter throughput of a LAN connection with the old write
+ * path (every setter followed by up to 20 times usleep(25000) plus *OPC?),
+ * with one *OPC? per command (tmc_write()) and with one *OPC? per batch
+ * (tmc_write_batch()).
+ * Meant to be run against the emulator, e.g. "dsr_emulator -l 500",
+ * the latency option simulates the round trip time of a real instrument.
+ * Pacing is switched off so that only the protocol is measured.
+ * The shadow cache is cleared before every exchange, otherwise
+ * it would skip the repeated :WAV setters.
+ *
+ * usage: opc_bench [address] [commands per batch] [commands]
+ */
+
+
+#include "../connection.h"
+
+
+#define BENCH_DEF_ADDRESS  "127.0.0.1"
+#define BENCH_DEF_BATCH    (8)
+#define BENCH_DEF_CMDS     (512)
+
+
+static const char *bench_cmds[4]={":WAV:SOUR CHAN1", ":WAV:MODE NORM", ":WAV:FORM BYTE", ":WAV:SOUR CHAN2"};
+
+
+static double bench_time(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+
+  return ts.tv_sec + (ts.tv_nsec / 1e9);
+}
+
+
+/* the write path before the *OPC? polling was reworked, returns the number of *OPC? sent or -1 */
+static int bench_write_old(struct tmcdev *dev, const char *cmd)
+{
+  int i, n;
+
+  char buf[256];
+
+  snprintf(buf, 256, "%s\n", cmd);
+
+  if(tmclan_send(dev, buf) != (int)strlen(buf))
+  {
+    return -1;
+  }
+
+  for(i=0; i<20; i++)
+  {
+    usleep(25000);
+
+    if(tmclan_send(dev, "*OPC?\n") != 6)
+    {
+      return -1;
+    }
+
+    n = tmclan_recv(dev, buf, 128);
+
+    if(n < 0)
+    {
+      return -1;
+    }
+
+    if(n == 2)
+    {
+      if(buf[0] == '1')
+      {
+        break;
+      }
+    }
+  }
+
+  return (i < 20) ? (i + 1) : 20;
+}
+
+
+static void bench_print(const char *name, int cmds, int opcs, double t)
+{
+  printf("%-10s %6i cmds %6i *OPC?  %9.2f ms  %8.1f cmds/s  %7.3f ms/cmd\n",
+         name, cmds, opcs, t * 1e3, cmds / t, (t * 1e3) / cmds);
+}
+
+
+int main(int argc, char **argv)
+{
+  int i, j, n,
+      opc_old=0,
+      batch=BENCH_DEF_BATCH,
+      cmds=BENCH_DEF_CMDS;
+
+  const char *address=BENCH_DEF_ADDRESS,
+             *list[TMC_CMD_BATCH_SZ];
+
+  double t_old, t_single, t_batch;
+
+  struct tmcdev *dev;
+
+  if(argc > 1)  address = argv[1];
+
+  if(argc > 2)  batch = atoi(argv[2]);
+
+  if(argc > 3)  cmds = atoi(argv[3]);
+
+  if((batch < 1) || (batch > TMC_CMD_BATCH_SZ) || (cmds < batch))
+  {
+    fprintf(stderr, "usage: opc_bench [address] [commands per batch, 1 - %i] [commands]\n", TMC_CMD_BATCH_SZ);
+
+    return EXIT_FAILURE;
+  }
+
+  cmds -= cmds % batch;
+
+  dev = tmc_open_lan(address);
+  if(dev == NULL)
+  {
+    fprintf(stderr, "can not connect to %s\n", address);
+
+    return EXIT_FAILURE;
+  }
+
+  /* tmc_pace_set() doesn't go below the minimum gap */
+  dev->pace_usec = 0;
+
+  t_old = bench_time();
+
+  for(i=0; i<cmds; i++)
+  {
+    n = bench_write_old(dev, bench_cmds[i % 4]);
+    if(n < 0)
+    {
+      fprintf(stderr, "write error\n");
+
+      goto OUT_ERROR;
+    }
+
+    opc_old += n;
+  }
+
+  t_old = bench_time() - t_old;
+
+  t_single = bench_time();
+
+  for(i=0; i<cmds; i++)
+  {
+    tmc_shadow_clear(dev);
+
+    if(tmc_write(dev, bench_cmds[i % 4]) < 0)
+    {
+      fprintf(stderr, "write error\n");
+
+      goto OUT_ERROR;
+    }
+  }
+
+  t_single = bench_time() - t_single;
+
+  t_batch = bench_time();
+
+  for(i=0; i<cmds; i+=batch)
+  {
+    for(j=0; j<batch; j++)
+    {
+      list[j] = bench_cmds[(i + j) % 4];
+    }
+
+    tmc_shadow_clear(dev);
+
+    if(tmc_write_batch(dev, list, batch, TMC_OPC_WAIT) != batch)
+    {
+      fprintf(stderr, "batch write error\n");
+
+      goto OUT_ERROR;
+    }
+  }
+
+  t_batch = bench_time() - t_batch;
+
+  printf("%s, %i commands per batch\n\n", address, batch);
+
+  bench_print("before", cmds, opc_old, t_old);
+
+  bench_print("unbatched", cmds, cmds, t_single);
+
+  bench_print("batched", cmds, cmds / batch, t_batch);
+
+  printf("\nspeedup unbatched x%.2f, batched x%.2f\n", t_old / t_single, t_old / t_batch);
+
+  tmc_close(dev);
+
+  return EXIT_SUCCESS;
+
+OUT_ERROR:
+
+  tmc_close(dev);
+
+  return EXIT_FAILURE;
+}
@@ -0,0 +1,27 @@
+
+TEMPLATE = app
+TARGET = opc_bench
+
+CONFIG -= qt
+CONFIG -= app_bundle
+CONFIG += console
+CONFIG += warn_on
+CONFIG += release
+
+OBJECTS_DIR = ./objects
+
+HEADERS += ../connection.h
+HEADERS += ../tmc_dev.h
+HEADERS += ../tmc_lan.h
+HEADERS += ../utils.h
+
+SOURCES += opc_bench.cpp
+SOURCES += ../connection.cpp
+SOURCES += ../tmc_dev.c
+SOURCES += ../tmc_lan.c
+SOURCES += ../utils.c
+
+LIBS += -lm -lpthread
+
+QMAKE_CFLAGS += -Wall -Wextra -Wshadow -Wformat-nonliteral -Wformat-security -Wtype-limits -Wfatal-errors
+QMAKE_CXXFLAGS += -Wall -Wextra -Wshadow -Wformat-nonliteral -Wformat-security -Wtype-limits -Wfatal-errors
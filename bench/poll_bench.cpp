@@ -0,0 +1,176 @@
+/*
+***************************************************************************
+*
+* Author: Teunis van Beelen
+*
+* Copyright (C) 2015 - 2024 Teunis van Beelen
+*
+* Email: teuniz@protonmail.com
+*
+***************************************************************************
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+***************************************************************************
+*/
+
+
+
+
+/*
+ * Polls a rack of instruments with instr_poll, first with one worker,
+ * then with one worker per instrument, and reports the poll cycles per second.
+ * Meant to be run against several emulators, e.g. 16 of them on
+ * 127.0.0.1 ... 127.0.0.16: "dsr_emulator -a 127.0.0.N -l 2000".
+ *
+ * usage: poll_bench [-c cycles] address ...
+ */
+
+
+#include "instr_poll.h"
+
+
+#define BENCH_DEF_CYCLES  (20)
+
+
+static const char *bench_qry[3]={":TRIG:STAT?", ":ACQ:SRAT?", ":ACQ:MDEP?"};
+
+
+static double bench_time(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+
+  return ts.tv_sec + (ts.tv_nsec / 1e9);
+}
+
+
+/* returns the time in seconds or -1 in case of an error */
+static double bench_run(instr_poll *rack, int thread_cnt, int cycles)
+{
+  int i, err;
+
+  double t;
+
+  t = bench_time();
+
+  for(i=0; i<cycles; i++)
+  {
+    err = rack->poll(thread_cnt);
+    if(err)
+    {
+      fprintf(stderr, "%i devices failed\n", err);
+
+      return -1;
+    }
+  }
+
+  return bench_time() - t;
+}
+
+
+int main(int argc, char **argv)
+{
+  int i, cnt=0,
+      cycles=BENCH_DEF_CYCLES,
+      err=EXIT_FAILURE;
+
+  double t_single, t_pool;
+
+  struct tmcdev *dev[IPOLL_MAX_DEVS];
+
+  instr_poll rack;
+
+  for(i=1; i<argc; i++)
+  {
+    if((!strcmp(argv[i], "-c")) && (i < (argc - 1)))
+    {
+      cycles = atoi(argv[++i]);
+
+      continue;
+    }
+
+    if(cnt == IPOLL_MAX_DEVS)
+    {
+      fprintf(stderr, "more than %i devices\n", IPOLL_MAX_DEVS);
+
+      goto OUT_ERROR;
+    }
+
+    dev[cnt] = tmc_open_lan(argv[i]);
+    if(dev[cnt] == NULL)
+    {
+      fprintf(stderr, "can not connect to %s\n", argv[i]);
+
+      goto OUT_ERROR;
+    }
+
+    /* pacing would hide the concurrency */
+    dev[cnt]->pace_usec = 0;
+
+    rack.add_device(dev[cnt++]);
+  }
+
+  if((!cnt) || (cycles < 1))
+  {
+    fprintf(stderr, "usage: poll_bench [-c cycles] address ...\n");
+
+    goto OUT_ERROR;
+  }
+
+  rack.set_queries(-1, bench_qry, 3);
+
+  t_single = bench_run(&rack, 1, cycles);
+  if(t_single < 0)
+  {
+    goto OUT_ERROR;
+  }
+
+  t_pool = bench_run(&rack, 0, cycles);
+  if(t_pool < 0)
+  {
+    goto OUT_ERROR;
+  }
+
+  for(i=0; i<cnt; i++)
+  {
+    if(strcmp(rack.get_response(i, 2), "12000"))
+    {
+      fprintf(stderr, "unexpected response of device %i: %s\n", i + 1, rack.get_response(i, 2));
+
+      goto OUT_ERROR;
+    }
+  }
+
+  printf("%i devices, %i queries per device, %i cycles\n\n", cnt, 3, cycles);
+
+  printf("1 worker    %8.2f ms/cycle  %7.1f cycles/s\n", (t_single * 1e3) / cycles, cycles / t_single);
+
+  printf("%2i workers  %8.2f ms/cycle  %7.1f cycles/s\n", (cnt < WPOOL_MAX_THREADS) ? cnt : WPOOL_MAX_THREADS,
+         (t_pool * 1e3) / cycles, cycles / t_pool);
+
+  printf("\nspeedup x%.2f\n", t_single / t_pool);
+
+  err = EXIT_SUCCESS;
+
+OUT_ERROR:
+
+  for(i=0; i<cnt; i++)
+  {
+    tmc_close(dev[i]);
+  }
+
+  return err;
+}
@@ -0,0 +1,32 @@
+
+TEMPLATE = app
+TARGET = poll_bench
+
+QT += core
+QT -= gui
+CONFIG -= app_bundle
+CONFIG += console
+CONFIG += warn_on
+CONFIG += release
+
+OBJECTS_DIR = ./objects
+
+HEADERS += ../connection.h
+HEADERS += instr_poll.h
+HEADERS += ../tmc_dev.h
+HEADERS += ../tmc_lan.h
+HEADERS += ../utils.h
+HEADERS += ../work_pool.h
+
+SOURCES += poll_bench.cpp
+SOURCES += instr_poll.cpp
+SOURCES += ../connection.cpp
+SOURCES += ../tmc_dev.c
+SOURCES += ../tmc_lan.c
+SOURCES += ../utils.c
+SOURCES += ../work_pool.cpp
+
+LIBS += -lm -lpthread
+
+QMAKE_CFLAGS += -Wall -Wextra -Wshadow -Wformat-nonliteral -Wformat-security -Wtype-limits -Wfatal-errors
+QMAKE_CXXFLAGS += -Wall -Wextra -Wshadow -Wformat-nonliteral -Wformat-security -Wtype-limits -Wfatal-errors
@@ -0,0 +1,262 @@
+/*
+***************************************************************************
+*
+* Author: Teunis van Beelen
+*
+* Copyright (C) 2015 - 2024 Teunis van Beelen
+*
+* Email: teuniz@protonmail.com
+*
+***************************************************************************
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+***************************************************************************
+*/
+
+
+
+/*
+ * Micro benchmark of the sample conversion kernels (sample_conv.c).
+ * Every kernel is timed at every level the CPU supports and the
+ * results are compared with the plain C version. The pixel kernels
+ * run on the same number of pixels, see bench_layer() for the layers.
+ *
+ * usage: sconv_bench [samples] [runs]
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../sample_conv.h"
+
+
+#define BENCH_DEF_SAMPLES  (24000000)
+#define BENCH_DEF_RUNS     (5)
+
+
+static const char *level_name[3]={"scalar", "SSE2", "AVX2"};
+
+
+static double bench_time(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+
+  return ts.tv_sec + (ts.tv_nsec / 1e9);
+}
+
+
+/* a trace layer: mostly transparent, an opaque trace and anti-aliased edges */
+static void bench_layer(unsigned int *px, int n)
+{
+  int i, r;
+
+  for(i=0; i<n; i++)
+  {
+    r = rand() % 100;
+
+    if(r < 80)
+    {
+      px[i] = 0;
+    }
+    else if(r < 90)
+      {
+        px[i] = 0xff00c0ff;
+      }
+      else
+      {
+        r = rand() & 0xff;
+
+        px[i] = ((unsigned int)r << 24) | (((0xc0 * r) / 255) << 8) | ((0xff * r) / 255);
+      }
+  }
+}
+
+
+static void bench_report(const char *kernel, int level, double t_best, int n, double t_ref, int ok)
+{
+  printf("%-16s %-7s %8.2f ms  %7.0f Msamples/s  x%5.2f  %s\n",
+         kernel, level_name[level], t_best * 1e3, (n / t_best) / 1e6, t_ref / t_best, ok ? "ok" : "MISMATCH");
+}
+
+
+int main(int argc, char **argv)
+{
+  int i, r, n, runs, level, max_level, ok;
+
+  unsigned char *src;
+
+  short *s16, *s16_ref, s_min, s_max, s_min_ref=0, s_max_ref=0;
+
+  unsigned int *px_src, *px, *px_ref;
+
+  double *dbl, *dbl_ref, t, t_best, t_ref[5]={0, 0, 0, 0, 0};
+
+  long long s_sum, s_sum_ref=0;
+
+  n = BENCH_DEF_SAMPLES;
+
+  runs = BENCH_DEF_RUNS;
+
+  if(argc > 1)  n = atoi(argv[1]);
+
+  if(argc > 2)  runs = atoi(argv[2]);
+
+  if((n < 1) || (runs < 1))
+  {
+    fprintf(stderr, "usage: sconv_bench [samples] [runs]\n");
+    return EXIT_FAILURE;
+  }
+
+  src = (unsigned char *)malloc(n);
+  s16 = (short *)malloc(n * sizeof(short));
+  s16_ref = (short *)malloc(n * sizeof(short));
+  dbl = (double *)malloc(n * sizeof(double));
+  dbl_ref = (double *)malloc(n * sizeof(double));
+  px_src = (unsigned int *)malloc(n * sizeof(unsigned int));
+  px = (unsigned int *)malloc(n * sizeof(unsigned int));
+  px_ref = (unsigned int *)malloc(n * sizeof(unsigned int));
+  if((src == NULL) || (s16 == NULL) || (s16_ref == NULL) || (dbl == NULL) || (dbl_ref == NULL) ||
+     (px_src == NULL) || (px == NULL) || (px_ref == NULL))
+  {
+    fprintf(stderr, "malloc error\n");
+    return EXIT_FAILURE;
+  }
+
+  srand(1);
+
+  for(i=0; i<n; i++)
+  {
+    src[i] = rand();
+  }
+
+  bench_layer(px_src, n);
+
+  max_level = sconv_set_level(SCONV_LEVEL_AVX2);
+
+  printf("%i samples, best of %i runs, highest level: %s\n\n", n, runs, level_name[max_level]);
+
+  for(level=SCONV_LEVEL_SCALAR; level<=max_level; level++)
+  {
+    sconv_set_level(level);
+
+    /* u8 -> s16, the conversion of the deep memory download */
+    for(r=0, t_best=1e9; r<runs; r++)
+    {
+      t = bench_time();
+      sconv_u8_to_s16((level == SCONV_LEVEL_SCALAR) ? s16_ref : s16, src, n, 127 + 3, 5);
+      t = bench_time() - t;
+      if(t < t_best)  t_best = t;
+    }
+
+    if(level == SCONV_LEVEL_SCALAR)  t_ref[0] = t_best;
+
+    ok = (level == SCONV_LEVEL_SCALAR) || (!memcmp(s16, s16_ref, n * sizeof(short)));
+
+    bench_report("u8_to_s16", level, t_best, n, t_ref[0], ok);
+
+    /* u8 -> double, the input of the FFT */
+    for(r=0, t_best=1e9; r<runs; r++)
+    {
+      t = bench_time();
+      sconv_u8_to_double((level == SCONV_LEVEL_SCALAR) ? dbl_ref : dbl, src, n, 127, 0.04);
+      t = bench_time() - t;
+      if(t < t_best)  t_best = t;
+    }
+
+    if(level == SCONV_LEVEL_SCALAR)  t_ref[1] = t_best;
+
+    ok = (level == SCONV_LEVEL_SCALAR) || (!memcmp(dbl, dbl_ref, n * sizeof(double)));
+
+    bench_report("u8_to_double", level, t_best, n, t_ref[1], ok);
+
+    /* min, max and sum */
+    for(r=0, t_best=1e9; r<runs; r++)
+    {
+      t = bench_time();
+      sconv_s16_minmax_sum(s16_ref, n, &s_min, &s_max, &s_sum);
+      t = bench_time() - t;
+      if(t < t_best)  t_best = t;
+    }
+
+    if(level == SCONV_LEVEL_SCALAR)
+    {
+      t_ref[2] = t_best;
+
+      s_min_ref = s_min;
+      s_max_ref = s_max;
+      s_sum_ref = s_sum;
+    }
+
+    ok = (s_min == s_min_ref) && (s_max == s_max_ref) && (s_sum == s_sum_ref);
+
+    bench_report("s16_minmax_sum", level, t_best, n, t_ref[2], ok);
+
+    /* the spans of the trace rasterizer */
+    for(r=0, t_best=1e9; r<runs; r++)
+    {
+      t = bench_time();
+      sconv_fill_u32((level == SCONV_LEVEL_SCALAR) ? px_ref : px, n, 0xff00c0ff);
+      t = bench_time() - t;
+      if(t < t_best)  t_best = t;
+    }
+
+    if(level == SCONV_LEVEL_SCALAR)  t_ref[3] = t_best;
+
+    /* px_ref is overwritten by the composite below, the fill is checked against the value */
+    for(i=0, ok=1; i<n; i++)
+    {
+      if(((level == SCONV_LEVEL_SCALAR) ? px_ref[i] : px[i]) != 0xff00c0ff)  ok = 0;
+    }
+
+    bench_report("fill_u32", level, t_best, n, t_ref[3], ok);
+
+    /* a trace layer composited over an opaque one, the destination is reset before every run */
+    for(r=0, t_best=1e9; r<runs; r++)
+    {
+      sconv_fill_u32((level == SCONV_LEVEL_SCALAR) ? px_ref : px, n, 0xff404040);
+
+      t = bench_time();
+      sconv_argb_over((level == SCONV_LEVEL_SCALAR) ? px_ref : px, px_src, n);
+      t = bench_time() - t;
+      if(t < t_best)  t_best = t;
+    }
+
+    if(level == SCONV_LEVEL_SCALAR)  t_ref[4] = t_best;
+
+    ok = (level == SCONV_LEVEL_SCALAR) || (!memcmp(px, px_ref, n * sizeof(unsigned int)));
+
+    bench_report("argb_over", level, t_best, n, t_ref[4], ok);
+
+    printf("\n");
+  }
+
+  free(src);
+  free(s16);
+  free(s16_ref);
+  free(dbl);
+  free(dbl_ref);
+  free(px_src);
+  free(px);
+  free(px_ref);
+
+  return EXIT_SUCCESS;
+}
+
+
@@ -0,0 +1,17 @@
+
+TEMPLATE = app
+TARGET = sconv_bench
+
+CONFIG -= qt
+CONFIG -= app_bundle
+CONFIG += console
+CONFIG += warn_on
+CONFIG += release
+
+OBJECTS_DIR = ./objects
+
+SOURCES += sconv_bench.c
+SOURCES += ../sample_conv.c
+
+QMAKE_CFLAGS += -Wall -Wextra -Wshadow -Wformat-nonliteral -Wformat-security -Wtype-limits -Wfatal-errors
+
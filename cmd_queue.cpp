@@ -0,0 +1,348 @@
+/*
+***************************************************************************
+*
+* Author: Teunis van Beelen
+*
+* Copyright (C) 2015 - 2024 Teunis van Beelen
+*
+* Email: teuniz@protonmail.com
+*
+***************************************************************************
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+***************************************************************************
+*/
+
+
+
+
+#include "cmd_queue.h"
+
+
+#define TMC_CMD_CUE_MASK  (TMC_CMD_CUE_SZ - 1)
+
+#if (TMC_CMD_CUE_SZ & TMC_CMD_CUE_MASK)
+#error "TMC_CMD_CUE_SZ must be a power of two"
+#endif
+
+
+/* indexed by opcode */
+const struct tmc_cmd_op tmc_cmd_ops[TMC_OP_CNT]=
+{
+  {NULL,                     0,                                        TMC_THRD_JOB_NONE},         /* TMC_OP_RAW */
+  {NULL,                     TMC_OPF_SYNC,                             TMC_THRD_JOB_NONE},         /* TMC_OP_RAW_SYNC */
+  {":CHAN%i:SCAL %e",        TMC_OPF_CHN | TMC_OPF_VAL | TMC_OPF_LAST, TMC_THRD_JOB_TRIGEDGELEV},  /* TMC_OP_CHAN_SCAL */
+  {":CHAN%i:OFFS %e",        TMC_OPF_CHN | TMC_OPF_VAL | TMC_OPF_LAST, TMC_THRD_JOB_NONE},         /* TMC_OP_CHAN_OFFS */
+  {":TIM:SCAL %e",           TMC_OPF_VAL | TMC_OPF_LAST,               TMC_THRD_JOB_FFTHZDIV},     /* TMC_OP_TIM_SCAL */
+  {":TIM:OFFS %e",           TMC_OPF_VAL | TMC_OPF_LAST,               TMC_THRD_JOB_NONE},         /* TMC_OP_TIM_OFFS */
+  {":TIM:DEL:SCAL %e",       TMC_OPF_VAL | TMC_OPF_LAST,               TMC_THRD_JOB_NONE},         /* TMC_OP_TIM_DEL_SCAL */
+  {":TIM:DEL:OFFS %e",       TMC_OPF_VAL | TMC_OPF_LAST,               TMC_THRD_JOB_NONE},         /* TMC_OP_TIM_DEL_OFFS */
+  {":TIM:DEL:ENAB 1",        0,                                        TMC_THRD_JOB_TIMDELAY},     /* TMC_OP_TIM_DEL_ON */
+  {":TRIGger:EDGE:LEVel %e", TMC_OPF_VAL | TMC_OPF_LAST,               TMC_THRD_JOB_NONE},         /* TMC_OP_TRIG_EDGE_LEV */
+  {":TLHA",                  0,                                        TMC_THRD_JOB_TRIGEDGELEV},  /* TMC_OP_TLHA */
+  {NULL,                     0,                                        TMC_THRD_JOB_FFTHZDIV}      /* TMC_OP_FFT_ON */
+};
+
+
+/* commands queued as text that still need a follow-up query or must not be batched */
+static const struct
+{
+  const char *prefix;
+  int op;
+} tmc_cmd_text_ops[]=
+{
+  {"*RST",            TMC_OP_RAW_SYNC},
+  {":AUT",            TMC_OP_RAW_SYNC},
+  {":TLHA",           TMC_OP_TLHA},
+  {":TIM:DEL:ENAB 1", TMC_OP_TIM_DEL_ON},
+  {":MATH:OPER FFT",  TMC_OP_FFT_ON},
+  {":MATH1:OPER FFT", TMC_OP_FFT_ON},
+  {":CALC:MODE FFT",  TMC_OP_FFT_ON},
+  {NULL,              TMC_OP_RAW}
+};
+
+
+int tmc_cmd_format(const struct tmc_cmd *cmd, char *dest, int sz)
+{
+  const struct tmc_cmd_op *op;
+
+  if((cmd->op < 0) || (cmd->op >= TMC_OP_CNT))
+  {
+    dest[0] = 0;
+
+    return 0;
+  }
+
+  op = &tmc_cmd_ops[cmd->op];
+
+  if(op->fmt == NULL)
+  {
+    return strlcpy(dest, cmd->str, sz);
+  }
+
+  if(op->flags & TMC_OPF_CHN)
+  {
+    return snprintf(dest, sz, op->fmt, cmd->chn + 1, cmd->value);
+  }
+
+  if(op->flags & TMC_OPF_VAL)
+  {
+    return snprintf(dest, sz, op->fmt, cmd->value);
+  }
+
+  return strlcpy(dest, op->fmt, sz);
+}
+
+
+cmd_queue::cmd_queue()
+{
+  reset();
+}
+
+
+void cmd_queue::reset(void)
+{
+  int i;
+
+  for(i=0; i<TMC_CMD_CUE_SZ; i++)
+  {
+    cells[i].seq.storeRelease(i);
+  }
+
+  enq_pos.storeRelease(0);
+
+  deq_pos = 0;
+
+  scan_pos = 0;
+
+  scan_seg = 0;
+
+  for(i=0; i<(TMC_OP_CNT * TMC_CMD_KEY_CHNS); i++)
+  {
+    last_pos[i] = 0;
+
+    last_seg[i] = ~0U;
+  }
+}
+
+
+/* reserves a free cell, *pos receives its position */
+struct cmd_queue::cell * cmd_queue::claim(unsigned int *pos)
+{
+  int dif;
+
+  unsigned int p;
+
+  struct cell *c;
+
+  p = enq_pos.loadAcquire();
+
+  while(1)
+  {
+    c = &cells[p & TMC_CMD_CUE_MASK];
+
+    dif = (int)((unsigned int)c->seq.loadAcquire() - p);
+
+    if(dif == 0)
+    {
+      if(enq_pos.testAndSetOrdered(p, p + 1))
+      {
+        break;
+      }
+    }
+    else if(dif < 0)
+      {
+        return NULL;  /* full */
+      }
+
+    p = enq_pos.loadAcquire();
+  }
+
+  *pos = p;
+
+  return c;
+}
+
+
+int cmd_queue::push(int op, int chn, double value, char *resp)
+{
+  unsigned int pos;
+
+  struct cell *c;
+
+  c = claim(&pos);
+  if(c == NULL)
+  {
+    return -1;
+  }
+
+  c->cmd.op = op;
+  c->cmd.chn = chn;
+  c->cmd.value = value;
+  c->cmd.resp = resp;
+  c->cmd.str[0] = 0;
+
+  c->seq.storeRelease(pos + 1);
+
+  return 0;
+}
+
+
+int cmd_queue::push(const char *str, char *resp)
+{
+  int i;
+
+  unsigned int pos;
+
+  struct cell *c;
+
+  c = claim(&pos);
+  if(c == NULL)
+  {
+    return -1;
+  }
+
+  c->cmd.op = TMC_OP_RAW;
+
+  for(i=0; tmc_cmd_text_ops[i].prefix!=NULL; i++)
+  {
+    if(!strncmp(str, tmc_cmd_text_ops[i].prefix, strlen(tmc_cmd_text_ops[i].prefix)))
+    {
+      c->cmd.op = tmc_cmd_text_ops[i].op;
+
+      break;
+    }
+  }
+
+  c->cmd.chn = 0;
+  c->cmd.value = 0;
+  c->cmd.resp = resp;
+  strlcpy(c->cmd.str, str, TMC_CMD_STR_LEN);
+
+  c->seq.storeRelease(pos + 1);
+
+  return 0;
+}
+
+
+struct tmc_cmd * cmd_queue::peek(int idx)
+{
+  unsigned int p;
+
+  struct cell *c;
+
+  if((idx < 0) || (idx >= TMC_CMD_CUE_SZ))
+  {
+    return NULL;
+  }
+
+  p = deq_pos + idx;
+
+  c = &cells[p & TMC_CMD_CUE_MASK];
+
+  if((unsigned int)c->seq.loadAcquire() != (p + 1))
+  {
+    return NULL;
+  }
+
+  return &c->cmd;
+}
+
+
+void cmd_queue::pop(void)
+{
+  struct cell *c;
+
+  c = &cells[deq_pos & TMC_CMD_CUE_MASK];
+
+  c->seq.storeRelease(deq_pos + TMC_CMD_CUE_SZ);
+
+  deq_pos++;
+}
+
+
+/*
+ * Indexes the entries that became available since the last call, every
+ * entry is visited once. A setter marks the previous setter of the same
+ * setting as superseded when only setters lie in between. Anything else
+ * (text commands, queries, *RST, :TLHA, ...) starts a new segment,
+ * commands are never moved across it.
+ */
+void cmd_queue::scan(void)
+{
+  int key;
+
+  unsigned int prev;
+
+  struct cell *c;
+
+  if((int)(scan_pos - deq_pos) < 0)
+  {
+    scan_pos = deq_pos;
+  }
+
+  while(1)
+  {
+    c = &cells[scan_pos & TMC_CMD_CUE_MASK];
+
+    if((unsigned int)c->seq.loadAcquire() != (scan_pos + 1))
+    {
+      break;
+    }
+
+    c->sup = 0;
+
+    if((c->cmd.resp != NULL) || (!(tmc_cmd_ops[c->cmd.op].flags & TMC_OPF_LAST)) ||
+       (c->cmd.chn < 0) || (c->cmd.chn >= TMC_CMD_KEY_CHNS))
+    {
+      scan_seg++;
+    }
+    else
+    {
+      key = (c->cmd.op * TMC_CMD_KEY_CHNS) + c->cmd.chn;
+
+      prev = last_pos[key];
+
+      if((last_seg[key] == scan_seg) && ((int)(prev - deq_pos) >= 0))
+      {
+        cells[prev & TMC_CMD_CUE_MASK].sup = 1;
+      }
+
+      last_pos[key] = scan_pos;
+
+      last_seg[key] = scan_seg;
+    }
+
+    scan_pos++;
+  }
+}
+
+
+/* a setter is superseded when the same setting is set again later in the same segment */
+int cmd_queue::superseded(int idx)
+{
+  unsigned int p;
+
+  if(peek(idx) == NULL)
+  {
+    return 0;
+  }
+
+  p = deq_pos + idx;
+
+  scan();
+
+  return cells[p & TMC_CMD_CUE_MASK].sup;
+}
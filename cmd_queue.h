@@ -0,0 +1,145 @@
+/*
+***************************************************************************
+*
+* Author: Teunis van Beelen
+*
+* Copyright (C) 2015 - 2024 Teunis van Beelen
+*
+* Email: teuniz@protonmail.com
+*
+***************************************************************************
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+***************************************************************************
+*/
+
+
+
+#ifndef DEF_CMD_QUEUE_H
+#define DEF_CMD_QUEUE_H
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <QAtomicInt>
+
+#include "global.h"
+#include "utils.h"
+
+
+#define TMC_CMD_STR_LEN  (128)
+
+#define TMC_CMD_KEY_CHNS  (MAX_TRIG_SRCS)  /* channels or trigger sources a setting can be kept apart by */
+
+/* opcodes of the queued commands */
+#define TMC_OP_RAW            (0)   /* the text in str is sent as is */
+#define TMC_OP_RAW_SYNC       (1)   /* text, must not be batched (*RST, :AUT) */
+#define TMC_OP_CHAN_SCAL      (2)
+#define TMC_OP_CHAN_OFFS      (3)
+#define TMC_OP_TIM_SCAL       (4)
+#define TMC_OP_TIM_OFFS       (5)
+#define TMC_OP_TIM_DEL_SCAL   (6)
+#define TMC_OP_TIM_DEL_OFFS   (7)
+#define TMC_OP_TIM_DEL_ON     (8)
+#define TMC_OP_TRIG_EDGE_LEV  (9)
+#define TMC_OP_TLHA           (10)
+#define TMC_OP_FFT_ON         (11)  /* text, switches the FFT on */
+#define TMC_OP_CNT            (12)
+
+#define TMC_OPF_CHN    (1)  /* the format takes the channel number */
+#define TMC_OPF_VAL    (2)  /* the format takes the value */
+#define TMC_OPF_SYNC   (4)  /* never send in a batch */
+#define TMC_OPF_LAST   (8)  /* setter, only the last queued value needs to be sent */
+
+
+struct tmc_cmd
+{
+  int op;
+  int chn;          /* 0 - 3, the trigger source for TMC_OP_TRIG_EDGE_LEV */
+  double value;
+  char *resp;       /* receives the response of a query, or NULL */
+  char str[TMC_CMD_STR_LEN];  /* text of TMC_OP_RAW, TMC_OP_RAW_SYNC and TMC_OP_FFT_ON */
+};
+
+
+struct tmc_cmd_op
+{
+  const char *fmt;  /* NULL if the text in str is used */
+  int flags;
+  int follow_up;    /* TMC_THRD_JOB_xxx, the query to send after the command */
+};
+
+
+extern const struct tmc_cmd_op tmc_cmd_ops[TMC_OP_CNT];
+
+/* formats the command to SCPI, returns the length */
+int tmc_cmd_format(const struct tmc_cmd *, char *, int);
+
+
+/*
+ * Bounded lock-free multiple producer, single consumer queue.
+ * Every cell has a sequence number that tells if it is free for the
+ * producer of that round or filled for the consumer, so producers
+ * only contend on the enqueue position and never on the data.
+ */
+class cmd_queue
+{
+public:
+
+  cmd_queue();
+
+  /* any thread, returns -1 if the queue is full */
+  int push(int, int, double, char *);
+  int push(const char *, char *);
+
+  /* consumer only, peek() returns NULL if the entry is not (yet) available */
+  struct tmc_cmd * peek(int);
+  void pop(void);
+
+  /* consumer only, returns 1 if a later entry overwrites the same setting */
+  int superseded(int);
+
+  /* only when there is no producer or consumer active */
+  void reset(void);
+
+private:
+
+  struct cell
+  {
+    QAtomicInt seq;
+    struct tmc_cmd cmd;
+    int sup;  /* consumer only, a later setter in the queue overwrites this one */
+  } cells[TMC_CMD_CUE_SZ];
+
+  QAtomicInt enq_pos;
+  unsigned int deq_pos;
+
+  /* consumer only, the entries up to scan_pos are indexed, last_pos and last_seg
+     hold the position and barrier segment of the latest setter per setting */
+  unsigned int scan_pos;
+  unsigned int scan_seg;
+  unsigned int last_pos[TMC_OP_CNT * TMC_CMD_KEY_CHNS];
+  unsigned int last_seg[TMC_OP_CNT * TMC_CMD_KEY_CHNS];
+
+  struct cell * claim(unsigned int *);
+  void scan(void);
+};
+
+
+#endif
+
+
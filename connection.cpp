@@ -30,74 +30,1201 @@
 
 
 
-int tmc_connection_type;
+#define TMC_TRACE_MAGIC    "DSRTRC02"  /* the last two digits are the version of the format */
+#define TMC_TRACE_MAGIC_SZ (8)
+#define TMC_TRACE_REC_SZ   (24)  /* size of a record header in the file */
 
-struct tmcdev *tmc_device;
+#define TMC_TRACE_WRITE   ('W')
+#define TMC_TRACE_BATCH   ('B')
+#define TMC_TRACE_READ    ('R')
 
+#define TMC_PACE_MIN_USEC  (500)
+#define TMC_PACE_MAX_USEC  (100000)
+#define TMC_PACE_OK_CNT    (32)   /* error free exchanges before the gap is made smaller */
+
+#define TMC_MAX_CMD_LEN    (255)
+#define TMC_OPC_MAX_USEC   (500000)
+
+
+/*
+ * A trace file starts with TMC_TRACE_MAGIC followed by records.
+ * Every record is this header followed by len bytes of payload:
+ * the command, the commands of a batch separated by newlines,
+ * or the response. The header is serialized field by field, see
+ * tmc_trace_put() for the layout, so the file doesn't depend on the
+ * padding or the byte order of the compiler.
+ */
+struct tmc_trace_rec
+{
+  char type;
+  char opc;             /* batch: TMC_OPC_WAIT or TMC_OPC_NONE */
+  char reserved[2];
+  int result;           /* return value of the call */
+  long long usec;       /* monotonic time since the start of the recording */
+  int duration;         /* microseconds the call took */
+  int len;              /* payload length */
+};
+
+
+static long long tmc_get_usec(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+
+  return (ts.tv_sec * 1000000LL) + (ts.tv_nsec / 1000LL);
+}
+
+
+static void tmc_trace_put_int(unsigned char *dest, long long val, int sz)
+{
+  int i;
+
+  for(i=0; i<sz; i++)
+  {
+    dest[i] = (val >> (i * 8)) & 0xff;
+  }
+}
+
+
+static long long tmc_trace_get_int(const unsigned char *src, int sz)
+{
+  int i;
+
+  unsigned long long val=0;
+
+  for(i=0; i<sz; i++)
+  {
+    val |= (unsigned long long)src[i] << (i * 8);
+  }
+
+  if(sz < 8)
+  {
+    /* sign extension */
+    if(val & (1ULL << ((sz * 8) - 1)))
+    {
+      val |= ~0ULL << (sz * 8);
+    }
+  }
+
+  return (long long)val;
+}
+
+
+/*
+ * Record header, little endian:
+ * offset 0 type, 1 opc, 2-3 reserved, 4 result (int32),
+ * 8 usec (int64), 16 duration (int32), 20 len (int32)
+ */
+static int tmc_trace_put(FILE *f, const struct tmc_trace_rec *rec)
+{
+  unsigned char buf[TMC_TRACE_REC_SZ];
+
+  memset(buf, 0, TMC_TRACE_REC_SZ);
+
+  buf[0] = rec->type;
+  buf[1] = rec->opc;
+  tmc_trace_put_int(buf + 4, rec->result, 4);
+  tmc_trace_put_int(buf + 8, rec->usec, 8);
+  tmc_trace_put_int(buf + 16, rec->duration, 4);
+  tmc_trace_put_int(buf + 20, rec->len, 4);
+
+  if(fwrite(buf, TMC_TRACE_REC_SZ, 1, f) != 1)
+  {
+    return -1;
+  }
+
+  return 0;
+}
+
+
+static int tmc_trace_get(FILE *f, struct tmc_trace_rec *rec)
+{
+  unsigned char buf[TMC_TRACE_REC_SZ];
+
+  if(fread(buf, TMC_TRACE_REC_SZ, 1, f) != 1)
+  {
+    return -1;
+  }
+
+  memset(rec, 0, sizeof(struct tmc_trace_rec));
+
+  rec->type = buf[0];
+  rec->opc = buf[1];
+  rec->result = tmc_trace_get_int(buf + 4, 4);
+  rec->usec = tmc_trace_get_int(buf + 8, 8);
+  rec->duration = tmc_trace_get_int(buf + 16, 4);
+  rec->len = tmc_trace_get_int(buf + 20, 4);
+
+  return 0;
+}
+
+
+static void tmc_trace_add(struct tmcdev *dev, char type, int opc, const char *payload, int len, int result, long long t_start)
+{
+  struct tmc_trace_rec rec;
+
+  if((dev == NULL) || (dev->trace == NULL))
+  {
+    return;
+  }
+
+  if((payload == NULL) || (len < 0))
+  {
+    len = 0;
+  }
+
+  memset(&rec, 0, sizeof(struct tmc_trace_rec));
+
+  rec.type = type;
+  rec.opc = opc;
+  rec.result = result;
+  rec.usec = t_start - dev->trace_t0;
+  rec.duration = tmc_get_usec() - t_start;
+  rec.len = len;
+
+  if(tmc_trace_put(dev->trace, &rec) ||
+     (len && (fwrite(payload, len, 1, dev->trace) != 1)))
+  {
+    printf("trace: write error, recording stopped\n");
+
+    tmc_record_stop(dev);
+  }
+}
+
+
+/* joins the commands of a batch into one payload, returns the length */
+static int tmc_trace_join(char **dest, const char * const *cmds, int cnt)
+{
+  int i, len=0;
+
+  char *buf;
+
+  for(i=0; i<cnt; i++)
+  {
+    len += strlen(cmds[i]) + 1;
+  }
+
+  buf = (char *)malloc(len + 1);
+  if(buf == NULL)
+  {
+    *dest = NULL;
+
+    return 0;
+  }
+
+  buf[0] = 0;
+
+  for(i=0; i<cnt; i++)
+  {
+    if(i)
+    {
+      strcat(buf, "\n");
+    }
+
+    strcat(buf, cmds[i]);
+  }
+
+  *dest = buf;
+
+  return strlen(buf);
+}
+
+
+int tmc_record_start(struct tmcdev *dev, const char *path)
+{
+  if((dev == NULL) || (dev->type == TMC_TYPE_REPLAY))
+  {
+    return -1;
+  }
+
+  tmc_record_stop(dev);
+
+  dev->trace = fopen(path, "wb");
+  if(dev->trace == NULL)
+  {
+    printf("trace: can not create file %s\n", path);
+
+    return -1;
+  }
+
+  if(fwrite(TMC_TRACE_MAGIC, TMC_TRACE_MAGIC_SZ, 1, dev->trace) != 1)
+  {
+    fclose(dev->trace);
+
+    dev->trace = NULL;
+
+    return -1;
+  }
+
+  dev->trace_t0 = tmc_get_usec();
+
+  return 0;
+}
+
+
+void tmc_record_stop(struct tmcdev *dev)
+{
+  if((dev == NULL) || (dev->type == TMC_TYPE_REPLAY) || (dev->trace == NULL))
+  {
+    return;
+  }
+
+  fclose(dev->trace);
+
+  dev->trace = NULL;
+}
+
+
+struct tmcdev * tmc_open_replay(const char *path, int realtime)
+{
+  char magic[TMC_TRACE_MAGIC_SZ];
+
+  struct tmcdev *dev;
+
+  dev = (struct tmcdev *)calloc(1, sizeof(struct tmcdev));
+  if(dev == NULL)
+  {
+    return NULL;
+  }
+
+  dev->type = TMC_TYPE_REPLAY;
+
+  dev->fd = -1;
+
+  dev->trace_realtime = realtime;
+
+  dev->trace_usec_last = -1;
+
+  dev->trace = fopen(path, "rb");
+  if(dev->trace == NULL)
+  {
+    printf("replay: can not open file %s\n", path);
+
+    free(dev);
+
+    return NULL;
+  }
+
+  if((fread(magic, TMC_TRACE_MAGIC_SZ, 1, dev->trace) != 1) ||
+     memcmp(magic, TMC_TRACE_MAGIC, TMC_TRACE_MAGIC_SZ))
+  {
+    printf("replay: %s is not a trace file\n", path);
+
+    fclose(dev->trace);
+
+    free(dev);
+
+    return NULL;
+  }
+
+  dev->trace_t0 = ftell(dev->trace);
+
+
+  return dev;
+}
+
+
+/*
+ * Searches the trace for the next record of the requested type,
+ * for writes the payload must match as well. At the end of the trace
+ * the search wraps around once, so a recording of a few frames can be
+ * replayed endlessly. Returns the payload length and leaves the file
+ * positioned at the payload, or -1 when not found in which case the
+ * file position is not changed.
+ */
+static int tmc_replay_find(struct tmcdev *dev, char type, const char *payload, int len, struct tmc_trace_rec *rec)
+{
+  int wrapped=0, match;
+
+  long pos_start, pos;
+
+  char *buf;
+
+  pos_start = ftell(dev->trace);
+
+  while(1)
+  {
+    if(tmc_trace_get(dev->trace, rec))
+    {
+      if(wrapped)
+      {
+        break;
+      }
+
+      wrapped = 1;
+
+      fseek(dev->trace, dev->trace_t0, SEEK_SET);
+
+      continue;
+    }
+
+    pos = ftell(dev->trace);
+
+    if(wrapped && ((pos - TMC_TRACE_REC_SZ) >= pos_start))
+    {
+      break;
+    }
+
+    if((rec->type != type) || (rec->len < 0))
+    {
+      fseek(dev->trace, rec->len, SEEK_CUR);
+
+      continue;
+    }
+
+    if(type == TMC_TRACE_READ)
+    {
+      return rec->len;
+    }
+
+    match = 0;
+
+    if(rec->len == len)
+    {
+      buf = (char *)malloc(len + 1);
+      if(buf == NULL)
+      {
+        break;
+      }
+
+      if((fread(buf, len, 1, dev->trace) == 1) || (!len))
+      {
+        match = !memcmp(buf, payload, len);
+      }
+
+      free(buf);
+    }
+
+    if(match)
+    {
+      return len;
+    }
+
+    fseek(dev->trace, pos + rec->len, SEEK_SET);
+  }
+
+  fseek(dev->trace, pos_start, SEEK_SET);
+
+  return -1;
+}
+
+
+/*
+ * Realtime replay follows the recorded timeline: a call returns at the
+ * recorded end of its exchange, so the gaps between the calls are
+ * reproduced as well as their durations. When the application falls
+ * behind the recording, or the trace wrapped around, the timeline is
+ * moved instead of catching up with a burst of calls.
+ */
+static void tmc_replay_pace(struct tmcdev *dev, struct tmc_trace_rec *rec, long long t_start)
+{
+  long long t_now, t_end;
+
+  if(!dev->trace_realtime)
+  {
+    return;
+  }
+
+  if((dev->trace_usec_last < 0) || (rec->usec < dev->trace_usec_last))
+  {
+    dev->trace_t_base = t_start - rec->usec;
+  }
+
+  dev->trace_usec_last = rec->usec;
+
+  t_end = dev->trace_t_base + rec->usec + rec->duration;
+
+  t_now = tmc_get_usec();
+
+  if(t_end > t_now)
+  {
+    usleep(t_end - t_now);
+  }
+  else
+  {
+    dev->trace_t_base += t_now - t_end;
+  }
+}
+
+
+static int tmc_replay_write(struct tmcdev *dev, char type, const char *payload, int len)
+{
+  long long t_start;
+
+  struct tmc_trace_rec rec;
+
+  t_start = tmc_get_usec();
+
+  if(tmc_replay_find(dev, type, payload, len, &rec) < 0)
+  {
+    printf("replay: command not found in trace: %.*s\n", len, payload);
+
+    /* a setter that was not recorded is ignored, a query has no response to give */
+    if(memchr(payload, '?', len) != NULL)
+    {
+      return -1;
+    }
+
+    return len;
+  }
+
+  tmc_replay_pace(dev, &rec, t_start);
+
+  return rec.result;
+}
+
+
+static int tmc_replay_read(struct tmcdev *dev, char *dest, int destsz, void (*progress)(int, int, void *), void *progress_data)
+{
+  int len;
+
+  long long t_start;
+
+  char *buf;
+
+  struct tmc_trace_rec rec;
+
+  t_start = tmc_get_usec();
+
+  len = tmc_replay_find(dev, TMC_TRACE_READ, NULL, 0, &rec);
+  if(len < 0)
+  {
+    printf("replay: no response left in trace\n");
+
+    return -1;
+  }
+
+  if(dest != NULL)
+  {
+    if(len > destsz)
+    {
+      fseek(dev->trace, len, SEEK_CUR);
+
+      return -1;
+    }
+
+    if(len && (fread(dest, len, 1, dev->trace) != 1))
+    {
+      return -1;
+    }
+
+    dev->buf = dest;  /* like the usb and lan reads, callers check the payload in dev->buf */
+
+    if(progress != NULL)
+    {
+      progress(len, len, progress_data);
+    }
+  }
+  else
+  {
+    buf = (char *)realloc(dev->hdrbuf, len + 1);
+    if(buf == NULL)
+    {
+      return -1;
+    }
+
+    dev->hdrbuf = buf;
+
+    dev->buf = dev->hdrbuf;
+
+    if(len && (fread(dev->buf, len, 1, dev->trace) != 1))
+    {
+      return -1;
+    }
+
+    dev->buf[len] = 0;
+  }
+
+  dev->sz = len;
+
+  tmc_replay_pace(dev, &rec, t_start);
+
+  return rec.result;
+}
+
+
+/*
+ * The waveform subsystem can only be changed remotely, so the last value
+ * written is the state of the device. Writing the same value again is
+ * skipped, every skipped write saves a round trip including the *OPC?.
+ */
+static const char *tmc_shadow_hdr[TMC_SHADOW_CNT]=
+{
+  ":WAV:SOUR ",
+  ":WAV:FORM ",
+  ":WAV:MODE "
+};
+
+
+/* commands after which the waveform settings are unknown */
+static int tmc_shadow_invalidates(const char *cmd)
+{
+  if((!strncasecmp(cmd, "*RST", 4)) ||
+     (!strncasecmp(cmd, "*RCL", 4)) ||
+     (!strncasecmp(cmd, ":AUT", 4)) ||
+     (!strncasecmp(cmd, ":SYST", 5)) ||
+     (!strncasecmp(cmd, ":LOAD", 5)) ||
+     (!strncasecmp(cmd, ":STOR", 5)) ||
+     (!strncasecmp(cmd, ":WAV", 4)))
+  {
+    return 1;
+  }
+
+  return 0;
+}
+
+
+/* returns 1 if the command would not change anything */
+static int tmc_shadow_redundant(struct tmcdev *dev, const char *cmd)
+{
+  int i, len;
+
+  for(i=0; i<TMC_SHADOW_CNT; i++)
+  {
+    len = strlen(tmc_shadow_hdr[i]);
+
+    if(!strncasecmp(cmd, tmc_shadow_hdr[i], len))
+    {
+      return (dev->shadow[i][0] != 0) && (!strcasecmp(cmd + len, dev->shadow[i]));
+    }
+  }
+
+  return 0;
+}
+
+
+static void tmc_shadow_update(struct tmcdev *dev, const char *cmd, int ok)
+{
+  int i, len;
+
+  len = strlen(cmd);
+
+  if((!len) || (cmd[len - 1] == '?'))
+  {
+    return;
+  }
+
+  for(i=0; i<TMC_SHADOW_CNT; i++)
+  {
+    len = strlen(tmc_shadow_hdr[i]);
+
+    if(!strncasecmp(cmd, tmc_shadow_hdr[i], len))
+    {
+      if(ok)
+      {
+        strlcpy(dev->shadow[i], cmd + len, TMC_SHADOW_VAL_LEN);
+      }
+      else
+      {
+        dev->shadow[i][0] = 0;
+      }
+
+      return;
+    }
+  }
+
+  if((!ok) || tmc_shadow_invalidates(cmd))
+  {
+    tmc_shadow_clear(dev);
+  }
+}
+
+
+void tmc_shadow_clear(struct tmcdev *dev)
+{
+  if(dev == NULL)
+  {
+    return;
+  }
+
+  memset(dev->shadow, 0, sizeof(dev->shadow));
+}
+
+
+void tmc_pace_set(struct tmcdev *dev, int usec)
+{
+  if((dev == NULL) || (dev->type == TMC_TYPE_REPLAY))
+  {
+    return;
+  }
+
+  if(usec < TMC_PACE_MIN_USEC)
+  {
+    usec = TMC_PACE_MIN_USEC;
+  }
+
+  if(usec > TMC_PACE_MAX_USEC)
+  {
+    usec = TMC_PACE_MAX_USEC;
+  }
+
+  dev->pace_usec = usec;
+
+  dev->pace_floor_usec = TMC_PACE_MIN_USEC;
+
+  dev->pace_ok_cnt = 0;
+}
+
+
+int tmc_pace_get(struct tmcdev *dev)
+{
+  if(dev == NULL)
+  {
+    return 0;
+  }
+
+  return dev->pace_usec;
+}
+
+
+/* waits until the gap since the end of the last exchange has passed */
+static void tmc_pace_wait(struct tmcdev *dev)
+{
+  long long t_wait;
+
+  if(dev->pace_usec <= 0)
+  {
+    return;
+  }
+
+  t_wait = dev->pace_t_last + dev->pace_usec - tmc_get_usec();
+
+  if(t_wait > 0)
+  {
+    usleep(t_wait);
+  }
+}
+
+
+/* adapts the gap to the result of an exchange */
+static void tmc_pace_done(struct tmcdev *dev, int ok, int is_read, long long t_start)
+{
+  int gap;
+
+  dev->pace_t_last = tmc_get_usec();
+
+  if(dev->pace_usec <= 0)
+  {
+    return;
+  }
+
+  if(!ok)
+  {
+    dev->pace_err_cnt++;
+
+    dev->pace_ok_cnt = 0;
+
+    /* don't come back to the gap that failed */
+    gap = dev->pace_usec + (dev->pace_usec / 4);
+
+    if(gap > dev->pace_floor_usec)
+    {
+      dev->pace_floor_usec = (gap < TMC_PACE_MAX_USEC) ? gap : TMC_PACE_MAX_USEC;
+    }
+
+    gap = dev->pace_usec * 2;
+
+    dev->pace_usec = (gap < TMC_PACE_MAX_USEC) ? gap : TMC_PACE_MAX_USEC;
+
+    return;
+  }
+
+  if(is_read)
+  {
+    if(dev->pace_lat_usec)
+    {
+      dev->pace_lat_usec += ((int)(dev->pace_t_last - t_start) - dev->pace_lat_usec) / 8;
+    }
+    else
+    {
+      dev->pace_lat_usec = dev->pace_t_last - t_start;
+    }
+  }
+
+  if(++dev->pace_ok_cnt < TMC_PACE_OK_CNT)
+  {
+    return;
+  }
+
+  dev->pace_ok_cnt = 0;
+
+  gap = dev->pace_usec - (dev->pace_usec / 8);
+
+  if(gap < dev->pace_floor_usec)
+  {
+    gap = dev->pace_floor_usec;
+  }
+
+  dev->pace_usec = gap;
+}
+
+
+static int tmc_send(struct tmcdev *dev, const char *str)
+{
+  if(dev->type == TMC_TYPE_USB)
+  {
+    return tmcdev_send(dev, str);
+  }
+
+  return tmclan_send(dev, str);
+}
+
+
+static int tmc_recv(struct tmcdev *dev, char *buf, int sz)
+{
+  if(dev->type == TMC_TYPE_USB)
+  {
+    return tmcdev_recv(dev, buf, sz);
+  }
+
+  return tmclan_recv(dev, buf, sz);
+}
+
+
+/*
+ * Sends one command terminated with a newline.
+ * qry is set to 1 when the command must not be followed by *OPC?
+ * Returns the length of the command or -1 in case of an error.
+ */
+static int tmc_send_cmd(struct tmcdev *dev, const char *cmd, int *qry)
+{
+  int n, len;
+
+  char buf[TMC_MAX_CMD_LEN + 16];
+
+  *qry = 0;
+
+  len = strlen(cmd);
+
+  if(len > TMC_MAX_CMD_LEN)
+  {
+    printf("tmc error: command too long\n");
+
+    return -1;
+  }
+
+  if(len < 2)
+  {
+    printf("tmc error: command too short\n");
+
+    return -1;
+  }
+
+  if(cmd[len - 1] == '?')
+  {
+    *qry = 1;
+  }
+
+  strlcpy(buf, cmd, TMC_MAX_CMD_LEN + 16);
+
+  strlcat(buf, "\n", TMC_MAX_CMD_LEN + 16);
+
+  if(!(!strncmp(buf, ":TRIG:STAT?", 11) ||  /* don't print these commands to the console */
+       !strncmp(buf, ":TRIG:SWE?", 10) ||   /* because they are used repeatedly */
+       !strncmp(buf, ":WAV:DATA?", 10) ||
+       !strncmp(buf, ":WAV:MODE NORM", 14) ||
+       !strncmp(buf, ":WAV:MODE RAW", 13) ||  /* the RAW window of every frame */
+       !strncmp(buf, ":WAV:STAR ", 10) ||
+       !strncmp(buf, ":WAV:STOP ", 10) ||
+       !strncmp(buf, ":WAV:POIN ", 10) ||
+       !strncmp(buf, ":WAV:FORM BYTE", 14) ||
+       !strncmp(buf, ":WAV:SOUR CHAN", 14) ||
+       !strncmp(buf, ":ACQ:SRAT?", 10) ||
+       !strncmp(buf, ":ACQ:MDEP?", 10) ||
+       !strncmp(buf, ":MEAS:COUN:VAL?", 15) ||
+       !strncmp(buf, ":FUNC:WREC:OPER?", 16) ||
+       !strncmp(buf, ":FUNC:WREP:OPER?", 16) ||
+       !strncmp(buf, ":FUNC:WREP:FMAX?", 16) ||
+       !strncmp(buf, ":FUNC:WREC:FMAX?", 16) ||
+       !strncmp(buf, ":FUNC:WREP:FCUR?", 16) ||
+       !strncmp(buf, ":WAV:XOR?", 9)))
+  {
+    printf("tmc write: %s", buf);
+  }
+
+  if((!strncmp(buf, "*RST", 4)) || (!strncmp(buf, ":AUT", 4)))
+  {
+    *qry = 1;
+  }
+
+  n = tmc_send(dev, buf);
+
+  if(n != (len + 1))
+  {
+    printf("tmc error: device write error\n");
+
+    return -1;
+  }
+
+  return len;
+}
+
+
+/*
+ * Polls *OPC? until the device reports that all pending operations
+ * are complete. The first poll is sent immediately, the interval
+ * between the following polls grows from 1 to 25 milli-Sec.
+ * Gives up after TMC_OPC_MAX_USEC and returns 1, the commands are
+ * not failed for that but the pacing backs off.
+ * Returns -1 in case of an error.
+ */
+static int tmc_wait_opc(struct tmcdev *dev)
+{
+  int n, delay=1000;
+
+  char str[256];
+
+  long long t_start;
+
+  t_start = tmc_get_usec();
+
+  while(1)
+  {
+    if(tmc_send(dev, "*OPC?\n") != 6)
+    {
+      printf("tmc error: device write error\n");
+
+      return -1;
+    }
+
+    n = tmc_recv(dev, str, 128);
+
+    if(n < 0)
+    {
+      printf("tmc error: device read error\n");
+
+      return -1;
+    }
+
+    if(n == 2)
+    {
+      if(str[0] == '1')
+      {
+        break;
+      }
+    }
+
+    if((tmc_get_usec() - t_start) > TMC_OPC_MAX_USEC)
+    {
+      printf("tmc error: *OPC? timeout\n");
+
+      return 1;
+    }
+
+    usleep(delay);
+
+    delay *= 2;
+
+    if(delay > 25000)
+    {
+      delay = 25000;
+    }
+  }
+
+  return 0;
+}
+
+
+/*
+ * Sends cnt commands back-to-back without waiting for each of them.
+ * If opc is TMC_OPC_WAIT, they are confirmed with one trailing *OPC?
+ * except for a single query, *RST or :AUT which is never confirmed.
+ * opc_late is set to 1 when the device didn't confirm them in time.
+ * Returns the number of commands sent or -1 in case of an error.
+ */
+static int tmc_send_cmds(struct tmcdev *dev, const char * const *cmds, int cnt, int opc, int *opc_late)
+{
+  int i, qry=0;
+
+  long long t_start;
+
+  *opc_late = 0;
+
+  t_start = tmc_get_usec();
+
+  for(i=0; i<cnt; i++)
+  {
+    if(tmc_send_cmd(dev, cmds[i], &qry) < 0)
+    {
+      return -1;
+    }
+  }
+
+  if((cnt == 1) && qry)
+  {
+    opc = TMC_OPC_NONE;
+  }
+
+  if((cnt > 0) && (opc == TMC_OPC_WAIT))
+  {
+    *opc_late = tmc_wait_opc(dev);
+
+    if(*opc_late < 0)
+    {
+      return -1;
+    }
+  }
+
+  dev->cmd_usec = tmc_get_usec() - t_start;
+
+  return cnt;
+}
 
 
 struct tmcdev * tmc_open_usb(const char *device)
 {
-  tmc_connection_type = 0;
+  struct tmcdev *dev;
 
-  tmc_device = tmcdev_open(device);
+  dev = tmcdev_open(device);
 
-  return tmc_device;
+  tmc_pace_set(dev, TMC_GDS_DELAY);
+
+  return dev;
 }
 
 
 struct tmcdev * tmc_open_lan(const char *address)
 {
-  tmc_connection_type = 1;
+  struct tmcdev *dev;
+
+  dev = tmclan_open(address);
+
+  tmc_pace_set(dev, TMC_GDS_DELAY);
+
+  return dev;
+}
+
+
+void tmc_close(struct tmcdev *dev)
+{
+  if(dev == NULL)
+  {
+    return;
+  }
+
+  if(dev->type == TMC_TYPE_REPLAY)
+  {
+    fclose(dev->trace);
+
+    free(dev->hdrbuf);
+
+    free(dev);
+  }
+  else
+  {
+    tmc_record_stop(dev);
+
+    if(dev->type == TMC_TYPE_USB)
+    {
+      tmcdev_close(dev);
+    }
+    else
+    {
+      tmclan_close(dev);
+    }
+  }
+}
+
+
+int tmc_write(struct tmcdev *dev, const char *cmd)
+{
+  int ret, opc_late=0;
+
+  long long t_start;
+
+  if(dev == NULL)
+  {
+    return -1;
+  }
+
+  if(tmc_shadow_redundant(dev, cmd))
+  {
+    return strlen(cmd);
+  }
+
+  if(dev->type == TMC_TYPE_REPLAY)
+  {
+    ret = tmc_replay_write(dev, TMC_TRACE_WRITE, cmd, strlen(cmd));
+  }
+  else
+  {
+    tmc_pace_wait(dev);
+
+    t_start = tmc_get_usec();
+
+    ret = tmc_send_cmds(dev, &cmd, 1, TMC_OPC_WAIT, &opc_late);
+
+    if(ret == 1)
+    {
+      ret = strlen(cmd);
+    }
 
-  tmc_device =  tmclan_open(address);
+    tmc_pace_done(dev, (ret == (int)strlen(cmd)) && !opc_late, 0, t_start);
 
-  return tmc_device;
+    tmc_trace_add(dev, TMC_TRACE_WRITE, 0, cmd, strlen(cmd), ret, t_start);
+  }
+
+  tmc_shadow_update(dev, cmd, ret == (int)strlen(cmd));
+
+  return ret;
 }
 
 
-void tmc_close(void)
+int tmc_write_batch(struct tmcdev *dev, const char * const *cmds_in, int cnt_in, int opc)
 {
-  if(tmc_connection_type == 0)
+  int i, ret, len, cnt=0, opc_late=0;
+
+  long long t_start;
+
+  char *joined=NULL;
+
+  const char *cmds[TMC_CMD_BATCH_SZ];
+
+  if((dev == NULL) || (cnt_in > TMC_CMD_BATCH_SZ))
+  {
+    return -1;
+  }
+
+  for(i=0; i<cnt_in; i++)
+  {
+    len = strlen(cmds_in[i]);
+
+    if((len > 0) && (cmds_in[i][len - 1] == '?'))
+    {
+      printf("tmc error: can not batch a query: %s\n", cmds_in[i]);
+
+      return -1;
+    }
+  }
+
+  for(i=0; i<cnt_in; i++)
+  {
+    if(!tmc_shadow_redundant(dev, cmds_in[i]))
+    {
+      cmds[cnt++] = cmds_in[i];
+    }
+  }
+
+  if(!cnt)
+  {
+    return cnt_in;
+  }
+
+  if((dev->type == TMC_TYPE_REPLAY) || (dev->trace != NULL))
+  {
+    len = tmc_trace_join(&joined, cmds, cnt);
+    if(joined == NULL)
+    {
+      return -1;
+    }
+  }
+
+  if(dev->type == TMC_TYPE_REPLAY)
   {
-    tmcdev_close(tmc_device);
+    ret = tmc_replay_write(dev, TMC_TRACE_BATCH, joined, len);
+
+    free(joined);
   }
   else
   {
-    tmclan_close(tmc_device);
+    tmc_pace_wait(dev);
+
+    t_start = tmc_get_usec();
+
+    ret = tmc_send_cmds(dev, cmds, cnt, opc, &opc_late);
+
+    tmc_pace_done(dev, (ret == cnt) && !opc_late, 0, t_start);
+
+    if(joined != NULL)
+    {
+      tmc_trace_add(dev, TMC_TRACE_BATCH, opc, joined, len, ret, t_start);
+
+      free(joined);
+    }
+  }
+
+  for(i=0; i<cnt; i++)
+  {
+    tmc_shadow_update(dev, cmds[i], ret == cnt);
+  }
+
+  if(ret == cnt)
+  {
+    return cnt_in;
   }
 
-  tmc_device = NULL;
+  return ret;
 }
 
 
-int tmc_write(const char *cmd)
+int tmc_read(struct tmcdev *dev)
 {
-  if(tmc_connection_type == 0)
+  int ret;
+
+  long long t_start;
+
+  if(dev == NULL)
+  {
+    return -1;
+  }
+
+  if(dev->type == TMC_TYPE_REPLAY)
+  {
+    return tmc_replay_read(dev, NULL, 0, NULL, NULL);
+  }
+
+  t_start = tmc_get_usec();
+
+  if(dev->type == TMC_TYPE_USB)
   {
-    return tmcdev_write(tmc_device, cmd);
+    ret = tmcdev_read(dev);
   }
   else
   {
-    return tmclan_write(tmc_device, cmd);
+    ret = tmclan_read(dev);
   }
 
-  return -1;
+  tmc_pace_done(dev, ret >= 0, 1, t_start);
+
+  tmc_trace_add(dev, TMC_TRACE_READ, 0, dev->buf, ret, ret, t_start);
+
+  return ret;
 }
 
 
-int tmc_read(void)
+int tmc_read_block(struct tmcdev *dev, char *dest, int destsz, void (*progress)(int, int, void *), void *progress_data)
 {
-  if(tmc_connection_type == 0)
+  int ret;
+
+  long long t_start;
+
+  if(dev == NULL)
+  {
+    return -1;
+  }
+
+  if(dev->type == TMC_TYPE_REPLAY)
+  {
+    return tmc_replay_read(dev, dest, destsz, progress, progress_data);
+  }
+
+  t_start = tmc_get_usec();
+
+  if(dev->type == TMC_TYPE_USB)
   {
-    return tmcdev_read(tmc_device);
+    ret = tmcdev_read_block(dev, dest, destsz, progress, progress_data);
   }
   else
   {
-    return tmclan_read(tmc_device);
+    ret = tmclan_read_block(dev, dest, destsz, progress, progress_data);
   }
 
-  return -1;
+  tmc_pace_done(dev, ret >= 0, 1, t_start);
+
+  tmc_trace_add(dev, TMC_TRACE_READ, 0, (dest != NULL) ? dest : dev->buf, ret, ret, t_start);
+
+  return ret;
 }
 
 
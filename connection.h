@@ -32,6 +32,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <strings.h>
 #include <locale.h>
 #include <time.h>
 #include <sys/types.h>
@@ -44,11 +45,50 @@
 #include "utils.h"
 
 
+/*
+ * Every opened device is an independent connection.
+ * The functions with a device argument can be used concurrently
+ * for different devices, e.g. one screen thread per instrument.
+ * There is no global device, every call takes the device it talks to.
+ */
 struct tmcdev * tmc_open_usb(const char *);
-void tmc_close(void);
-int tmc_write(const char *);
-int tmc_read(void);
 struct tmcdev * tmc_open_lan(const char *);
+void tmc_close(struct tmcdev *);
+int tmc_write(struct tmcdev *, const char *);
+int tmc_write_batch(struct tmcdev *, const char * const *, int, int);
+int tmc_read(struct tmcdev *);
+int tmc_read_block(struct tmcdev *, char *, int, void (*)(int, int, void *), void *);
+
+/*
+ * Recording writes every exchange of a device with timestamps into a
+ * binary trace file. A trace can be opened as a device again, the
+ * responses are served in the recorded order, setters that were not
+ * recorded are ignored, queries that were not recorded fail. With realtime
+ * set, the calls follow the recorded timeline, the gaps between the calls
+ * as well as their durations, otherwise the trace is replayed at full speed.
+ */
+int tmc_record_start(struct tmcdev *, const char *);
+void tmc_record_stop(struct tmcdev *);
+struct tmcdev * tmc_open_replay(const char *, int);
+
+/*
+ * Writes of :WAV:SOUR, :WAV:FORM and :WAV:MODE that would set the value
+ * that was written last are skipped. The cache is cleared by commands
+ * that can change these settings (*RST, :AUT, :SYST, etc.) and by failed writes.
+ * Call tmc_shadow_clear() when the device state can not be trusted anymore.
+ */
+void tmc_shadow_clear(struct tmcdev *);
+
+/*
+ * Commands are paced: a write waits until a minimum gap has passed since
+ * the end of the previous exchange. The gap is adapted while running,
+ * it shrinks slowly as long as the device answers correctly and doubles
+ * after a timeout or an invalid response. tmc_pace_set() sets the start
+ * value, e.g. from a profile saved for the model, tmc_pace_get() returns
+ * the gap the device was tuned to.
+ */
+void tmc_pace_set(struct tmcdev *, int);
+int tmc_pace_get(struct tmcdev *);
 
 
 
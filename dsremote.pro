@@ -78,6 +78,18 @@ HEADERS += global.h
 HEADERS += mainwindow.h
 HEADERS += about_dialog.h
 HEADERS += utils.h
+HEADERS += sample_conv.h
+HEADERS += fft_stage.h
+HEADERS += frame_policy.h
+HEADERS += persist.h
+HEADERS += welch_psd.h
+HEADERS += wave_lod.h
+HEADERS += trace_raster.h
+HEADERS += work_pool.h
+HEADERS += trace_render.h
+HEADERS += wave_density.h
+HEADERS += psd_view.h
+HEADERS += psd_dialog.h
 HEADERS += connection.h
 HEADERS += tmc_dev.h
 HEADERS += tmc_lan.h
@@ -86,6 +98,7 @@ HEADERS += edflib.h
 HEADERS += signalcurve.h
 HEADERS += settings_dialog.h
 HEADERS += screen_thread.h
+HEADERS += cmd_queue.h
 HEADERS += lan_connect_thread.h
 HEADERS += read_settings_thread.h
 HEADERS += save_data_thread.h
@@ -108,6 +121,18 @@ SOURCES += interface.cpp
 SOURCES += serial_decoder.cpp
 SOURCES += about_dialog.cpp
 SOURCES += utils.c
+SOURCES += sample_conv.c
+SOURCES += fft_stage.cpp
+SOURCES += frame_policy.c
+SOURCES += persist.c
+SOURCES += welch_psd.cpp
+SOURCES += wave_lod.cpp
+SOURCES += trace_raster.c
+SOURCES += work_pool.cpp
+SOURCES += trace_render.cpp
+SOURCES += wave_density.cpp
+SOURCES += psd_view.cpp
+SOURCES += psd_dialog.cpp
 SOURCES += connection.cpp
 SOURCES += tmc_dev.c
 SOURCES += tmc_lan.c
@@ -116,6 +141,7 @@ SOURCES += edflib.c
 SOURCES += signalcurve.cpp
 SOURCES += settings_dialog.cpp
 SOURCES += screen_thread.cpp
+SOURCES += cmd_queue.cpp
 SOURCES += lan_connect_thread.cpp
 SOURCES += read_settings_thread.cpp
 SOURCES += save_data_thread.cpp
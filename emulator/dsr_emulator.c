@@ -0,0 +1,1301 @@
+/*
+***************************************************************************
+*
+* Author: Teunis van Beelen
+*
+* Copyright (C) 2015 - 2024 Teunis van Beelen
+*
+* Email: teuniz@protonmail.com
+*
+***************************************************************************
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+***************************************************************************
+*/
+
+
+/*
+ * Emulates a Rigol DS1054Z on TCP port 5555 with the subset of SCPI
+ * commands that DSRemote uses, so that the screen thread, the deep memory
+ * download and the settings reader can be profiled without an instrument.
+ *
+ * Setters are stored and returned by the matching query, long and short
+ * SCPI keywords are treated the same. Compound commands separated by ';'
+ * are supported, the responses are joined with ';'.
+ *
+ * Channel 1: 1 KHz sine
+ * Channel 2: UART TX, 8N1, LSB first
+ * Channel 3: SPI SCLK
+ * Channel 4: SPI MOSI, MSB first
+ *
+ * usage: dsr_emulator [-a bind address] [-p port] [-l latency in uSec]
+ *                     [-b bandwidth in bytes/Sec] [-u UART baudrate]
+ *                     [-s SPI clock in Hz] [-m model]
+ *
+ * Several emulators can run next to each other on 127.0.0.2, 127.0.0.3, etc.
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+#include <errno.h>
+#include <signal.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+
+
+
+#define EMU_DEFAULT_PORT   (5555)
+
+#define EMU_MAX_KEYS       (512)
+#define EMU_KEY_LEN        (64)
+#define EMU_VAL_LEN        (64)
+
+#define EMU_MAX_LINE       (4096)
+
+#define EMU_MAX_CHNS       (4)
+
+#define EMU_RAW_MAX_PNTS   (250000)
+
+#define EMU_MAX_SRATE      (1e9)
+
+#define EMU_BMP_WIDTH      (800)
+#define EMU_BMP_HEIGHT     (480)
+#define EMU_BMP_SZ         (EMU_BMP_WIDTH * EMU_BMP_HEIGHT * 3 + 54)
+
+#ifndef M_PI
+#define M_PI (3.14159265358979323846)
+#endif
+
+
+
+struct emu_setting
+{
+  char key[EMU_KEY_LEN];
+  char val[EMU_VAL_LEN];
+};
+
+
+static struct
+{
+  struct emu_setting settings[EMU_MAX_KEYS];
+  int setting_cnt;
+
+  char model[64];
+  int latency;           /* uSec added before every response */
+  double bandwidth;      /* bytes per second, 0 is unlimited */
+  int uart_baud;
+  int spi_clk;
+
+  int running;           /* 0=stopped, 1=running, 2=single, waiting for a trigger */
+  unsigned int acq_cnt;  /* increments every acquisition while running */
+  int single_cnt;
+
+  unsigned char *outbuf;
+  int outbuf_sz;
+  int out_len;
+} emu;
+
+
+static const char *emu_defaults[][2]=
+{
+  {"ACQ:AVER", "2"},
+  {"ACQ:MDEP", "12000"},
+  {"ACQ:TYPE", "NORM"},
+  {"BUS1:DISP", "0"},
+  {"BUS1:FORM", "HEX"},
+  {"BUS1:MODE", "PAR"},
+  {"BUS1:POS", "350"},
+  {"CALC:MODE", "OFF"},
+  {"CHAN1:BWL", "OFF"},
+  {"CHAN1:COUP", "DC"},
+  {"CHAN1:DISP", "1"},
+  {"CHAN1:INV", "0"},
+  {"CHAN1:OFFS", "0.000000e+00"},
+  {"CHAN1:PROB", "10"},
+  {"CHAN1:SCAL", "1.000000e+00"},
+  {"CHAN1:UNIT", "VOLT"},
+  {"CHAN1:VERN", "0"},
+  {"CHAN2:BWL", "OFF"},
+  {"CHAN2:COUP", "DC"},
+  {"CHAN2:DISP", "1"},
+  {"CHAN2:INV", "0"},
+  {"CHAN2:OFFS", "0.000000e+00"},
+  {"CHAN2:PROB", "10"},
+  {"CHAN2:SCAL", "1.000000e+00"},
+  {"CHAN2:UNIT", "VOLT"},
+  {"CHAN2:VERN", "0"},
+  {"CHAN3:BWL", "OFF"},
+  {"CHAN3:COUP", "DC"},
+  {"CHAN3:DISP", "1"},
+  {"CHAN3:INV", "0"},
+  {"CHAN3:OFFS", "0.000000e+00"},
+  {"CHAN3:PROB", "10"},
+  {"CHAN3:SCAL", "1.000000e+00"},
+  {"CHAN3:UNIT", "VOLT"},
+  {"CHAN3:VERN", "0"},
+  {"CHAN4:BWL", "OFF"},
+  {"CHAN4:COUP", "DC"},
+  {"CHAN4:DISP", "1"},
+  {"CHAN4:INV", "0"},
+  {"CHAN4:OFFS", "0.000000e+00"},
+  {"CHAN4:PROB", "10"},
+  {"CHAN4:SCAL", "1.000000e+00"},
+  {"CHAN4:UNIT", "VOLT"},
+  {"CHAN4:VERN", "0"},
+  {"DEC1:DISP", "0"},
+  {"DEC1:FORM", "HEX"},
+  {"DEC1:MODE", "UART"},
+  {"DEC1:POS", "350"},
+  {"DISP:GRAD:TIME", "MIN"},
+  {"DISP:GRID", "FULL"},
+  {"DISP:TYPE", "VECT"},
+  {"FUNC:WREC:ENAB", "0"},
+  {"FUNC:WREC:FEND", "1000"},
+  {"FUNC:WREC:FINT", "1.000000e-07"},
+  {"FUNC:WREC:FMAX", "1000"},
+  {"FUNC:WREC:OPER", "STOP"},
+  {"FUNC:WREP:FCUR", "1"},
+  {"FUNC:WREP:FEND", "1000"},
+  {"FUNC:WREP:FINT", "1.000000e-07"},
+  {"FUNC:WREP:FMAX", "1000"},
+  {"FUNC:WREP:FST", "1"},
+  {"FUNC:WREP:OPER", "STOP"},
+  {"FUNC:WRM", "OFF"},
+  {"MATH:DISP", "0"},
+  {"MATH:FFT:HCEN", "5.000000e+06"},
+  {"MATH:FFT:HSC", "1"},
+  {"MATH:FFT:SOUR", "CHAN1"},
+  {"MATH:FFT:SPL", "FULL"},
+  {"MATH:FFT:UNIT", "VRMS"},
+  {"MATH:OFFS", "0.000000e+00"},
+  {"MATH:OPER", "ADD"},
+  {"MATH:SCAL", "1.000000e+00"},
+  {"MEAS:COUN:SOUR", "OFF"},
+  {"REC:WREC:ENAB", "0"},
+  {"TIM:DEL:ENAB", "0"},
+  {"TIM:DEL:OFFS", "0.000000e+00"},
+  {"TIM:DEL:SCAL", "5.000000e-07"},
+  {"TIM:HREF:MODE", "CENT"},
+  {"TIM:HREF:POS", "0"},
+  {"TIM:MODE", "MAIN"},
+  {"TIM:OFFS", "0.000000e+00"},
+  {"TIM:SCAL", "1.000000e-04"},
+  {"TIM:VERN", "0"},
+  {"TIM:XY1:DISP", "0"},
+  {"TIM:XY2:DISP", "0"},
+  {"TRIG:COUP", "DC"},
+  {"TRIG:EDG:LEV", "0.000000e+00"},
+  {"TRIG:EDG:SLOP", "POS"},
+  {"TRIG:EDG:SOUR", "CHAN1"},
+  {"TRIG:HOLD", "1.600000e-08"},
+  {"TRIG:MODE", "EDGE"},
+  {"TRIG:SWE", "AUTO"},
+  {"WAV:FORM", "BYTE"},
+  {"WAV:MODE", "NORM"},
+  {"WAV:SOUR", "CHAN1"},
+  {"WAV:STAR", "1"},
+  {"WAV:STOP", "1200"},
+  {NULL, NULL}
+};
+
+
+static const char emu_message[]="Hello from the DSRemote emulator!\r\n";
+
+
+
+/*
+ * Converts a SCPI header like ":TRIGger:EDGE:LEVel" or ":TRIG:EDG:LEV"
+ * into the same key "TRIG:EDG:LEV". Every node is cut to the first four
+ * letters, or three if the fourth one is a vowel. This is not always the
+ * official short form ("MODE" becomes "MOD") but it is the same for the
+ * long and the short spelling, which is all that matters here.
+ * A numeric suffix like in "CHANnel2" is kept.
+ */
+static void emu_normalize_key(char *dest, const char *src, int sz)
+{
+  int i, j, k, letters, len=0;
+
+  char node[EMU_KEY_LEN];
+
+  dest[0] = 0;
+
+  while(*src == ':')
+  {
+    src++;
+  }
+
+  while(*src)
+  {
+    for(i=0; src[i] && (src[i] != ':') && (i < (EMU_KEY_LEN - 1)); i++)
+    {
+      node[i] = toupper((unsigned char)src[i]);
+    }
+    node[i] = 0;
+
+    src += i;
+
+    while(*src == ':')
+    {
+      src++;
+    }
+
+    j = i;
+
+    while((j > 0) && isdigit((unsigned char)node[j - 1]))
+    {
+      j--;
+    }
+
+    letters = j;
+
+    if(letters > 4)
+    {
+      letters = 4;
+    }
+
+    if((letters == 4) && strchr("AEIOU", node[3]))
+    {
+      letters = 3;
+    }
+
+    if(len && (len < (sz - 1)))
+    {
+      dest[len++] = ':';
+    }
+
+    for(k=0; (k<letters) && (len < (sz - 1)); k++)
+    {
+      dest[len++] = node[k];
+    }
+
+    for(k=j; (k<i) && (len < (sz - 1)); k++)
+    {
+      dest[len++] = node[k];
+    }
+
+    dest[len] = 0;
+  }
+}
+
+
+static int emu_key_is(const char *key, const char *name)
+{
+  char norm[EMU_KEY_LEN];
+
+  if(name[0] == '*')
+  {
+    return !strcmp(key, name);
+  }
+
+  emu_normalize_key(norm, name, EMU_KEY_LEN);
+
+  return !strcmp(key, norm);
+}
+
+
+static const char * emu_get(const char *name)
+{
+  int i;
+
+  char key[EMU_KEY_LEN];
+
+  emu_normalize_key(key, name, EMU_KEY_LEN);
+
+  for(i=0; i<emu.setting_cnt; i++)
+  {
+    if(!strcmp(emu.settings[i].key, key))
+    {
+      return emu.settings[i].val;
+    }
+  }
+
+  return NULL;
+}
+
+
+static void emu_set(const char *name, const char *val)
+{
+  int i;
+
+  char key[EMU_KEY_LEN];
+
+  emu_normalize_key(key, name, EMU_KEY_LEN);
+
+  for(i=0; i<emu.setting_cnt; i++)
+  {
+    if(!strcmp(emu.settings[i].key, key))
+    {
+      break;
+    }
+  }
+
+  if(i == emu.setting_cnt)
+  {
+    if(emu.setting_cnt >= EMU_MAX_KEYS)
+    {
+      return;
+    }
+
+    emu.setting_cnt++;
+
+    strcpy(emu.settings[i].key, key);
+  }
+
+  strncpy(emu.settings[i].val, val, EMU_VAL_LEN - 1);
+  emu.settings[i].val[EMU_VAL_LEN - 1] = 0;
+}
+
+
+static double emu_get_dbl(const char *key, double def)
+{
+  const char *val;
+
+  val = emu_get(key);
+  if(val == NULL)
+  {
+    return def;
+  }
+
+  return atof(val);
+}
+
+
+static void emu_reset(void)
+{
+  int i;
+
+  emu.setting_cnt = 0;
+
+  for(i=0; emu_defaults[i][0]!=NULL; i++)
+  {
+    emu_set(emu_defaults[i][0], emu_defaults[i][1]);
+  }
+
+  emu.running = 1;
+}
+
+
+static void emu_out_reserve(int sz)
+{
+  if((emu.out_len + sz) <= emu.outbuf_sz)
+  {
+    return;
+  }
+
+  emu.outbuf_sz = (emu.out_len + sz) * 2;
+
+  emu.outbuf = (unsigned char *)realloc(emu.outbuf, emu.outbuf_sz);
+  if(emu.outbuf == NULL)
+  {
+    fprintf(stderr, "emulator: malloc error\n");
+
+    exit(EXIT_FAILURE);
+  }
+}
+
+
+static void emu_out_str(const char *str)
+{
+  int len;
+
+  len = strlen(str);
+
+  emu_out_reserve(len);
+
+  memcpy(emu.outbuf + emu.out_len, str, len);
+
+  emu.out_len += len;
+}
+
+
+static int emu_active_chns(void)
+{
+  int chn, cnt=0;
+
+  char key[EMU_KEY_LEN];
+
+  for(chn=0; chn<EMU_MAX_CHNS; chn++)
+  {
+    snprintf(key, EMU_KEY_LEN, "CHAN%i:DISP", chn + 1);
+
+    if(emu_get_dbl(key, 0) > 0.5)
+    {
+      cnt++;
+    }
+  }
+
+  return cnt;
+}
+
+
+static double emu_samplerate(void)
+{
+  int chns;
+
+  double srate, mdep, timescale;
+
+  chns = emu_active_chns();
+
+  srate = EMU_MAX_SRATE;
+
+  if(chns > 2)
+  {
+    srate /= 4;
+  }
+  else if(chns == 2)
+    {
+      srate /= 2;
+    }
+
+  mdep = emu_get_dbl("ACQ:MDEP", 0);
+
+  timescale = emu_get_dbl("TIM:SCAL", 1e-4);
+
+  if(mdep > 1)
+  {
+    if((mdep / (12 * timescale)) < srate)
+    {
+      srate = mdep / (12 * timescale);
+    }
+  }
+
+  return srate;
+}
+
+
+static int emu_norm_points(void)
+{
+  if((!strncmp(emu.model, "DS1", 3)) || (!strncmp(emu.model, "MSO1", 4)))
+  {
+    return 1200;
+  }
+
+  return 1400;
+}
+
+
+static int emu_source_chn(void)
+{
+  const char *src;
+
+  src = emu_get("WAV:SOUR");
+
+  if((src != NULL) && (!strncmp(src, "CHAN", 4)) && (src[4] >= '1') && (src[4] <= '4'))
+  {
+    return src[4] - '1';
+  }
+
+  return 0;
+}
+
+
+/* returns a sample between -100 and +100 */
+static int emu_signal(int chn, double t)
+{
+  int bit, bits_per_byte, idx, byte, msg_len, level;
+
+  double bit_time;
+
+  long long bit_nr;
+
+  msg_len = strlen(emu_message);
+
+  switch(chn)
+  {
+    case 0: return (int)(75.0 * sin(2.0 * M_PI * 1000.0 * t));
+
+    case 1: bits_per_byte = 12;  /* start bit, 8 data bits, stop bit and 2 idle bits */
+            bit_nr = (long long)floor(t * emu.uart_baud);
+            bit_nr %= (long long)bits_per_byte * msg_len;
+            if(bit_nr < 0)
+            {
+              bit_nr += (long long)bits_per_byte * msg_len;
+            }
+            idx = bit_nr / bits_per_byte;
+            bit = bit_nr % bits_per_byte;
+            byte = (unsigned char)emu_message[idx];
+            if(bit == 0)
+            {
+              level = 0;
+            }
+            else if(bit < 9)
+              {
+                level = (byte >> (bit - 1)) & 1;
+              }
+              else
+              {
+                level = 1;
+              }
+            return level ? 50 : -50;
+
+    case 2:
+    case 3: bits_per_byte = 10;  /* 8 clock cycles and 2 idle cycles */
+            bit_time = t * emu.spi_clk;
+            bit_nr = (long long)floor(bit_time);
+            bit_nr %= (long long)bits_per_byte * msg_len;
+            if(bit_nr < 0)
+            {
+              bit_nr += (long long)bits_per_byte * msg_len;
+            }
+            idx = bit_nr / bits_per_byte;
+            bit = bit_nr % bits_per_byte;
+            if(chn == 2)
+            {
+              if(bit > 7)
+              {
+                return -50;
+              }
+
+              return ((bit_time - floor(bit_time)) >= 0.5) ? 50 : -50;
+            }
+
+            if(bit > 7)
+            {
+              return -50;
+            }
+            byte = (unsigned char)emu_message[idx];
+            return ((byte >> (7 - bit)) & 1) ? 50 : -50;
+  }
+
+  return 0;
+}
+
+
+static unsigned char emu_sample(int chn, double t, unsigned int *seed)
+{
+  int val;
+
+  *seed = (*seed * 1103515245) + 12345;
+
+  val = 127 + emu_signal(chn, t) + (int)((*seed >> 16) % 5) - 2;
+
+  if(val < 0)
+  {
+    val = 0;
+  }
+
+  if(val > 255)
+  {
+    val = 255;
+  }
+
+  return val;
+}
+
+
+static void emu_out_block_hdr(int sz)
+{
+  char hdr[32];
+
+  snprintf(hdr, 32, "#9%09i", sz);
+
+  emu_out_str(hdr);
+}
+
+
+static void emu_wav_data(void)
+{
+  int i, chn, n, start, stop;
+
+  unsigned int seed;
+
+  double dt, t0, timescale, timeoffset, srate;
+
+  const char *mode;
+
+  chn = emu_source_chn();
+
+  timescale = emu_get_dbl("TIM:SCAL", 1e-4);
+
+  timeoffset = emu_get_dbl("TIM:OFFS", 0);
+
+  mode = emu_get("WAV:MODE");
+
+  seed = (emu.acq_cnt * 7919) + chn;
+
+  if((mode != NULL) && (!strcmp(mode, "RAW")))
+  {
+    srate = emu_samplerate();
+
+    start = emu_get_dbl("WAV:STAR", 1);
+
+    stop = emu_get_dbl("WAV:STOP", 1200);
+
+    if(start < 1)
+    {
+      start = 1;
+    }
+
+    if(stop > emu_get_dbl("ACQ:MDEP", 12000))
+    {
+      stop = emu_get_dbl("ACQ:MDEP", 12000);
+    }
+
+    n = stop - start + 1;
+
+    if(n > EMU_RAW_MAX_PNTS)
+    {
+      n = EMU_RAW_MAX_PNTS;
+    }
+
+    if(n < 0)
+    {
+      n = 0;
+    }
+
+    dt = 1.0 / srate;
+
+    t0 = timeoffset - (emu_get_dbl("ACQ:MDEP", 12000) * dt / 2) + ((start - 1) * dt);
+  }
+  else
+  {
+    n = emu_norm_points();
+
+    dt = (12.0 * timescale) / n;
+
+    t0 = timeoffset - (6.0 * timescale);
+  }
+
+  emu_out_block_hdr(n);
+
+  emu_out_reserve(n + 1);
+
+  for(i=0; i<n; i++)
+  {
+    emu.outbuf[emu.out_len++] = emu_sample(chn, t0 + (i * dt), &seed);
+  }
+}
+
+
+static void emu_put_le(unsigned char *buf, unsigned int val, int bytes)
+{
+  int i;
+
+  for(i=0; i<bytes; i++)
+  {
+    buf[i] = (val >> (i * 8)) & 0xff;
+  }
+}
+
+
+static void emu_disp_data(void)
+{
+  int x, y, chn, sample, py;
+
+  unsigned char *bmp;
+
+  unsigned int seed;
+
+  static const unsigned char colors[EMU_MAX_CHNS][3]={{0x33, 0xff, 0xff},  /* BGR */
+                                                     {0xff, 0xff, 0x33},
+                                                     {0xff, 0x33, 0xff},
+                                                     {0xff, 0x80, 0x00}};
+
+  emu_out_block_hdr(EMU_BMP_SZ);
+
+  emu_out_reserve(EMU_BMP_SZ + 1);
+
+  bmp = emu.outbuf + emu.out_len;
+
+  memset(bmp, 0, EMU_BMP_SZ);
+
+  bmp[0] = 'B';
+  bmp[1] = 'M';
+  emu_put_le(bmp + 2, EMU_BMP_SZ, 4);
+  emu_put_le(bmp + 10, 54, 4);
+  emu_put_le(bmp + 14, 40, 4);
+  emu_put_le(bmp + 18, EMU_BMP_WIDTH, 4);
+  emu_put_le(bmp + 22, EMU_BMP_HEIGHT, 4);
+  emu_put_le(bmp + 26, 1, 2);
+  emu_put_le(bmp + 28, 24, 2);
+  emu_put_le(bmp + 34, EMU_BMP_WIDTH * EMU_BMP_HEIGHT * 3, 4);
+
+  for(chn=0; chn<EMU_MAX_CHNS; chn++)
+  {
+    seed = emu.acq_cnt + chn;
+
+    for(x=0; x<EMU_BMP_WIDTH; x++)
+    {
+      sample = emu_sample(chn, (x - (EMU_BMP_WIDTH / 2)) * (12.0 * emu_get_dbl("TIM:SCAL", 1e-4)) / EMU_BMP_WIDTH, &seed);
+
+      py = (sample * (EMU_BMP_HEIGHT - 1)) / 255;
+
+      for(y=py-1; y<=py+1; y++)
+      {
+        if((y < 0) || (y >= EMU_BMP_HEIGHT))
+        {
+          continue;
+        }
+
+        memcpy(bmp + 54 + (((y * EMU_BMP_WIDTH) + x) * 3), colors[chn], 3);
+      }
+    }
+  }
+
+  emu.out_len += EMU_BMP_SZ;
+}
+
+
+static void emu_out_dbl(double val)
+{
+  char str[64];
+
+  snprintf(str, 64, "%e", val);
+
+  emu_out_str(str);
+}
+
+
+/* handles a query, the key is normalized and without the question mark */
+static void emu_query(const char *key)
+{
+  int chn;
+
+  char str[EMU_KEY_LEN],
+       pre[256];
+
+  const char *val;
+
+  if(emu_key_is(key, "*IDN"))
+  {
+    snprintf(pre, 256, "RIGOL TECHNOLOGIES,%s,DS1ZE000000001,00.04.04.SP4", emu.model);
+    emu_out_str(pre);
+  }
+  else if(emu_key_is(key, "*OPC"))
+    {
+      emu_out_str("1");
+    }
+    else if(emu_key_is(key, "TRIG:STAT"))
+      {
+        if(emu.running == 1)
+        {
+          emu.acq_cnt++;
+
+          emu_out_str("TD");
+        }
+        else if(emu.running == 2)
+          {
+            if(++emu.single_cnt > 10)
+            {
+              emu.acq_cnt++;
+
+              emu.running = 0;
+            }
+
+            emu_out_str("WAIT");
+          }
+          else
+          {
+            emu_out_str("STOP");
+          }
+      }
+      else if(emu_key_is(key, "ACQ:SRAT"))
+        {
+          emu_out_dbl(emu_samplerate());
+        }
+        else if(emu_key_is(key, "MEAS:COUN:VAL"))
+          {
+            emu_out_dbl(1000.0);
+          }
+          else if(emu_key_is(key, "WAV:DATA"))
+            {
+              emu_wav_data();
+            }
+            else if(emu_key_is(key, "DISP:DATA"))
+              {
+                emu_disp_data();
+              }
+              else if(emu_key_is(key, "WAV:XOR"))
+                {
+                  emu_out_dbl(emu_get_dbl("TIM:OFFS", 0) - (6.0 * emu_get_dbl("TIM:SCAL", 1e-4)));
+                }
+                else if(emu_key_is(key, "WAV:YINC"))
+                  {
+                    snprintf(str, EMU_KEY_LEN, "CHAN%i:SCAL", emu_source_chn() + 1);
+                    emu_out_dbl(emu_get_dbl(str, 1) / 25.0);
+                  }
+                  else if(emu_key_is(key, "WAV:YREF"))
+                    {
+                      emu_out_str("127");
+                    }
+                    else if(emu_key_is(key, "WAV:YOR"))
+                      {
+                        emu_out_str("0");
+                      }
+                      else if(emu_key_is(key, "WAV:PRE"))
+                        {
+                          chn = emu_source_chn();
+                          snprintf(str, EMU_KEY_LEN, "CHAN%i:SCAL", chn + 1);
+                          snprintf(pre, 256, "0,0,%i,1,%e,%e,0,%e,0,127",
+                                   emu_norm_points(),
+                                   (12.0 * emu_get_dbl("TIM:SCAL", 1e-4)) / emu_norm_points(),
+                                   emu_get_dbl("TIM:OFFS", 0) - (6.0 * emu_get_dbl("TIM:SCAL", 1e-4)),
+                                   emu_get_dbl(str, 1) / 25.0);
+                          emu_out_str(pre);
+                        }
+                        else
+                        {
+                          val = emu_get(key);
+                          if(val == NULL)
+                          {
+                            emu_out_str("0");
+                          }
+                          else
+                          {
+                            emu_out_str(val);
+                          }
+                        }
+}
+
+
+/* handles a setter, the key is normalized, val can be empty */
+static void emu_command(const char *key, const char *val)
+{
+  const char *prev;
+
+  if(emu_key_is(key, "*RST"))
+  {
+    emu_reset();
+  }
+  else if(emu_key_is(key, "RUN"))
+    {
+      emu.running = 1;
+    }
+    else if(emu_key_is(key, "STOP"))
+      {
+        emu.running = 0;
+      }
+      else if(emu_key_is(key, "SING"))
+        {
+          emu.running = 2;
+
+          emu.single_cnt = 0;
+
+          emu_set("TRIG:SWE", "SING");
+        }
+        else if(val[0])
+          {
+            prev = emu_get(key);
+
+            /* booleans are returned as 0 or 1 */
+            if((prev != NULL) && ((!strcmp(prev, "0")) || (!strcmp(prev, "1"))))
+            {
+              if(!strcmp(val, "ON"))
+              {
+                val = "1";
+              }
+              else if(!strcmp(val, "OFF"))
+                {
+                  val = "0";
+                }
+            }
+
+            emu_set(key, val);
+
+            if(emu_key_is(key, "TRIG:SWE") && strcmp(val, "SING"))
+            {
+              emu.running = 1;
+            }
+          }
+}
+
+
+/* handles one line that can contain several commands separated by ';' */
+static void emu_line(char *line)
+{
+  int len, queries=0;
+
+  char *cmd, *next, *arg, key[EMU_KEY_LEN], subsys[EMU_KEY_LEN]="", full[EMU_KEY_LEN * 2];
+
+  for(cmd=line; cmd!=NULL; cmd=next)
+  {
+    next = strchr(cmd, ';');
+    if(next != NULL)
+    {
+      *next++ = 0;
+    }
+
+    while(isspace((unsigned char)*cmd))
+    {
+      cmd++;
+    }
+
+    len = strlen(cmd);
+
+    while(len && isspace((unsigned char)cmd[len - 1]))
+    {
+      cmd[--len] = 0;
+    }
+
+    if(!len)
+    {
+      continue;
+    }
+
+    arg = cmd;
+
+    while(*arg && !isspace((unsigned char)*arg))
+    {
+      arg++;
+    }
+
+    if(*arg)
+    {
+      *arg++ = 0;
+
+      while(isspace((unsigned char)*arg))
+      {
+        arg++;
+      }
+    }
+
+    /* a command without leading colon or star is relative to the previous subsystem */
+    if((cmd[0] != ':') && (cmd[0] != '*') && subsys[0])
+    {
+      snprintf(full, EMU_KEY_LEN * 2, "%s:%s", subsys, cmd);
+    }
+    else
+    {
+      strncpy(full, cmd, EMU_KEY_LEN * 2 - 1);
+      full[EMU_KEY_LEN * 2 - 1] = 0;
+    }
+
+    len = strlen(full);
+
+    if(full[0] == '*')
+    {
+      strncpy(key, full, EMU_KEY_LEN - 1);
+      key[EMU_KEY_LEN - 1] = 0;
+
+      len = strlen(key);
+
+      if(len && (key[len - 1] == '?'))
+      {
+        key[len - 1] = 0;
+      }
+
+      for(len=0; key[len]; len++)
+      {
+        key[len] = toupper((unsigned char)key[len]);
+      }
+    }
+    else
+    {
+      if(len && (full[len - 1] == '?'))
+      {
+        full[len - 1] = 0;
+      }
+
+      emu_normalize_key(key, full, EMU_KEY_LEN);
+
+      strncpy(subsys, key, EMU_KEY_LEN - 1);
+      subsys[EMU_KEY_LEN - 1] = 0;
+
+      if(strrchr(subsys, ':') != NULL)
+      {
+        *strrchr(subsys, ':') = 0;
+      }
+      else
+      {
+        subsys[0] = 0;
+      }
+    }
+
+    if(cmd[strlen(cmd) - 1] == '?')
+    {
+      if(queries++)
+      {
+        emu_out_str(";");
+      }
+
+      emu_query(key);
+    }
+    else
+    {
+      emu_command(key, arg);
+    }
+  }
+
+  if(queries)
+  {
+    emu_out_str("\n");
+  }
+}
+
+
+static long long emu_get_usec(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+
+  return (ts.tv_sec * 1000000LL) + (ts.tv_nsec / 1000LL);
+}
+
+
+/* sends the output buffer, paced to the configured bandwidth */
+static int emu_flush(int fd)
+{
+  int n, chunk, sent=0;
+
+  long long t_start, t_due, t_wait;
+
+  if(!emu.out_len)
+  {
+    return 0;
+  }
+
+  if(emu.latency > 0)
+  {
+    usleep(emu.latency);
+  }
+
+  t_start = emu_get_usec();
+
+  while(sent < emu.out_len)
+  {
+    chunk = emu.out_len - sent;
+
+    if((emu.bandwidth > 0) && (chunk > 65536))
+    {
+      chunk = 65536;
+    }
+
+    n = send(fd, emu.outbuf + sent, chunk, 0);  /* SIGPIPE is ignored */
+    if(n < 1)
+    {
+      return -1;
+    }
+
+    sent += n;
+
+    if(emu.bandwidth > 0)
+    {
+      t_due = t_start + (long long)(sent * 1e6 / emu.bandwidth);
+
+      t_wait = t_due - emu_get_usec();
+
+      if(t_wait > 0)
+      {
+        usleep(t_wait);
+      }
+    }
+  }
+
+  emu.out_len = 0;
+
+  return 0;
+}
+
+
+static void emu_serve(int fd)
+{
+  int n, len=0, i, start;
+
+  char buf[EMU_MAX_LINE + 1];
+
+  while(1)
+  {
+    n = recv(fd, buf + len, EMU_MAX_LINE - len, 0);
+    if(n < 1)
+    {
+      return;
+    }
+
+    len += n;
+
+    for(i=0, start=0; i<len; i++)
+    {
+      if(buf[i] == '\n')
+      {
+        buf[i] = 0;
+
+        emu_line(buf + start);
+
+        if(emu_flush(fd))
+        {
+          return;
+        }
+
+        start = i + 1;
+      }
+    }
+
+    if(start)
+    {
+      memmove(buf, buf + start, len - start);
+
+      len -= start;
+    }
+    else if(len >= EMU_MAX_LINE)
+      {
+        len = 0;  /* line too long, discard */
+      }
+  }
+}
+
+
+int main(int argc, char **argv)
+{
+  int i, sockfd, fd, port=EMU_DEFAULT_PORT, one=1;
+
+  char address[64]="0.0.0.0";
+
+  struct sockaddr_in inet_address;
+
+  memset(&emu, 0, sizeof(emu));
+
+  strcpy(emu.model, "DS1054Z");
+
+  emu.uart_baud = 115200;
+
+  emu.spi_clk = 250000;
+
+  for(i=1; i<argc; i++)
+  {
+    if((i + 1) >= argc)
+    {
+      fprintf(stderr, "usage: %s [-a address] [-p port] [-l latency_us] [-b bytes_per_sec] [-u baud] [-s spi_clk_hz] [-m model]\n", argv[0]);
+
+      return EXIT_FAILURE;
+    }
+
+    if(!strcmp(argv[i], "-a"))
+    {
+      strncpy(address, argv[++i], 63);
+    }
+    else if(!strcmp(argv[i], "-p"))
+      {
+        port = atoi(argv[++i]);
+      }
+      else if(!strcmp(argv[i], "-l"))
+        {
+          emu.latency = atoi(argv[++i]);
+        }
+        else if(!strcmp(argv[i], "-b"))
+          {
+            emu.bandwidth = atof(argv[++i]);
+          }
+          else if(!strcmp(argv[i], "-u"))
+            {
+              emu.uart_baud = atoi(argv[++i]);
+            }
+            else if(!strcmp(argv[i], "-s"))
+              {
+                emu.spi_clk = atoi(argv[++i]);
+              }
+              else if(!strcmp(argv[i], "-m"))
+                {
+                  strncpy(emu.model, argv[++i], 63);
+                }
+                else
+                {
+                  fprintf(stderr, "unknown option: %s\n", argv[i]);
+
+                  return EXIT_FAILURE;
+                }
+  }
+
+  if((emu.uart_baud < 1) || (emu.spi_clk < 1))
+  {
+    fprintf(stderr, "invalid baudrate or SPI clock\n");
+
+    return EXIT_FAILURE;
+  }
+
+  signal(SIGPIPE, SIG_IGN);
+
+  emu_reset();
+
+  sockfd = socket(PF_INET, SOCK_STREAM, 0);
+  if(sockfd == -1)
+  {
+    perror("socket()");
+
+    return EXIT_FAILURE;
+  }
+
+  setsockopt(sockfd, SOL_SOCKET, SO_REUSEADDR, (void *)&one, sizeof one);
+
+  memset(&inet_address, 0, sizeof(struct sockaddr_in));
+
+  inet_address.sin_family = AF_INET;
+  inet_address.sin_port = htons(port);
+  if(inet_aton(address, &inet_address.sin_addr) == 0)
+  {
+    fprintf(stderr, "invalid address: %s\n", address);
+
+    return EXIT_FAILURE;
+  }
+
+  if(bind(sockfd, (struct sockaddr *)&inet_address, sizeof(struct sockaddr_in)))
+  {
+    perror("bind()");
+
+    return EXIT_FAILURE;
+  }
+
+  if(listen(sockfd, 1))
+  {
+    perror("listen()");
+
+    return EXIT_FAILURE;
+  }
+
+  printf("Emulating a %s on %s:%i\n", emu.model, address, port);
+
+  while(1)
+  {
+    fd = accept(sockfd, NULL, NULL);
+    if(fd == -1)
+    {
+      if(errno == EINTR)
+      {
+        continue;
+      }
+
+      perror("accept()");
+
+      break;
+    }
+
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, (void *)&one, sizeof one);
+
+    printf("Client connected\n");
+
+    emu_serve(fd);
+
+    close(fd);
+
+    emu.out_len = 0;
+
+    printf("Client disconnected\n");
+  }
+
+  close(sockfd);
+
+  free(emu.outbuf);
+
+  return EXIT_SUCCESS;
+}
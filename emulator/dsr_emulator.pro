@@ -0,0 +1,18 @@
+
+TEMPLATE = app
+TARGET = dsr_emulator
+
+CONFIG -= qt
+CONFIG -= app_bundle
+CONFIG += console
+CONFIG += warn_on
+CONFIG += release
+
+OBJECTS_DIR = ./objects
+
+SOURCES += dsr_emulator.c
+
+LIBS += -lm
+
+QMAKE_CFLAGS += -Wall -Wextra -Wshadow -Wformat-nonliteral -Wformat-security -Wtype-limits -Wfatal-errors
+
@@ -0,0 +1,622 @@
+/*
+***************************************************************************
+*
+* Author: Teunis van Beelen
+*
+* Copyright (C) 2015 - 2024 Teunis van Beelen
+*
+* Email: teuniz@protonmail.com
+*
+***************************************************************************
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+***************************************************************************
+*/
+
+
+
+
+
+#include "fft_stage.h"
+
+
+#define SPECT_LOG_MINIMUM (0.00000001)
+#define SPECT_LOG_MINIMUM_LOG (-80)
+
+
+fft_stage::fft_stage()
+{
+  int i;
+
+  memset(plans, 0, sizeof(plans));
+
+  for(i=0; i<FFT_PLAN_CACHE_SZ; i++)
+  {
+    plans[i].win_type = -1;
+  }
+
+  plan_next = 0;
+
+  in_buf = NULL;
+  in_bufsz = 0;
+  in_n = 0;
+  memset(&in_params, 0, sizeof(in_params));
+  in_req = 0;
+  reset_req = 0;
+  quit_req = 0;
+
+  rec = NULL;
+  recsz = 0;
+  work_in = NULL;
+  work_out = NULL;
+  worksz = 0;
+
+  result = (double *)calloc(1, FFT_MAX_BUFSZ * sizeof(double));
+  result_bins = 0;
+  result_seq = 0;
+
+  power = (double *)calloc(1, FFT_MAX_BUFSZ * sizeof(double));
+  avg_sum = (double *)calloc(1, FFT_MAX_BUFSZ * sizeof(double));
+  spect = (double *)calloc(1, FFT_MAX_BUFSZ * sizeof(double));
+
+  for(i=0; i<FFT_AVG_MAX_CNT; i++)
+  {
+    avg_ring[i] = (double *)calloc(1, FFT_MAX_BUFSZ * sizeof(double));
+  }
+
+  avg_idx = 0;
+  avg_fill = 0;
+  memset(&avg_params, 0, sizeof(avg_params));
+}
+
+
+fft_stage::~fft_stage()
+{
+  int i;
+
+  request_quit();
+
+  wait();
+
+  for(i=0; i<FFT_PLAN_CACHE_SZ; i++)
+  {
+    free(plans[i].cfg);
+    free(plans[i].win);
+  }
+
+  for(i=0; i<FFT_AVG_MAX_CNT; i++)
+  {
+    free(avg_ring[i]);
+  }
+
+  free(in_buf);
+  free(rec);
+  free(work_in);
+  free(work_out);
+  free(result);
+  free(power);
+  free(avg_sum);
+  free(spect);
+}
+
+
+void fft_stage::submit(const unsigned char *buf, int n, const struct fft_stage_params *p)
+{
+  unsigned char *tmp;
+
+  if(n > FFT_STAGE_MAX_N)
+  {
+    n = FFT_STAGE_MAX_N;
+  }
+
+  mtx.lock();
+
+  if(n > in_bufsz)
+  {
+    tmp = (unsigned char *)realloc(in_buf, n);
+    if(tmp == NULL)
+    {
+      mtx.unlock();
+
+      return;
+    }
+
+    in_buf = tmp;
+
+    in_bufsz = n;
+  }
+
+  memcpy(in_buf, buf, n);
+
+  in_n = n;
+
+  in_params = *p;
+
+  in_req = 1;
+
+  if(!isRunning())
+  {
+    start();
+  }
+
+  cond.wakeOne();
+
+  mtx.unlock();
+}
+
+
+int fft_stage::get_spectrum(double *dest, int bins, unsigned int *seq)
+{
+  int ret=0;
+
+  mtx.lock();
+
+  if((result_bins == bins) && (bins > 0))
+  {
+    memcpy(dest, result, bins * sizeof(double));
+
+    *seq = result_seq;
+
+    ret = 1;
+  }
+
+  mtx.unlock();
+
+  return ret;
+}
+
+
+void fft_stage::reset()
+{
+  mtx.lock();
+
+  reset_req = 1;
+
+  result_bins = 0;
+
+  mtx.unlock();
+}
+
+
+void fft_stage::request_quit()
+{
+  mtx.lock();
+
+  quit_req = 1;
+
+  cond.wakeAll();
+
+  mtx.unlock();
+}
+
+
+void fft_stage::run()
+{
+  int n, tmp_sz;
+
+  unsigned char *tmp;
+
+  struct fft_stage_params p;
+
+  while(1)
+  {
+    mtx.lock();
+
+    while((!in_req) && (!quit_req))
+    {
+      cond.wait(&mtx);
+    }
+
+    if(quit_req)
+    {
+      mtx.unlock();
+
+      break;
+    }
+
+    // take over the record by swapping the buffers, no copy needed
+    tmp = rec;
+    rec = in_buf;
+    in_buf = tmp;
+
+    tmp_sz = recsz;
+    recsz = in_bufsz;
+    in_bufsz = tmp_sz;
+
+    n = in_n;
+
+    p = in_params;
+
+    in_req = 0;
+
+    if(reset_req)
+    {
+      avg_fill = 0;
+
+      reset_req = 0;
+    }
+
+    mtx.unlock();
+
+    if(process(n, &p))
+    {
+      continue;
+    }
+
+    mtx.lock();
+
+    memcpy(result, spect, p.bins * sizeof(double));
+
+    result_bins = p.bins;
+
+    result_seq++;
+
+    mtx.unlock();
+  }
+}
+
+
+// fills win with n coefficients of window type, returns the sum of the coefficients
+double fft_window_fill(double *win, int n, int type)
+{
+  int i;
+
+  double x, sum=0;
+
+  for(i=0; i<n; i++)
+  {
+    x = (2.0 * M_PI * i) / (n - 1);
+
+    if(type == FFT_WIN_HANN)
+    {
+      win[i] = 0.5 - (0.5 * cos(x));
+    }
+    else if(type == FFT_WIN_BLACKMAN_HARRIS)
+      {
+        win[i] = 0.35875 - (0.48829 * cos(x)) + (0.14128 * cos(2.0 * x)) - (0.01168 * cos(3.0 * x));
+      }
+      else if(type == FFT_WIN_FLATTOP)  // amplitude accurate within 0.01dB
+        {
+          win[i] = 0.21557895 - (0.41663158 * cos(x)) + (0.277263158 * cos(2.0 * x))
+                   - (0.083578947 * cos(3.0 * x)) + (0.006947368 * cos(4.0 * x));
+        }
+        else
+        {
+          win[i] = 1.0;
+        }
+
+    sum += win[i];
+  }
+
+  return sum;
+}
+
+
+// plans are cached by length, a screen length that was used before
+// doesn't need a new allocation
+struct fft_stage::fft_plan * fft_stage::get_plan(int nfft)
+{
+  int i;
+
+  struct fft_plan *plan;
+
+  for(i=0; i<FFT_PLAN_CACHE_SZ; i++)
+  {
+    if((plans[i].nfft == nfft) && (plans[i].cfg != NULL))
+    {
+      return &plans[i];
+    }
+  }
+
+  plan = &plans[plan_next];
+
+  plan_next = (plan_next + 1) % FFT_PLAN_CACHE_SZ;
+
+  free(plan->cfg);
+
+  plan->cfg = kiss_fftr_alloc(nfft, 0, NULL, NULL);
+  if(plan->cfg == NULL)
+  {
+    plan->nfft = 0;
+
+    return NULL;
+  }
+
+  plan->nfft = nfft;
+
+  plan->win_type = -1;
+
+  return plan;
+}
+
+
+void fft_stage::set_window(struct fft_plan *plan, int type, int n)
+{
+  double *tmp;
+
+  if((plan->win_type == type) && (plan->win_n == n))
+  {
+    return;
+  }
+
+  plan->win_type = FFT_WIN_RECT;
+  plan->win_n = n;
+  plan->win_sum = n;
+
+  if(type == FFT_WIN_RECT)
+  {
+    return;
+  }
+
+  tmp = (double *)realloc(plan->win, n * sizeof(double));
+  if(tmp == NULL)
+  {
+    return;
+  }
+
+  plan->win = tmp;
+
+  plan->win_sum = fft_window_fill(plan->win, n, type);
+
+  plan->win_type = type;
+}
+
+
+// returns 0 when spect contains the new spectrum
+int fft_stage::process(int n, const struct fft_stage_params *p)
+{
+  int i, j, k, nfft, half, cnt;
+
+  double norm, step, pos, frac, *pw, *tmp_in;
+
+  kiss_fft_cpx *tmp_out;
+
+  struct fft_plan *plan;
+
+  if((n < 32) || (p->bins < 2) || (p->bins > FFT_MAX_BUFSZ) || (p->sf <= 0))
+  {
+    return -1;
+  }
+
+  // zero padded to a length kiss_fft handles fast
+  nfft = kiss_fftr_next_fast_size_real(n);
+
+  half = nfft / 2;
+
+  if(nfft > worksz)
+  {
+    tmp_in = (double *)realloc(work_in, nfft * sizeof(double));
+    if(tmp_in == NULL)
+    {
+      return -1;
+    }
+
+    work_in = tmp_in;
+
+    tmp_out = (kiss_fft_cpx *)realloc(work_out, (half + 1) * sizeof(kiss_fft_cpx));
+    if(tmp_out == NULL)
+    {
+      return -1;
+    }
+
+    work_out = tmp_out;
+
+    worksz = nfft;
+  }
+
+  plan = get_plan(nfft);
+  if(plan == NULL)
+  {
+    return -1;
+  }
+
+  set_window(plan, p->window, n);
+
+  sconv_u8_to_double(work_in, rec, n, 127, p->y_incr);
+
+  if(plan->win_type != FFT_WIN_RECT)
+  {
+    for(i=0; i<n; i++)
+    {
+      work_in[i] *= plan->win[i];
+    }
+  }
+
+  for(i=n; i<nfft; i++)
+  {
+    work_in[i] = 0;
+  }
+
+  kiss_fftr(plan->cfg, work_in, work_out);
+
+  // power in Vrms^2 per bin, corrected for the gain of the window
+  norm = 2.0 / (plan->win_sum * plan->win_sum);
+
+  for(i=0; i<=half; i++)
+  {
+    work_in[i] = ((work_out[i].r * work_out[i].r) + (work_out[i].i * work_out[i].i)) * norm;
+  }
+
+  work_in[0] /= 2.0;  // DC!
+
+  // the output always has bins bins from 0 to f_span, other record lengths are resampled,
+  // a record with a higher samplerate than the screen gives more resolution on the same axis
+  if((half == p->bins) && ((p->f_span <= 0) || (p->f_span >= (p->sf / 2.0))))
+  {
+    memcpy(power, work_in, p->bins * sizeof(double));
+  }
+  else
+  {
+    step = (double)half / (double)p->bins;
+
+    if((p->f_span > 0) && (p->f_span < (p->sf / 2.0)))
+    {
+      step *= p->f_span / (p->sf / 2.0);
+    }
+
+    if(step > 1.0)  // more fft bins than output bins, keep the peak so a narrow spur stays visible
+    {
+      for(k=0; k<p->bins; k++)
+      {
+        i = k * step;
+
+        j = (k + 1) * step;
+
+        if(j > half)
+        {
+          j = half;
+        }
+
+        power[k] = work_in[i];
+
+        for(i++; i<j; i++)
+        {
+          if(work_in[i] > power[k])
+          {
+            power[k] = work_in[i];
+          }
+        }
+      }
+    }
+    else
+    {
+      for(k=0; k<p->bins; k++)
+      {
+        pos = k * step;
+
+        i = pos;
+
+        frac = pos - i;
+
+        power[k] = work_in[i] + ((work_in[i + 1] - work_in[i]) * frac);
+      }
+    }
+  }
+
+////////////////////////////// averaging //////////////////////////////
+
+  if((avg_params.src != p->src) || (avg_params.bins != p->bins) || (avg_params.window != p->window) ||
+     (avg_params.avg_mode != p->avg_mode) || (avg_params.avg_cnt != p->avg_cnt) ||
+     (avg_params.y_incr != p->y_incr) || (avg_params.sf != p->sf) || (avg_params.f_span != p->f_span))
+  {
+    avg_fill = 0;
+
+    avg_params = *p;
+  }
+
+  cnt = p->avg_cnt;
+
+  if(cnt > FFT_AVG_MAX_CNT)
+  {
+    cnt = FFT_AVG_MAX_CNT;
+  }
+
+  pw = power;
+
+  if((p->avg_mode == FFT_AVG_EXP) && (cnt > 1))
+  {
+    // starts as a linear average until cnt spectra are in
+    if(avg_fill < cnt)
+    {
+      avg_fill++;
+    }
+
+    if(avg_fill == 1)
+    {
+      memcpy(avg_sum, power, p->bins * sizeof(double));
+    }
+    else
+    {
+      for(k=0; k<p->bins; k++)
+      {
+        avg_sum[k] += (power[k] - avg_sum[k]) / avg_fill;
+      }
+    }
+
+    pw = avg_sum;
+  }
+  else if((p->avg_mode == FFT_AVG_LIN) && (cnt > 1))
+    {
+      if(avg_fill == 0)
+      {
+        avg_idx = 0;
+      }
+
+      memcpy(avg_ring[avg_idx], power, p->bins * sizeof(double));
+
+      avg_idx = (avg_idx + 1) % cnt;
+
+      if(avg_fill < cnt)
+      {
+        avg_fill++;
+      }
+
+      memset(avg_sum, 0, p->bins * sizeof(double));
+
+      for(i=0; i<avg_fill; i++)
+      {
+        for(k=0; k<p->bins; k++)
+        {
+          avg_sum[k] += avg_ring[i][k];
+        }
+      }
+
+      for(k=0; k<p->bins; k++)
+      {
+        avg_sum[k] /= avg_fill;
+      }
+
+      pw = avg_sum;
+    }
+
+////////////////////////////// unit //////////////////////////////
+
+  if(p->unit)  // dBm
+  {
+    for(k=0; k<p->bins; k++)
+    {
+      spect[k] = (pw[k] < SPECT_LOG_MINIMUM) ? SPECT_LOG_MINIMUM : pw[k];
+    }
+
+    // convert to deciBel's, not to Bel's!
+    for(k=0; k<p->bins; k++)
+    {
+      spect[k] = log10(spect[k]) * 10.0;
+    }
+
+    for(k=0; k<p->bins; k++)
+    {
+      if(spect[k] < SPECT_LOG_MINIMUM_LOG)
+      {
+        spect[k] = SPECT_LOG_MINIMUM_LOG;
+      }
+    }
+  }
+  else  // Vrms
+  {
+    for(k=0; k<p->bins; k++)
+    {
+      spect[k] = sqrt(pw[k]);
+    }
+  }
+
+  return 0;
+}
+
+
+
+
+
+
@@ -0,0 +1,160 @@
+/*
+***************************************************************************
+*
+* Author: Teunis van Beelen
+*
+* Copyright (C) 2015 - 2024 Teunis van Beelen
+*
+* Email: teuniz@protonmail.com
+*
+***************************************************************************
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+***************************************************************************
+*/
+
+
+
+#ifndef DEF_FFT_STAGE_H
+#define DEF_FFT_STAGE_H
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+
+#include "global.h"
+#include "sample_conv.h"
+
+#include "third_party/kiss_fft/kiss_fftr.h"
+
+
+#define FFT_WIN_RECT             (0)
+#define FFT_WIN_HANN             (1)
+#define FFT_WIN_BLACKMAN_HARRIS  (2)
+#define FFT_WIN_FLATTOP          (3)
+
+#define FFT_AVG_OFF  (0)
+#define FFT_AVG_EXP  (1)  /* exponential, the weight of a new spectrum is 1 / avg_cnt */
+#define FFT_AVG_LIN  (2)  /* mean of the last avg_cnt spectra */
+
+#define FFT_AVG_MAX_CNT  (16)
+
+#define FFT_PLAN_CACHE_SZ  (4)
+#define FFT_STAGE_MAX_N    (1 << 22)  /* longer records are truncated */
+
+
+struct fft_stage_params
+{
+  int src;            /* channel, only used to detect a change */
+  int bins;           /* number of output bins, from 0 to sf / 2 */
+  int unit;           /* 0 = Vrms, 1 = dB */
+  int window;         /* FFT_WIN_xxx */
+  int avg_mode;       /* FFT_AVG_xxx */
+  int avg_cnt;
+  double y_incr;      /* volts per count */
+  double sf;          /* samplerate of the record */
+  double f_span;      /* frequency of the last bin, 0 is sf / 2 */
+};
+
+
+double fft_window_fill(double *, int, int);
+
+
+/*
+ * Computes the spectrum of the screen data in its own thread, so the
+ * screen thread can start the next download right away. Only the most
+ * recent record is kept, a record that arrives while the previous one
+ * is still being transformed replaces the one that is waiting.
+ */
+class fft_stage : public QThread
+{
+public:
+
+  fft_stage();
+  ~fft_stage();
+
+  /* copies the record, any thread */
+  void submit(const unsigned char *, int, const struct fft_stage_params *);
+
+  /* copies the latest spectrum and its sequence number, returns 0 if there is none with that number of bins */
+  int get_spectrum(double *, int, unsigned int *);
+
+  /* restarts the averaging with the next record */
+  void reset();
+
+  void request_quit();
+
+private:
+
+  struct fft_plan
+  {
+    int nfft;
+    kiss_fftr_cfg cfg;
+    int win_type;
+    int win_n;
+    double *win;
+    double win_sum;
+  } plans[FFT_PLAN_CACHE_SZ];
+
+  int plan_next;
+
+  QMutex mtx;
+  QWaitCondition cond;
+
+  /* protected by mtx */
+  unsigned char *in_buf;
+  int in_bufsz;
+  int in_n;
+  struct fft_stage_params in_params;
+  int in_req;
+  int reset_req;
+  int quit_req;
+  double *result;
+  int result_bins;
+  unsigned int result_seq;  /* incremented for every new spectrum */
+
+  /* only used by the thread */
+  unsigned char *rec;
+  int recsz;
+  double *work_in;
+  kiss_fft_cpx *work_out;
+  int worksz;
+  double *power;
+  double *avg_ring[FFT_AVG_MAX_CNT];
+  double *avg_sum;
+  double *spect;
+  int avg_idx;
+  int avg_fill;
+  struct fft_stage_params avg_params;
+
+  void run();
+
+  struct fft_plan * get_plan(int);
+
+  void set_window(struct fft_plan *, int, int);
+
+  int process(int, const struct fft_stage_params *);
+};
+
+
+#endif
+
+
@@ -0,0 +1,165 @@
+/*
+***************************************************************************
+*
+* Author: Teunis van Beelen
+*
+* Copyright (C) 2015 - 2024 Teunis van Beelen
+*
+* Email: teuniz@protonmail.com
+*
+***************************************************************************
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+***************************************************************************
+*/
+
+
+
+#include "frame_policy.h"
+
+
+#define FPOL_DECAY  (0.875)
+
+/* hysteresis, RAW is chosen when the screen fits in 80% of the budget
+   and kept until it needs more than 110% */
+#define FPOL_UP_MARGIN    (0.8)
+#define FPOL_DOWN_MARGIN  (1.1)
+
+
+void fpol_init(struct frame_policy *pol)
+{
+  pol->bw = 0;
+  pol->sum_bytes = 0;
+  pol->sum_usec = 0;
+  pol->fixed_usec = 0;
+  pol->xfer_usec = 0;
+  pol->bw_valid = 0;
+  pol->fixed_valid = 0;
+  pol->mode = FPOL_MODE_NORM;
+  pol->pnts = 0;
+}
+
+
+// the bandwidth is the ratio of the decayed sums of bytes and time, a big
+// transfer weighs more than a small one where the round trip dominates
+void fpol_add_transfer(struct frame_policy *pol, int bytes, long long usec, int lat_usec)
+{
+  double net;
+
+  if((bytes < 1) || (usec < 1))
+  {
+    return;
+  }
+
+  net = usec - lat_usec;
+
+  if(net < (usec / 4.0))
+  {
+    net = usec / 4.0;
+  }
+
+  pol->sum_bytes = (pol->sum_bytes * FPOL_DECAY) + bytes;
+
+  pol->sum_usec = (pol->sum_usec * FPOL_DECAY) + net;
+
+  pol->bw = (pol->sum_bytes * 1e6) / pol->sum_usec;
+
+  if(pol->bw_valid)
+  {
+    pol->xfer_usec += (lat_usec - pol->xfer_usec) * (1.0 - FPOL_DECAY);
+  }
+  else
+  {
+    pol->xfer_usec = lat_usec;
+  }
+
+  pol->bw_valid = 1;
+}
+
+
+void fpol_add_frame(struct frame_policy *pol, long long usec, long long xfer_usec)
+{
+  double fixed;
+
+  fixed = usec - xfer_usec;
+
+  if(fixed < 0)
+  {
+    fixed = 0;
+  }
+
+  if(pol->fixed_valid)
+  {
+    pol->fixed_usec += (fixed - pol->fixed_usec) * (1.0 - FPOL_DECAY);
+  }
+  else
+  {
+    pol->fixed_usec = fixed;
+
+    pol->fixed_valid = 1;
+  }
+}
+
+
+int fpol_budget(const struct frame_policy *pol, int chns, int frame_usec)
+{
+  double per_chn;
+
+  if((!pol->bw_valid) || (!pol->fixed_valid) || (chns < 1))
+  {
+    return 0;
+  }
+
+  per_chn = ((frame_usec - pol->fixed_usec) / chns) - pol->xfer_usec;
+
+  if(per_chn <= 0)
+  {
+    return 0;
+  }
+
+  return (per_chn * pol->bw) / 1e6;
+}
+
+
+int fpol_choose(struct frame_policy *pol, const struct frame_policy_req *req)
+{
+  int budget;
+
+  double margin;
+
+  budget = fpol_budget(pol, req->chns, req->frame_usec);
+
+  margin = (pol->mode == FPOL_MODE_RAW) ? FPOL_DOWN_MARGIN : FPOL_UP_MARGIN;
+
+  if(req->raw_allowed &&
+     (req->screen_smpls > req->norm_pnts) &&
+     (req->screen_smpls <= FPOL_RAW_MAX_PNTS) &&
+     (req->screen_smpls <= (budget * margin)))
+  {
+    pol->mode = FPOL_MODE_RAW;
+
+    pol->pnts = req->screen_smpls;
+  }
+  else
+  {
+    pol->mode = FPOL_MODE_NORM;
+
+    pol->pnts = req->norm_pnts;
+  }
+
+  return pol->mode;
+}
+
+
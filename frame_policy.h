@@ -0,0 +1,98 @@
+/*
+***************************************************************************
+*
+* Author: Teunis van Beelen
+*
+* Copyright (C) 2015 - 2024 Teunis van Beelen
+*
+* Email: teuniz@protonmail.com
+*
+***************************************************************************
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+***************************************************************************
+*/
+
+
+
+#ifndef FRAME_POLICY_H
+#define FRAME_POLICY_H
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/*
+ * Chooses the number of points of a screen frame from the measured
+ * throughput of the link. The time of a frame is modelled as a fixed
+ * part (status queries, command round trips) plus the waveform bytes
+ * divided by the bandwidth. Both are estimated from the frames that
+ * were already downloaded.
+ */
+
+#define FPOL_MODE_NORM  (0)  /* the points on the screen, :WAV:MODE NORM */
+#define FPOL_MODE_RAW   (1)  /* a window of the sample memory, :WAV:MODE RAW */
+
+#define FPOL_RAW_MAX_PNTS  (250000)  /* max bytes of one :WAV:DATA? read in RAW mode */
+
+
+struct frame_policy
+{
+  double bw;            /* waveform bytes per second */
+  double sum_bytes;     /* decayed sums the bandwidth is computed from */
+  double sum_usec;
+  double fixed_usec;    /* time of a frame without the waveform transfers */
+  double xfer_usec;     /* time of one transfer without the bytes, the round trip */
+  int bw_valid;
+  int fixed_valid;
+  int mode;             /* FPOL_MODE_xxx of the last decision */
+  int pnts;             /* points per channel of the last decision */
+};
+
+
+struct frame_policy_req
+{
+  int chns;             /* channels to download */
+  int norm_pnts;        /* points per channel in NORM mode */
+  int screen_smpls;     /* samples in memory that span the screen */
+  int raw_allowed;      /* the acquisition is stopped, RAW data is stable */
+  int frame_usec;       /* target frame time */
+};
+
+
+void fpol_init(struct frame_policy *);
+
+/* one :WAV:DATA? transfer of bytes in usec, lat_usec is the round trip of a short query */
+void fpol_add_transfer(struct frame_policy *, int, long long, int);
+
+/* a complete frame, usec in total of which xfer_usec was spent in waveform transfers */
+void fpol_add_frame(struct frame_policy *, long long, long long);
+
+/* points per channel that fit in the frame time, 0 if the link is not measured yet */
+int fpol_budget(const struct frame_policy *, int, int);
+
+/* sets mode and pnts for the next frame, returns the mode */
+int fpol_choose(struct frame_policy *, const struct frame_policy_req *);
+
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif
+
+
@@ -69,6 +69,8 @@
 
 #define FFT_MAX_BUFSZ (4096)
 
+#define FFT_WF_ROWS (256)  /* history of the waterfall in spectra */
+
 #define ADJ_DIAL_FUNC_NONE (0)
 #define ADJ_DIAL_FUNC_HOLDOFF (1)
 #define ADJ_DIAL_FUNC_ACQ_AVG (2)
@@ -86,10 +88,12 @@
 #define LABEL_ACTIVE_TRIG (5)
 #define LABEL_ACTIVE_FFT (6)
 
-#define TMC_GDS_DELAY (10000)
+#define TMC_GDS_DELAY (10000)  // initial command pacing in microseconds, the connection adapts it
 
 #define TMC_CMD_CUE_SZ (1024)
 
+#define TMC_CMD_BATCH_SZ (32)
+
 #define TMC_THRD_RESULT_NONE (0)
 #define TMC_THRD_RESULT_SCRN (1)
 #define TMC_THRD_RESULT_CMD (2)
@@ -154,7 +158,7 @@ struct waveform_preamble {
 
 struct device_settings {
     int connected;
-    int connectiontype; // 0=USB, 1=LAN
+    int connectiontype; // 0=USB, 1=LAN, 2=replay of a recorded session
     char modelname[128];
     char serialnr[128];
     char softwvers[128];
@@ -166,6 +170,7 @@ struct device_settings {
     char hostname[128];
 
     int screentimerival;
+    int screen_res_adaptive;  // 0=always the screen points, 1=raw samples when the link is fast enough
 
     int channel_cnt;    // Device has 2 or 4 channels
     int bandwidth;      // Bandwidth in MHz
@@ -212,6 +217,8 @@ struct device_settings {
     int displaygrid;    // 0=none, 1=half, 2=full
     int displaytype;    // 0=vectors, 1=dots
     int displaygrading; // 0=minimum, 1=0.1, 2=0.2, 5=0.5, 1=10, 2=20, 5=50, 10000=infinite
+    int display_persist; // 0=off, 1=the grading time is applied on screen by the client
+    int display_aa;      // 0=off, 1=the vectors of the traces are drawn anti-aliased by the client
 
     double samplerate;   // Samplefrequency
     int acquiretype;     // 0=normal, 1=average, 2=peak, 3=highres
@@ -280,6 +287,8 @@ struct device_settings {
     char *screenshot_buf;
     short *wavebuf[MAX_CHNS];
     int wavebufsz;
+    int screen_pnts;          // points per channel in wavebuf that span the screen width
+    unsigned long long frame_hash;  // equal for frames that show the same
     double yinc[MAX_CHNS];
     int yor[MAX_CHNS];
 
@@ -289,8 +298,6 @@ struct device_settings {
 
     int screenupdates_on;
 
-    pthread_mutex_t mutexx;
-
     int thread_error_stat;
     int thread_error_line;
     int thread_result;
@@ -299,20 +306,18 @@ struct device_settings {
 
     struct waveform_preamble preamble;
 
-    char cmd_cue[TMC_CMD_CUE_SZ][128];
-    char *cmd_cue_resp[TMC_CMD_CUE_SZ];
-    int cmd_cue_idx_in;
-    int cmd_cue_idx_out;
 
     int math_fft_src;   // 0=ch1, 1=ch2, 2=ch3, 3=ch4
     int math_fft;       // 0=off, 1=on
     int math_fft_split; // 0=off, 1=on
     int math_fft_unit;  // 0=VRMS, 1=DB
-    double *fftbuf_in;
     double *fftbuf_out;
     int fftbufsz;
-    kiss_fftr_cfg k_cfg;
-    kiss_fft_cpx *kiss_fftbuf;
+    unsigned int fftbuf_seq;  // changes when fftbuf_out holds a new spectrum
+    int math_fft_waterfall;   // 0=off, 1=on
+    int math_fft_window;   // FFT_WIN_xxx, the window of the local FFT
+    int math_fft_avg;      // FFT_AVG_xxx
+    int math_fft_avg_cnt;
     double math_fft_hscale;
     double math_fft_hcenter;
     double fft_vscale;
@@ -201,9 +201,7 @@ void UI_Mainwindow::navDialReleased()
 
       statusLabel->setText(str);
 
-      snprintf(str, 512, ":TIM:DEL:OFFS %e", devparms.timebasedelayoffset);
-
-      set_cue_cmd(str);
+      set_cue_cmd(TMC_OP_TIM_DEL_OFFS, 0, devparms.timebasedelayoffset);
     }
 
   waveForm->update();
@@ -1022,9 +1020,7 @@ void UI_Mainwindow::vertScaleDialChanged(int new_pos)
 
   statusLabel->setText(str);
 
-  snprintf(str, 512, ":CHAN%i:SCAL %e", chn + 1, devparms.chanscale[chn]);
-
-  set_cue_cmd(str);
+  set_cue_cmd(TMC_OP_CHAN_SCAL, chn, devparms.chanscale[chn]);
 
   old_pos = new_pos;
 
@@ -1248,8 +1244,6 @@ void UI_Mainwindow::set_memdepth(int mdepth)
 
     devparms.timebaseoffset = 0;
 
-    usleep(20000);
-
     set_cue_cmd(":TIM:OFFS 0");
 
     return;
@@ -1267,8 +1261,6 @@ void UI_Mainwindow::set_memdepth(int mdepth)
 
   devparms.timebaseoffset = 0;
 
-  usleep(20000);
-
   set_cue_cmd(":TIM:OFFS 0");
 }
 
@@ -1530,7 +1522,11 @@ void UI_Mainwindow::dispButtonClicked()
   submenutype.setTitle("Type");
   submenutype.addAction("Vectors", this, SLOT(set_grid_type_vectors()));
   submenutype.addAction("Dots",    this, SLOT(set_grid_type_dots()));
+  submenutype.addSeparator();
+  submenutype.addAction("Anti-aliasing", this, SLOT(toggle_display_aa()));
   actionList = submenutype.actions();
+  actionList[3]->setCheckable(true);
+  actionList[3]->setChecked(devparms.display_aa == 1);
   if(devparms.displaytype == 0)
   {
     actionList[0]->setCheckable(true);
@@ -1577,7 +1573,11 @@ void UI_Mainwindow::dispButtonClicked()
 //   submenugrading.addAction("10",       this, SLOT(set_grading_10()));
 //   submenugrading.addAction("20",       this, SLOT(set_grading_20()));
   submenugrading.addAction("Infinite", this, SLOT(set_grading_inf()));
+  submenugrading.addSeparator();
+  submenugrading.addAction("On screen", this, SLOT(toggle_display_persist()));
   actionList = submenugrading.actions();
+  actionList[9]->setCheckable(true);
+  actionList[9]->setChecked(devparms.display_persist == 1);
   if(devparms.displaygrading == 0)
   {
     actionList[0]->setCheckable(true);
@@ -1654,6 +1654,30 @@ void UI_Mainwindow::set_grid_type_dots()
 }
 
 
+// local only, the vectors are drawn with anti-aliasing by the client
+void UI_Mainwindow::toggle_display_aa()
+{
+  QSettings settings;
+
+  if(devparms.display_aa == 1)
+  {
+    devparms.display_aa = 0;
+
+    statusLabel->setText("Anti-aliasing off");
+  }
+  else
+  {
+    devparms.display_aa = 1;
+
+    statusLabel->setText("Anti-aliasing on");
+  }
+
+  settings.setValue("display/antialias", devparms.display_aa);
+
+  waveForm->update();
+}
+
+
 void UI_Mainwindow::set_grid_full()
 {
   if(devparms.displaygrid == 2)
@@ -1843,6 +1867,30 @@ void UI_Mainwindow::set_grading_inf()
 }
 
 
+// local only, the grading time is applied to the traces on screen
+void UI_Mainwindow::toggle_display_persist()
+{
+  QSettings settings;
+
+  if(devparms.display_persist == 1)
+  {
+    devparms.display_persist = 0;
+
+    statusLabel->setText("Persistence on screen off");
+  }
+  else
+  {
+    devparms.display_persist = 1;
+
+    statusLabel->setText("Persistence on screen on");
+  }
+
+  settings.setValue("display/persistence", devparms.display_persist);
+
+  waveForm->update();
+}
+
+
 void UI_Mainwindow::utilButtonClicked()
 {
   QMenu menu;
@@ -2498,6 +2546,8 @@ void UI_Mainwindow::chan_menu()
 
 void UI_Mainwindow::math_menu()
 {
+  int i;
+
   char str[512];
 
   double val;
@@ -2508,7 +2558,9 @@ void UI_Mainwindow::math_menu()
         submenuffthzdiv,
         submenufftsrc,
         submenufftvscale,
-        submenufftoffset;
+        submenufftoffset,
+        submenufftwin,
+        submenufftavg;
 
   QList<QAction *> actionList;
 
@@ -2693,6 +2745,40 @@ void UI_Mainwindow::math_menu()
           actionList[3]->setChecked(true);
         }
 
+  submenufftwin.setTitle("Window");
+  submenufftwin.addAction("Rectangle",       this, SLOT(select_fft_win_rect()));
+  submenufftwin.addAction("Hann",            this, SLOT(select_fft_win_hann()));
+  submenufftwin.addAction("Blackman-Harris", this, SLOT(select_fft_win_blackman_harris()));
+  submenufftwin.addAction("Flat top",        this, SLOT(select_fft_win_flattop()));
+  actionList = submenufftwin.actions();
+  actionList[devparms.math_fft_window]->setCheckable(true);
+  actionList[devparms.math_fft_window]->setChecked(true);
+
+  submenufftavg.setTitle("Averaging");
+  submenufftavg.addAction("Off",            this, SLOT(select_fft_avg_off()));
+  submenufftavg.addAction("Exponential 4",  this, SLOT(select_fft_avg_exp4()));
+  submenufftavg.addAction("Exponential 16", this, SLOT(select_fft_avg_exp16()));
+  submenufftavg.addAction("Linear 4",       this, SLOT(select_fft_avg_lin4()));
+  submenufftavg.addAction("Linear 16",      this, SLOT(select_fft_avg_lin16()));
+  actionList = submenufftavg.actions();
+  if(devparms.math_fft_avg == FFT_AVG_OFF)
+  {
+    actionList[0]->setCheckable(true);
+    actionList[0]->setChecked(true);
+  }
+  else
+  {
+    i = (devparms.math_fft_avg == FFT_AVG_EXP) ? 1 : 3;
+
+    if(devparms.math_fft_avg_cnt == 16)
+    {
+      i++;
+    }
+
+    actionList[i]->setCheckable(true);
+    actionList[i]->setChecked(true);
+  }
+
   submenufft.setTitle("FFT");
   submenufft.addAction("On",     this, SLOT(toggle_fft()));
   submenufft.addAction("Off",    this, SLOT(toggle_fft()));
@@ -2700,11 +2786,14 @@ void UI_Mainwindow::math_menu()
   submenufft.addAction("Half",   this, SLOT(toggle_fft_split()));
   submenufft.addAction("Vrms",   this, SLOT(toggle_fft_unit()));
   submenufft.addAction("dB/dBm", this, SLOT(toggle_fft_unit()));
+  submenufft.addAction("Waterfall", this, SLOT(toggle_fft_waterfall()));
   submenufft.addMenu(&submenufftsrc);
   submenufft.addMenu(&submenufftctr);
   submenufft.addMenu(&submenuffthzdiv);
   submenufft.addMenu(&submenufftoffset);
   submenufft.addMenu(&submenufftvscale);
+  submenufft.addMenu(&submenufftwin);
+  submenufft.addMenu(&submenufftavg);
   actionList = submenufft.actions();
   if(devparms.math_fft == 1)
   {
@@ -2736,6 +2825,8 @@ void UI_Mainwindow::math_menu()
     actionList[5]->setCheckable(true);
     actionList[5]->setChecked(true);
   }
+  actionList[6]->setCheckable(true);
+  actionList[6]->setChecked(devparms.math_fft_waterfall == 1);
 
   menu.addMenu(&submenufft);
 
@@ -3383,9 +3474,7 @@ void UI_Mainwindow::vertOffsetDialClicked(QPoint)
 
   statusLabel->setText(str);
 
-  snprintf(str, 512, ":CHAN%i:OFFS %e", chn + 1, devparms.chanoffset[chn]);
-
-  set_cue_cmd(str);
+  set_cue_cmd(TMC_OP_CHAN_OFFS, chn, devparms.chanoffset[chn]);
 }
 
 
@@ -3408,11 +3497,11 @@ void UI_Mainwindow::autoButtonClicked()
 
   scrn_timer->stop();
 
-  scrn_thread->wait();
+  scrn_thread->wait_idle();
 
   statusLabel->setText("Auto settings");
 
-  tmc_write(":AUT");
+  tmc_write(device, ":AUT");
 
   get_device_settings(12);
 
@@ -3561,9 +3650,7 @@ void UI_Mainwindow::horPosDialClicked(QPoint)
 
     statusLabel->setText(str);
 
-    snprintf(str, 512, ":TIM:DEL:OFFS %e", devparms.timebasedelayoffset);
-
-    set_cue_cmd(str);
+    set_cue_cmd(TMC_OP_TIM_DEL_OFFS, 0, devparms.timebasedelayoffset);
   }
   else
   {
@@ -3577,9 +3664,7 @@ void UI_Mainwindow::horPosDialClicked(QPoint)
 
     statusLabel->setText(str);
 
-    snprintf(str, 512, ":TIM:OFFS %e", devparms.timebaseoffset);
-
-    set_cue_cmd(str);
+    set_cue_cmd(TMC_OP_TIM_OFFS, 0, devparms.timebaseoffset);
   }
 }
 
@@ -4143,9 +4228,7 @@ void UI_Mainwindow::trigAdjustDialClicked(QPoint)
 
   statusLabel->setText(str);
 
-  snprintf(str, 512, ":TRIGger:EDGE:LEVel %e", devparms.triggeredgelevel[devparms.triggeredgesource]);
-
-  set_cue_cmd(str);
+  set_cue_cmd(TMC_OP_TRIG_EDGE_LEV, devparms.triggeredgesource, devparms.triggeredgelevel[devparms.triggeredgesource]);
 }
 
 
@@ -4228,6 +4311,30 @@ void UI_Mainwindow::toggle_fft_split()
 }
 
 
+// local only, the history is built from the spectra that are downloaded
+void UI_Mainwindow::toggle_fft_waterfall()
+{
+  QSettings settings;
+
+  if(devparms.math_fft_waterfall == 1)
+  {
+    devparms.math_fft_waterfall = 0;
+
+    statusLabel->setText("FFT waterfall off");
+  }
+  else
+  {
+    devparms.math_fft_waterfall = 1;
+
+    statusLabel->setText("FFT waterfall on");
+  }
+
+  settings.setValue("fft/waterfall", devparms.math_fft_waterfall);
+
+  waveForm->update();
+}
+
+
 void UI_Mainwindow::toggle_fft_unit()
 {
   char str[512];
@@ -4685,6 +4792,106 @@ void UI_Mainwindow::select_fft_vscale20()
 }
 
 
+void UI_Mainwindow::select_fft_win_rect()
+{
+  set_fft_window(FFT_WIN_RECT);
+}
+
+
+void UI_Mainwindow::select_fft_win_hann()
+{
+  set_fft_window(FFT_WIN_HANN);
+}
+
+
+void UI_Mainwindow::select_fft_win_blackman_harris()
+{
+  set_fft_window(FFT_WIN_BLACKMAN_HARRIS);
+}
+
+
+void UI_Mainwindow::select_fft_win_flattop()
+{
+  set_fft_window(FFT_WIN_FLATTOP);
+}
+
+
+// the window is applied by the local FFT only, nothing is sent to the device
+void UI_Mainwindow::set_fft_window(int win)
+{
+  QSettings settings;
+
+  const char *win_str[4]={"Rectangle", "Hann", "Blackman-Harris", "Flat top"};
+
+  char str[512];
+
+  devparms.math_fft_window = win;
+
+  settings.setValue("fft/window", win);
+
+  snprintf(str, 512, "FFT window: %s", win_str[win]);
+
+  statusLabel->setText(str);
+}
+
+
+void UI_Mainwindow::select_fft_avg_off()
+{
+  set_fft_avg(FFT_AVG_OFF, devparms.math_fft_avg_cnt);
+}
+
+
+void UI_Mainwindow::select_fft_avg_exp4()
+{
+  set_fft_avg(FFT_AVG_EXP, 4);
+}
+
+
+void UI_Mainwindow::select_fft_avg_exp16()
+{
+  set_fft_avg(FFT_AVG_EXP, 16);
+}
+
+
+void UI_Mainwindow::select_fft_avg_lin4()
+{
+  set_fft_avg(FFT_AVG_LIN, 4);
+}
+
+
+void UI_Mainwindow::select_fft_avg_lin16()
+{
+  set_fft_avg(FFT_AVG_LIN, 16);
+}
+
+
+void UI_Mainwindow::set_fft_avg(int mode, int cnt)
+{
+  QSettings settings;
+
+  char str[512];
+
+  devparms.math_fft_avg = mode;
+
+  devparms.math_fft_avg_cnt = cnt;
+
+  settings.setValue("fft/averaging", mode);
+
+  settings.setValue("fft/averages", cnt);
+
+  if(mode == FFT_AVG_OFF)
+  {
+    strlcpy(str, "FFT averaging: off", 512);
+  }
+  else
+  {
+    snprintf(str, 512, "FFT averaging: %s %i", (mode == FFT_AVG_EXP) ? "exponential" : "linear", cnt);
+  }
+
+  statusLabel->setText(str);
+}
+
+
 void UI_Mainwindow::set_fft_vscale()
 {
   char str[512];
@@ -62,6 +62,8 @@ void UI_Mainwindow::open_connection() {
 
     if (!strcmp(str, "LAN")) {
         devparms.connectiontype = 1;
+    } else if (!strcmp(str, "REPLAY")) {
+        devparms.connectiontype = 2;
     } else {
         devparms.connectiontype = 0;
     }
@@ -162,14 +164,33 @@ void UI_Mainwindow::open_connection() {
         }
     }
 
-    if (tmc_write("*IDN?") != 5)
-    //  if(tmc_write("*IDN?;:SYST:ERR?") != 16)  // This is a fix for the broken *IDN? command in older fw version
+    if (devparms.connectiontype == 2) // replay of a recorded session
+    {
+        strlcpy(dev_str, settings.value("connection/replay_file", "").toString().toLocal8Bit().data(), 256);
+
+        device = tmc_open_replay(dev_str, settings.value("connection/replay_realtime", 0).toInt());
+        if (device == NULL) {
+            snprintf(str, 4096, "Can not open trace file %s", dev_str);
+            goto OC_OUT_ERROR;
+        }
+    } else {
+        strlcpy(str, settings.value("connection/record_file", "").toString().toLocal8Bit().data(), 4096);
+
+        if (strlen(str)) {
+            if (tmc_record_start(device, str)) {
+                printf("Can not record the session to %s\n", str);
+            }
+        }
+    }
+
+    if (tmc_write(device, "*IDN?") != 5)
+    //  if(tmc_write(device, "*IDN?;:SYST:ERR?") != 16)  // This is a fix for the broken *IDN? command in older fw version
     {
         snprintf(str, 4096, "Can not write to device %s", dev_str);
         goto OC_OUT_ERROR;
     }
 
-    n = tmc_read();
+    n = tmc_read(device);
 
     if (n < 0) {
         snprintf(str, 4096, "Can not read from device %s", dev_str);
@@ -208,6 +229,8 @@ void UI_Mainwindow::open_connection() {
         goto OC_OUT_ERROR;
     }
 
+    load_pace_profile();
+
     ptr = strtok(NULL, ",");
     if (ptr == NULL) {
         snprintf(str, 1024, "Received an unknown identification string from device:\n\n%s\n ", device->buf);
@@ -301,18 +324,10 @@ void UI_Mainwindow::open_connection() {
         ch2Button->setVisible(false);
     }
 
-    devparms.cmd_cue_idx_in = 0;
-    devparms.cmd_cue_idx_out = 0;
-
     devparms.func_has_record = 0;
 
     devparms.fftbufsz = devparms.hordivisions * 50;
 
-    if (devparms.k_cfg != NULL) {
-        free(devparms.k_cfg);
-    }
-    devparms.k_cfg = kiss_fftr_alloc(devparms.fftbufsz * 2, 0, NULL, NULL);
-
     connect(adjDial, SIGNAL(valueChanged(int)), this, SLOT(adjDialChanged(int)));
     connect(trigAdjustDial, SIGNAL(valueChanged(int)), this, SLOT(trigAdjustDialChanged(int)));
     connect(horScaleDial, SIGNAL(valueChanged(int)), this, SLOT(horScaleDialChanged(int)));
@@ -376,6 +391,8 @@ void UI_Mainwindow::open_connection() {
 
     scrn_thread->set_device(device);
 
+    scrn_thread->start();
+
     devparms.connected = 1;
 
     //  test_timer->start(2000);
@@ -415,17 +432,18 @@ void UI_Mainwindow::close_connection() {
 
     devparms.connected = 0;
 
+    scrn_thread->request_quit();
+
     if (scrn_thread->wait(5000) == false) {
         scrn_thread->terminate();
 
         scrn_thread->wait(5000);
 
-        pthread_mutex_trylock(&devparms.mutexx);
-        pthread_mutex_unlock(&devparms.mutexx);
-
         scrn_thread->h_busy = 0;
     }
 
+    save_pace_profile();
+
     devparms.screenupdates_on = 0;
 
     setWindowTitle(PROGRAM_NAME " " PROGRAM_VERSION);
@@ -495,16 +513,10 @@ void UI_Mainwindow::close_connection() {
 
     waveForm->clear();
 
-    tmc_close();
+    tmc_close(device);
 
     device = NULL;
 
-    if (devparms.k_cfg != NULL) {
-        free(devparms.k_cfg);
-
-        devparms.k_cfg = NULL;
-    }
-
     statusLabel->setText("Disconnected");
 
     printf("Disconnected from device\n");
@@ -519,17 +531,21 @@ void UI_Mainwindow::closeEvent(QCloseEvent *cl_event) {
 
     adjdial_timer->stop();
 
+    scrn_thread->request_quit();
+
     scrn_thread->wait(5000);
 
     scrn_thread->terminate();
 
     scrn_thread->wait(5000);
 
+    save_pace_profile();
+
     devparms.screenupdates_on = 0;
 
     scrn_thread->set_device(NULL);
 
-    tmc_close();
+    tmc_close(device);
 
     device = NULL;
 
@@ -771,6 +787,37 @@ double UI_Mainwindow::get_stepsize_divide_by_1000(double val) {
     return val;
 }
 
+// the command pacing the device was tuned to is saved per model and connection type,
+// the next session starts with it instead of the conservative default
+void UI_Mainwindow::load_pace_profile() {
+    char str[256];
+
+    QSettings settings;
+
+    if ((device == NULL) || (device->type == TMC_TYPE_REPLAY) || (!devparms.modelname[0])) {
+        return;
+    }
+
+    snprintf(str, 256, "pacing/%s/%s", (device->type == TMC_TYPE_USB) ? "usb" : "lan", devparms.modelname);
+
+    tmc_pace_set(device, settings.value(str, TMC_GDS_DELAY).toInt());
+}
+
+void UI_Mainwindow::save_pace_profile() {
+    char str[256];
+
+    QSettings settings;
+
+    if ((device == NULL) || (device->type == TMC_TYPE_REPLAY) || (!devparms.modelname[0]) ||
+        (!strcmp(devparms.modelname, "-----"))) {
+        return;
+    }
+
+    snprintf(str, 256, "pacing/%s/%s", (device->type == TMC_TYPE_USB) ? "usb" : "lan", devparms.modelname);
+
+    settings.setValue(str, tmc_pace_get(device));
+}
+
 void UI_Mainwindow::get_device_model(const char *str) {
     devparms.channel_cnt = 0;
 
@@ -1604,9 +1651,7 @@ void UI_Mainwindow::zoom_in() {
 
         statusLabel->setText(str);
 
-        snprintf(str, 512, ":TIM:DEL:SCAL %e", devparms.timebasedelayscale);
-
-        set_cue_cmd(str);
+        set_cue_cmd(TMC_OP_TIM_DEL_SCAL, 0, devparms.timebasedelayscale);
     } else {
         if (devparms.modelserie == 1) {
             if (devparms.timebasescale <= 5.001e-9) {
@@ -1642,9 +1687,7 @@ void UI_Mainwindow::zoom_in() {
 
         statusLabel->setText(str);
 
-        snprintf(str, 512, ":TIM:SCAL %e", devparms.timebasescale);
-
-        set_cue_cmd(str);
+        set_cue_cmd(TMC_OP_TIM_SCAL, 0, devparms.timebasescale);
     }
 
     waveForm->update();
@@ -1724,9 +1767,7 @@ void UI_Mainwindow::zoom_out() {
 
         statusLabel->setText(str);
 
-        snprintf(str, 512, ":TIM:DEL:SCAL %e", devparms.timebasedelayscale);
-
-        set_cue_cmd(str);
+        set_cue_cmd(TMC_OP_TIM_DEL_SCAL, 0, devparms.timebasedelayscale);
 
         if (devparms.timebasedelayscale > 0.1000001) {
             devparms.func_wrec_enable = 0;
@@ -1750,9 +1791,7 @@ void UI_Mainwindow::zoom_out() {
 
         statusLabel->setText(str);
 
-        snprintf(str, 512, ":TIM:SCAL %e", devparms.timebasescale);
-
-        set_cue_cmd(str);
+        set_cue_cmd(TMC_OP_TIM_SCAL, 0, devparms.timebasescale);
 
         if (devparms.timebasescale > 0.1000001) {
             devparms.func_wrec_enable = 0;
@@ -1867,9 +1906,7 @@ void UI_Mainwindow::chan_scale_plus() {
 
     statusLabel->setText(str);
 
-    snprintf(str, 512, ":CHAN%i:SCAL %e", chn + 1, devparms.chanscale[chn]);
-
-    set_cue_cmd(str);
+    set_cue_cmd(TMC_OP_CHAN_SCAL, chn, devparms.chanscale[chn]);
 
     waveForm->update();
 }
@@ -1931,9 +1968,7 @@ void UI_Mainwindow::chan_scale_plus_all() {
 
         statusLabel->setText(str);
 
-        snprintf(str, 512, ":CHAN%i:SCAL %e", chn + 1, devparms.chanscale[chn]);
-
-        set_cue_cmd(str);
+        set_cue_cmd(TMC_OP_CHAN_SCAL, chn, devparms.chanscale[chn]);
     }
 
     waveForm->update();
@@ -2048,9 +2083,7 @@ void UI_Mainwindow::chan_scale_minus() {
 
     statusLabel->setText(str);
 
-    snprintf(str, 512, ":CHAN%i:SCAL %e", chn + 1, devparms.chanscale[chn]);
-
-    set_cue_cmd(str);
+    set_cue_cmd(TMC_OP_CHAN_SCAL, chn, devparms.chanscale[chn]);
 
     waveForm->update();
 }
@@ -2116,9 +2149,7 @@ void UI_Mainwindow::chan_scale_minus_all() {
 
         statusLabel->setText(str);
 
-        snprintf(str, 512, ":CHAN%i:SCAL %e", chn + 1, devparms.chanscale[chn]);
-
-        set_cue_cmd(str);
+        set_cue_cmd(TMC_OP_CHAN_SCAL, chn, devparms.chanscale[chn]);
     }
 
     waveForm->update();
@@ -2303,7 +2334,9 @@ void UI_Mainwindow::shift_trace_down() {
 void UI_Mainwindow::set_to_factory() {
     int i;
 
-    char str[512];
+    char str[MAX_CHNS][128];
+
+    const char *batch[MAX_CHNS];
 
     if ((device == NULL) || (!devparms.connected)) {
         return;
@@ -2318,9 +2351,9 @@ void UI_Mainwindow::set_to_factory() {
 
     scrn_timer->stop();
 
-    scrn_thread->wait();
+    scrn_thread->wait_idle();
 
-    tmc_write("*RST");
+    tmc_write(device, "*RST");
 
     devparms.timebasescale = 1e-6;
 
@@ -2402,42 +2435,45 @@ void UI_Mainwindow::set_to_factory() {
 
     if (devparms.modelserie == 6) {
         for (i = 0; i < MAX_CHNS; i++) {
-            snprintf(str, 512, ":CHAN%i:SCAL 1", i + 1);
+            snprintf(str[i], 128, ":CHAN%i:SCAL 1", i + 1);
 
-            tmc_write(str);
-
-            usleep(20000);
+            batch[i] = str[i];
         }
+
+        // confirmed with *OPC? before the screen thread queries the device again
+        tmc_write_batch(device, batch, MAX_CHNS, TMC_OPC_WAIT);
     }
 
     scrn_timer->start(devparms.screentimerival);
 }
 
-// this function is called when screen_thread has finished
+// this function is called when screen_thread has published a new frame
 void UI_Mainwindow::screenUpdate() {
     int i, chns = 0;
 
     char str[512];
 
     if (device == NULL) {
-        pthread_mutex_unlock(&devparms.mutexx);
-
         return;
     }
 
     if (!devparms.connected) {
-        pthread_mutex_unlock(&devparms.mutexx);
-
         return;
     }
 
     if (!devparms.screenupdates_on) {
-        pthread_mutex_unlock(&devparms.mutexx);
+        return;
+    }
 
+    if (!scrn_thread->get_params(&devparms)) {
         return;
     }
 
-    scrn_thread->get_params(&devparms);
+    if (devparms.thread_job == TMC_THRD_JOB_TRIGEDGELEV) {
+        devparms.triggeredgelevel[devparms.triggeredgesource] = devparms.thread_value;
+
+        //      waveForm->setTrigLineVisible();
+    }
 
     if (devparms.thread_error_stat) {
         scrn_timer->stop();
@@ -2451,34 +2487,22 @@ void UI_Mainwindow::screenUpdate() {
         msgBox.setText(str);
         msgBox.exec();
 
-        pthread_mutex_unlock(&devparms.mutexx);
-
         close_connection();
 
         return;
     }
 
     if (devparms.thread_result == TMC_THRD_RESULT_NONE) {
-        pthread_mutex_unlock(&devparms.mutexx);
-
         return;
     }
 
     if (devparms.thread_result == TMC_THRD_RESULT_CMD) {
-        if (devparms.thread_job == TMC_THRD_JOB_TRIGEDGELEV) {
-            devparms.triggeredgelevel[devparms.triggeredgesource] = devparms.thread_value;
-
-            //      waveForm->setTrigLineVisible();
-        }
-
-        pthread_mutex_unlock(&devparms.mutexx);
+        scrn_redraw_req = 1;
 
         return;
     }
 
     if (scrn_timer->isActive() == false) {
-        pthread_mutex_unlock(&devparms.mutexx);
-
         return;
     }
 
@@ -2513,11 +2537,21 @@ void UI_Mainwindow::screenUpdate() {
     }
 
     if (waveForm->hasMoveEvent() == true) {
-        pthread_mutex_unlock(&devparms.mutexx);
+        scrn_redraw_req = 1;
 
         return;
     }
 
+    // a stopped or waiting scope sends the same frame over and over,
+    // the decoder and the repaint would give the same picture
+    if ((devparms.frame_hash == last_frame_hash) && (!scrn_redraw_req)) {
+        return;
+    }
+
+    last_frame_hash = devparms.frame_hash;
+
+    scrn_redraw_req = 0;
+
     for (i = 0; i < MAX_CHNS; i++) {
         if (!devparms.chandisplay[i]) // Display data only when channel is switched on
         {
@@ -2530,8 +2564,6 @@ void UI_Mainwindow::screenUpdate() {
     if (!chns) {
         waveForm->clear();
 
-        pthread_mutex_unlock(&devparms.mutexx);
-
         return;
     }
 
@@ -2547,31 +2579,37 @@ void UI_Mainwindow::screenUpdate() {
         waveForm->update();
     }
 
-    pthread_mutex_unlock(&devparms.mutexx);
 }
 
 void UI_Mainwindow::set_cue_cmd(const char *str) {
-    strlcpy(devparms.cmd_cue[devparms.cmd_cue_idx_in], str, 128);
-
-    devparms.cmd_cue_resp[devparms.cmd_cue_idx_in] = NULL;
-
-    devparms.cmd_cue_idx_in++;
+    if (scrn_thread->queue_cmd(str, NULL)) {
+        printf("Command queue is full, dropped: %s\n", str);
+    }
 
-    devparms.cmd_cue_idx_in %= TMC_CMD_CUE_SZ;
+    scrn_redraw_req = 1;
 
     scrn_timer_handler();
 }
 
 void UI_Mainwindow::set_cue_cmd(const char *str, char *ptr) {
-    strlcpy(devparms.cmd_cue[devparms.cmd_cue_idx_in], str, 128);
-
     ptr[0] = 0;
 
-    devparms.cmd_cue_resp[devparms.cmd_cue_idx_in] = ptr;
+    if (scrn_thread->queue_cmd(str, ptr)) {
+        printf("Command queue is full, dropped: %s\n", str);
+    }
 
-    devparms.cmd_cue_idx_in++;
+    scrn_redraw_req = 1;
+
+    scrn_timer_handler();
+}
+
+// queues a typed command (TMC_OP_xxx), it's formatted to SCPI when it's sent
+void UI_Mainwindow::set_cue_cmd(int op, int chn, double value) {
+    if (scrn_thread->queue_cmd(op, chn, value)) {
+        printf("Command queue is full, dropped opcode %i\n", op);
+    }
 
-    devparms.cmd_cue_idx_in %= TMC_CMD_CUE_SZ;
+    scrn_redraw_req = 1;
 
     scrn_timer_handler();
 }
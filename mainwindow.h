@@ -45,6 +45,7 @@
 #include "global.h"
 #include "about_dialog.h"
 #include "utils.h"
+#include "sample_conv.h"
 #include "connection.h"
 #include "tmc_dev.h"
 #include "tled.h"
@@ -81,6 +82,7 @@ public:
   void write_settings(void);
   void set_cue_cmd(const char *);
   void set_cue_cmd(const char *, char *);
+  void set_cue_cmd(int, int, double);
   void serial_decoder(struct device_settings *);
   void save_wave_inspector_buffer_to_edf(struct device_settings *);
 
@@ -98,6 +100,10 @@ public:
 
   screen_thread *scrn_thread;
 
+  unsigned long long last_frame_hash;
+
+  int scrn_redraw_req;
+
 private:
 
   QMenuBar     *menubar;
@@ -211,6 +217,8 @@ private:
   int parse_preamble(char *, int, struct waveform_preamble *, int);
   int get_metric_factor(double);
   void get_device_model(const char *);
+  void load_pace_profile();
+  void save_pace_profile();
   double get_stepsize_divide_by_1000(double);
   inline unsigned char reverse_bitorder_8(unsigned char);
   inline unsigned int reverse_bitorder_32(unsigned int);
@@ -323,6 +331,7 @@ private slots:
 
   void set_grid_type_vectors();
   void set_grid_type_dots();
+  void toggle_display_aa();
 
   void set_grid_full();
   void set_grid_half();
@@ -339,6 +348,7 @@ private slots:
   void set_grading_10();
   void set_grading_20();
   void set_grading_inf();
+  void toggle_display_persist();
 
   void chan_coupling_ac();
   void chan_coupling_dc();
@@ -426,6 +436,7 @@ private slots:
 
   void toggle_fft();
   void toggle_fft_split();
+  void toggle_fft_waterfall();
   void toggle_fft_unit();
   void select_fft_ch1();
   void select_fft_ch2();
@@ -451,6 +462,17 @@ private slots:
   void select_fft_vscale10();
   void select_fft_vscale20();
   void set_fft_vscale();
+  void select_fft_win_rect();
+  void select_fft_win_hann();
+  void select_fft_win_blackman_harris();
+  void select_fft_win_flattop();
+  void set_fft_window(int);
+  void select_fft_avg_off();
+  void select_fft_avg_exp4();
+  void select_fft_avg_exp16();
+  void select_fft_avg_lin4();
+  void select_fft_avg_lin16();
+  void set_fft_avg(int, int);
   void select_fft_voffsetp4();
   void select_fft_voffsetp3();
   void select_fft_voffsetp2();
@@ -85,8 +85,6 @@ UI_Mainwindow::UI_Mainwindow()
 
   for(i=0; i<MAX_CHNS; i++)
   {
-    devparms.wavebuf[i] = (short *)malloc(WAVFRM_MAX_BUFSZ * sizeof(short));
-
     devparms.chanscale[i] = 1;
   }
 
@@ -95,13 +93,34 @@ UI_Mainwindow::UI_Mainwindow()
   strlcpy(devparms.chanunitstr[2], "A", 2);
   strlcpy(devparms.chanunitstr[3], "U", 2);
 
-  devparms.fftbuf_in = (double *)malloc(FFT_MAX_BUFSZ * sizeof(double));
+  devparms.math_fft_window = settings.value("fft/window", FFT_WIN_RECT).toInt();
+
+  if((devparms.math_fft_window < FFT_WIN_RECT) || (devparms.math_fft_window > FFT_WIN_FLATTOP))
+  {
+    devparms.math_fft_window = FFT_WIN_RECT;
+  }
+
+  devparms.math_fft_avg = settings.value("fft/averaging", FFT_AVG_OFF).toInt();
+
+  if((devparms.math_fft_avg < FFT_AVG_OFF) || (devparms.math_fft_avg > FFT_AVG_LIN))
+  {
+    devparms.math_fft_avg = FFT_AVG_OFF;
+  }
+
+  devparms.math_fft_avg_cnt = settings.value("fft/averages", 4).toInt();
+
+  if((devparms.math_fft_avg_cnt < 2) || (devparms.math_fft_avg_cnt > FFT_AVG_MAX_CNT))
+  {
+    devparms.math_fft_avg_cnt = 4;
+  }
+
+  devparms.math_fft_waterfall = settings.value("fft/waterfall", 0).toInt() ? 1 : 0;
 
-  devparms.fftbuf_out = (double *)malloc(FFT_MAX_BUFSZ * sizeof(double));
+  devparms.screen_res_adaptive = settings.value("gui/adaptive_screen_res", 1).toInt() ? 1 : 0;
 
-  devparms.kiss_fftbuf = (kiss_fft_cpx *)malloc(FFT_MAX_BUFSZ * sizeof(kiss_fft_cpx));
+  devparms.display_persist = settings.value("display/persistence", 0).toInt() ? 1 : 0;
 
-  devparms.k_cfg = NULL;
+  devparms.display_aa = settings.value("display/antialias", 0).toInt() ? 1 : 0;
 
   devparms.screentimerival = settings.value("gui/refresh", 50).toInt();
 
@@ -177,10 +196,13 @@ UI_Mainwindow::UI_Mainwindow()
 
   strlcpy(devparms.modelname, "-----", 128);
 
-  pthread_mutex_init(&devparms.mutexx, NULL);
-
   scrn_thread = new screen_thread;
   scrn_thread->set_device(NULL);
+  scrn_thread->set_frame_bufs(&devparms);
+
+  last_frame_hash = 0;
+
+  scrn_redraw_req = 1;
 
   menubar = menuBar();
 
@@ -566,10 +588,14 @@ UI_Mainwindow::UI_Mainwindow()
   {
     devparms.connectiontype = 1;
   }
-  else
-  {
-    devparms.connectiontype = 0;
-  }
+  else if(!strcmp(str, "REPLAY"))
+    {
+      devparms.connectiontype = 2;
+    }
+    else
+    {
+      devparms.connectiontype = 0;
+    }
 
   adjDialFunc = ADJ_DIAL_FUNC_NONE;
   navDialFunc = NAV_DIAL_FUNC_NONE;
@@ -605,7 +631,7 @@ UI_Mainwindow::UI_Mainwindow()
 #endif
 
   connect(scrn_timer,          SIGNAL(timeout()),        this, SLOT(scrn_timer_handler()));
-  connect(scrn_thread,         SIGNAL(finished()),       this, SLOT(screenUpdate()));
+  connect(scrn_thread,         SIGNAL(frame_ready()),    this, SLOT(screenUpdate()));
   connect(adjdial_timer,       SIGNAL(timeout()),        this, SLOT(adjdial_timer_handler()));
   connect(navDial,             SIGNAL(sliderReleased()), this, SLOT(navDialReleased()));
   connect(navDial_timer,       SIGNAL(timeout()),        this, SLOT(navDial_timer_handler()));
@@ -671,20 +697,8 @@ UI_Mainwindow::~UI_Mainwindow()
 
   delete scrn_thread;
   delete appfont;
-  pthread_mutex_destroy(&devparms.mutexx);
 
   free(devparms.screenshot_buf);
-
-  for(int i=0; i<MAX_CHNS; i++)
-  {
-    free(devparms.wavebuf[i]);
-  }
-
-  free(devparms.fftbuf_in);
-
-  free(devparms.fftbuf_out);
-
-  free(devparms.kiss_fftbuf);
 }
 
 
@@ -0,0 +1,435 @@
+/*
+***************************************************************************
+*
+* Author: Teunis van Beelen
+*
+* Copyright (C) 2015 - 2024 Teunis van Beelen
+*
+* Email: teuniz@protonmail.com
+*
+***************************************************************************
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+***************************************************************************
+*/
+
+
+
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "persist.h"
+#include "sample_conv.h"
+
+
+
+void pers_init(struct persist_buf *pb)
+{
+  memset(pb, 0, sizeof(struct persist_buf));
+}
+
+
+void pers_free(struct persist_buf *pb)
+{
+  int chn;
+
+  for(chn=0; chn<PERS_MAX_CHNS; chn++)
+  {
+    free(pb->acc[chn]);
+  }
+
+  free(pb->col_lo);
+  free(pb->col_hi);
+
+  pers_init(pb);
+}
+
+
+int pers_resize(struct persist_buf *pb, int w, int h)
+{
+  int chn;
+
+  unsigned short *p;
+
+  int *q;
+
+  if((w < 1) || (h < 1))
+  {
+    return -1;
+  }
+
+  if((w == pb->w) && (h == pb->h))
+  {
+    return 0;
+  }
+
+  if((w * h) > pb->sz)
+  {
+    for(chn=0; chn<PERS_MAX_CHNS; chn++)
+    {
+      p = (unsigned short *)realloc(pb->acc[chn], w * h * sizeof(unsigned short));
+      if(p == NULL)
+      {
+        pb->w = 0;
+        pb->h = 0;
+
+        return -1;
+      }
+
+      pb->acc[chn] = p;
+    }
+
+    pb->sz = w * h;
+  }
+
+  if(w > pb->col_sz)
+  {
+    q = (int *)realloc(pb->col_lo, w * sizeof(int));
+    if(q == NULL)
+    {
+      pb->w = 0;
+      pb->h = 0;
+
+      return -1;
+    }
+
+    pb->col_lo = q;
+
+    q = (int *)realloc(pb->col_hi, w * sizeof(int));
+    if(q == NULL)
+    {
+      pb->w = 0;
+      pb->h = 0;
+
+      return -1;
+    }
+
+    pb->col_hi = q;
+
+    pb->col_sz = w;
+  }
+
+  pb->w = w;
+  pb->h = h;
+
+  pers_clear(pb, -1);
+
+  return 0;
+}
+
+
+void pers_clear(struct persist_buf *pb, int chn)
+{
+  int i;
+
+  if(!pb->sz)
+  {
+    return;
+  }
+
+  for(i=0; i<PERS_MAX_CHNS; i++)
+  {
+    if((chn < 0) || (chn == i))
+    {
+      memset(pb->acc[i], 0, pb->sz * sizeof(unsigned short));
+
+      pb->y_lo[i] = pb->h;
+      pb->y_hi[i] = -1;
+    }
+  }
+}
+
+
+/* a plain loop over 16-bit values with a 32-bit product, the compiler vectorizes it */
+void pers_decay(struct persist_buf *pb, int chn, double factor)
+{
+  int i, n;
+
+  unsigned int k;
+
+  unsigned short *p;
+
+  if((chn < 0) || (chn >= PERS_MAX_CHNS) || (!pb->w))
+  {
+    return;
+  }
+
+  if(factor >= 1.0)
+  {
+    return;
+  }
+
+  if(factor <= 0.0)
+  {
+    pers_clear(pb, chn);
+
+    return;
+  }
+
+  if(pb->y_hi[chn] < pb->y_lo[chn])
+  {
+    return;
+  }
+
+  k = factor * 65536.0;
+
+  p = pb->acc[chn] + (pb->y_lo[chn] * pb->w);
+
+  n = (pb->y_hi[chn] - pb->y_lo[chn] + 1) * pb->w;
+
+  for(i=0; i<n; i++)
+  {
+    p[i] = (p[i] * k) >> 16;
+  }
+}
+
+
+/* the span of a line segment inside every column it crosses is added to the span of
+   that column, then every column is filled from its lowest to its highest pixel,
+   many samples per column cost a compare each, few samples give connected lines,
+   the spans are short so the stride of a line costs little compared to a full pass */
+void pers_add_trace(struct persist_buf *pb, int chn, const short *buf, int n,
+                    double x_off, double x_step, double y_off, double y_step, int weight)
+{
+  int i, c, c0, c1, y, ya, yb, w, h, hits=0;
+
+  unsigned int v;
+
+  unsigned short *p;
+
+  double x0, x1, y0, y1, slope, xa, xb;
+
+  if((chn < 0) || (chn >= PERS_MAX_CHNS) || (!pb->w) || (n < 1) || (x_step <= 0.0))
+  {
+    return;
+  }
+
+  w = pb->w;
+  h = pb->h;
+
+  for(c=0; c<w; c++)
+  {
+    pb->col_lo[c] = h;
+    pb->col_hi[c] = -1;
+  }
+
+  for(i=0; i<n; i++)
+  {
+    x0 = x_off + (i * x_step);
+    y0 = y_off + (buf[i] * y_step);
+
+    if(i < (n - 1))
+    {
+      x1 = x0 + x_step;
+      y1 = y_off + (buf[i + 1] * y_step);
+    }
+    else
+    {
+      x1 = x0;
+      y1 = y0;
+    }
+
+    if((x1 < 0.0) || (x0 >= w))
+    {
+      continue;
+    }
+
+    c0 = (x0 < 0.0) ? 0 : (int)x0;
+    c1 = (x1 >= w) ? (w - 1) : (int)x1;
+
+    slope = (x1 > x0) ? ((y1 - y0) / (x1 - x0)) : 0.0;
+
+    for(c=c0; c<=c1; c++)
+    {
+      xa = (c > x0) ? c : x0;
+      xb = ((c + 1) < x1) ? (c + 1) : x1;
+
+      ya = y0 + ((xa - x0) * slope);
+      yb = y0 + ((xb - x0) * slope);
+
+      if(ya > yb)
+      {
+        y = ya;
+        ya = yb;
+        yb = y;
+      }
+
+      if(ya < pb->col_lo[c])
+      {
+        pb->col_lo[c] = ya;
+      }
+
+      if(yb > pb->col_hi[c])
+      {
+        pb->col_hi[c] = yb;
+      }
+
+      hits = 1;
+    }
+  }
+
+  if(!hits)
+  {
+    return;
+  }
+
+  for(c=0; c<w; c++)
+  {
+    ya = pb->col_lo[c];
+    yb = pb->col_hi[c];
+
+    if((yb < 0) || (ya >= h))
+    {
+      continue;
+    }
+
+    if(ya < 0)
+    {
+      ya = 0;
+    }
+
+    if(yb >= h)
+    {
+      yb = h - 1;
+    }
+
+    if(ya < pb->y_lo[chn])
+    {
+      pb->y_lo[chn] = ya;
+    }
+
+    if(yb > pb->y_hi[chn])
+    {
+      pb->y_hi[chn] = yb;
+    }
+
+    p = pb->acc[chn] + (ya * w) + c;
+
+    for(y=ya; y<=yb; y++, p+=w)
+    {
+      v = *p + weight;
+
+      *p = (v > 65535) ? 65535 : v;
+    }
+  }
+}
+
+
+void pers_render(const struct persist_buf *pb, unsigned int *img, int stride, const unsigned int * const *lut)
+{
+  int x, x0, y, chn, chns=0, w, h, n;
+
+  unsigned int *dest, pix[PERS_RENDER_CHUNK];
+
+  const unsigned short *src[PERS_MAX_CHNS];
+
+  const unsigned int *clut[PERS_MAX_CHNS];
+
+  w = pb->w;
+  h = pb->h;
+
+  if(!w)
+  {
+    return;
+  }
+
+  for(y=0; y<h; y++)
+  {
+    for(chn=0, chns=0; chn<PERS_MAX_CHNS; chn++)
+    {
+      if((lut[chn] != NULL) && (y >= pb->y_lo[chn]) && (y <= pb->y_hi[chn]))
+      {
+        src[chns] = pb->acc[chn] + (y * w);
+
+        clut[chns++] = lut[chn];
+      }
+    }
+
+    dest = img + (y * stride);
+
+    if(!chns)
+    {
+      memset(dest, 0, w * sizeof(unsigned int));
+
+      continue;
+    }
+
+    for(x=0; x<w; x++)
+    {
+      dest[x] = clut[0][(src[0][x] + 255) >> 8];
+    }
+
+    // the colors of the other channels are looked up a chunk at a time and added
+    for(chn=1; chn<chns; chn++)
+    {
+      for(x0=0; x0<w; x0+=PERS_RENDER_CHUNK)
+      {
+        n = ((w - x0) < PERS_RENDER_CHUNK) ? (w - x0) : PERS_RENDER_CHUNK;
+
+        for(x=0; x<n; x++)
+        {
+          pix[x] = clut[chn][(src[chn][x0 + x] + 255) >> 8];
+        }
+
+        sconv_argb_adds(dest + x0, pix, n);
+      }
+    }
+  }
+}
+
+
+void pers_color_ramp(unsigned int *lut, int sz, unsigned int color, int sqrt_ramp)
+{
+  int i;
+
+  unsigned int r, g, b;
+
+  double t;
+
+  r = (color >> 16) & 0xff;
+  g = (color >> 8) & 0xff;
+  b = color & 0xff;
+
+  lut[0] = 0;
+
+  for(i=1; i<sz; i++)
+  {
+    t = i / (double)(sz - 1);
+
+    if(sqrt_ramp)
+    {
+      t = sqrt(t);
+    }
+
+    if(t < 0.85)
+    {
+      t = 0.2 + (t * (0.8 / 0.85));
+
+      lut[i] = 0xff000000 | ((unsigned int)(r * t) << 16) | ((unsigned int)(g * t) << 8) | (unsigned int)(b * t);
+    }
+    else
+    {
+      t = (t - 0.85) / 0.15;
+
+      lut[i] = 0xff000000 |
+               ((unsigned int)(r + ((255 - r) * t)) << 16) |
+               ((unsigned int)(g + ((255 - g) * t)) << 8) |
+               (unsigned int)(b + ((255 - b) * t));
+    }
+  }
+}
+
@@ -0,0 +1,105 @@
+/*
+***************************************************************************
+*
+* Author: Teunis van Beelen
+*
+* Copyright (C) 2015 - 2024 Teunis van Beelen
+*
+* Email: teuniz@protonmail.com
+*
+***************************************************************************
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+***************************************************************************
+*/
+
+
+
+
+#ifndef PERSIST_H
+#define PERSIST_H
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/*
+ * Client side persistence. Every channel has an intensity per pixel that is
+ * raised where the trace of a frame passes and, with a finite persistence,
+ * decays between the frames. The buffers are stored line by line like the
+ * image they are rendered into. The buffers are only reallocated when the
+ * plot grows.
+ */
+
+#define PERS_MAX_CHNS  (4)
+
+#define PERS_HIT_DECAY  (16384)  /* added per hit with a finite persistence */
+#define PERS_HIT_INF    (256)    /* added per hit with infinite persistence, saturates after 256 frames */
+
+#define PERS_LUT_SZ  (257)  /* colors per channel, index 0 is an untouched pixel */
+
+#define PERS_RENDER_CHUNK  (256)  /* pixels of a line whose colors are added at once */
+
+
+struct persist_buf
+{
+  unsigned short *acc[PERS_MAX_CHNS];  /* w * h, line by line */
+  int *col_lo;                         /* vertical span of the trace per column */
+  int *col_hi;
+  int y_lo[PERS_MAX_CHNS];             /* lines that can hold a nonzero intensity, */
+  int y_hi[PERS_MAX_CHNS];             /* the other lines are skipped */
+  int w;
+  int h;
+  int sz;                              /* allocated pixels per channel */
+  int col_sz;                          /* allocated columns */
+};
+
+
+void pers_init(struct persist_buf *);
+
+void pers_free(struct persist_buf *);
+
+/* sets the size of the plot, the intensities are cleared when the size changes, returns 0 on success */
+int pers_resize(struct persist_buf *, int, int);
+
+/* clears one channel, or all of them if chn is -1 */
+void pers_clear(struct persist_buf *, int);
+
+/* multiplies the intensities of a channel with factor (0.0 - 1.0) */
+void pers_decay(struct persist_buf *, int, double);
+
+/* adds the trace of n samples, x = x_off + (i * x_step), y = y_off + (buf[i] * y_step),
+   weight is added to every pixel the trace passes */
+void pers_add_trace(struct persist_buf *, int, const short *, int, double, double, double, double, int);
+
+/* writes the sum of the colors of the channels into an ARGB32 premultiplied image, lut[chn] holds
+   PERS_LUT_SZ colors indexed with (intensity + 255) / 256, a NULL lut skips the channel, stride is in pixels */
+void pers_render(const struct persist_buf *, unsigned int *, int, const unsigned int * const *);
+
+/* fills the sz colors of a lut, index 0 is transparent, then dark to color (RGB32), the top
+   turns towards white, sqrt_ramp spreads the low indices so that rare hits stay visible,
+   also used by the density view */
+void pers_color_ramp(unsigned int *, int, unsigned int, int);
+
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif
+
+
@@ -0,0 +1,300 @@
+/*
+***************************************************************************
+*
+* Author: Teunis van Beelen
+*
+* Copyright (C) 2015 - 2024 Teunis van Beelen
+*
+* Email: teuniz@protonmail.com
+*
+***************************************************************************
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+***************************************************************************
+*/
+
+
+
+#include "psd_dialog.h"
+
+
+
+UI_psd_window::UI_psd_window(struct device_settings *p_devparms, QWidget *parnt) : QDialog(parnt)
+{
+  int i, n;
+
+  char str[512];
+
+  devparms = p_devparms;
+
+  psd_buf = NULL;
+
+  psd_bufsz = 0;
+
+  psd_chn = 0;
+
+  done_ms = 0;
+
+  setMinimumSize(840, 500);
+  setWindowTitle("Spectrum (Welch)");
+  setWindowIcon(QIcon(":/images/r_dsremote.png"));
+
+  psdcurve = new PsdCurve;
+  psdcurve->setBackgroundColor(Qt::black);
+  psdcurve->setRasterColor(Qt::darkGray);
+  psdcurve->setTextColor(Qt::white);
+  psdcurve->setSignalColor(Qt::yellow);
+  psdcurve->setBorderSize(60);
+
+  chanComboBox = new QComboBox;
+  for(i=0; i<devparms->channel_cnt; i++)
+  {
+    if(!devparms->chandisplay[i])
+    {
+      continue;
+    }
+
+    snprintf(str, 512, "CH%i", i + 1);
+
+    chanComboBox->addItem(str, QVariant(i));
+  }
+  chanComboBox->setToolTip("Source channel");
+
+  // segment length sets the resolution bandwidth, the number of segments the noise of the estimate
+  segComboBox = new QComboBox;
+  for(n=4096; n<=WELCH_MAX_NFFT; n*=2)
+  {
+    if(n > devparms->wavebufsz)
+    {
+      break;
+    }
+
+    snprintf(str, 512, "%i", n);
+
+    segComboBox->addItem(str, QVariant(n));
+
+    if(n == 65536)
+    {
+      segComboBox->setCurrentIndex(segComboBox->count() - 1);
+    }
+  }
+  segComboBox->setToolTip("Segment length");
+
+  overlapComboBox = new QComboBox;
+  overlapComboBox->addItem("0%", QVariant(0));
+  overlapComboBox->addItem("50%", QVariant(50));
+  overlapComboBox->addItem("75%", QVariant(75));
+  overlapComboBox->setCurrentIndex(1);
+  overlapComboBox->setToolTip("Segment overlap");
+
+  windowComboBox = new QComboBox;
+  windowComboBox->addItem("Rectangle");
+  windowComboBox->addItem("Hann");
+  windowComboBox->addItem("Blackman-Harris");
+  windowComboBox->addItem("Flat top");
+  windowComboBox->setCurrentIndex(FFT_WIN_HANN);
+  windowComboBox->setToolTip("Window");
+
+  unitComboBox = new QComboBox;
+  unitComboBox->addItem("dBV");
+  unitComboBox->addItem("dBuV");
+  unitComboBox->addItem("dBV/rtHz");
+  unitComboBox->setToolTip("dBV and dBuV show the level of a sine, dBV/rtHz the noise density");
+
+  logfreqCheckBox = new QCheckBox("Log");
+  logfreqCheckBox->setTristate(false);
+  logfreqCheckBox->setToolTip("Logarithmic frequency axis");
+
+  startButton = new QPushButton("Start");
+
+  statusLabel = new QLabel;
+
+  h_layout = new QHBoxLayout;
+  h_layout->addWidget(chanComboBox);
+  h_layout->addWidget(segComboBox);
+  h_layout->addWidget(overlapComboBox);
+  h_layout->addWidget(windowComboBox);
+  h_layout->addWidget(unitComboBox);
+  h_layout->addWidget(logfreqCheckBox);
+  h_layout->addStretch(1000);
+  h_layout->addWidget(startButton);
+
+  v_layout = new QVBoxLayout(this);
+  v_layout->addLayout(h_layout);
+  v_layout->addWidget(psdcurve, 1000);
+  v_layout->addWidget(statusLabel);
+
+  preview_timer = new QTimer(this);
+
+  connect(startButton,     SIGNAL(clicked()),                this, SLOT(start_analysis()));
+  connect(preview_timer,   SIGNAL(timeout()),                this, SLOT(preview_timer_handler()));
+  connect(unitComboBox,    SIGNAL(currentIndexChanged(int)), this, SLOT(unit_changed(int)));
+  connect(logfreqCheckBox, SIGNAL(stateChanged(int)),        this, SLOT(logfreq_changed(int)));
+
+  if(parnt != NULL)
+  {
+    move(parnt->x() + 40, parnt->y() + 40);
+  }
+
+  show();
+
+  start_analysis();
+}
+
+
+UI_psd_window::~UI_psd_window()
+{
+  stop_analysis();
+
+  free(psd_buf);
+}
+
+
+void UI_psd_window::closeEvent(QCloseEvent *cl_event)
+{
+  stop_analysis();
+
+  cl_event->accept();
+}
+
+
+void UI_psd_window::stop_analysis(void)
+{
+  preview_timer->stop();
+
+  psd.abort();
+}
+
+
+void UI_psd_window::start_analysis()
+{
+  int bins;
+
+  double *tmp;
+
+  struct welch_psd_params params;
+
+  stop_analysis();
+
+  if((chanComboBox->count() < 1) || (segComboBox->count() < 1))
+  {
+    statusLabel->setText("The record is too short or no channel is enabled.");
+
+    return;
+  }
+
+  psd_chn = chanComboBox->itemData(chanComboBox->currentIndex()).toInt();
+
+  params.nfft = segComboBox->itemData(segComboBox->currentIndex()).toInt();
+  params.overlap = overlapComboBox->itemData(overlapComboBox->currentIndex()).toInt();
+  params.window = windowComboBox->currentIndex();
+  params.y_incr = devparms->yinc[psd_chn];
+  params.sf = devparms->samplerate;
+
+  bins = (params.nfft / 2) + 1;
+
+  if(bins > psd_bufsz)
+  {
+    tmp = (double *)realloc(psd_buf, bins * sizeof(double));
+    if(tmp == NULL)
+    {
+      statusLabel->setText("Malloc error");
+
+      return;
+    }
+
+    psd_buf = tmp;
+
+    psd_bufsz = bins;
+  }
+
+  psdcurve->clearSpectrum();
+
+  elapsed.start();
+
+  if(psd.start(devparms->wavebuf[psd_chn], devparms->wavebufsz, &params))
+  {
+    statusLabel->setText("Can not start the analysis.");
+
+    return;
+  }
+
+  preview_timer->start(100);
+}
+
+
+void UI_psd_window::preview_timer_handler()
+{
+  // checked before merging, so the last merge contains every segment
+  if(!psd.is_busy())
+  {
+    preview_timer->stop();
+
+    done_ms = elapsed.elapsed();
+  }
+
+  update_spectrum();
+}
+
+
+void UI_psd_window::update_spectrum(void)
+{
+  int done, total;
+
+  char str[512],
+       str2[128];
+
+  const char *unit_str[3]={"dBV", "dBuV", "dBV/rtHz"};
+
+  if(psd.get_psd(psd_buf, psd_bufsz, unitComboBox->currentIndex(), &done, &total) < 0)
+  {
+    return;
+  }
+
+  psdcurve->setSpectrum(psd_buf, psd.get_bins(), devparms->samplerate / 2.0, unit_str[unitComboBox->currentIndex()]);
+
+  convert_to_metric_suffix(str2, psd.get_rbw(), 2, 128);
+
+  snprintf(str, 512, "CH%i   segments: %i / %i   RBW: %sHz   threads: %i",
+           psd_chn + 1, done, total, str2, psd.get_thread_cnt());
+
+  if(preview_timer->isActive())
+  {
+    strlcat(str, "   busy...", 512);
+  }
+  else if(done == total)
+    {
+      snprintf(str + strlen(str), 512 - strlen(str), "   done in %i ms", done_ms);
+    }
+
+  statusLabel->setText(str);
+}
+
+
+void UI_psd_window::unit_changed(int)
+{
+  if(!preview_timer->isActive())
+  {
+    update_spectrum();
+  }
+}
+
+
+void UI_psd_window::logfreq_changed(int state)
+{
+  psdcurve->setLogFrequency(state == Qt::Checked);
+}
+
+
@@ -0,0 +1,109 @@
+/*
+***************************************************************************
+*
+* Author: Teunis van Beelen
+*
+* Copyright (C) 2015 - 2024 Teunis van Beelen
+*
+* Email: teuniz@protonmail.com
+*
+***************************************************************************
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+***************************************************************************
+*/
+
+
+
+#ifndef PSD_DIALOG_H
+#define PSD_DIALOG_H
+
+
+
+#include "qt_headers.h"
+
+#include "global.h"
+#include "utils.h"
+#include "welch_psd.h"
+#include "psd_view.h"
+
+
+class PsdCurve;
+
+
+class UI_psd_window : public QDialog
+{
+  Q_OBJECT
+
+public:
+
+  UI_psd_window(struct device_settings *, QWidget *parent=0);
+  ~UI_psd_window();
+
+  void stop_analysis(void);
+
+private:
+
+struct device_settings *devparms;
+
+welch_psd psd;
+
+double *psd_buf;
+
+int psd_bufsz,
+    psd_chn,
+    done_ms;
+
+QElapsedTimer elapsed;
+
+QTimer *preview_timer;
+
+QVBoxLayout *v_layout;
+
+QHBoxLayout *h_layout;
+
+PsdCurve *psdcurve;
+
+QComboBox *chanComboBox,
+          *segComboBox,
+          *overlapComboBox,
+          *windowComboBox,
+          *unitComboBox;
+
+QCheckBox *logfreqCheckBox;
+
+QPushButton *startButton;
+
+QLabel *statusLabel;
+
+void update_spectrum(void);
+
+private slots:
+
+void start_analysis();
+void preview_timer_handler();
+void unit_changed(int);
+void logfreq_changed(int);
+
+protected:
+  void closeEvent(QCloseEvent *);
+
+};
+
+
+
+#endif
+
+
@@ -0,0 +1,464 @@
+/*
+***************************************************************************
+*
+* Author: Teunis van Beelen
+*
+* Copyright (C) 2015 - 2024 Teunis van Beelen
+*
+* Email: teuniz@protonmail.com
+*
+***************************************************************************
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+***************************************************************************
+*/
+
+
+
+#include "psd_view.h"
+
+
+#define PSD_DB_DIVS    (10)
+#define PSD_DB_PER_DIV (10.0)
+
+
+
+PsdCurve::PsdCurve(QWidget *w_parent) : QWidget(w_parent)
+{
+  setAttribute(Qt::WA_OpaquePaintEvent);
+
+  setMouseTracking(true);
+
+  SignalColor = Qt::yellow;
+  BackgroundColor = Qt::black;
+  RasterColor = Qt::darkGray;
+  TextColor = Qt::white;
+
+  smallfont.setFamily("Arial");
+  smallfont.setPixelSize(10);
+
+  spect = NULL;
+  spect_sz = 0;
+  bins = 0;
+  f_max = 0;
+  db_top = 0;
+  unit_str[0] = 0;
+
+  bordersize = 60;
+
+  log_freq = 0;
+
+  mouse_x = -1;
+  mouse_y = -1;
+}
+
+
+PsdCurve::~PsdCurve()
+{
+  free(spect);
+}
+
+
+void PsdCurve::setSpectrum(const double *data, int n, double fmax, const char *unit)
+{
+  int i;
+
+  double *tmp, max;
+
+  if((n < 2) || (fmax <= 0))
+  {
+    return;
+  }
+
+  if(n > spect_sz)
+  {
+    tmp = (double *)realloc(spect, n * sizeof(double));
+    if(tmp == NULL)
+    {
+      return;
+    }
+
+    spect = tmp;
+
+    spect_sz = n;
+  }
+
+  memcpy(spect, data, n * sizeof(double));
+
+  bins = n;
+
+  f_max = fmax;
+
+  strlcpy(unit_str, unit, 32);
+
+  // DC is left out, it would push the scale up for a trace with an offset
+  max = spect[1];
+
+  for(i=2; i<bins; i++)
+  {
+    if(spect[i] > max)
+    {
+      max = spect[i];
+    }
+  }
+
+  db_top = ceil(max / PSD_DB_PER_DIV) * PSD_DB_PER_DIV;
+
+  update();
+}
+
+
+void PsdCurve::clearSpectrum()
+{
+  bins = 0;
+
+  update();
+}
+
+
+void PsdCurve::setLogFrequency(int val)
+{
+  log_freq = val ? 1 : 0;
+
+  update();
+}
+
+
+double PsdCurve::pix_to_freq(int x, int curve_w)
+{
+  double lg_lo, lg_hi;
+
+  if(log_freq)
+  {
+    lg_lo = log10(f_max / (bins - 1));
+
+    lg_hi = log10(f_max);
+
+    return pow(10.0, lg_lo + (((lg_hi - lg_lo) * x) / curve_w));
+  }
+
+  return (f_max * x) / curve_w;
+}
+
+
+int PsdCurve::freq_to_bin(double freq)
+{
+  int bin;
+
+  bin = ((freq * (bins - 1)) / f_max) + 0.5;
+
+  if(bin < 0)
+  {
+    bin = 0;
+  }
+
+  if(bin >= bins)
+  {
+    bin = bins - 1;
+  }
+
+  return bin;
+}
+
+
+void PsdCurve::paintEvent(QPaintEvent *)
+{
+  int i, j, x, b0, b1,
+      curve_w,
+      curve_h,
+      y_min,
+      y_max,
+      old_y=0;
+
+  double v_min,
+         v_max,
+         freq,
+         step,
+         lg_lo,
+         lg_hi,
+         decade,
+         db_sense;
+
+  char str[512];
+
+  QPainter paint(this);
+#if (QT_VERSION >= 0x050000) && (QT_VERSION < 0x060000)
+  paint.setRenderHint(QPainter::Qt4CompatiblePainting, true);
+#endif
+
+  QPainter *painter = &paint;
+
+  painter->setFont(smallfont);
+
+  curve_w = width();
+
+  curve_h = height();
+
+  painter->fillRect(0, 0, curve_w, curve_h, BackgroundColor);
+
+  if((curve_w < ((bordersize * 2) + 5)) || (curve_h < ((bordersize * 2) + 5)))
+  {
+    return;
+  }
+
+  painter->translate(bordersize, bordersize);
+
+  curve_w -= (bordersize * 2);
+
+  curve_h -= (bordersize * 2);
+
+/////////////////////////////////// draw the rasters ///////////////////////////////////////////
+
+  painter->setPen(RasterColor);
+
+  painter->drawRect (0, 0, curve_w - 1, curve_h - 1);
+
+  if(bins < 2)
+  {
+    painter->setPen(TextColor);
+
+    painter->drawText(0, 0, curve_w, curve_h, Qt::AlignCenter, "No spectrum");
+
+    return;
+  }
+
+  painter->setPen(QPen(QBrush(RasterColor, Qt::SolidPattern), 0, Qt::DotLine, Qt::SquareCap, Qt::BevelJoin));
+
+  step = (double)curve_h / PSD_DB_DIVS;
+
+  for(i=1; i<PSD_DB_DIVS; i++)
+  {
+    painter->drawLine(0, step * i, curve_w - 1, step * i);
+  }
+
+  if(log_freq)
+  {
+    lg_lo = log10(f_max / (bins - 1));
+
+    lg_hi = log10(f_max);
+
+    for(decade=pow(10.0, floor(lg_lo)); decade<f_max; decade*=10.0)
+    {
+      for(j=1; j<10; j++)
+      {
+        freq = decade * j;
+
+        if((freq <= pow(10.0, lg_lo)) || (freq >= f_max))
+        {
+          continue;
+        }
+
+        x = ((log10(freq) - lg_lo) * curve_w) / (lg_hi - lg_lo);
+
+        painter->drawLine(x, curve_h - 1, x, 0);
+
+        if(j == 1)
+        {
+          convert_to_metric_suffix(str, freq, 0, 512);
+
+          strlcat(str, "Hz", 512);
+
+          painter->setPen(TextColor);
+
+          painter->drawText(x - 40, curve_h + 5, 80, 20, Qt::AlignCenter, str);
+
+          painter->setPen(QPen(QBrush(RasterColor, Qt::SolidPattern), 0, Qt::DotLine, Qt::SquareCap, Qt::BevelJoin));
+        }
+      }
+    }
+  }
+  else
+  {
+    step = (double)curve_w / 10.0;
+
+    for(i=1; i<10; i++)
+    {
+      painter->drawLine(step * i, curve_h - 1, step * i, 0);
+    }
+
+    painter->setPen(TextColor);
+
+    for(i=0; i<=10; i++)
+    {
+      convert_to_metric_suffix(str, (f_max * i) / 10.0, 2, 512);
+
+      strlcat(str, "Hz", 512);
+
+      painter->drawText((step * i) - 40, curve_h + 5, 80, 20, Qt::AlignCenter, str);
+    }
+  }
+
+  painter->setPen(TextColor);
+
+  step = (double)curve_h / PSD_DB_DIVS;
+
+  for(i=0; i<=PSD_DB_DIVS; i++)
+  {
+    snprintf(str, 512, "%.0f", db_top - (i * PSD_DB_PER_DIV));
+
+    painter->drawText(-bordersize, (step * i) - 10, bordersize - 5, 20, Qt::AlignRight | Qt::AlignVCenter, str);
+  }
+
+  painter->drawText(-bordersize, -bordersize, bordersize * 2, bordersize - 5, Qt::AlignLeft | Qt::AlignBottom, unit_str);
+
+/////////////////////////////////// draw the curve ///////////////////////////////////////////
+
+  // every column shows the peak and the minimum of the bins it covers,
+  // a narrow spur must stay visible when a million bins are squeezed into a few hundred pixels
+  db_sense = curve_h / (PSD_DB_DIVS * PSD_DB_PER_DIV);
+
+  painter->setClipping(true);
+
+  painter->setClipRect(0, 0, curve_w, curve_h);
+
+  painter->setPen(SignalColor);
+
+  for(x=0; x<curve_w; x++)
+  {
+    b0 = freq_to_bin(pix_to_freq(x, curve_w));
+
+    b1 = freq_to_bin(pix_to_freq(x + 1, curve_w));
+
+    if(b1 <= b0)
+    {
+      b1 = b0 + 1;
+    }
+
+    if(b1 > bins)
+    {
+      b1 = bins;
+    }
+
+    v_min = spect[b0];
+
+    v_max = spect[b0];
+
+    for(i=b0+1; i<b1; i++)
+    {
+      if(spect[i] > v_max)
+      {
+        v_max = spect[i];
+      }
+
+      if(spect[i] < v_min)
+      {
+        v_min = spect[i];
+      }
+    }
+
+    y_max = (db_top - v_max) * db_sense;
+
+    y_min = (db_top - v_min) * db_sense;
+
+    if(x)
+    {
+      painter->drawLine(x - 1, old_y, x, y_max);
+    }
+
+    if(y_min != y_max)
+    {
+      painter->drawLine(x, y_max, x, y_min);
+    }
+
+    old_y = y_max;
+  }
+
+  painter->setClipping(false);
+
+/////////////////////////////////// mouse readout ///////////////////////////////////////////
+
+  x = mouse_x - bordersize;
+
+  if((x >= 0) && (x < curve_w) && (mouse_y >= bordersize) && (mouse_y < (bordersize + curve_h)))
+  {
+    freq = pix_to_freq(x, curve_w);
+
+    b0 = freq_to_bin(freq);
+
+    painter->setPen(QPen(QBrush(TextColor, Qt::SolidPattern), 0, Qt::DashLine, Qt::SquareCap, Qt::BevelJoin));
+
+    painter->drawLine(x, 0, x, curve_h - 1);
+
+    convert_to_metric_suffix(str, (f_max * b0) / (bins - 1), 3, 512);
+
+    snprintf(str + strlen(str), 512 - strlen(str), "Hz  %.1f %s", spect[b0], unit_str);
+
+    painter->setPen(TextColor);
+
+    painter->drawText(curve_w - 300, -bordersize, 300, bordersize - 5, Qt::AlignRight | Qt::AlignBottom, str);
+  }
+}
+
+
+void PsdCurve::mouseMoveEvent(QMouseEvent *move_event)
+{
+#if QT_VERSION < 0x060000
+  mouse_x = move_event->x();
+  mouse_y = move_event->y();
+#else
+  mouse_x = move_event->position().x();
+  mouse_y = move_event->position().y();
+#endif
+
+  update();
+}
+
+
+void PsdCurve::leaveEvent(QEvent *)
+{
+  mouse_x = -1;
+
+  mouse_y = -1;
+
+  update();
+}
+
+
+void PsdCurve::setSignalColor(QColor newColor)
+{
+  SignalColor = newColor;
+  update();
+}
+
+
+void PsdCurve::setBackgroundColor(QColor newColor)
+{
+  BackgroundColor = newColor;
+  update();
+}
+
+
+void PsdCurve::setRasterColor(QColor newColor)
+{
+  RasterColor = newColor;
+  update();
+}
+
+
+void PsdCurve::setTextColor(QColor newColor)
+{
+  TextColor = newColor;
+  update();
+}
+
+
+void PsdCurve::setBorderSize(int newsize)
+{
+  bordersize = newsize;
+  if(bordersize < 0)  bordersize = 0;
+  update();
+}
+
+
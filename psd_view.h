@@ -0,0 +1,102 @@
+/*
+***************************************************************************
+*
+* Author: Teunis van Beelen
+*
+* Copyright (C) 2015 - 2024 Teunis van Beelen
+*
+* Email: teuniz@protonmail.com
+*
+***************************************************************************
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+***************************************************************************
+*/
+
+
+
+#ifndef PSDCURVE_H
+#define PSDCURVE_H
+
+
+#include "qt_headers.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "global.h"
+#include "utils.h"
+
+
+class PsdCurve: public QWidget
+{
+  Q_OBJECT
+
+public:
+  PsdCurve(QWidget *parent=0);
+  ~PsdCurve();
+
+  QSize sizeHint() const {return minimumSizeHint(); }
+  QSize minimumSizeHint() const {return QSize(30,10); }
+
+  void setSignalColor(QColor);
+  void setBackgroundColor(QColor);
+  void setRasterColor(QColor);
+  void setTextColor(QColor);
+  void setBorderSize(int);
+  void setLogFrequency(int);
+
+  /* bins from 0 to f_max in dB, the data is copied */
+  void setSpectrum(const double *, int, double, const char *);
+  void clearSpectrum();
+
+private:
+
+  QColor SignalColor,
+         BackgroundColor,
+         RasterColor,
+         TextColor;
+
+  QFont smallfont;
+
+  double *spect,
+         f_max,
+         db_top;
+
+  char unit_str[32];
+
+  int bins,
+      spect_sz,
+      bordersize,
+      log_freq,
+      mouse_x,
+      mouse_y;
+
+  double pix_to_freq(int, int);
+  int freq_to_bin(double);
+
+protected:
+  void paintEvent(QPaintEvent *);
+  void mouseMoveEvent(QMouseEvent *);
+  void leaveEvent(QEvent *);
+
+};
+
+
+#endif
+
+
@@ -101,15 +101,13 @@ void read_settings_thread::run()
   {
     snprintf(str, 512, ":CHAN%i:BWL?", chn + 1);
 
-    usleep(TMC_GDS_DELAY);
-
-    if(tmc_write(str) != 11)
+    if(tmc_write(device, str) != 11)
     {
       line = __LINE__;
       goto GDS_OUT_ERROR;
     }
 
-    if(tmc_read() < 1)
+    if(tmc_read(device) < 1)
     {
       line = __LINE__;
       goto GDS_OUT_ERROR;
@@ -135,15 +133,13 @@ void read_settings_thread::run()
 
     snprintf(str, 512, ":CHAN%i:COUP?", chn + 1);
 
-    usleep(TMC_GDS_DELAY);
-
-    if(tmc_write(str) != 12)
+    if(tmc_write(device, str) != 12)
     {
       line = __LINE__;
       goto GDS_OUT_ERROR;
     }
 
-    if(tmc_read() < 1)
+    if(tmc_read(device) < 1)
     {
       line = __LINE__;
       goto GDS_OUT_ERROR;
@@ -169,15 +165,13 @@ void read_settings_thread::run()
 
     snprintf(str, 512, ":CHAN%i:DISP?", chn + 1);
 
-    usleep(TMC_GDS_DELAY);
-
-    if(tmc_write(str) != 12)
+    if(tmc_write(device, str) != 12)
     {
       line = __LINE__;
       goto GDS_OUT_ERROR;
     }
 
-    if(tmc_read() < 1)
+    if(tmc_read(device) < 1)
     {
       line = __LINE__;
       goto GDS_OUT_ERROR;
@@ -206,15 +200,13 @@ void read_settings_thread::run()
     {
       snprintf(str, 512, ":CHAN%i:IMP?", chn + 1);
 
-      usleep(TMC_GDS_DELAY);
-
-      if(tmc_write(str) != 11)
+      if(tmc_write(device, str) != 11)
       {
         line = __LINE__;
         goto GDS_OUT_ERROR;
       }
 
-      if(tmc_read() < 1)
+      if(tmc_read(device) < 1)
       {
         line = __LINE__;
         goto GDS_OUT_ERROR;
@@ -237,15 +229,13 @@ void read_settings_thread::run()
 
     snprintf(str, 512, ":CHAN%i:INVert?", chn + 1);
 
-    usleep(TMC_GDS_DELAY);
-
-    if(tmc_write(str) != 14)
+    if(tmc_write(device, str) != 14)
     {
       line = __LINE__;
       goto GDS_OUT_ERROR;
     }
 
-    if(tmc_read() < 1)
+    if(tmc_read(device) < 1)
     {
       line = __LINE__;
       goto GDS_OUT_ERROR;
@@ -267,15 +257,13 @@ void read_settings_thread::run()
 
     snprintf(str, 512, ":CHAN%i:OFFS?", chn + 1);
 
-    usleep(TMC_GDS_DELAY);
-
-    if(tmc_write(str) != 12)
+    if(tmc_write(device, str) != 12)
     {
       line = __LINE__;
       goto GDS_OUT_ERROR;
     }
 
-    if(tmc_read() < 1)
+    if(tmc_read(device) < 1)
     {
       line = __LINE__;
       goto GDS_OUT_ERROR;
@@ -285,15 +273,13 @@ void read_settings_thread::run()
 
     snprintf(str, 512, ":CHAN%i:PROB?", chn + 1);
 
-    usleep(TMC_GDS_DELAY);
-
-    if(tmc_write(str) != 12)
+    if(tmc_write(device, str) != 12)
     {
       line = __LINE__;
       goto GDS_OUT_ERROR;
     }
 
-    if(tmc_read() < 1)
+    if(tmc_read(device) < 1)
     {
       line = __LINE__;
       goto GDS_OUT_ERROR;
@@ -303,15 +289,13 @@ void read_settings_thread::run()
 
     snprintf(str, 512, ":CHAN%i:UNIT?", chn + 1);
 
-    usleep(TMC_GDS_DELAY);
-
-    if(tmc_write(str) != 12)
+    if(tmc_write(device, str) != 12)
     {
       line = __LINE__;
       goto GDS_OUT_ERROR;
     }
 
-    if(tmc_read() < 1)
+    if(tmc_read(device) < 1)
     {
       line = __LINE__;
       goto GDS_OUT_ERROR;
@@ -340,15 +324,13 @@ void read_settings_thread::run()
 
     snprintf(str, 512, ":CHAN%i:SCAL?", chn + 1);
 
-    usleep(TMC_GDS_DELAY);
-
-    if(tmc_write(str) != 12)
+    if(tmc_write(device, str) != 12)
     {
       line = __LINE__;
       goto GDS_OUT_ERROR;
     }
 
-    if(tmc_read() < 1)
+    if(tmc_read(device) < 1)
     {
       line = __LINE__;
       goto GDS_OUT_ERROR;
@@ -358,15 +340,13 @@ void read_settings_thread::run()
 
     snprintf(str, 512, ":CHAN%i:VERN?", chn + 1);
 
-    usleep(TMC_GDS_DELAY);
-
-    if(tmc_write(str) != 12)
+    if(tmc_write(device, str) != 12)
     {
       line = __LINE__;
       goto GDS_OUT_ERROR;
     }
 
-    if(tmc_read() < 1)
+    if(tmc_read(device) < 1)
     {
       line = __LINE__;
       goto GDS_OUT_ERROR;
@@ -387,17 +367,15 @@ void read_settings_thread::run()
       }
   }
 
-  usleep(TMC_GDS_DELAY);
-
   strlcpy(str, ":TIM:OFFS?", 512);
 
-  if(tmc_write(str) != 10)
+  if(tmc_write(device, str) != 10)
   {
     line = __LINE__;
     goto GDS_OUT_ERROR;
   }
 
-  if(tmc_read() < 1)
+  if(tmc_read(device) < 1)
   {
     line = __LINE__;
     goto GDS_OUT_ERROR;
@@ -405,17 +383,15 @@ void read_settings_thread::run()
 
   devparms->timebaseoffset = atof(device->buf);
 
-  usleep(TMC_GDS_DELAY);
-
   strlcpy(str, ":TIM:SCAL?", 512);
 
-  if(tmc_write(str) != 10)
+  if(tmc_write(device, str) != 10)
   {
     line = __LINE__;
     goto GDS_OUT_ERROR;
   }
 
-  if(tmc_read() < 1)
+  if(tmc_read(device) < 1)
   {
     line = __LINE__;
     goto GDS_OUT_ERROR;
@@ -423,17 +399,15 @@ void read_settings_thread::run()
 
   devparms->timebasescale = atof(device->buf);
 
-  usleep(TMC_GDS_DELAY);
-
   strlcpy(str, ":TIM:DEL:ENAB?", 512);
 
-  if(tmc_write(str) != 14)
+  if(tmc_write(device, str) != 14)
   {
     line = __LINE__;
     goto GDS_OUT_ERROR;
   }
 
-  if(tmc_read() < 1)
+  if(tmc_read(device) < 1)
   {
     line = __LINE__;
     goto GDS_OUT_ERROR;
@@ -453,17 +427,15 @@ void read_settings_thread::run()
       goto GDS_OUT_ERROR;
     }
 
-  usleep(TMC_GDS_DELAY);
-
   strlcpy(str, ":TIM:DEL:OFFS?", 512);
 
-  if(tmc_write(str) != 14)
+  if(tmc_write(device, str) != 14)
   {
     line = __LINE__;
     goto GDS_OUT_ERROR;
   }
 
-  if(tmc_read() < 1)
+  if(tmc_read(device) < 1)
   {
     line = __LINE__;
     goto GDS_OUT_ERROR;
@@ -471,17 +443,15 @@ void read_settings_thread::run()
 
   devparms->timebasedelayoffset = atof(device->buf);
 
-  usleep(TMC_GDS_DELAY);
-
   strlcpy(str, ":TIM:DEL:SCAL?", 512);
 
-  if(tmc_write(str) != 14)
+  if(tmc_write(device, str) != 14)
   {
     line = __LINE__;
     goto GDS_OUT_ERROR;
   }
 
-  if(tmc_read() < 1)
+  if(tmc_read(device) < 1)
   {
     line = __LINE__;
     goto GDS_OUT_ERROR;
@@ -491,17 +461,15 @@ void read_settings_thread::run()
 
   if(devparms->modelserie != 1)
   {
-    usleep(TMC_GDS_DELAY);
-
     strlcpy(str, ":TIM:HREF:MODE?", 512);
 
-    if(tmc_write(str) != 15)
+    if(tmc_write(device, str) != 15)
     {
       line = __LINE__;
       goto GDS_OUT_ERROR;
     }
 
-    if(tmc_read() < 1)
+    if(tmc_read(device) < 1)
     {
       line = __LINE__;
       goto GDS_OUT_ERROR;
@@ -525,17 +493,15 @@ void read_settings_thread::run()
           goto GDS_OUT_ERROR;
         }
 
-    usleep(TMC_GDS_DELAY);
-
     strlcpy(str, ":TIM:HREF:POS?", 512);
 
-    if(tmc_write(str) != 14)
+    if(tmc_write(device, str) != 14)
     {
       line = __LINE__;
       goto GDS_OUT_ERROR;
     }
 
-    if(tmc_read() < 1)
+    if(tmc_read(device) < 1)
     {
       line = __LINE__;
       goto GDS_OUT_ERROR;
@@ -544,17 +510,15 @@ void read_settings_thread::run()
     devparms->timebasehrefpos = atoi(device->buf);
   }
 
-  usleep(TMC_GDS_DELAY);
-
   strlcpy(str, ":TIM:MODE?", 512);
 
-  if(tmc_write(str) != 10)
+  if(tmc_write(device, str) != 10)
   {
     line = __LINE__;
     goto GDS_OUT_ERROR;
   }
 
-  if(tmc_read() < 1)
+  if(tmc_read(device) < 1)
   {
     line = __LINE__;
     goto GDS_OUT_ERROR;
@@ -580,17 +544,15 @@ void read_settings_thread::run()
 
   if(devparms->modelserie != 1)
   {
-    usleep(TMC_GDS_DELAY);
-
     strlcpy(str, ":TIM:VERN?", 512);
 
-    if(tmc_write(str) != 10)
+    if(tmc_write(device, str) != 10)
     {
       line = __LINE__;
       goto GDS_OUT_ERROR;
     }
 
-    if(tmc_read() < 1)
+    if(tmc_read(device) < 1)
     {
       line = __LINE__;
       goto GDS_OUT_ERROR;
@@ -613,17 +575,15 @@ void read_settings_thread::run()
 
   if((devparms->modelserie != 1) && (devparms->modelserie != 2) && (devparms->modelserie != 7))
   {
-    usleep(TMC_GDS_DELAY);
-
     strlcpy(str, ":TIM:XY1:DISP?", 512);
 
-    if(tmc_write(str) != 14)
+    if(tmc_write(device, str) != 14)
     {
       line = __LINE__;
       goto GDS_OUT_ERROR;
     }
 
-    if(tmc_read() < 1)
+    if(tmc_read(device) < 1)
     {
       line = __LINE__;
       goto GDS_OUT_ERROR;
@@ -643,17 +603,15 @@ void read_settings_thread::run()
         goto GDS_OUT_ERROR;
       }
 
-    usleep(TMC_GDS_DELAY);
-
     strlcpy(str, ":TIM:XY2:DISP?", 512);
 
-    if(tmc_write(str) != 14)
+    if(tmc_write(device, str) != 14)
     {
       line = __LINE__;
       goto GDS_OUT_ERROR;
     }
 
-    if(tmc_read() < 1)
+    if(tmc_read(device) < 1)
     {
       line = __LINE__;
       goto GDS_OUT_ERROR;
@@ -674,17 +632,15 @@ void read_settings_thread::run()
       }
   }
 
-  usleep(TMC_GDS_DELAY);
-
   strlcpy(str, ":TRIG:COUP?", 512);
 
-  if(tmc_write(str) != 11)
+  if(tmc_write(device, str) != 11)
   {
     line = __LINE__;
     goto GDS_OUT_ERROR;
   }
 
-  if(tmc_read() < 1)
+  if(tmc_read(device) < 1)
   {
     line = __LINE__;
     goto GDS_OUT_ERROR;
@@ -712,17 +668,15 @@ void read_settings_thread::run()
           goto GDS_OUT_ERROR;
         }
 
-  usleep(TMC_GDS_DELAY);
-
   strlcpy(str, ":TRIG:SWE?", 512);
 
-  if(tmc_write(str) != 10)
+  if(tmc_write(device, str) != 10)
   {
     line = __LINE__;
     goto GDS_OUT_ERROR;
   }
 
-  if(tmc_read() < 1)
+  if(tmc_read(device) < 1)
   {
     line = __LINE__;
     goto GDS_OUT_ERROR;
@@ -746,17 +700,15 @@ void read_settings_thread::run()
         goto GDS_OUT_ERROR;
       }
 
-  usleep(TMC_GDS_DELAY);
-
   strlcpy(str, ":TRIG:MODE?", 512);
 
-  if(tmc_write(str) != 11)
+  if(tmc_write(device, str) != 11)
   {
     line = __LINE__;
     goto GDS_OUT_ERROR;
   }
 
-  if(tmc_read() < 1)
+  if(tmc_read(device) < 1)
   {
     line = __LINE__;
     goto GDS_OUT_ERROR;
@@ -836,17 +788,15 @@ void read_settings_thread::run()
                                     goto GDS_OUT_ERROR;
                                   }
 
-  usleep(TMC_GDS_DELAY);
-
   strlcpy(str, ":TRIG:STAT?", 512);
 
-  if(tmc_write(str) != 11)
+  if(tmc_write(device, str) != 11)
   {
     line = __LINE__;
     goto GDS_OUT_ERROR;
   }
 
-  if(tmc_read() < 1)
+  if(tmc_read(device) < 1)
   {
     line = __LINE__;
     goto GDS_OUT_ERROR;
@@ -882,13 +832,11 @@ void read_settings_thread::run()
               goto GDS_OUT_ERROR;
             }
 
-  usleep(TMC_GDS_DELAY);
-
   if(devparms->modelserie == 7)
   {
     strlcpy(str, ":TRIGger:EDGe:SLOPe?", 512);
 
-    if(tmc_write(str) != 20)
+    if(tmc_write(device, str) != 20)
     {
       line = __LINE__;
       goto GDS_OUT_ERROR;
@@ -898,7 +846,7 @@ void read_settings_thread::run()
   {
   strlcpy(str, ":TRIG:EDG:SLOP?", 512);
 
-  if(tmc_write(str) != 15)
+  if(tmc_write(device, str) != 15)
   {
     line = __LINE__;
     goto GDS_OUT_ERROR;
@@ -907,7 +855,7 @@ void read_settings_thread::run()
   
   
 
-  if(tmc_read() < 1)
+  if(tmc_read(device) < 1)
   {
     line = __LINE__;
     goto GDS_OUT_ERROR;
@@ -931,13 +879,11 @@ void read_settings_thread::run()
         goto GDS_OUT_ERROR;
       }
 
-  usleep(TMC_GDS_DELAY);
-
   if(devparms->modelserie == 7)
   {
     strlcpy(str, ":TRIGger:EDGe:SOURce?", 512);
 
-    if(tmc_write(str) != 21)
+    if(tmc_write(device, str) != 21)
     {
       line = __LINE__;
       goto GDS_OUT_ERROR;
@@ -947,14 +893,14 @@ void read_settings_thread::run()
   {
   strlcpy(str, ":TRIG:EDG:SOUR?", 512);
 
-  if(tmc_write(str) != 15)
+  if(tmc_write(device, str) != 15)
   {
     line = __LINE__;
     goto GDS_OUT_ERROR;
   }
   }
 
-  if(tmc_read() < 1)
+  if(tmc_read(device) < 1)
   {
     line = __LINE__;
     goto GDS_OUT_ERROR;
@@ -998,17 +944,13 @@ void read_settings_thread::run()
                   {
                     devparms->triggeredgesource = 0;
 
-                    usleep(TMC_GDS_DELAY);
-
                     strlcpy(str, ":TRIG:EDGe:SOUR CHAN1", 512);
 
-                    if(tmc_write(str) != 20)
+                    if(tmc_write(device, str) != 20)
                     {
                       line = __LINE__;
                       goto GDS_OUT_ERROR;
                     }
-
-                    usleep(TMC_GDS_DELAY);
                   }
                 }
                 else
@@ -1022,25 +964,21 @@ void read_settings_thread::run()
   {
     snprintf(str, 512, ":TRIG:EDGe:SOUR CHAN%i", chn + 1);
 
-    usleep(TMC_GDS_DELAY);
-
-    if(tmc_write(str) != 21)
+    if(tmc_write(device, str) != 21)
     {
       line = __LINE__;
       goto GDS_OUT_ERROR;
     }
 
-    usleep(TMC_GDS_DELAY);
-
     strlcpy(str, ":TRIG:EDGe:LEV?", 512);
 
-    if(tmc_write(str) != 15)
+    if(tmc_write(device, str) != 15)
     {
       line = __LINE__;
       goto GDS_OUT_ERROR;
     }
 
-    if(tmc_read() < 1)
+    if(tmc_read(device) < 1)
     {
       line = __LINE__;
       goto GDS_OUT_ERROR;
@@ -1054,9 +992,7 @@ void read_settings_thread::run()
   {
     snprintf(str, 512, ":TRIG:EDGe:SOUR CHAN%i", devparms->triggeredgesource + 1);
 
-    usleep(TMC_GDS_DELAY);
-
-    if(tmc_write(str) != 21)
+    if(tmc_write(device, str) != 21)
     {
       line = __LINE__;
       goto GDS_OUT_ERROR;
@@ -1064,11 +1000,9 @@ void read_settings_thread::run()
   }
   else if(devparms->triggeredgesource == TRIG_SRC_EXT)
     {
-      usleep(TMC_GDS_DELAY);
-
       strlcpy(str, ":TRIG:EDGe:SOUR EXT", 512);
 
-      if(tmc_write(str) != 19)
+      if(tmc_write(device, str) != 19)
       {
         line = __LINE__;
         goto GDS_OUT_ERROR;
@@ -1076,11 +1010,9 @@ void read_settings_thread::run()
     }
     else if(devparms->triggeredgesource == TRIG_SRC_EXT5)
       {
-        usleep(TMC_GDS_DELAY);
-
         strlcpy(str, ":TRIG:EDGe:SOUR EXT5", 512);
 
-        if(tmc_write(str) != 20)
+        if(tmc_write(device, str) != 20)
         {
           line = __LINE__;
           goto GDS_OUT_ERROR;
@@ -1088,11 +1020,9 @@ void read_settings_thread::run()
       }
       else if(devparms->triggeredgesource == TRIG_SRC_ACL)
         {
-          usleep(TMC_GDS_DELAY);
-
           strlcpy(str, ":TRIG:EDGe:SOUR AC", 512);
 
-          if(tmc_write(str) != 18)
+          if(tmc_write(device, str) != 18)
           {
             line = __LINE__;
             goto GDS_OUT_ERROR;
@@ -1102,26 +1032,22 @@ void read_settings_thread::run()
           {
             snprintf(str, 512, ":TRIG:EDGe:SOUR D%i", devparms->triggeredgesource - TRIG_SRC_LA_D0);
 
-            usleep(TMC_GDS_DELAY);
-
-            if((tmc_write(str) != 18) && (tmc_write(str) != 19))
+            if((tmc_write(device, str) != 18) && (tmc_write(device, str) != 19))
             {
               line = __LINE__;
               goto GDS_OUT_ERROR;
             }
           }
 
-  usleep(TMC_GDS_DELAY);
-
   strlcpy(str, ":TRIG:HOLD?", 512);
 
-  if(tmc_write(str) != 11)
+  if(tmc_write(device, str) != 11)
   {
     line = __LINE__;
     goto GDS_OUT_ERROR;
   }
 
-  if(tmc_read() < 1)
+  if(tmc_read(device) < 1)
   {
     line = __LINE__;
     goto GDS_OUT_ERROR;
@@ -1129,17 +1055,15 @@ void read_settings_thread::run()
 
   devparms->triggerholdoff = atof(device->buf);
 
-  usleep(TMC_GDS_DELAY);
-
   strlcpy(str, ":ACQ:SRAT?", 512);
 
-  if(tmc_write(str) != 10)
+  if(tmc_write(device, str) != 10)
   {
     line = __LINE__;
     goto GDS_OUT_ERROR;
   }
 
-  if(tmc_read() < 1)
+  if(tmc_read(device) < 1)
   {
     line = __LINE__;
     goto GDS_OUT_ERROR;
@@ -1147,17 +1071,15 @@ void read_settings_thread::run()
 
   devparms->samplerate = atof(device->buf);
 
-  usleep(TMC_GDS_DELAY);
-
   strlcpy(str, ":DISP:GRID?", 512);
 
-  if(tmc_write(str) != 11)
+  if(tmc_write(device, str) != 11)
   {
     line = __LINE__;
     goto GDS_OUT_ERROR;
   }
 
-  if(tmc_read() < 1)
+  if(tmc_read(device) < 1)
   {
     line = __LINE__;
     goto GDS_OUT_ERROR;
@@ -1181,17 +1103,15 @@ void read_settings_thread::run()
         goto GDS_OUT_ERROR;
       }
 
-  usleep(TMC_GDS_DELAY);
-
   strlcpy(str, ":MEAS:COUN:SOUR?", 512);
 
-  if(tmc_write(str) != 16)
+  if(tmc_write(device, str) != 16)
   {
     line = __LINE__;
     goto GDS_OUT_ERROR;
   }
 
-  if(tmc_read() < 1)
+  if(tmc_read(device) < 1)
   {
     line = __LINE__;
     goto GDS_OUT_ERROR;
@@ -1223,17 +1143,15 @@ void read_settings_thread::run()
             goto GDS_OUT_ERROR;
           }
 
-  usleep(TMC_GDS_DELAY);
-
   strlcpy(str, ":DISP:TYPE?", 512);
 
-  if(tmc_write(str) != 11)
+  if(tmc_write(device, str) != 11)
   {
     line = __LINE__;
     goto GDS_OUT_ERROR;
   }
 
-  if(tmc_read() < 1)
+  if(tmc_read(device) < 1)
   {
     line = __LINE__;
     goto GDS_OUT_ERROR;
@@ -1253,17 +1171,15 @@ void read_settings_thread::run()
       goto GDS_OUT_ERROR;
     }
 
-  usleep(TMC_GDS_DELAY);
-
   strlcpy(str, ":ACQ:TYPE?", 512);
 
-  if(tmc_write(str) != 10)
+  if(tmc_write(device, str) != 10)
   {
     line = __LINE__;
     goto GDS_OUT_ERROR;
   }
 
-  if(tmc_read() < 1)
+  if(tmc_read(device) < 1)
   {
     line = __LINE__;
     goto GDS_OUT_ERROR;
@@ -1291,17 +1207,15 @@ void read_settings_thread::run()
           goto GDS_OUT_ERROR;
         }
 
-  usleep(TMC_GDS_DELAY);
-
   strlcpy(str, ":ACQ:AVER?", 512);
 
-  if(tmc_write(str) != 10)
+  if(tmc_write(device, str) != 10)
   {
     line = __LINE__;
     goto GDS_OUT_ERROR;
   }
 
-  if(tmc_read() < 1)
+  if(tmc_read(device) < 1)
   {
     line = __LINE__;
     goto GDS_OUT_ERROR;
@@ -1309,17 +1223,15 @@ void read_settings_thread::run()
 
   devparms->acquireaverages = atoi(device->buf);
 
-  usleep(TMC_GDS_DELAY);
-
   strlcpy(str, ":DISP:GRAD:TIME?", 512);
 
-  if(tmc_write(str) != 16)
+  if(tmc_write(device, str) != 16)
   {
     line = __LINE__;
     goto GDS_OUT_ERROR;
   }
 
-  if(tmc_read() < 1)
+  if(tmc_read(device) < 1)
   {
     line = __LINE__;
     goto GDS_OUT_ERROR;
@@ -1367,8 +1279,6 @@ void read_settings_thread::run()
                     goto GDS_OUT_ERROR;
                   }
 
-  usleep(TMC_GDS_DELAY);
-
   if(devparms->modelserie == 7)
   {
     devparms->math_fft_split = 0;
@@ -1379,7 +1289,7 @@ void read_settings_thread::run()
   {
     strlcpy(str, ":CALC:FFT:SPL?", 512);
 
-    if(tmc_write(str) != 14)
+    if(tmc_write(device, str) != 14)
     {
       line = __LINE__;
       goto GDS_OUT_ERROR;
@@ -1389,35 +1299,33 @@ void read_settings_thread::run()
   {
     strlcpy(str, ":MATH:FFT:SPL?", 512);
 
-    if(tmc_write(str) != 14)
+    if(tmc_write(device, str) != 14)
     {
       line = __LINE__;
       goto GDS_OUT_ERROR;
     }
   }
 
-  if(tmc_read() < 1)
+  if(tmc_read(device) < 1)
   {
     line = __LINE__;
     goto GDS_OUT_ERROR;
   }
 
   devparms->math_fft_split = atoi(device->buf);
-
-  usleep(TMC_GDS_DELAY);
   }
 
   if(devparms->modelserie != 1 && devparms->modelserie != 7)
   {
     strlcpy(str, ":CALC:MODE?", 512);
 
-    if(tmc_write(str) != 11)
+    if(tmc_write(device, str) != 11)
     {
       line = __LINE__;
       goto GDS_OUT_ERROR;
     }
 
-    if(tmc_read() < 1)
+    if(tmc_read(device) < 1)
     {
       line = __LINE__;
       goto GDS_OUT_ERROR;
@@ -1438,7 +1346,7 @@ void read_settings_thread::run()
     {
       strlcpy(str, ":MATH1:DISP?", 512);
 
-      if(tmc_write(str) != 12)
+      if(tmc_write(device, str) != 12)
       {
         line = __LINE__;
         goto GDS_OUT_ERROR;
@@ -1448,14 +1356,14 @@ void read_settings_thread::run()
     {
     strlcpy(str, ":MATH:DISP?", 512);
 
-    if(tmc_write(str) != 11)
+    if(tmc_write(device, str) != 11)
     {
       line = __LINE__;
       goto GDS_OUT_ERROR;
     }
     }
 
-    if(tmc_read() < 1)
+    if(tmc_read(device) < 1)
     {
       line = __LINE__;
       goto GDS_OUT_ERROR;
@@ -1465,13 +1373,11 @@ void read_settings_thread::run()
 
     if(devparms->math_fft == 1)
     {
-      usleep(TMC_GDS_DELAY);
-
       if(devparms->modelserie == 7)
       {
         strlcpy(str, ":MATH1:OPER?", 512);
 
-        if(tmc_write(str) != 12)
+        if(tmc_write(device, str) != 12)
         {
           line = __LINE__;
           goto GDS_OUT_ERROR;
@@ -1481,14 +1387,14 @@ void read_settings_thread::run()
       {
       strlcpy(str, ":MATH:OPER?", 512);
 
-      if(tmc_write(str) != 11)
+      if(tmc_write(device, str) != 11)
       {
         line = __LINE__;
         goto GDS_OUT_ERROR;
       }
       }
 
-      if(tmc_read() < 1)
+      if(tmc_read(device) < 1)
       {
         line = __LINE__;
         goto GDS_OUT_ERROR;
@@ -1505,13 +1411,11 @@ void read_settings_thread::run()
     }
   }
 
-  usleep(TMC_GDS_DELAY);
-
   if(devparms->modelserie == 7)
   {
     strlcpy(str, ":MATH1:FFT:UNIT?", 512);
 
-    if(tmc_write(str) != 16)
+    if(tmc_write(device, str) != 16)
     {
       line = __LINE__;
       goto GDS_OUT_ERROR;
@@ -1521,7 +1425,7 @@ void read_settings_thread::run()
   {
     strlcpy(str, ":CALC:FFT:VSM?", 512);
 
-    if(tmc_write(str) != 14)
+    if(tmc_write(device, str) != 14)
     {
       line = __LINE__;
       goto GDS_OUT_ERROR;
@@ -1531,14 +1435,14 @@ void read_settings_thread::run()
   {
     strlcpy(str, ":MATH:FFT:UNIT?", 512);
 
-    if(tmc_write(str) != 15)
+    if(tmc_write(device, str) != 15)
     {
       line = __LINE__;
       goto GDS_OUT_ERROR;
     }
   }
 
-  if(tmc_read() < 1)
+  if(tmc_read(device) < 1)
   {
     line = __LINE__;
     goto GDS_OUT_ERROR;
@@ -1561,13 +1465,11 @@ void read_settings_thread::run()
     devparms->math_fft_unit = 1;
   }
 
-  usleep(TMC_GDS_DELAY);
-
   if(devparms->modelserie == 7)
   {
     strlcpy(str, ":MATH1:FFT:SOUR?", 512);
 
-    if(tmc_write(str) != 16)
+    if(tmc_write(device, str) != 16)
     {
       line = __LINE__;
       goto GDS_OUT_ERROR;
@@ -1577,7 +1479,7 @@ void read_settings_thread::run()
   {
     strlcpy(str, ":CALC:FFT:SOUR?", 512);
 
-    if(tmc_write(str) != 15)
+    if(tmc_write(device, str) != 15)
     {
       line = __LINE__;
       goto GDS_OUT_ERROR;
@@ -1587,14 +1489,14 @@ void read_settings_thread::run()
   {
     strlcpy(str, ":MATH:FFT:SOUR?", 512);
 
-    if(tmc_write(str) != 15)
+    if(tmc_write(device, str) != 15)
     {
       line = __LINE__;
       goto GDS_OUT_ERROR;
     }
   }
 
-  if(tmc_read() < 1)
+  if(tmc_read(device) < 1)
   {
     line = __LINE__;
     goto GDS_OUT_ERROR;
@@ -1621,21 +1523,19 @@ void read_settings_thread::run()
           devparms->math_fft_src = 0;
         }
 
-  usleep(TMC_GDS_DELAY);
-
   devparms->current_screen_sf = 100.0 / devparms->timebasescale;
 
   if(devparms->modelserie == 7)
   {
     strlcpy(str, ":MATH1:FFT:HSC?", 512);
 
-    if(tmc_write(str) != 15)
+    if(tmc_write(device, str) != 15)
     {
       line = __LINE__;
       goto GDS_OUT_ERROR;
     }
 
-    if(tmc_read() < 1)
+    if(tmc_read(device) < 1)
     {
       line = __LINE__;
       goto GDS_OUT_ERROR;
@@ -1647,13 +1547,13 @@ void read_settings_thread::run()
   {
     strlcpy(str, ":CALC:FFT:HSP?", 512);
 
-    if(tmc_write(str) != 14)
+    if(tmc_write(device, str) != 14)
     {
       line = __LINE__;
       goto GDS_OUT_ERROR;
     }
 
-    if(tmc_read() < 1)
+    if(tmc_read(device) < 1)
     {
       line = __LINE__;
       goto GDS_OUT_ERROR;
@@ -1663,13 +1563,13 @@ void read_settings_thread::run()
 
 //     strlcpy(str, ":CALC:FFT:HSC?", 512);
 //
-//     if(tmc_write(str) != 14)
+//     if(tmc_write(device, str) != 14)
 //     {
 //       line = __LINE__;
 //       goto GDS_OUT_ERROR;
 //     }
 //
-//     if(tmc_read() < 1)
+//     if(tmc_read(device) < 1)
 //     {
 //       line = __LINE__;
 //       goto GDS_OUT_ERROR;
@@ -1693,13 +1593,13 @@ void read_settings_thread::run()
   {
     strlcpy(str, ":MATH:FFT:HSC?", 512);
 
-    if(tmc_write(str) != 14)
+    if(tmc_write(device, str) != 14)
     {
       line = __LINE__;
       goto GDS_OUT_ERROR;
     }
 
-    if(tmc_read() < 1)
+    if(tmc_read(device) < 1)
     {
       line = __LINE__;
       goto GDS_OUT_ERROR;
@@ -1708,13 +1608,11 @@ void read_settings_thread::run()
     devparms->math_fft_hscale = atof(device->buf);
   }
 
-  usleep(TMC_GDS_DELAY);
-
   if(devparms->modelserie == 7)
   {
     strlcpy(str, ":MATH1:FFT:HCEN?", 512);
 
-    if(tmc_write(str) != 16)
+    if(tmc_write(device, str) != 16)
     {
       line = __LINE__;
       goto GDS_OUT_ERROR;
@@ -1724,7 +1622,7 @@ void read_settings_thread::run()
   {
     strlcpy(str, ":CALC:FFT:HCEN?", 512);
 
-    if(tmc_write(str) != 15)
+    if(tmc_write(device, str) != 15)
     {
       line = __LINE__;
       goto GDS_OUT_ERROR;
@@ -1734,14 +1632,14 @@ void read_settings_thread::run()
   {
     strlcpy(str, ":MATH:FFT:HCEN?", 512);
 
-    if(tmc_write(str) != 15)
+    if(tmc_write(device, str) != 15)
     {
       line = __LINE__;
       goto GDS_OUT_ERROR;
     }
   }
 
-  if(tmc_read() < 1)
+  if(tmc_read(device) < 1)
   {
     line = __LINE__;
     goto GDS_OUT_ERROR;
@@ -1749,19 +1647,17 @@ void read_settings_thread::run()
 
   devparms->math_fft_hcenter = atof(device->buf);
 
-  usleep(TMC_GDS_DELAY);
-
   if(devparms->modelserie == 7)
   {
     strlcpy(str, ":MATH1:OFFS?", 512);
 
-    if(tmc_write(str) != 12)
+    if(tmc_write(device, str) != 12)
     {
       line = __LINE__;
       goto GDS_OUT_ERROR;
     }
 
-    if(tmc_read() < 1)
+    if(tmc_read(device) < 1)
     {
       line = __LINE__;
       goto GDS_OUT_ERROR;
@@ -1773,13 +1669,13 @@ void read_settings_thread::run()
   {
     strlcpy(str, ":CALC:FFT:VOFF?", 512);
 
-    if(tmc_write(str) != 15)
+    if(tmc_write(device, str) != 15)
     {
       line = __LINE__;
       goto GDS_OUT_ERROR;
     }
 
-    if(tmc_read() < 1)
+    if(tmc_read(device) < 1)
     {
       line = __LINE__;
       goto GDS_OUT_ERROR;
@@ -1791,13 +1687,13 @@ void read_settings_thread::run()
   {
     strlcpy(str, ":MATH:OFFS?", 512);
 
-    if(tmc_write(str) != 11)
+    if(tmc_write(device, str) != 11)
     {
       line = __LINE__;
       goto GDS_OUT_ERROR;
     }
 
-    if(tmc_read() < 1)
+    if(tmc_read(device) < 1)
     {
       line = __LINE__;
       goto GDS_OUT_ERROR;
@@ -1806,19 +1702,17 @@ void read_settings_thread::run()
     devparms->fft_voffset = atof(device->buf);
   }
 
-  usleep(TMC_GDS_DELAY);
-
   if(devparms->modelserie == 7)
   {
     strlcpy(str, ":MATH1:SCAL?", 512);
 
-    if(tmc_write(str) != 12)
+    if(tmc_write(device, str) != 12)
     {
       line = __LINE__;
       goto GDS_OUT_ERROR;
     }
 
-    if(tmc_read() < 1)
+    if(tmc_read(device) < 1)
     {
       line = __LINE__;
       goto GDS_OUT_ERROR;
@@ -1830,13 +1724,13 @@ void read_settings_thread::run()
   {
     strlcpy(str, ":CALC:FFT:VSC?", 512);
 
-    if(tmc_write(str) != 14)
+    if(tmc_write(device, str) != 14)
     {
       line = __LINE__;
       goto GDS_OUT_ERROR;
     }
 
-    if(tmc_read() < 1)
+    if(tmc_read(device) < 1)
     {
       line = __LINE__;
       goto GDS_OUT_ERROR;
@@ -1855,13 +1749,13 @@ void read_settings_thread::run()
   {
     strlcpy(str, ":MATH:SCAL?", 512);
 
-    if(tmc_write(str) != 11)
+    if(tmc_write(device, str) != 11)
     {
       line = __LINE__;
       goto GDS_OUT_ERROR;
     }
 
-    if(tmc_read() < 1)
+    if(tmc_read(device) < 1)
     {
       line = __LINE__;
       goto GDS_OUT_ERROR;
@@ -1870,13 +1764,11 @@ void read_settings_thread::run()
     devparms->fft_vscale = atof(device->buf);
   }
 
-  usleep(TMC_GDS_DELAY);
-
   if(devparms->modelserie != 1)
   {
     strlcpy(str, ":BUS1:MODE?", 512);
 
-    if(tmc_write(str) != 11)
+    if(tmc_write(device, str) != 11)
     {
       line = __LINE__;
       goto GDS_OUT_ERROR;
@@ -1886,14 +1778,14 @@ void read_settings_thread::run()
   {
     strlcpy(str, ":DEC1:MODE?", 512);
 
-    if(tmc_write(str) != 11)
+    if(tmc_write(device, str) != 11)
     {
       line = __LINE__;
       goto GDS_OUT_ERROR;
     }
   }
 
-  if(tmc_read() < 1)
+  if(tmc_read(device) < 1)
   {
     line = __LINE__;
     goto GDS_OUT_ERROR;
@@ -1920,13 +1812,11 @@ void read_settings_thread::run()
             devparms->math_decode_mode = 3;
           }
 
-  usleep(TMC_GDS_DELAY);
-
   if(devparms->modelserie != 1)
   {
     strlcpy(str, ":BUS1:DISP?", 512);
 
-    if(tmc_write(str) != 11)
+    if(tmc_write(device, str) != 11)
     {
       line = __LINE__;
       goto GDS_OUT_ERROR;
@@ -1936,14 +1826,14 @@ void read_settings_thread::run()
   {
     strlcpy(str, ":DEC1:DISP?", 512);
 
-    if(tmc_write(str) != 11)
+    if(tmc_write(device, str) != 11)
     {
       line = __LINE__;
       goto GDS_OUT_ERROR;
     }
   }
 
-  if(tmc_read() < 1)
+  if(tmc_read(device) < 1)
   {
     line = __LINE__;
     goto GDS_OUT_ERROR;
@@ -1951,13 +1841,11 @@ void read_settings_thread::run()
 
   devparms->math_decode_display = atoi(device->buf);
 
-  usleep(TMC_GDS_DELAY);
-
   if(devparms->modelserie != 1)
   {
     strlcpy(str, ":BUS1:FORM?", 512);
 
-    if(tmc_write(str) != 11)
+    if(tmc_write(device, str) != 11)
     {
       line = __LINE__;
       goto GDS_OUT_ERROR;
@@ -1967,14 +1855,14 @@ void read_settings_thread::run()
   {
     strlcpy(str, ":DEC1:FORM?", 512);
 
-    if(tmc_write(str) != 11)
+    if(tmc_write(device, str) != 11)
     {
       line = __LINE__;
       goto GDS_OUT_ERROR;
     }
   }
 
-  if(tmc_read() < 1)
+  if(tmc_read(device) < 1)
   {
     line = __LINE__;
     goto GDS_OUT_ERROR;
@@ -2001,13 +1889,11 @@ void read_settings_thread::run()
             devparms->math_decode_format = 4;
           }
 
-  usleep(TMC_GDS_DELAY);
-
   if(devparms->modelserie == 7)
   {
     strlcpy(str, ":BUS1:POSition?", 512);
 
-    if(tmc_write(str) != 15)
+    if(tmc_write(device, str) != 15)
     {
       line = __LINE__;
       goto GDS_OUT_ERROR;
@@ -2017,7 +1903,7 @@ void read_settings_thread::run()
   {
     strlcpy(str, ":BUS1:SPI:OFFS?", 512);
 
-    if(tmc_write(str) != 15)
+    if(tmc_write(device, str) != 15)
     {
       line = __LINE__;
       goto GDS_OUT_ERROR;
@@ -2027,14 +1913,14 @@ void read_settings_thread::run()
   {
     strlcpy(str, ":DEC1:POS?", 512);
 
-    if(tmc_write(str) != 10)
+    if(tmc_write(device, str) != 10)
     {
       line = __LINE__;
       goto GDS_OUT_ERROR;
     }
   }
 
-  if(tmc_read() < 1)
+  if(tmc_read(device) < 1)
   {
     line = __LINE__;
     goto GDS_OUT_ERROR;
@@ -2042,13 +1928,11 @@ void read_settings_thread::run()
 
   devparms->math_decode_pos = atoi(device->buf);
 
-  usleep(TMC_GDS_DELAY);
-
   if(devparms->modelserie != 1)
   {
     strlcpy(str, ":BUS1:SPI:MISO:THR?", 512);
 
-    if(tmc_write(str) != 19)
+    if(tmc_write(device, str) != 19)
     {
       line = __LINE__;
       goto GDS_OUT_ERROR;
@@ -2058,14 +1942,14 @@ void read_settings_thread::run()
   {
     strlcpy(str, ":DEC1:THRE:CHAN1?", 512);
 
-    if(tmc_write(str) != 17)
+    if(tmc_write(device, str) != 17)
     {
       line = __LINE__;
       goto GDS_OUT_ERROR;
     }
   }
 
-  if(tmc_read() < 1)
+  if(tmc_read(device) < 1)
   {
     line = __LINE__;
     goto GDS_OUT_ERROR;
@@ -2073,13 +1957,11 @@ void read_settings_thread::run()
 
   devparms->math_decode_threshold[0] = atof(device->buf);
 
-  usleep(TMC_GDS_DELAY);
-
   if(devparms->modelserie != 1)
   {
     strlcpy(str, ":BUS1:SPI:MOSI:THR?", 512);
 
-    if(tmc_write(str) != 19)
+    if(tmc_write(device, str) != 19)
     {
       line = __LINE__;
       goto GDS_OUT_ERROR;
@@ -2089,14 +1971,14 @@ void read_settings_thread::run()
   {
     strlcpy(str, ":DEC1:THRE:CHAN2?", 512);
 
-    if(tmc_write(str) != 17)
+    if(tmc_write(device, str) != 17)
     {
       line = __LINE__;
       goto GDS_OUT_ERROR;
     }
   }
 
-  if(tmc_read() < 1)
+  if(tmc_read(device) < 1)
   {
     line = __LINE__;
     goto GDS_OUT_ERROR;
@@ -2106,13 +1988,11 @@ void read_settings_thread::run()
 
   if(devparms->channel_cnt == 4)
   {
-    usleep(TMC_GDS_DELAY);
-
     if(devparms->modelserie != 1)
     {
       strlcpy(str, ":BUS1:SPI:SCLK:THR?", 512);
 
-      if(tmc_write(str) != 19)
+      if(tmc_write(device, str) != 19)
       {
         line = __LINE__;
         goto GDS_OUT_ERROR;
@@ -2122,14 +2002,14 @@ void read_settings_thread::run()
     {
       strlcpy(str, ":DEC1:THRE:CHAN3?", 512);
 
-      if(tmc_write(str) != 17)
+      if(tmc_write(device, str) != 17)
       {
         line = __LINE__;
         goto GDS_OUT_ERROR;
       }
     }
 
-    if(tmc_read() < 1)
+    if(tmc_read(device) < 1)
     {
       line = __LINE__;
       goto GDS_OUT_ERROR;
@@ -2137,13 +2017,11 @@ void read_settings_thread::run()
 
     devparms->math_decode_threshold[2] = atof(device->buf);
 
-    usleep(TMC_GDS_DELAY);
-
     if(devparms->modelserie != 1)
     {
       strlcpy(str, ":BUS1:SPI:SS:THR?", 512);
 
-      if(tmc_write(str) != 17)
+      if(tmc_write(device, str) != 17)
       {
         line = __LINE__;
         goto GDS_OUT_ERROR;
@@ -2153,14 +2031,14 @@ void read_settings_thread::run()
     {
       strlcpy(str, ":DEC1:THRE:CHAN4?", 512);
 
-      if(tmc_write(str) != 17)
+      if(tmc_write(device, str) != 17)
       {
         line = __LINE__;
         goto GDS_OUT_ERROR;
       }
     }
 
-    if(tmc_read() < 1)
+    if(tmc_read(device) < 1)
     {
       line = __LINE__;
       goto GDS_OUT_ERROR;
@@ -2171,17 +2049,15 @@ void read_settings_thread::run()
 
   if(devparms->modelserie != 1)
   {
-    usleep(TMC_GDS_DELAY);
-
     strlcpy(str, ":BUS1:RS232:TTHR?", 512);
 
-    if(tmc_write(str) != 17)
+    if(tmc_write(device, str) != 17)
     {
       line = __LINE__;
       goto GDS_OUT_ERROR;
     }
 
-    if(tmc_read() < 1)
+    if(tmc_read(device) < 1)
     {
       line = __LINE__;
       goto GDS_OUT_ERROR;
@@ -2190,17 +2066,15 @@ void read_settings_thread::run()
 //    devparms->math_decode_threshold_uart_tx = atof(device->buf);
     devparms->math_decode_threshold_uart_tx = atof(device->buf) * 10.0;  // hack for firmware bug!
 
-    usleep(TMC_GDS_DELAY);
-
     strlcpy(str, ":BUS1:RS232:RTHR?", 512);
 
-    if(tmc_write(str) != 17)
+    if(tmc_write(device, str) != 17)
     {
       line = __LINE__;
       goto GDS_OUT_ERROR;
     }
 
-    if(tmc_read() < 1)
+    if(tmc_read(device) < 1)
     {
       line = __LINE__;
       goto GDS_OUT_ERROR;
@@ -2212,17 +2086,15 @@ void read_settings_thread::run()
 
   if(devparms->modelserie == 1)
   {
-    usleep(TMC_GDS_DELAY);
-
     strlcpy(str, ":DEC1:THRE:AUTO?", 512);
 
-    if(tmc_write(str) != 16)
+    if(tmc_write(device, str) != 16)
     {
       line = __LINE__;
       goto GDS_OUT_ERROR;
     }
 
-    if(tmc_read() < 1)
+    if(tmc_read(device) < 1)
     {
       line = __LINE__;
       goto GDS_OUT_ERROR;
@@ -2231,13 +2103,11 @@ void read_settings_thread::run()
     devparms->math_decode_threshold_auto = atoi(device->buf);
   }
 
-  usleep(TMC_GDS_DELAY);
-
   if(devparms->modelserie != 1)
   {
     strlcpy(str, ":BUS1:RS232:RX?", 512);
 
-    if(tmc_write(str) != 15)
+    if(tmc_write(device, str) != 15)
     {
       line = __LINE__;
       goto GDS_OUT_ERROR;
@@ -2247,14 +2117,14 @@ void read_settings_thread::run()
   {
     strlcpy(str, ":DEC1:UART:RX?", 512);
 
-    if(tmc_write(str) != 14)
+    if(tmc_write(device, str) != 14)
     {
       line = __LINE__;
       goto GDS_OUT_ERROR;
     }
   }
 
-  if(tmc_read() < 1)
+  if(tmc_read(device) < 1)
   {
     line = __LINE__;
     goto GDS_OUT_ERROR;
@@ -2285,13 +2155,11 @@ void read_settings_thread::run()
             devparms->math_decode_uart_rx = 0;
           }
 
-  usleep(TMC_GDS_DELAY);
-
   if(devparms->modelserie != 1)
   {
     strlcpy(str, ":BUS1:RS232:TX?", 512);
 
-    if(tmc_write(str) != 15)
+    if(tmc_write(device, str) != 15)
     {
       line = __LINE__;
       goto GDS_OUT_ERROR;
@@ -2301,14 +2169,14 @@ void read_settings_thread::run()
   {
     strlcpy(str, ":DEC1:UART:TX?", 512);
 
-    if(tmc_write(str) != 14)
+    if(tmc_write(device, str) != 14)
     {
       line = __LINE__;
       goto GDS_OUT_ERROR;
     }
   }
 
-  if(tmc_read() < 1)
+  if(tmc_read(device) < 1)
   {
     line = __LINE__;
     goto GDS_OUT_ERROR;
@@ -2339,13 +2207,11 @@ void read_settings_thread::run()
             devparms->math_decode_uart_tx = 0;
           }
 
-  usleep(TMC_GDS_DELAY);
-
   if(devparms->modelserie != 1)
   {
     strlcpy(str, ":BUS1:RS232:POL?", 512);
 
-    if(tmc_write(str) != 16)
+    if(tmc_write(device, str) != 16)
     {
       line = __LINE__;
       goto GDS_OUT_ERROR;
@@ -2355,14 +2221,14 @@ void read_settings_thread::run()
   {
     strlcpy(str, ":DEC1:UART:POL?", 512);
 
-    if(tmc_write(str) != 15)
+    if(tmc_write(device, str) != 15)
     {
       line = __LINE__;
       goto GDS_OUT_ERROR;
     }
   }
 
-  if(tmc_read() < 1)
+  if(tmc_read(device) < 1)
   {
     line = __LINE__;
     goto GDS_OUT_ERROR;
@@ -2377,13 +2243,11 @@ void read_settings_thread::run()
       devparms->math_decode_uart_pol = 0;
     }
 
-  usleep(TMC_GDS_DELAY);
-
   if(devparms->modelserie != 1)
   {
     strlcpy(str, ":BUS1:RS232:END?", 512);
 
-    if(tmc_write(str) != 16)
+    if(tmc_write(device, str) != 16)
     {
       line = __LINE__;
       goto GDS_OUT_ERROR;
@@ -2393,14 +2257,14 @@ void read_settings_thread::run()
   {
     strlcpy(str, ":DEC1:UART:END?", 512);
 
-    if(tmc_write(str) != 15)
+    if(tmc_write(device, str) != 15)
     {
       line = __LINE__;
       goto GDS_OUT_ERROR;
     }
   }
 
-  if(tmc_read() < 1)
+  if(tmc_read(device) < 1)
   {
     line = __LINE__;
     goto GDS_OUT_ERROR;
@@ -2415,13 +2279,11 @@ void read_settings_thread::run()
       devparms->math_decode_uart_pol = 0;
     }
 
-  usleep(TMC_GDS_DELAY);
-
   if(devparms->modelserie != 1)
   {
     strlcpy(str, ":BUS1:RS232:BAUD?", 512);
 
-    if(tmc_write(str) != 17)
+    if(tmc_write(device, str) != 17)
     {
       line = __LINE__;
       goto GDS_OUT_ERROR;
@@ -2431,14 +2293,14 @@ void read_settings_thread::run()
   {
     strlcpy(str, ":DEC1:UART:BAUD?", 512);
 
-    if(tmc_write(str) != 16)
+    if(tmc_write(device, str) != 16)
     {
       line = __LINE__;
       goto GDS_OUT_ERROR;
     }
   }
 
-  if(tmc_read() < 1)
+  if(tmc_read(device) < 1)
   {
     line = __LINE__;
     goto GDS_OUT_ERROR;
@@ -2447,13 +2309,11 @@ void read_settings_thread::run()
 //FIXME  DEC1:UART:BAUD? can return also "USER" instead of a number!
   devparms->math_decode_uart_baud = atoi(device->buf);
 
-  usleep(TMC_GDS_DELAY);
-
   if(devparms->modelserie != 1)
   {
     strlcpy(str, ":BUS1:RS232:DBIT?", 512);
 
-    if(tmc_write(str) != 17)
+    if(tmc_write(device, str) != 17)
     {
       line = __LINE__;
       goto GDS_OUT_ERROR;
@@ -2463,14 +2323,14 @@ void read_settings_thread::run()
   {
     strlcpy(str, ":DEC1:UART:WIDT?", 512);
 
-    if(tmc_write(str) != 16)
+    if(tmc_write(device, str) != 16)
     {
       line = __LINE__;
       goto GDS_OUT_ERROR;
     }
   }
 
-  if(tmc_read() < 1)
+  if(tmc_read(device) < 1)
   {
     line = __LINE__;
     goto GDS_OUT_ERROR;
@@ -2478,13 +2338,11 @@ void read_settings_thread::run()
 
   devparms->math_decode_uart_width = atoi(device->buf);
 
-  usleep(TMC_GDS_DELAY);
-
   if(devparms->modelserie != 1)
   {
     strlcpy(str, ":BUS1:RS232:SBIT?", 512);
 
-    if(tmc_write(str) != 17)
+    if(tmc_write(device, str) != 17)
     {
       line = __LINE__;
       goto GDS_OUT_ERROR;
@@ -2494,14 +2352,14 @@ void read_settings_thread::run()
   {
     strlcpy(str, ":DEC1:UART:STOP?", 512);
 
-    if(tmc_write(str) != 16)
+    if(tmc_write(device, str) != 16)
     {
       line = __LINE__;
       goto GDS_OUT_ERROR;
     }
   }
 
-  if(tmc_read() < 1)
+  if(tmc_read(device) < 1)
   {
     line = __LINE__;
     goto GDS_OUT_ERROR;
@@ -2520,13 +2378,11 @@ void read_settings_thread::run()
         devparms->math_decode_uart_stop = 2;
       }
 
-  usleep(TMC_GDS_DELAY);
-
   if(devparms->modelserie != 1)
   {
     strlcpy(str, ":BUS1:RS232:PAR?", 512);
 
-    if(tmc_write(str) != 16)
+    if(tmc_write(device, str) != 16)
     {
       line = __LINE__;
       goto GDS_OUT_ERROR;
@@ -2536,14 +2392,14 @@ void read_settings_thread::run()
   {
     strlcpy(str, ":DEC1:UART:PAR?", 512);
 
-    if(tmc_write(str) != 15)
+    if(tmc_write(device, str) != 15)
     {
       line = __LINE__;
       goto GDS_OUT_ERROR;
     }
   }
 
-  if(tmc_read() < 1)
+  if(tmc_read(device) < 1)
   {
     line = __LINE__;
     goto GDS_OUT_ERROR;
@@ -2566,13 +2422,11 @@ void read_settings_thread::run()
         devparms->math_decode_uart_par = 0;
       }
 
-  usleep(TMC_GDS_DELAY);
-
   if(devparms->modelserie != 1)
   {
     strlcpy(str, ":BUS1:SPI:SCLK:SOUR?", 512);
 
-    if(tmc_write(str) != 20)
+    if(tmc_write(device, str) != 20)
     {
       line = __LINE__;
       goto GDS_OUT_ERROR;
@@ -2582,14 +2436,14 @@ void read_settings_thread::run()
   {
     strlcpy(str, ":DEC1:SPI:CLK?", 512);
 
-    if(tmc_write(str) != 14)
+    if(tmc_write(device, str) != 14)
     {
       line = __LINE__;
       goto GDS_OUT_ERROR;
     }
   }
 
-  if(tmc_read() < 1)
+  if(tmc_read(device) < 1)
   {
     line = __LINE__;
     goto GDS_OUT_ERROR;
@@ -2612,13 +2466,11 @@ void read_settings_thread::run()
           devparms->math_decode_spi_clk = 3;
         }
 
-  usleep(TMC_GDS_DELAY);
-
   if(devparms->modelserie != 1)
   {
     strlcpy(str, ":BUS1:SPI:MISO:SOUR?", 512);
 
-    if(tmc_write(str) != 20)
+    if(tmc_write(device, str) != 20)
     {
       line = __LINE__;
       goto GDS_OUT_ERROR;
@@ -2628,14 +2480,14 @@ void read_settings_thread::run()
   {
     strlcpy(str, ":DEC1:SPI:MISO?", 512);
 
-    if(tmc_write(str) != 15)
+    if(tmc_write(device, str) != 15)
     {
       line = __LINE__;
       goto GDS_OUT_ERROR;
     }
   }
 
-  if(tmc_read() < 1)
+  if(tmc_read(device) < 1)
   {
     line = __LINE__;
     goto GDS_OUT_ERROR;
@@ -2666,13 +2518,11 @@ void read_settings_thread::run()
             devparms->math_decode_spi_miso = 0;
           }
 
-  usleep(TMC_GDS_DELAY);
-
   if(devparms->modelserie != 1)
   {
     strlcpy(str, ":BUS1:SPI:MOSI:SOUR?", 512);
 
-    if(tmc_write(str) != 20)
+    if(tmc_write(device, str) != 20)
     {
       line = __LINE__;
       goto GDS_OUT_ERROR;
@@ -2682,14 +2532,14 @@ void read_settings_thread::run()
   {
     strlcpy(str, ":DEC1:SPI:MOSI?", 512);
 
-    if(tmc_write(str) != 15)
+    if(tmc_write(device, str) != 15)
     {
       line = __LINE__;
       goto GDS_OUT_ERROR;
     }
   }
 
-  if(tmc_read() < 1)
+  if(tmc_read(device) < 1)
   {
     line = __LINE__;
     goto GDS_OUT_ERROR;
@@ -2720,13 +2570,11 @@ void read_settings_thread::run()
             devparms->math_decode_spi_mosi = 0;
           }
 
-  usleep(TMC_GDS_DELAY);
-
   if(devparms->modelserie != 1)
   {
     strlcpy(str, ":BUS1:SPI:SS:SOUR?", 512);
 
-    if(tmc_write(str) != 18)
+    if(tmc_write(device, str) != 18)
     {
       line = __LINE__;
       goto GDS_OUT_ERROR;
@@ -2736,14 +2584,14 @@ void read_settings_thread::run()
   {
     strlcpy(str, ":DEC1:SPI:CS?", 512);
 
-    if(tmc_write(str) != 13)
+    if(tmc_write(device, str) != 13)
     {
       line = __LINE__;
       goto GDS_OUT_ERROR;
     }
   }
 
-  if(tmc_read() < 1)
+  if(tmc_read(device) < 1)
   {
     line = __LINE__;
     goto GDS_OUT_ERROR;
@@ -2774,13 +2622,11 @@ void read_settings_thread::run()
             devparms->math_decode_spi_cs = 0;
           }
 
-  usleep(TMC_GDS_DELAY);
-
   if(devparms->modelserie != 1)
   {
     strlcpy(str, ":BUS1:SPI:SS:POL?", 512);
 
-    if(tmc_write(str) != 17)
+    if(tmc_write(device, str) != 17)
     {
       line = __LINE__;
       goto GDS_OUT_ERROR;
@@ -2790,14 +2636,14 @@ void read_settings_thread::run()
   {
     strlcpy(str, ":DEC1:SPI:SEL?", 512);
 
-    if(tmc_write(str) != 14)
+    if(tmc_write(device, str) != 14)
     {
       line = __LINE__;
       goto GDS_OUT_ERROR;
     }
   }
 
-  if(tmc_read() < 1)
+  if(tmc_read(device) < 1)
   {
     line = __LINE__;
     goto GDS_OUT_ERROR;
@@ -2822,17 +2668,15 @@ void read_settings_thread::run()
 
   if(devparms->modelserie == 1)
   {
-    usleep(TMC_GDS_DELAY);
-
     strlcpy(str, ":DEC1:SPI:MODE?", 512);
 
-    if(tmc_write(str) != 15)
+    if(tmc_write(device, str) != 15)
     {
       line = __LINE__;
       goto GDS_OUT_ERROR;
     }
 
-    if(tmc_read() < 1)
+    if(tmc_read(device) < 1)
     {
       line = __LINE__;
       goto GDS_OUT_ERROR;
@@ -2850,17 +2694,15 @@ void read_settings_thread::run()
 
   if(devparms->modelserie == 1)
   {
-    usleep(TMC_GDS_DELAY);
-
     strlcpy(str, ":DEC1:SPI:TIM?", 512);
 
-    if(tmc_write(str) != 14)
+    if(tmc_write(device, str) != 14)
     {
       line = __LINE__;
       goto GDS_OUT_ERROR;
     }
 
-    if(tmc_read() < 1)
+    if(tmc_read(device) < 1)
     {
       line = __LINE__;
       goto GDS_OUT_ERROR;
@@ -2869,13 +2711,11 @@ void read_settings_thread::run()
     devparms->math_decode_spi_timeout = atof(device->buf);
   }
 
-  usleep(TMC_GDS_DELAY);
-
   if(devparms->modelserie != 1)
   {
     strlcpy(str, ":BUS1:SPI:MOSI:POL?", 512);
 
-    if(tmc_write(str) != 19)
+    if(tmc_write(device, str) != 19)
     {
       line = __LINE__;
       goto GDS_OUT_ERROR;
@@ -2885,14 +2725,14 @@ void read_settings_thread::run()
   {
     strlcpy(str, ":DEC1:SPI:POL?", 512);
 
-    if(tmc_write(str) != 14)
+    if(tmc_write(device, str) != 14)
     {
       line = __LINE__;
       goto GDS_OUT_ERROR;
     }
   }
 
-  if(tmc_read() < 1)
+  if(tmc_read(device) < 1)
   {
     line = __LINE__;
     goto GDS_OUT_ERROR;
@@ -2907,13 +2747,11 @@ void read_settings_thread::run()
       devparms->math_decode_spi_pol = 1;
     }
 
-  usleep(TMC_GDS_DELAY);
-
   if(devparms->modelserie != 1)
   {
     strlcpy(str, ":BUS1:SPI:SCLK:SLOP?", 512);
 
-    if(tmc_write(str) != 20)
+    if(tmc_write(device, str) != 20)
     {
       line = __LINE__;
       goto GDS_OUT_ERROR;
@@ -2923,14 +2761,14 @@ void read_settings_thread::run()
   {
     strlcpy(str, ":DEC1:SPI:EDGE?", 512);
 
-    if(tmc_write(str) != 15)
+    if(tmc_write(device, str) != 15)
     {
       line = __LINE__;
       goto GDS_OUT_ERROR;
     }
   }
 
-  if(tmc_read() < 1)
+  if(tmc_read(device) < 1)
   {
     line = __LINE__;
     goto GDS_OUT_ERROR;
@@ -2953,13 +2791,11 @@ void read_settings_thread::run()
           devparms->math_decode_spi_edge = 1;
         }
 
-  usleep(TMC_GDS_DELAY);
-
   if(devparms->modelserie != 1)
   {
     strlcpy(str, ":BUS1:SPI:DBIT?", 512);
 
-    if(tmc_write(str) != 15)
+    if(tmc_write(device, str) != 15)
     {
       line = __LINE__;
       goto GDS_OUT_ERROR;
@@ -2969,14 +2805,14 @@ void read_settings_thread::run()
   {
     strlcpy(str, ":DEC1:SPI:WIDT?", 512);
 
-    if(tmc_write(str) != 15)
+    if(tmc_write(device, str) != 15)
     {
       line = __LINE__;
       goto GDS_OUT_ERROR;
     }
   }
 
-  if(tmc_read() < 1)
+  if(tmc_read(device) < 1)
   {
     line = __LINE__;
     goto GDS_OUT_ERROR;
@@ -2984,13 +2820,11 @@ void read_settings_thread::run()
 
   devparms->math_decode_spi_width = atoi(device->buf);
 
-  usleep(TMC_GDS_DELAY);
-
   if(devparms->modelserie != 1)
   {
     strlcpy(str, ":BUS1:SPI:END?", 512);
 
-    if(tmc_write(str) != 14)
+    if(tmc_write(device, str) != 14)
     {
       line = __LINE__;
       goto GDS_OUT_ERROR;
@@ -3000,14 +2834,14 @@ void read_settings_thread::run()
   {
     strlcpy(str, ":DEC1:SPI:END?", 512);
 
-    if(tmc_write(str) != 14)
+    if(tmc_write(device, str) != 14)
     {
       line = __LINE__;
       goto GDS_OUT_ERROR;
     }
   }
 
-  if(tmc_read() < 1)
+  if(tmc_read(device) < 1)
   {
     line = __LINE__;
     goto GDS_OUT_ERROR;
@@ -3022,19 +2856,17 @@ void read_settings_thread::run()
       devparms->math_decode_spi_end = 1;
     }
 
-  usleep(TMC_GDS_DELAY);
-
   if(devparms->modelserie == 7)
   {
     strlcpy(str, ":RECord:WRECord:ENABle?", 512);
 
-    if(tmc_write(str) != 23)
+    if(tmc_write(device, str) != 23)
     {
       line = __LINE__;
       goto GDS_OUT_ERROR;
     }
 
-    if(tmc_read() < 1)
+    if(tmc_read(device) < 1)
     {
       line = __LINE__;
       goto GDS_OUT_ERROR;
@@ -3058,13 +2890,13 @@ void read_settings_thread::run()
   {
     strlcpy(str, ":FUNC:WREC:ENAB?", 512);
 
-    if(tmc_write(str) != 16)
+    if(tmc_write(device, str) != 16)
     {
       line = __LINE__;
       goto GDS_OUT_ERROR;
     }
 
-    if(tmc_read() < 1)
+    if(tmc_read(device) < 1)
     {
       line = __LINE__;
       goto GDS_OUT_ERROR;
@@ -3088,13 +2920,13 @@ void read_settings_thread::run()
   {
     strlcpy(str, ":FUNC:WRM?", 512);
 
-    if(tmc_write(str) != 10)
+    if(tmc_write(device, str) != 10)
     {
       line = __LINE__;
       goto GDS_OUT_ERROR;
     }
 
-    if(tmc_read() < 1)
+    if(tmc_read(device) < 1)
     {
       line = __LINE__;
       goto GDS_OUT_ERROR;
@@ -3121,17 +2953,15 @@ void read_settings_thread::run()
 
   if(devparms->func_wrec_enable)
   {
-    usleep(TMC_GDS_DELAY);
-
     strlcpy(str, ":FUNC:WREC:FEND?", 512);
 
-    if(tmc_write(str) != 16)
+    if(tmc_write(device, str) != 16)
     {
       line = __LINE__;
       goto GDS_OUT_ERROR;
     }
 
-    if(tmc_read() < 1)
+    if(tmc_read(device) < 1)
     {
       line = __LINE__;
       goto GDS_OUT_ERROR;
@@ -3139,17 +2969,15 @@ void read_settings_thread::run()
 
     devparms->func_wrec_fend = atoi(device->buf);
 
-    usleep(TMC_GDS_DELAY);
-
     strlcpy(str, ":FUNC:WREC:FMAX?", 512);
 
-    if(tmc_write(str) != 16)
+    if(tmc_write(device, str) != 16)
     {
       line = __LINE__;
       goto GDS_OUT_ERROR;
     }
 
-    if(tmc_read() < 1)
+    if(tmc_read(device) < 1)
     {
       line = __LINE__;
       goto GDS_OUT_ERROR;
@@ -3157,17 +2985,15 @@ void read_settings_thread::run()
 
     devparms->func_wrec_fmax = atoi(device->buf);
 
-    usleep(TMC_GDS_DELAY);
-
     strlcpy(str, ":FUNC:WREC:FINT?", 512);
 
-    if(tmc_write(str) != 16)
+    if(tmc_write(device, str) != 16)
     {
       line = __LINE__;
       goto GDS_OUT_ERROR;
     }
 
-    if(tmc_read() < 1)
+    if(tmc_read(device) < 1)
     {
       line = __LINE__;
       goto GDS_OUT_ERROR;
@@ -3175,17 +3001,15 @@ void read_settings_thread::run()
 
     devparms->func_wrec_fintval = atof(device->buf);
 
-    usleep(TMC_GDS_DELAY);
-
     strlcpy(str, ":FUNC:WREP:FST?", 512);
 
-    if(tmc_write(str) != 15)
+    if(tmc_write(device, str) != 15)
     {
       line = __LINE__;
       goto GDS_OUT_ERROR;
     }
 
-    if(tmc_read() < 1)
+    if(tmc_read(device) < 1)
     {
       line = __LINE__;
       goto GDS_OUT_ERROR;
@@ -3193,17 +3017,15 @@ void read_settings_thread::run()
 
     devparms->func_wplay_fstart = atoi(device->buf);
 
-    usleep(TMC_GDS_DELAY);
-
     strlcpy(str, ":FUNC:WREP:FEND?", 512);
 
-    if(tmc_write(str) != 16)
+    if(tmc_write(device, str) != 16)
     {
       line = __LINE__;
       goto GDS_OUT_ERROR;
     }
 
-    if(tmc_read() < 1)
+    if(tmc_read(device) < 1)
     {
       line = __LINE__;
       goto GDS_OUT_ERROR;
@@ -3211,17 +3033,15 @@ void read_settings_thread::run()
 
     devparms->func_wplay_fend = atoi(device->buf);
 
-    usleep(TMC_GDS_DELAY);
-
     strlcpy(str, ":FUNC:WREP:FMAX?", 512);
 
-    if(tmc_write(str) != 16)
+    if(tmc_write(device, str) != 16)
     {
       line = __LINE__;
       goto GDS_OUT_ERROR;
     }
 
-    if(tmc_read() < 1)
+    if(tmc_read(device) < 1)
     {
       line = __LINE__;
       goto GDS_OUT_ERROR;
@@ -3229,17 +3049,15 @@ void read_settings_thread::run()
 
     devparms->func_wplay_fmax = atoi(device->buf);
 
-    usleep(TMC_GDS_DELAY);
-
     strlcpy(str, ":FUNC:WREP:FINT?", 512);
 
-    if(tmc_write(str) != 16)
+    if(tmc_write(device, str) != 16)
     {
       line = __LINE__;
       goto GDS_OUT_ERROR;
     }
 
-    if(tmc_read() < 1)
+    if(tmc_read(device) < 1)
     {
       line = __LINE__;
       goto GDS_OUT_ERROR;
@@ -3247,17 +3065,15 @@ void read_settings_thread::run()
 
     devparms->func_wplay_fintval = atof(device->buf);
 
-    usleep(TMC_GDS_DELAY);
-
     strlcpy(str, ":FUNC:WREP:FCUR?", 512);
 
-    if(tmc_write(str) != 16)
+    if(tmc_write(device, str) != 16)
     {
       line = __LINE__;
       goto GDS_OUT_ERROR;
     }
 
-    if(tmc_read() < 1)
+    if(tmc_read(device) < 1)
     {
       line = __LINE__;
       goto GDS_OUT_ERROR;
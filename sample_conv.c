@@ -0,0 +1,866 @@
+/*
+***************************************************************************
+*
+* Author: Teunis van Beelen
+*
+* Copyright (C) 2015 - 2024 Teunis van Beelen
+*
+* Email: teuniz@protonmail.com
+*
+***************************************************************************
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+***************************************************************************
+*/
+
+
+
+
+
+#include <string.h>
+
+#include "sample_conv.h"
+
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__SSE2__) && defined(__GNUC__)
+#define SCONV_X86
+#include <immintrin.h>
+#endif
+
+
+/* vectors summed with 32-bit lanes before the lanes are added to the 64-bit total, */
+/* a lane grows by at most 65536 per vector */
+#define SCONV_SUM_BLOCK  (16384)
+
+
+static int sconv_level=-1;
+
+
+static int sconv_cpu_level(void)
+{
+#ifdef SCONV_X86
+  __builtin_cpu_init();
+
+  if(__builtin_cpu_supports("avx2"))
+  {
+    return SCONV_LEVEL_AVX2;
+  }
+
+  return SCONV_LEVEL_SSE2;
+#else
+  return SCONV_LEVEL_SCALAR;
+#endif
+}
+
+
+int sconv_get_level(void)
+{
+  if(sconv_level < 0)
+  {
+    sconv_level = sconv_cpu_level();
+  }
+
+  return sconv_level;
+}
+
+
+int sconv_set_level(int level)
+{
+  int cpu_level;
+
+  cpu_level = sconv_cpu_level();
+
+  if(level > cpu_level)
+  {
+    level = cpu_level;
+  }
+
+  if(level < SCONV_LEVEL_SCALAR)
+  {
+    level = SCONV_LEVEL_SCALAR;
+  }
+
+  sconv_level = level;
+
+  return sconv_level;
+}
+
+
+/////////////////////////////// plain C ///////////////////////////////
+
+static void sconv_u8_to_s16_c(short *dest, const unsigned char *src, int n, int offset, int shift)
+{
+  int i;
+
+  for(i=0; i<n; i++)
+  {
+    dest[i] = (unsigned int)(src[i] - offset) << shift;
+  }
+}
+
+
+static void sconv_u8_to_double_c(double *dest, const unsigned char *src, int n, int offset, double scale)
+{
+  int i;
+
+  for(i=0; i<n; i++)
+  {
+    dest[i] = (double)(src[i] - offset) * scale;
+  }
+}
+
+
+static void sconv_s16_minmax_sum_c(const short *src, int n, short *min, short *max, long long *sum)
+{
+  int i;
+
+  short s_min, s_max;
+
+  long long s_sum=0;
+
+  s_min = src[0];
+  s_max = src[0];
+
+  for(i=0; i<n; i++)
+  {
+    if(src[i] < s_min)  s_min = src[i];
+
+    if(src[i] > s_max)  s_max = src[i];
+
+    s_sum += src[i];
+  }
+
+  *min = s_min;
+  *max = s_max;
+  *sum = s_sum;
+}
+
+
+static void sconv_fill_u32_c(unsigned int *dest, int n, unsigned int val)
+{
+  int i;
+
+  for(i=0; i<n; i++)
+  {
+    dest[i] = val;
+  }
+}
+
+
+/* x * a / 255 for the four bytes of x, two bytes per multiplication */
+static inline unsigned int sconv_byte_mul(unsigned int x, unsigned int a)
+{
+  unsigned int rb, ag;
+
+  rb = ((x & 0x00ff00ff) * a) + 0x00800080;
+  rb = ((rb + ((rb >> 8) & 0x00ff00ff)) >> 8) & 0x00ff00ff;
+
+  ag = (((x >> 8) & 0x00ff00ff) * a) + 0x00800080;
+  ag = (ag + ((ag >> 8) & 0x00ff00ff)) & 0xff00ff00;
+
+  return rb | ag;
+}
+
+
+static void sconv_argb_over_c(unsigned int *dest, const unsigned int *src, int n)
+{
+  int i;
+
+  unsigned int a;
+
+  for(i=0; i<n; i++)
+  {
+    a = src[i] >> 24;
+
+    if(a == 255)
+    {
+      dest[i] = src[i];
+    }
+    else if(a)
+      {
+        dest[i] = src[i] + sconv_byte_mul(dest[i], 255 - a);
+      }
+  }
+}
+
+
+/* saturating add of every byte, two bytes at a time in 16-bit lanes */
+static void sconv_argb_adds_c(unsigned int *dest, const unsigned int *src, int n)
+{
+  int i;
+
+  unsigned int rb, ag;
+
+  for(i=0; i<n; i++)
+  {
+    rb = (dest[i] & 0x00ff00ff) + (src[i] & 0x00ff00ff);
+    rb |= ((rb >> 8) & 0x00010001) * 0xff;
+
+    ag = ((dest[i] >> 8) & 0x00ff00ff) + ((src[i] >> 8) & 0x00ff00ff);
+    ag |= ((ag >> 8) & 0x00010001) * 0xff;
+
+    dest[i] = (rb & 0x00ff00ff) | ((ag & 0x00ff00ff) << 8);
+  }
+}
+
+
+#ifdef SCONV_X86
+
+/////////////////////////////// SSE2 ///////////////////////////////
+
+static void sconv_u8_to_s16_sse2(short *dest, const unsigned char *src, int n, int offset, int shift)
+{
+  int i;
+
+  __m128i zero, off, cnt, v, lo, hi;
+
+  zero = _mm_setzero_si128();
+  off = _mm_set1_epi16((short)offset);
+  cnt = _mm_cvtsi32_si128(shift);
+
+  for(i=0; i<=(n-16); i+=16)
+  {
+    v = _mm_loadu_si128((const __m128i *)(src + i));
+
+    lo = _mm_sll_epi16(_mm_sub_epi16(_mm_unpacklo_epi8(v, zero), off), cnt);
+    hi = _mm_sll_epi16(_mm_sub_epi16(_mm_unpackhi_epi8(v, zero), off), cnt);
+
+    _mm_storeu_si128((__m128i *)(dest + i), lo);
+    _mm_storeu_si128((__m128i *)(dest + i + 8), hi);
+  }
+
+  sconv_u8_to_s16_c(dest + i, src + i, n - i, offset, shift);
+}
+
+
+static void sconv_u8_to_double_sse2(double *dest, const unsigned char *src, int n, int offset, double scale)
+{
+  int i, j;
+
+  __m128i zero, off, v, w[2], d;
+
+  __m128d sc;
+
+  zero = _mm_setzero_si128();
+  off = _mm_set1_epi32(offset);
+  sc = _mm_set1_pd(scale);
+
+  for(i=0; i<=(n-16); i+=16)
+  {
+    v = _mm_loadu_si128((const __m128i *)(src + i));
+
+    w[0] = _mm_unpacklo_epi8(v, zero);
+    w[1] = _mm_unpackhi_epi8(v, zero);
+
+    for(j=0; j<2; j++)
+    {
+      d = _mm_sub_epi32(_mm_unpacklo_epi16(w[j], zero), off);
+
+      _mm_storeu_pd(dest + i + (j * 8), _mm_mul_pd(_mm_cvtepi32_pd(d), sc));
+      _mm_storeu_pd(dest + i + (j * 8) + 2, _mm_mul_pd(_mm_cvtepi32_pd(_mm_srli_si128(d, 8)), sc));
+
+      d = _mm_sub_epi32(_mm_unpackhi_epi16(w[j], zero), off);
+
+      _mm_storeu_pd(dest + i + (j * 8) + 4, _mm_mul_pd(_mm_cvtepi32_pd(d), sc));
+      _mm_storeu_pd(dest + i + (j * 8) + 6, _mm_mul_pd(_mm_cvtepi32_pd(_mm_srli_si128(d, 8)), sc));
+    }
+  }
+
+  sconv_u8_to_double_c(dest + i, src + i, n - i, offset, scale);
+}
+
+
+static void sconv_s16_minmax_sum_sse2(const short *src, int n, short *min, short *max, long long *sum)
+{
+  int i, j, blk;
+
+  short lanes16[8];
+
+  int lanes32[4];
+
+  short s_min, s_max;
+
+  long long s_sum=0;
+
+  __m128i v, v_min, v_max, v_sum, ones;
+
+  v_min = _mm_set1_epi16(32767);
+  v_max = _mm_set1_epi16(-32768);
+  ones = _mm_set1_epi16(1);
+
+  for(i=0; i<=(n-8); )
+  {
+    v_sum = _mm_setzero_si128();
+
+    for(blk=0; (blk<SCONV_SUM_BLOCK) && (i<=(n-8)); blk++, i+=8)
+    {
+      v = _mm_loadu_si128((const __m128i *)(src + i));
+
+      v_min = _mm_min_epi16(v_min, v);
+      v_max = _mm_max_epi16(v_max, v);
+      v_sum = _mm_add_epi32(v_sum, _mm_madd_epi16(v, ones));
+    }
+
+    _mm_storeu_si128((__m128i *)lanes32, v_sum);
+
+    for(j=0; j<4; j++)
+    {
+      s_sum += lanes32[j];
+    }
+  }
+
+  _mm_storeu_si128((__m128i *)lanes16, v_min);
+
+  s_min = lanes16[0];
+
+  for(j=1; j<8; j++)
+  {
+    if(lanes16[j] < s_min)  s_min = lanes16[j];
+  }
+
+  _mm_storeu_si128((__m128i *)lanes16, v_max);
+
+  s_max = lanes16[0];
+
+  for(j=1; j<8; j++)
+  {
+    if(lanes16[j] > s_max)  s_max = lanes16[j];
+  }
+
+  for(; i<n; i++)
+  {
+    if(src[i] < s_min)  s_min = src[i];
+
+    if(src[i] > s_max)  s_max = src[i];
+
+    s_sum += src[i];
+  }
+
+  *min = s_min;
+  *max = s_max;
+  *sum = s_sum;
+}
+
+
+/////////////////////////////// AVX2 ///////////////////////////////
+
+static void sconv_fill_u32_sse2(unsigned int *dest, int n, unsigned int val)
+{
+  int i;
+
+  __m128i v;
+
+  v = _mm_set1_epi32(val);
+
+  for(i=0; i<=(n-4); i+=4)
+  {
+    _mm_storeu_si128((__m128i *)(dest + i), v);
+  }
+
+  sconv_fill_u32_c(dest + i, n - i, val);
+}
+
+
+/* d * (255 - a) / 255 of the 16-bit lanes, rounded like sconv_byte_mul() */
+static inline __m128i sconv_mul_255_sse2(__m128i d, __m128i ia)
+{
+  __m128i t;
+
+  t = _mm_add_epi16(_mm_mullo_epi16(d, ia), _mm_set1_epi16(128));
+
+  return _mm_srli_epi16(_mm_add_epi16(t, _mm_srli_epi16(t, 8)), 8);
+}
+
+
+/* four pixels at a time, runs of transparent or opaque pixels need no arithmetic */
+static void sconv_argb_over_sse2(unsigned int *dest, const unsigned int *src, int n)
+{
+  int i;
+
+  __m128i s, d, zero, amask, ia, lo, hi;
+
+  zero = _mm_setzero_si128();
+  amask = _mm_set1_epi32(0xff000000);
+
+  for(i=0; i<=(n-4); i+=4)
+  {
+    s = _mm_loadu_si128((const __m128i *)(src + i));
+
+    if(_mm_movemask_epi8(_mm_cmpeq_epi32(s, zero)) == 0xffff)
+    {
+      continue;
+    }
+
+    if(_mm_movemask_epi8(_mm_cmpeq_epi32(_mm_and_si128(s, amask), amask)) == 0xffff)
+    {
+      _mm_storeu_si128((__m128i *)(dest + i), s);
+
+      continue;
+    }
+
+    d = _mm_loadu_si128((const __m128i *)(dest + i));
+
+    /* 255 - alpha in both 16-bit halves of every pixel */
+    ia = _mm_sub_epi32(_mm_set1_epi32(255), _mm_srli_epi32(s, 24));
+    ia = _mm_or_si128(ia, _mm_slli_epi32(ia, 16));
+
+    lo = sconv_mul_255_sse2(_mm_unpacklo_epi8(d, zero), _mm_unpacklo_epi32(ia, ia));
+    hi = sconv_mul_255_sse2(_mm_unpackhi_epi8(d, zero), _mm_unpackhi_epi32(ia, ia));
+
+    _mm_storeu_si128((__m128i *)(dest + i), _mm_add_epi32(s, _mm_packus_epi16(lo, hi)));
+  }
+
+  sconv_argb_over_c(dest + i, src + i, n - i);
+}
+
+
+static void sconv_argb_adds_sse2(unsigned int *dest, const unsigned int *src, int n)
+{
+  int i;
+
+  for(i=0; i<=(n-4); i+=4)
+  {
+    _mm_storeu_si128((__m128i *)(dest + i), _mm_adds_epu8(_mm_loadu_si128((const __m128i *)(dest + i)),
+                                                          _mm_loadu_si128((const __m128i *)(src + i))));
+  }
+
+  sconv_argb_adds_c(dest + i, src + i, n - i);
+}
+
+
+__attribute__((target("avx2")))
+static void sconv_u8_to_s16_avx2(short *dest, const unsigned char *src, int n, int offset, int shift)
+{
+  int i;
+
+  __m128i cnt;
+
+  __m256i off, lo, hi;
+
+  off = _mm256_set1_epi16((short)offset);
+  cnt = _mm_cvtsi32_si128(shift);
+
+  for(i=0; i<=(n-32); i+=32)
+  {
+    lo = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *)(src + i)));
+    hi = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *)(src + i + 16)));
+
+    lo = _mm256_sll_epi16(_mm256_sub_epi16(lo, off), cnt);
+    hi = _mm256_sll_epi16(_mm256_sub_epi16(hi, off), cnt);
+
+    _mm256_storeu_si256((__m256i *)(dest + i), lo);
+    _mm256_storeu_si256((__m256i *)(dest + i + 16), hi);
+  }
+
+  sconv_u8_to_s16_c(dest + i, src + i, n - i, offset, shift);
+}
+
+
+__attribute__((target("avx2")))
+static void sconv_u8_to_double_avx2(double *dest, const unsigned char *src, int n, int offset, double scale)
+{
+  int i;
+
+  __m256i off, d;
+
+  __m256d sc;
+
+  off = _mm256_set1_epi32(offset);
+  sc = _mm256_set1_pd(scale);
+
+  for(i=0; i<=(n-8); i+=8)
+  {
+    d = _mm256_sub_epi32(_mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i *)(src + i))), off);
+
+    _mm256_storeu_pd(dest + i, _mm256_mul_pd(_mm256_cvtepi32_pd(_mm256_castsi256_si128(d)), sc));
+    _mm256_storeu_pd(dest + i + 4, _mm256_mul_pd(_mm256_cvtepi32_pd(_mm256_extracti128_si256(d, 1)), sc));
+  }
+
+  sconv_u8_to_double_c(dest + i, src + i, n - i, offset, scale);
+}
+
+
+__attribute__((target("avx2")))
+static void sconv_s16_minmax_sum_avx2(const short *src, int n, short *min, short *max, long long *sum)
+{
+  int i, j, blk;
+
+  short lanes16[16];
+
+  int lanes32[8];
+
+  short s_min, s_max;
+
+  long long s_sum=0;
+
+  __m256i v, v_min, v_max, v_sum, ones;
+
+  v_min = _mm256_set1_epi16(32767);
+  v_max = _mm256_set1_epi16(-32768);
+  ones = _mm256_set1_epi16(1);
+
+  for(i=0; i<=(n-16); )
+  {
+    v_sum = _mm256_setzero_si256();
+
+    for(blk=0; (blk<SCONV_SUM_BLOCK) && (i<=(n-16)); blk++, i+=16)
+    {
+      v = _mm256_loadu_si256((const __m256i *)(src + i));
+
+      v_min = _mm256_min_epi16(v_min, v);
+      v_max = _mm256_max_epi16(v_max, v);
+      v_sum = _mm256_add_epi32(v_sum, _mm256_madd_epi16(v, ones));
+    }
+
+    _mm256_storeu_si256((__m256i *)lanes32, v_sum);
+
+    for(j=0; j<8; j++)
+    {
+      s_sum += lanes32[j];
+    }
+  }
+
+  _mm256_storeu_si256((__m256i *)lanes16, v_min);
+
+  s_min = lanes16[0];
+
+  for(j=1; j<16; j++)
+  {
+    if(lanes16[j] < s_min)  s_min = lanes16[j];
+  }
+
+  _mm256_storeu_si256((__m256i *)lanes16, v_max);
+
+  s_max = lanes16[0];
+
+  for(j=1; j<16; j++)
+  {
+    if(lanes16[j] > s_max)  s_max = lanes16[j];
+  }
+
+  for(; i<n; i++)
+  {
+    if(src[i] < s_min)  s_min = src[i];
+
+    if(src[i] > s_max)  s_max = src[i];
+
+    s_sum += src[i];
+  }
+
+  *min = s_min;
+  *max = s_max;
+  *sum = s_sum;
+}
+
+
+__attribute__((target("avx2")))
+static void sconv_fill_u32_avx2(unsigned int *dest, int n, unsigned int val)
+{
+  int i;
+
+  __m256i v;
+
+  v = _mm256_set1_epi32(val);
+
+  for(i=0; i<=(n-8); i+=8)
+  {
+    _mm256_storeu_si256((__m256i *)(dest + i), v);
+  }
+
+  sconv_fill_u32_c(dest + i, n - i, val);
+}
+
+
+__attribute__((target("avx2")))
+static inline __m256i sconv_mul_255_avx2(__m256i d, __m256i ia)
+{
+  __m256i t;
+
+  t = _mm256_add_epi16(_mm256_mullo_epi16(d, ia), _mm256_set1_epi16(128));
+
+  return _mm256_srli_epi16(_mm256_add_epi16(t, _mm256_srli_epi16(t, 8)), 8);
+}
+
+
+/* the unpack and pack instructions work per 128-bit lane, the order of the pixels is kept */
+__attribute__((target("avx2")))
+static void sconv_argb_over_avx2(unsigned int *dest, const unsigned int *src, int n)
+{
+  int i;
+
+  __m256i s, d, zero, amask, ia, lo, hi;
+
+  zero = _mm256_setzero_si256();
+  amask = _mm256_set1_epi32(0xff000000);
+
+  for(i=0; i<=(n-8); i+=8)
+  {
+    s = _mm256_loadu_si256((const __m256i *)(src + i));
+
+    if(_mm256_testz_si256(s, s))
+    {
+      continue;
+    }
+
+    if(_mm256_movemask_epi8(_mm256_cmpeq_epi32(_mm256_and_si256(s, amask), amask)) == -1)
+    {
+      _mm256_storeu_si256((__m256i *)(dest + i), s);
+
+      continue;
+    }
+
+    d = _mm256_loadu_si256((const __m256i *)(dest + i));
+
+    ia = _mm256_sub_epi32(_mm256_set1_epi32(255), _mm256_srli_epi32(s, 24));
+    ia = _mm256_or_si256(ia, _mm256_slli_epi32(ia, 16));
+
+    lo = sconv_mul_255_avx2(_mm256_unpacklo_epi8(d, zero), _mm256_unpacklo_epi32(ia, ia));
+    hi = sconv_mul_255_avx2(_mm256_unpackhi_epi8(d, zero), _mm256_unpackhi_epi32(ia, ia));
+
+    _mm256_storeu_si256((__m256i *)(dest + i), _mm256_add_epi32(s, _mm256_packus_epi16(lo, hi)));
+  }
+
+  sconv_argb_over_c(dest + i, src + i, n - i);
+}
+
+
+__attribute__((target("avx2")))
+static void sconv_argb_adds_avx2(unsigned int *dest, const unsigned int *src, int n)
+{
+  int i;
+
+  for(i=0; i<=(n-8); i+=8)
+  {
+    _mm256_storeu_si256((__m256i *)(dest + i), _mm256_adds_epu8(_mm256_loadu_si256((const __m256i *)(dest + i)),
+                                                                _mm256_loadu_si256((const __m256i *)(src + i))));
+  }
+
+  sconv_argb_adds_c(dest + i, src + i, n - i);
+}
+
+#endif  /* SCONV_X86 */
+
+
+/////////////////////////////// dispatch ///////////////////////////////
+
+void sconv_u8_to_s16(short *dest, const unsigned char *src, int n, int offset, int shift)
+{
+#ifdef SCONV_X86
+  switch(sconv_get_level())
+  {
+    case SCONV_LEVEL_AVX2 : sconv_u8_to_s16_avx2(dest, src, n, offset, shift);
+                            return;
+    case SCONV_LEVEL_SSE2 : sconv_u8_to_s16_sse2(dest, src, n, offset, shift);
+                            return;
+  }
+#endif
+  sconv_u8_to_s16_c(dest, src, n, offset, shift);
+}
+
+
+void sconv_u8_to_double(double *dest, const unsigned char *src, int n, int offset, double scale)
+{
+#ifdef SCONV_X86
+  switch(sconv_get_level())
+  {
+    case SCONV_LEVEL_AVX2 : sconv_u8_to_double_avx2(dest, src, n, offset, scale);
+                            return;
+    case SCONV_LEVEL_SSE2 : sconv_u8_to_double_sse2(dest, src, n, offset, scale);
+                            return;
+  }
+#endif
+  sconv_u8_to_double_c(dest, src, n, offset, scale);
+}
+
+
+void sconv_s16_minmax_sum(const short *src, int n, short *min, short *max, long long *sum)
+{
+#ifdef SCONV_X86
+  switch(sconv_get_level())
+  {
+    case SCONV_LEVEL_AVX2 : sconv_s16_minmax_sum_avx2(src, n, min, max, sum);
+                            return;
+    case SCONV_LEVEL_SSE2 : sconv_s16_minmax_sum_sse2(src, n, min, max, sum);
+                            return;
+  }
+#endif
+  sconv_s16_minmax_sum_c(src, n, min, max, sum);
+}
+
+
+void sconv_fill_u32(unsigned int *dest, int n, unsigned int val)
+{
+#ifdef SCONV_X86
+  switch(sconv_get_level())
+  {
+    case SCONV_LEVEL_AVX2 : sconv_fill_u32_avx2(dest, n, val);
+                            return;
+    case SCONV_LEVEL_SSE2 : sconv_fill_u32_sse2(dest, n, val);
+                            return;
+  }
+#endif
+  sconv_fill_u32_c(dest, n, val);
+}
+
+
+void sconv_argb_over(unsigned int *dest, const unsigned int *src, int n)
+{
+#ifdef SCONV_X86
+  switch(sconv_get_level())
+  {
+    case SCONV_LEVEL_AVX2 : sconv_argb_over_avx2(dest, src, n);
+                            return;
+    case SCONV_LEVEL_SSE2 : sconv_argb_over_sse2(dest, src, n);
+                            return;
+  }
+#endif
+  sconv_argb_over_c(dest, src, n);
+}
+
+
+void sconv_argb_adds(unsigned int *dest, const unsigned int *src, int n)
+{
+#ifdef SCONV_X86
+  switch(sconv_get_level())
+  {
+    case SCONV_LEVEL_AVX2 : sconv_argb_adds_avx2(dest, src, n);
+                            return;
+    case SCONV_LEVEL_SSE2 : sconv_argb_adds_sse2(dest, src, n);
+                            return;
+  }
+#endif
+  sconv_argb_adds_c(dest, src, n);
+}
+
+
+/* xxHash64, the primes and the rounds are those of the reference implementation */
+
+#define SCONV_P64_1  (0x9E3779B185EBCA87ULL)
+#define SCONV_P64_2  (0xC2B2AE3D27D4EB4FULL)
+#define SCONV_P64_3  (0x165667B19E3779F9ULL)
+#define SCONV_P64_4  (0x85EBCA77C2B2AE63ULL)
+#define SCONV_P64_5  (0x27D4EB2F165667C5ULL)
+
+#define SCONV_ROTL64(x, r)  (((x) << (r)) | ((x) >> (64 - (r))))
+
+
+static unsigned long long sconv_xxh_round(unsigned long long acc, unsigned long long val)
+{
+  acc += val * SCONV_P64_2;
+
+  acc = SCONV_ROTL64(acc, 31);
+
+  return acc * SCONV_P64_1;
+}
+
+
+static unsigned long long sconv_xxh_merge(unsigned long long acc, unsigned long long val)
+{
+  acc ^= sconv_xxh_round(0, val);
+
+  return (acc * SCONV_P64_1) + SCONV_P64_4;
+}
+
+
+unsigned long long sconv_hash64(const void *buf, int n, unsigned long long seed)
+{
+  const unsigned char *p=(const unsigned char *)buf,
+                      *end;
+
+  unsigned long long h, v1, v2, v3, v4, k;
+
+  unsigned int k32;
+
+  if(n < 0)
+  {
+    n = 0;
+  }
+
+  end = p + n;
+
+  if(n >= 32)
+  {
+    v1 = seed + SCONV_P64_1 + SCONV_P64_2;
+    v2 = seed + SCONV_P64_2;
+    v3 = seed;
+    v4 = seed - SCONV_P64_1;
+
+    do
+    {
+      memcpy(&k, p, 8);  v1 = sconv_xxh_round(v1, k);
+      memcpy(&k, p + 8, 8);  v2 = sconv_xxh_round(v2, k);
+      memcpy(&k, p + 16, 8);  v3 = sconv_xxh_round(v3, k);
+      memcpy(&k, p + 24, 8);  v4 = sconv_xxh_round(v4, k);
+
+      p += 32;
+    }
+    while(p <= (end - 32));
+
+    h = SCONV_ROTL64(v1, 1) + SCONV_ROTL64(v2, 7) + SCONV_ROTL64(v3, 12) + SCONV_ROTL64(v4, 18);
+
+    h = sconv_xxh_merge(h, v1);
+    h = sconv_xxh_merge(h, v2);
+    h = sconv_xxh_merge(h, v3);
+    h = sconv_xxh_merge(h, v4);
+  }
+  else
+  {
+    h = seed + SCONV_P64_5;
+  }
+
+  h += (unsigned long long)n;
+
+  while((p + 8) <= end)
+  {
+    memcpy(&k, p, 8);
+
+    h ^= sconv_xxh_round(0, k);
+
+    h = (SCONV_ROTL64(h, 27) * SCONV_P64_1) + SCONV_P64_4;
+
+    p += 8;
+  }
+
+  if((p + 4) <= end)
+  {
+    memcpy(&k32, p, 4);
+
+    h ^= (unsigned long long)k32 * SCONV_P64_1;
+
+    h = (SCONV_ROTL64(h, 23) * SCONV_P64_2) + SCONV_P64_3;
+
+    p += 4;
+  }
+
+  while(p < end)
+  {
+    h ^= (*p) * SCONV_P64_5;
+
+    h = SCONV_ROTL64(h, 11) * SCONV_P64_1;
+
+    p++;
+  }
+
+  h ^= h >> 33;
+  h *= SCONV_P64_2;
+  h ^= h >> 29;
+  h *= SCONV_P64_3;
+  h ^= h >> 32;
+
+  return h;
+}
+
+
+
@@ -0,0 +1,88 @@
+/*
+***************************************************************************
+*
+* Author: Teunis van Beelen
+*
+* Copyright (C) 2015 - 2024 Teunis van Beelen
+*
+* Email: teuniz@protonmail.com
+*
+***************************************************************************
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+***************************************************************************
+*/
+
+
+
+#ifndef SAMPLE_CONV_H
+#define SAMPLE_CONV_H
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/*
+ * Conversion of the raw waveform bytes from the device, reductions
+ * over sample buffers and the pixel spans of the trace rasterizer.
+ * Every function has a plain C version and,
+ * on x86, SSE2 and AVX2 versions. The fastest version the CPU supports
+ * is selected at runtime, the results are identical. The hash is plain
+ * C only, it already runs at memory speed.
+ */
+
+#define SCONV_LEVEL_SCALAR  (0)
+#define SCONV_LEVEL_SSE2    (1)
+#define SCONV_LEVEL_AVX2    (2)
+
+
+/* returns the level in use */
+int sconv_get_level(void);
+
+/* limits the level, e.g. for benchmarks, returns the level in use */
+int sconv_set_level(int);
+
+/* dest[i] = (src[i] - offset) << shift, truncated to 16 bits like an assignment to short */
+void sconv_u8_to_s16(short *, const unsigned char *, int, int, int);
+
+/* dest[i] = (src[i] - offset) * scale */
+void sconv_u8_to_double(double *, const unsigned char *, int, int, double);
+
+/* minimum, maximum and sum of n samples in one pass, n must be > 0 */
+void sconv_s16_minmax_sum(const short *, int, short *, short *, long long *);
+
+/* dest[i] = val, the spans of the trace rasterizer */
+void sconv_fill_u32(unsigned int *, int, unsigned int);
+
+/* dest[i] = src[i] source over dest[i], ARGB32 premultiplied, */
+/* the bytes of dest are scaled by (255 - alpha of src) / 255, rounded */
+void sconv_argb_over(unsigned int *, const unsigned int *, int);
+
+/* dest[i] = dest[i] + src[i], every byte saturates at 255, adds the colors of the channels */
+void sconv_argb_adds(unsigned int *, const unsigned int *, int);
+
+/* xxHash64 of n bytes, used to detect frames that didn't change */
+unsigned long long sconv_hash64(const void *, int, unsigned long long);
+
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif
+
+
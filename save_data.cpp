@@ -41,7 +41,7 @@ void UI_Mainwindow::save_app_screenshot()
 
   scrn_timer->stop();
 
-  scrn_thread->wait();
+  scrn_thread->wait_idle();
 
   if(recent_savedir[0]!=0)
   {
@@ -85,12 +85,16 @@ void UI_Mainwindow::save_screenshot()
 
   scrn_timer->stop();
 
-  scrn_thread->wait();
+  scrn_thread->wait_idle();
 
-  tmc_write(":DISP:DATA?");
+  tmc_write(device, ":DISP:DATA?");
 
   save_data_thread get_data_thrd(0);
 
+  get_data_thrd.set_device(device);
+
+  get_data_thrd.set_read_dest(devparms.screenshot_buf, WAVFRM_MAX_BUFSZ);
+
   QMessageBox w_msg_box;
   w_msg_box.setIcon(QMessageBox::NoIcon);
   w_msg_box.setText("Downloading data...");
@@ -128,8 +132,6 @@ void UI_Mainwindow::save_screenshot()
     goto OUT_ERROR;
   }
 
-  memcpy(devparms.screenshot_buf, device->buf, SCRN_SHOT_BMP_SZ);
-
   screenXpm.loadFromData((uchar *)(devparms.screenshot_buf), SCRN_SHOT_BMP_SZ);
 
   if(devparms.modelserie == 1)
@@ -228,9 +230,14 @@ void UI_Mainwindow::get_deep_memory_waveform(void)
       bytes_rcvd=0,
       mempnts,
       yref[MAX_CHNS],
-      empty_buf;
+      empty_buf,
+      n_batch;
 
-  char str[512];
+  char str[512],
+       batch_str[2][128],
+       *rawbuf=NULL;
+
+  const char *batch[5];
 
   short *wavbuf[MAX_CHNS];
 
@@ -240,6 +247,8 @@ void UI_Mainwindow::get_deep_memory_waveform(void)
 
   save_data_thread get_data_thrd(0);
 
+  get_data_thrd.set_device(device);
+
   if(device == NULL)
   {
     return;
@@ -247,7 +256,7 @@ void UI_Mainwindow::get_deep_memory_waveform(void)
 
   scrn_timer->stop();
 
-  scrn_thread->wait();
+  scrn_thread->wait_idle();
 
   for(i=0; i<MAX_CHNS; i++)
   {
@@ -301,9 +310,27 @@ void UI_Mainwindow::get_deep_memory_waveform(void)
     }
   }
 
-  tmc_write(":STOP");
+  // the blocks are received straight into rawbuf, not staged in the device buffer
+  rawbuf = (char *)malloc(SAV_MEM_BSZ);
+  if(rawbuf == NULL)
+  {
+    snprintf(str, 512, "Malloc error.  line %i file %s", __LINE__, __FILE__);
+    goto OUT_ERROR;
+  }
+
+  get_data_thrd.set_read_dest(rawbuf, SAV_MEM_BSZ);
+
+  connect(&get_data_thrd, SIGNAL(read_progress(int)), &progress, SLOT(setValue(int)));
 
-  usleep(20000);
+  // the setters are confirmed with *OPC? before the next query, the device
+  // must have stopped and switched the source before the memory is read
+  batch[0] = ":STOP";
+
+  if(tmc_write_batch(device, batch, 1, TMC_OPC_WAIT) != 1)
+  {
+    snprintf(str, 512, "Can not write to device.  line %i file %s", __LINE__, __FILE__);
+    goto OUT_ERROR;
+  }
 
   for(chn=0; chn<MAX_CHNS; chn++)
   {
@@ -315,23 +342,21 @@ void UI_Mainwindow::get_deep_memory_waveform(void)
     snprintf(str, 512, "Downloading channel %i waveform data...", chn + 1);
     progress.setLabelText(str);
 
-    snprintf(str, 512, ":WAV:SOUR CHAN%i", chn + 1);
-
-    tmc_write(str);
+    snprintf(batch_str[0], 128, ":WAV:SOUR CHAN%i", chn + 1);
 
-    tmc_write(":WAV:FORM BYTE");
+    batch[0] = batch_str[0];
+    batch[1] = ":WAV:FORM BYTE";
+    batch[2] = ":WAV:MODE RAW";
 
-    usleep(20000);
-
-    tmc_write(":WAV:MODE RAW");
-
-    usleep(20000);
-
-    tmc_write(":WAV:YINC?");
+    if(tmc_write_batch(device, batch, 3, TMC_OPC_WAIT) != 3)
+    {
+      snprintf(str, 512, "Can not write to device.  line %i file %s", __LINE__, __FILE__);
+      goto OUT_ERROR;
+    }
 
-    usleep(20000);
+    tmc_write(device, ":WAV:YINC?");
 
-    tmc_read();
+    tmc_read(device);
 
     devparms.yinc[chn] = atof(device->buf);
 
@@ -341,13 +366,9 @@ void UI_Mainwindow::get_deep_memory_waveform(void)
       goto OUT_ERROR;
     }
 
-    usleep(20000);
-
-    tmc_write(":WAV:YREF?");
-
-    usleep(20000);
+    tmc_write(device, ":WAV:YREF?");
 
-    tmc_read();
+    tmc_read(device);
 
     yref[chn] = atoi(device->buf);
 
@@ -357,13 +378,9 @@ void UI_Mainwindow::get_deep_memory_waveform(void)
       goto OUT_ERROR;
     }
 
-    usleep(20000);
+    tmc_write(device, ":WAV:YOR?");
 
-    tmc_write(":WAV:YOR?");
-
-    usleep(20000);
-
-    tmc_read();
+    tmc_read(device);
 
     devparms.yor[chn] = atoi(device->buf);
 
@@ -389,28 +406,29 @@ void UI_Mainwindow::get_deep_memory_waveform(void)
         goto OUT_ERROR;
       }
 
-      snprintf(str, 512, ":WAV:STAR %i",  bytes_rcvd + 1);
-
-      usleep(20000);
-
-      tmc_write(str);
+      snprintf(batch_str[0], 128, ":WAV:STAR %i",  bytes_rcvd + 1);
 
       if((bytes_rcvd + SAV_MEM_BSZ) > mempnts)
       {
-        snprintf(str, 512, ":WAV:STOP %i", mempnts);
+        snprintf(batch_str[1], 128, ":WAV:STOP %i", mempnts);
       }
       else
       {
-        snprintf(str, 512, ":WAV:STOP %i", bytes_rcvd + SAV_MEM_BSZ);
+        snprintf(batch_str[1], 128, ":WAV:STOP %i", bytes_rcvd + SAV_MEM_BSZ);
       }
 
-      usleep(20000);
+      batch[0] = batch_str[0];
+      batch[1] = batch_str[1];
 
-      tmc_write(str);
+      if(tmc_write_batch(device, batch, 2, TMC_OPC_WAIT) != 2)
+      {
+        snprintf(str, 512, "Can not write to device.  line %i file %s", __LINE__, __FILE__);
+        goto OUT_ERROR;
+      }
 
-      usleep(20000);
+      tmc_write(device, ":WAV:DATA?");
 
-      tmc_write(":WAV:DATA?");
+      get_data_thrd.set_read_progress_base(bytes_rcvd);
 
       get_data_thrd.start();
 
@@ -431,11 +449,6 @@ void UI_Mainwindow::get_deep_memory_waveform(void)
 
       printf("received %i bytes, total %i bytes\n", n, n + bytes_rcvd);
 
-      if(n > SAV_MEM_BSZ)
-      {
-        snprintf(str, 512, "Datablock too big for buffer: %i  line %i file %s", n, __LINE__, __FILE__);
-        goto OUT_ERROR;
-      }
 
       if(n < 1)
       {
@@ -449,14 +462,16 @@ void UI_Mainwindow::get_deep_memory_waveform(void)
         empty_buf = 0;
       }
 
-      for(k=0; k<n; k++)
+      k = n;
+
+      if((bytes_rcvd + k) > mempnts)
       {
-        if((bytes_rcvd + k) >= mempnts)
-        {
-          break;
-        }
+        k = mempnts - bytes_rcvd;
+      }
 
-        wavbuf[chn][bytes_rcvd + k] = ((int)(((unsigned char *)device->buf)[k])) - yref[chn] - devparms.yor[chn];
+      if(k > 0)
+      {
+        sconv_u8_to_s16(wavbuf[chn] + bytes_rcvd, (unsigned char *)rawbuf, k, yref[chn] + devparms.yor[chn], 0);
       }
 
       bytes_rcvd += n;
@@ -483,36 +498,27 @@ void UI_Mainwindow::get_deep_memory_waveform(void)
       continue;
     }
 
-    snprintf(str, 512, ":WAV:SOUR CHAN%i", chn + 1);
-
-    usleep(20000);
-
-    tmc_write(str);
+    snprintf(batch_str[0], 128, ":WAV:SOUR CHAN%i", chn + 1);
 
-    usleep(20000);
-
-    tmc_write(":WAV:MODE NORM");
-
-    usleep(20000);
-
-    tmc_write(":WAV:STAR 1");
+    batch[0] = batch_str[0];
+    batch[1] = ":WAV:MODE NORM";
+    batch[2] = ":WAV:STAR 1";
 
     if(devparms.modelserie == 1)
     {
-      usleep(20000);
+      batch[3] = ":WAV:STOP 1200";
 
-      tmc_write(":WAV:STOP 1200");
+      n_batch = 4;
     }
     else
     {
-      usleep(20000);
+      batch[3] = ":WAV:STOP 1400";
+      batch[4] = ":WAV:POIN 1400";
 
-      tmc_write(":WAV:STOP 1400");
-
-      usleep(20000);
-
-      tmc_write(":WAV:POIN 1400");
+      n_batch = 5;
     }
+
+    tmc_write_batch(device, batch, n_batch, TMC_OPC_WAIT);
   }
 
   if(bytes_rcvd < mempnts)
@@ -529,6 +535,8 @@ void UI_Mainwindow::get_deep_memory_waveform(void)
 
   disconnect(&get_data_thrd, 0, 0, 0);
 
+  free(rawbuf);
+
   scrn_timer->start(devparms.screentimerival);
 
   return;
@@ -553,6 +561,8 @@ OUT_ERROR:
     w_msg_box.exec();
   }
 
+  free(rawbuf);
+
   if(progress.wasCanceled() == false)
   {
     QMessageBox msgBox;
@@ -568,24 +578,27 @@ OUT_ERROR:
       continue;
     }
 
-    snprintf(str, 512, ":WAV:SOUR CHAN%i", chn + 1);
-
-    tmc_write(str);
-
-    tmc_write(":WAV:MODE NORM");
+    snprintf(batch_str[0], 128, ":WAV:SOUR CHAN%i", chn + 1);
 
-    tmc_write(":WAV:STAR 1");
+    batch[0] = batch_str[0];
+    batch[1] = ":WAV:MODE NORM";
+    batch[2] = ":WAV:STAR 1";
 
     if(devparms.modelserie == 1)
     {
-      tmc_write(":WAV:STOP 1200");
+      batch[3] = ":WAV:STOP 1200";
+
+      n_batch = 4;
     }
     else
     {
-      tmc_write(":WAV:STOP 1400");
+      batch[3] = ":WAV:STOP 1400";
+      batch[4] = ":WAV:POIN 1400";
 
-      tmc_write(":WAV:POIN 1400");
+      n_batch = 5;
     }
+
+    tmc_write_batch(device, batch, n_batch, TMC_OPC_WAIT);
   }
 
   for(chn=0; chn<MAX_CHNS; chn++)
@@ -800,9 +813,9 @@ OUT_ERROR:
 }
 
 
-//     tmc_write(":WAV:PRE?");
+//     tmc_write(device, ":WAV:PRE?");
 //
-//     n = tmc_read();
+//     n = tmc_read(device);
 //
 //     if(n < 0)
 //     {
@@ -849,7 +862,10 @@ void UI_Mainwindow::save_screen_waveform()
       yref[MAX_CHNS];
 
   char str[512],
-       opath[MAX_PATHLEN];
+       opath[MAX_PATHLEN],
+       *rawbuf=NULL;
+
+  const char *batch[3];
 
   short *wavbuf[MAX_CHNS];
 
@@ -867,6 +883,8 @@ void UI_Mainwindow::save_screen_waveform()
 
   save_data_thread get_data_thrd(0);
 
+  get_data_thrd.set_device(device);
+
   QMessageBox w_msg_box;
   w_msg_box.setIcon(QMessageBox::NoIcon);
   w_msg_box.setText("Downloading data...");
@@ -874,7 +892,7 @@ void UI_Mainwindow::save_screen_waveform()
 
   scrn_timer->stop();
 
-  scrn_thread->wait();
+  scrn_thread->wait_idle();
 
   if(devparms.timebasedelayenable)
   {
@@ -914,6 +932,16 @@ void UI_Mainwindow::save_screen_waveform()
     goto OUT_ERROR;
   }
 
+  // the blocks are received straight into rawbuf, not staged in the device buffer
+  rawbuf = (char *)malloc(WAVFRM_MAX_BUFSZ);
+  if(rawbuf == NULL)
+  {
+    strlcpy(str, "Malloc error.", 512);
+    goto OUT_ERROR;
+  }
+
+  get_data_thrd.set_read_dest(rawbuf, WAVFRM_MAX_BUFSZ);
+
   for(chn=0; chn<MAX_CHNS; chn++)
   {
     if(!devparms.chandisplay[chn])  // Download data only when channel is switched on
@@ -921,27 +949,21 @@ void UI_Mainwindow::save_screen_waveform()
       continue;
     }
 
-    usleep(20000);
-
     snprintf(str, 512, ":WAV:SOUR CHAN%i", chn + 1);
 
-    tmc_write(str);
+    batch[0] = str;
+    batch[1] = ":WAV:FORM BYTE";
+    batch[2] = ":WAV:MODE NORM";
 
-    usleep(20000);
-
-    tmc_write(":WAV:FORM BYTE");
-
-    usleep(20000);
-
-    tmc_write(":WAV:MODE NORM");
-
-    usleep(20000);
-
-    tmc_write(":WAV:YINC?");
+    if(tmc_write_batch(device, batch, 3, TMC_OPC_WAIT) != 3)
+    {
+      strlcpy(str, "Can not write to device.", 512);
+      goto OUT_ERROR;
+    }
 
-    usleep(20000);
+    tmc_write(device, ":WAV:YINC?");
 
-    tmc_read();
+    tmc_read(device);
 
     devparms.yinc[chn] = atof(device->buf);
 
@@ -951,13 +973,9 @@ void UI_Mainwindow::save_screen_waveform()
       goto OUT_ERROR;
     }
 
-    usleep(20000);
-
-    tmc_write(":WAV:YREF?");
+    tmc_write(device, ":WAV:YREF?");
 
-    usleep(20000);
-
-    tmc_read();
+    tmc_read(device);
 
     yref[chn] = atoi(device->buf);
 
@@ -967,13 +985,9 @@ void UI_Mainwindow::save_screen_waveform()
       goto OUT_ERROR;
     }
 
-    usleep(20000);
-
-    tmc_write(":WAV:YOR?");
+    tmc_write(device, ":WAV:YOR?");
 
-    usleep(20000);
-
-    tmc_read();
+    tmc_read(device);
 
     devparms.yor[chn] = atoi(device->buf);
 
@@ -983,9 +997,7 @@ void UI_Mainwindow::save_screen_waveform()
       goto OUT_ERROR;
     }
 
-    usleep(20000);
-
-    tmc_write(":WAV:DATA?");
+    tmc_write(device, ":WAV:DATA?");
 
     connect(&get_data_thrd, SIGNAL(finished()), &w_msg_box, SLOT(accept()));
 
@@ -1007,22 +1019,13 @@ void UI_Mainwindow::save_screen_waveform()
       goto OUT_ERROR;
     }
 
-    if(n > WAVFRM_MAX_BUFSZ)
-    {
-      snprintf(str, 512, "Datablock too big for buffer: %i", n);
-      goto OUT_ERROR;
-    }
-
     if(n < 16)
     {
       strlcpy(str, "Not enough data in buffer.", 512);
       goto OUT_ERROR;
     }
 
-    for(i=0; i<n; i++)
-    {
-      wavbuf[chn][i] = ((int)(((unsigned char *)device->buf)[i]) - yref[chn] - devparms.yor[chn]) << 5;
-    }
+    sconv_u8_to_s16(wavbuf[chn], (unsigned char *)rawbuf, n, yref[chn] + devparms.yor[chn], 5);
   }
 
   opath[0] = 0;
@@ -1114,6 +1117,8 @@ OUT_NORMAL:
     wavbuf[chn] = NULL;
   }
 
+  free(rawbuf);
+
   scrn_timer->start(devparms.screentimerival);
 
   return;
@@ -1127,6 +1132,8 @@ OUT_ERROR:
     w_msg_box.exec();
   }
 
+  free(rawbuf);
+
   QMessageBox msgBox;
   msgBox.setIcon(QMessageBox::Critical);
   msgBox.setText(str);
@@ -49,6 +49,14 @@ save_data_thread::save_data_thread(int job_s)
   datrecs = 0;
 
   smps_per_record = 0;
+
+  rd_dest = NULL;
+
+  rd_dest_sz = 0;
+
+  rd_progress_base = 0;
+
+  device = NULL;
 }
 
 
@@ -70,6 +78,38 @@ int save_data_thread::get_num_bytes_rcvd(void)
 }
 
 
+void save_data_thread::set_device(struct tmcdev *dev)
+{
+  device = dev;
+}
+
+
+// lets read_data() receive the payload straight into dest instead of the device buffer
+void save_data_thread::set_read_dest(char *dest, int sz)
+{
+  rd_dest = dest;
+
+  rd_dest_sz = sz;
+}
+
+
+// read_progress() gives base plus the number of bytes received so far,
+// e.g. the position of the chunk in the memory of the device
+void save_data_thread::set_read_progress_base(int base)
+{
+  rd_progress_base = base;
+}
+
+
+// called by tmc_read_block() in this thread, the signal is queued to the GUI
+void save_data_thread::read_progress_cb(int got, int, void *data)
+{
+  save_data_thread *thrd = (save_data_thread *)data;
+
+  emit thrd->read_progress(thrd->rd_progress_base + got);
+}
+
+
 void save_data_thread::run()
 {
   err_str[0] = 0;
@@ -90,7 +130,14 @@ void save_data_thread::read_data(void)
 {
   msleep(100);
 
-  n_bytes_rcvd = tmc_read();
+  if(rd_dest != NULL)
+  {
+    n_bytes_rcvd = tmc_read_block(device, rd_dest, rd_dest_sz, read_progress_cb, this);
+  }
+  else
+  {
+    n_bytes_rcvd = tmc_read(device);
+  }
 
   err_num = 0;
 }
@@ -58,6 +58,9 @@ public:
   int get_error_num(void);
   void get_error_str(char *, int);
   int get_num_bytes_rcvd(void);
+  void set_device(struct tmcdev *);
+  void set_read_dest(char *, int);
+  void set_read_progress_base(int);
   void init_save_memory_edf_file(struct device_settings *devp, int,
                                  int, int, short **wav);
 
@@ -70,16 +73,28 @@ private:
       datrecs,
       smps_per_record;
 
-  char err_str[4096];
+  char err_str[4096],
+       *rd_dest;
+
+  int rd_dest_sz,
+      rd_progress_base;
 
   struct device_settings *devparms;
 
+  struct tmcdev *device;
+
   short **wavbuf;
 
   void run();
 
   void read_data(void);
   void save_memory_edf_file(void);
+
+  static void read_progress_cb(int, int, void *);
+
+signals:
+
+  void read_progress(int);
 };
 
 
@@ -29,178 +29,721 @@
 #include "screen_thread.h"
 
 
-#define SPECT_LOG_MINIMUM (0.00000001)
-#define SPECT_LOG_MINIMUM_LOG (-80)
+#define STAT_QRY_MAX_FIELDS (16)
 
 
+#define SCRN_THRD_FRESH     (4)
+#define SCRN_THRD_IDX_MASK  (3)
+
+
+static long long scrn_get_usec(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+
+  return ((long long)ts.tv_sec * 1000000LL) + (ts.tv_nsec / 1000LL);
+}
+
+
+// must only be called when the thread is not running
 void screen_thread::set_device(struct tmcdev *tmdev)
 {
-  params.cmd_cue_idx_in = 0;
-  params.cmd_cue_idx_out = 0;
   params.connected = 0;
 
+  pending.connected = 0;
+
+  cmd_cue.reset();
+
+  frame_req = 0;
+  quit_req = 0;
+  busy = 0;
+  frame_aborted = 0;
+  frame_idle = 0;
+  pending_changed = 0;
+  abort_cnt = 0;
+  wav_raw_set = 0;
+  raw_tb_offset_valid = 0;
+
+  reset_idle();
+
+  fpol_init(&fpol);
+
   device = tmdev;
 }
 
 
 screen_thread::screen_thread()
 {
-  int i;
+  int i, j;
 
   device = NULL;
 
+  deviceparms = NULL;
+
   h_busy = 0;
 
-  for(i=0; i<MAX_CHNS; i++)
+  memset(&params, 0, sizeof(params));
+  memset(&pending, 0, sizeof(pending));
+  memset(frames, 0, sizeof(frames));
+
+  for(j=0; j<SCRN_THRD_FRAMES; j++)
   {
-    params.wavebuf[i] = (short *)malloc(WAVFRM_MAX_BUFSZ);
+    for(i=0; i<MAX_CHNS; i++)
+    {
+      frames[j].wavebuf[i] = (short *)calloc(1, WAVFRM_MAX_BUFSZ * sizeof(short));
+    }
+
+    frames[j].fftbuf_out = (double *)calloc(1, FFT_MAX_BUFSZ * sizeof(double));
   }
 
-  params.cmd_cue_idx_in = 0;
-  params.cmd_cue_idx_out = 0;
+  wav_rd_buf = (unsigned char *)malloc(WAVFRM_MAX_BUFSZ);
+
+  frm_back = 0;
+  frm_front = 1;
+  frm_state.storeRelease(2);
+
+  last_trigedgelev_cnt = 0;
+  last_timdelay_cnt = 0;
+  last_ffthzdiv_cnt = 0;
+
+  last_math_fft = 0;
+
+  fft_last_valid = 0;
+
+  fft_last_hash = 0;
+
+  memset(&fft_last_p, 0, sizeof(fft_last_p));
+
+  frame_req = 0;
+  quit_req = 0;
+  busy = 0;
+  frame_aborted = 0;
+  frame_idle = 0;
+  pending_changed = 0;
+  abort_cnt = 0;
+  wav_raw_set = 0;
+  raw_tb_offset_valid = 0;
+
+  reset_idle();
+
   params.connected = 0;
 }
 
 
 screen_thread::~screen_thread()
+{
+  int i, j;
+
+  for(j=0; j<SCRN_THRD_FRAMES; j++)
+  {
+    for(i=0; i<MAX_CHNS; i++)
+    {
+      free(frames[j].wavebuf[i]);
+    }
+
+    free(frames[j].fftbuf_out);
+  }
+
+  free(wav_rd_buf);
+}
+
+
+// the waveform and fft buffers in devparms point to the frame
+// that is shown by the GUI, they are never written by the thread
+void screen_thread::set_frame_bufs(struct device_settings *dev_parms)
 {
   int i;
 
   for(i=0; i<MAX_CHNS; i++)
   {
-    free(params.wavebuf[i]);
+    dev_parms->wavebuf[i] = frames[frm_front].wavebuf[i];
   }
+
+  dev_parms->fftbuf_out = frames[frm_front].fftbuf_out;
 }
 
 
+// requests a new frame, if the thread is busy the request is
+// handled as soon as the current frame is finished
 void screen_thread::set_params(struct device_settings *dev_parms)
 {
+  unsigned long long hash;
+
+  req_mutex.lock();
+
+  hash = sconv_hash64(&pending, sizeof(pending), 0);
+
   deviceparms = dev_parms;
-  params.connected = deviceparms->connected;
-  params.modelserie = deviceparms->modelserie;
-  params.chandisplay[0] = deviceparms->chandisplay[0];
-  params.chandisplay[1] = deviceparms->chandisplay[1];
-  params.chandisplay[2] = deviceparms->chandisplay[2];
-  params.chandisplay[3] = deviceparms->chandisplay[3];
-  params.chanscale[0] = deviceparms->chanscale[0];
-  params.chanscale[1] = deviceparms->chanscale[1];
-  params.chanscale[2] = deviceparms->chanscale[2];
-  params.chanscale[3] = deviceparms->chanscale[3];
-  params.countersrc = deviceparms->countersrc;
-  params.cmd_cue_idx_in = deviceparms->cmd_cue_idx_in;
-  params.math_fft_src = deviceparms->math_fft_src;
-  params.math_fft = deviceparms->math_fft;
-  params.math_fft_unit = deviceparms->math_fft_unit;
-  params.fftbuf_in = deviceparms->fftbuf_in;
-  params.fftbuf_out = deviceparms->fftbuf_out;
-  params.fftbufsz = deviceparms->fftbufsz;
-  params.k_cfg = deviceparms->k_cfg;
-  params.kiss_fftbuf = deviceparms->kiss_fftbuf;
-  params.current_screen_sf = deviceparms->current_screen_sf;
+  pending.connected = deviceparms->connected;
+  pending.modelserie = deviceparms->modelserie;
+  pending.chandisplay[0] = deviceparms->chandisplay[0];
+  pending.chandisplay[1] = deviceparms->chandisplay[1];
+  pending.chandisplay[2] = deviceparms->chandisplay[2];
+  pending.chandisplay[3] = deviceparms->chandisplay[3];
+  pending.chanscale[0] = deviceparms->chanscale[0];
+  pending.chanscale[1] = deviceparms->chanscale[1];
+  pending.chanscale[2] = deviceparms->chanscale[2];
+  pending.chanscale[3] = deviceparms->chanscale[3];
+  pending.countersrc = deviceparms->countersrc;
+  pending.math_fft_src = deviceparms->math_fft_src;
+  pending.math_fft = deviceparms->math_fft;
+  pending.math_fft_unit = deviceparms->math_fft_unit;
+  pending.fftbufsz = deviceparms->fftbufsz;
+  pending.math_fft_window = deviceparms->math_fft_window;
+  pending.math_fft_avg = deviceparms->math_fft_avg;
+  pending.math_fft_avg_cnt = deviceparms->math_fft_avg_cnt;
+  pending.current_screen_sf = deviceparms->current_screen_sf;
+  pending.hordivisions = deviceparms->hordivisions;
+  pending.timebasescale = deviceparms->timebasescale;
+  pending.timebaseoffset = deviceparms->timebaseoffset;
+  pending.timebasedelayenable = deviceparms->timebasedelayenable;
+  pending.math_decode_display = deviceparms->math_decode_display;
+  pending.screentimerival = deviceparms->screentimerival;
+  pending.screen_res_adaptive = deviceparms->screen_res_adaptive;
+  pending.func_wrec_enable = deviceparms->func_wrec_enable;
+  pending.func_wrec_operate = deviceparms->func_wrec_operate;
+  pending.func_wplay_operate = deviceparms->func_wplay_operate;
+  pending.func_wplay_fcur = deviceparms->func_wplay_fcur;
+  pending.func_wrec_fmax = deviceparms->func_wrec_fmax;
+  pending.func_wrep_fmax = deviceparms->func_wplay_fmax;
+
+  // a changed setting ends the idle back-off with the next frame instead of
+  // waiting for the status poll, the idle state itself belongs to the thread
+  if(sconv_hash64(&pending, sizeof(pending), 0) != hash)
+  {
+    pending_changed = 1;
+  }
+
+  frame_req = 1;
+
+  req_cond.wakeOne();
+
+  req_mutex.unlock();
+}
+
+
+// called by the thread, copies the last request into the working parameters
+// the results of the previous frame (status, job values) are kept
+void screen_thread::load_params()
+{
+  int i;
+
+  params.connected = pending.connected;
+  params.modelserie = pending.modelserie;
+  for(i=0; i<MAX_CHNS; i++)
+  {
+    params.chandisplay[i] = pending.chandisplay[i];
+    params.chanscale[i] = pending.chanscale[i];
+  }
+  params.countersrc = pending.countersrc;
+  params.math_fft_src = pending.math_fft_src;
+  params.math_fft = pending.math_fft;
+  params.math_fft_unit = pending.math_fft_unit;
+  params.fftbufsz = pending.fftbufsz;
+  params.math_fft_window = pending.math_fft_window;
+  params.math_fft_avg = pending.math_fft_avg;
+  params.math_fft_avg_cnt = pending.math_fft_avg_cnt;
+  params.current_screen_sf = pending.current_screen_sf;
+  params.hordivisions = pending.hordivisions;
+  params.timebasescale = pending.timebasescale;
+  params.timebaseoffset = pending.timebaseoffset;
+  params.timebasedelayenable = pending.timebasedelayenable;
+  params.math_decode_display = pending.math_decode_display;
+  params.screentimerival = pending.screentimerival;
+  params.screen_res_adaptive = pending.screen_res_adaptive;
   params.debug_str[0] = 0;
-  params.func_wrec_enable = deviceparms->func_wrec_enable;
-  params.func_wrec_operate = deviceparms->func_wrec_operate;
-  params.func_wplay_operate = deviceparms->func_wplay_operate;
-  params.func_wplay_fcur = deviceparms->func_wplay_fcur;
-  params.func_wrec_fmax = deviceparms->func_wrec_fmax;
-  params.func_wrep_fmax = deviceparms->func_wplay_fmax;
+  params.func_wrec_enable = pending.func_wrec_enable;
+  params.func_wrec_operate = pending.func_wrec_operate;
+  params.func_wplay_operate = pending.func_wplay_operate;
+  params.func_wplay_fcur = pending.func_wplay_fcur;
+  params.func_wrec_fmax = pending.func_wrec_fmax;
+  params.func_wrep_fmax = pending.func_wrep_fmax;
 }
 
 
-void screen_thread::get_params(struct device_settings *dev_parms)
+// returns 1 when a new frame was taken over, 0 if there is nothing new
+// only the buffer pointers in dev_parms are changed, no sample data is copied
+int screen_thread::get_params(struct device_settings *dev_parms)
 {
   int i;
 
-  dev_parms->connected = params.connected;
-  dev_parms->triggerstatus = params.triggerstatus;
-  dev_parms->triggersweep = params.triggersweep;
-  dev_parms->samplerate = params.samplerate;
-  dev_parms->acquirememdepth = params.memdepth;
-  dev_parms->counterfreq = params.counterfreq;
-  dev_parms->wavebufsz = params.wavebufsz;
+  struct scrn_thrd_params *frm;
+
+  if(!(frm_state.loadAcquire() & SCRN_THRD_FRESH))
+  {
+    return 0;
+  }
+
+  frm_front = frm_state.fetchAndStoreOrdered(frm_front) & SCRN_THRD_IDX_MASK;
+
+  frm = &frames[frm_front];
+
+  dev_parms->connected = frm->connected;
+  dev_parms->triggerstatus = frm->triggerstatus;
+  dev_parms->triggersweep = frm->triggersweep;
+  dev_parms->samplerate = frm->samplerate;
+  dev_parms->acquirememdepth = frm->memdepth;
+  dev_parms->counterfreq = frm->counterfreq;
+  dev_parms->wavebufsz = frm->wavebufsz;
+  dev_parms->screen_pnts = frm->screen_pnts;
+  dev_parms->frame_hash = frm->frame_hash;
   for(i=0; i<MAX_CHNS; i++)
   {
-    if(params.chandisplay[i])
+    dev_parms->wavebuf[i] = frm->wavebuf[i];
+    if(frm->chandisplay[i])
     {
-      memcpy(dev_parms->wavebuf[i], params.wavebuf[i], params.wavebufsz * sizeof(short));
-      dev_parms->xorigin[i] = params.xorigin[i];
+      dev_parms->xorigin[i] = frm->xorigin[i];
     }
   }
-  dev_parms->thread_error_stat = params.error_stat;
-  dev_parms->thread_error_line = params.error_line;
-  dev_parms->cmd_cue_idx_out = params.cmd_cue_idx_out;
-  dev_parms->thread_result = params.result;
-  dev_parms->thread_job = params.job;
-  if(dev_parms->thread_job == TMC_THRD_JOB_TRIGEDGELEV)
+  dev_parms->fftbuf_out = frm->fftbuf_out;
+  dev_parms->fftbuf_seq = frm->fftbuf_seq;
+  dev_parms->thread_error_stat = frm->error_stat;
+  dev_parms->thread_error_line = frm->error_line;
+  dev_parms->thread_result = frm->result;
+  dev_parms->thread_job = TMC_THRD_JOB_NONE;
+  if(frm->timdelay_cnt != last_timdelay_cnt)
   {
-    dev_parms->thread_value = params.triggeredgelevel;
+    last_timdelay_cnt = frm->timdelay_cnt;
+    dev_parms->timebasedelayoffset = frm->timebasedelayoffset;
+    dev_parms->timebasedelayscale = frm->timebasedelayscale;
+    dev_parms->thread_job = TMC_THRD_JOB_TIMDELAY;
   }
-  if(dev_parms->thread_job == TMC_THRD_JOB_TIMDELAY)
+  if(frm->ffthzdiv_cnt != last_ffthzdiv_cnt)
   {
-    dev_parms->timebasedelayoffset = params.timebasedelayoffset;
-    dev_parms->timebasedelayscale = params.timebasedelayscale;
+    last_ffthzdiv_cnt = frm->ffthzdiv_cnt;
+    dev_parms->math_fft_hscale = frm->math_fft_hscale;
+    dev_parms->math_fft_hcenter = frm->math_fft_hcenter;
+    dev_parms->thread_job = TMC_THRD_JOB_FFTHZDIV;
   }
-  if(dev_parms->thread_job == TMC_THRD_JOB_FFTHZDIV)
+  if(frm->trigedgelev_cnt != last_trigedgelev_cnt)
   {
-    dev_parms->math_fft_hscale = params.math_fft_hscale;
-    dev_parms->math_fft_hcenter = params.math_fft_hcenter;
+    last_trigedgelev_cnt = frm->trigedgelev_cnt;
+    dev_parms->thread_value = frm->triggeredgelevel;
+    dev_parms->thread_job = TMC_THRD_JOB_TRIGEDGELEV;
   }
   if(dev_parms->func_wrec_enable)
   {
-    dev_parms->func_wrec_operate = params.func_wrec_operate;
-    dev_parms->func_wplay_operate = params.func_wplay_operate;
-    deviceparms->func_wplay_fcur = params.func_wplay_fcur;
-    deviceparms->func_wrec_fmax = params.func_wrec_fmax;
-    deviceparms->func_wplay_fmax = params.func_wrep_fmax;
+    dev_parms->func_wrec_operate = frm->func_wrec_operate;
+    dev_parms->func_wplay_operate = frm->func_wplay_operate;
+    dev_parms->func_wplay_fcur = frm->func_wplay_fcur;
+    dev_parms->func_wrec_fmax = frm->func_wrec_fmax;
+    dev_parms->func_wplay_fmax = frm->func_wrep_fmax;
+  }
+  if(frm->debug_str[0])
+  {
+    frm->debug_str[1023] = 0;
+
+    printf("params.debug_str: ->%s<-\n", frm->debug_str);
+  }
+
+  return 1;
+}
+
+
+// everything the GUI draws from a frame, a stopped scope gives the same hash
+// every frame so the GUI can skip the decoder and the repaint
+void screen_thread::set_frame_hash()
+{
+  int i;
+
+  struct
+  {
+    unsigned long long wave_hash[MAX_CHNS];
+    int chandisplay[MAX_CHNS];
+    double xorigin[MAX_CHNS];
+    int wavebufsz;
+    int screen_pnts;
+    int triggerstatus;
+    int math_fft;
+    unsigned int fftbuf_seq;
+  } key;
+
+  memset(&key, 0, sizeof(key));
+
+  for(i=0; i<MAX_CHNS; i++)
+  {
+    if(!params.chandisplay[i])
+    {
+      continue;
+    }
+
+    key.wave_hash[i] = params.wave_hash[i];
+    key.chandisplay[i] = 1;
+    key.xorigin[i] = params.xorigin[i];
+  }
+
+  key.wavebufsz = params.wavebufsz;
+  key.screen_pnts = params.screen_pnts;
+  key.triggerstatus = params.triggerstatus;
+  key.math_fft = params.math_fft;
+  if(params.math_fft)
+  {
+    key.fftbuf_seq = params.fftbuf_seq;
   }
+
+  params.frame_hash = sconv_hash64(&key, sizeof(key), 0);
+}
+
+
+// called by the thread when a frame is complete, only what get_params() reads
+// is copied, the sample and fft buffers of the frame are already filled
+void screen_thread::publish_frame()
+{
+  int i;
+
+  struct scrn_thrd_params *frm;
+
+  frm = &frames[frm_back];
+
+  frm->connected = params.connected;
+  frm->triggerstatus = params.triggerstatus;
+  frm->triggersweep = params.triggersweep;
+  frm->samplerate = params.samplerate;
+  frm->memdepth = params.memdepth;
+  frm->counterfreq = params.counterfreq;
+  frm->wavebufsz = params.wavebufsz;
+  frm->screen_pnts = params.screen_pnts;
+  frm->frame_hash = params.frame_hash;
+  for(i=0; i<MAX_CHNS; i++)
+  {
+    frm->chandisplay[i] = params.chandisplay[i];
+    frm->xorigin[i] = params.xorigin[i];
+  }
+  frm->fftbuf_seq = params.fftbuf_seq;
+  frm->error_stat = params.error_stat;
+  frm->error_line = params.error_line;
+  frm->result = params.result;
+  frm->timdelay_cnt = params.timdelay_cnt;
+  frm->timebasedelayoffset = params.timebasedelayoffset;
+  frm->timebasedelayscale = params.timebasedelayscale;
+  frm->ffthzdiv_cnt = params.ffthzdiv_cnt;
+  frm->math_fft_hscale = params.math_fft_hscale;
+  frm->math_fft_hcenter = params.math_fft_hcenter;
+  frm->trigedgelev_cnt = params.trigedgelev_cnt;
+  frm->triggeredgelevel = params.triggeredgelevel;
+  frm->func_wrec_operate = params.func_wrec_operate;
+  frm->func_wplay_operate = params.func_wplay_operate;
+  frm->func_wplay_fcur = params.func_wplay_fcur;
+  frm->func_wrec_fmax = params.func_wrec_fmax;
+  frm->func_wrep_fmax = params.func_wrep_fmax;
   if(params.debug_str[0])
   {
-    params.debug_str[1023] = 0;
+    strlcpy(frm->debug_str, params.debug_str, 1024);
+  }
+  else
+  {
+    frm->debug_str[0] = 0;
+  }
+
+  frm_back = frm_state.fetchAndStoreOrdered(frm_back | SCRN_THRD_FRESH) & SCRN_THRD_IDX_MASK;
+
+  emit frame_ready();
+}
+
+
+// blocks until the thread has finished the current frame and all requests,
+// after that the device can be used by the caller
+void screen_thread::wait_idle()
+{
+  req_mutex.lock();
+
+  while((busy || frame_req) && (!quit_req) && isRunning())
+  {
+    idle_cond.wait(&req_mutex, 100);
+  }
+
+  req_mutex.unlock();
+}
+
+
+// can be called from any thread, returns -1 if the queue is full
+int screen_thread::queue_cmd(int op, int chn, double value)
+{
+  return cmd_cue.push(op, chn, value, NULL);
+}
+
+
+int screen_thread::queue_cmd(const char *str, char *resp)
+{
+  return cmd_cue.push(str, resp);
+}
+
+
+void screen_thread::request_quit()
+{
+  req_mutex.lock();
+
+  quit_req = 1;
+
+  req_cond.wakeAll();
+
+  req_mutex.unlock();
+}
+
+
+// the thread keeps running while connected, every request from
+// set_params() results in one published frame unless the frame
+// is aborted because commands from the user are waiting
+void screen_thread::run()
+{
+  int i;
+
+  while(1)
+  {
+    req_mutex.lock();
+
+    while((!frame_req) && (!quit_req))
+    {
+      req_cond.wait(&req_mutex);
+    }
+
+    if(quit_req)
+    {
+      busy = 0;
+
+      idle_cond.wakeAll();
+
+      req_mutex.unlock();
+
+      break;
+    }
+
+    frame_req = 0;
+
+    busy = 1;
+
+    load_params();
+
+    if(pending_changed)
+    {
+      pending_changed = 0;
+
+      reset_idle();
+    }
+
+    req_mutex.unlock();
+
+    for(i=0; i<MAX_CHNS; i++)
+    {
+      params.wavebuf[i] = frames[frm_back].wavebuf[i];
+    }
+
+    params.fftbuf_out = frames[frm_back].fftbuf_out;
+
+    frame_aborted = 0;
 
-    printf("params.debug_str: ->%s<-\n", params.debug_str);
+    frame_idle = 0;
+
+    acquire_frame();
+
+    // every way out of acquire_frame() passes here, also an aborted frame or an error
+    if(wav_raw_set)
+    {
+      if(restore_wave_mode() && (!params.error_stat))
+      {
+        frame_aborted = 0;  // the GUI must see the error
+
+        params.result = TMC_THRD_RESULT_NONE;
+
+        params.error_line = __LINE__;
+
+        params.error_stat = -1;
+      }
+    }
+
+    if(frame_aborted)
+    {
+      abort_cnt++;
+    }
+    else if(params.result == TMC_THRD_RESULT_SCRN)
+      {
+        abort_cnt = 0;
+      }
+
+    if((!frame_aborted) && (!frame_idle))  // a status-only frame leaves the last one on screen
+    {
+      publish_frame();
+    }
+
+    req_mutex.lock();
+
+    if(frame_aborted)  // start over with the queued commands, no need to wait for the next tick
+    {
+      frame_req = 1;
+    }
+
+    busy = 0;
+
+    idle_cond.wakeAll();
+
+    req_mutex.unlock();
+
+    if(params.error_stat)  // the GUI closes the connection
+    {
+      break;
+    }
   }
 }
 
 
+// a RAW frame changes the waveform mode and the STAR/STOP window, this puts back
+// the state save_data.cpp and the next NORM frame expect, returns 0 on success
+int screen_thread::restore_wave_mode()
+{
+  int n_batch;
+
+  const char *batch[4];
+
+  batch[0] = ":WAV:MODE NORM";
+  batch[1] = ":WAV:STAR 1";
+
+  if(params.modelserie == 1)
+  {
+    batch[2] = ":WAV:STOP 1200";
+
+    n_batch = 3;
+  }
+  else
+  {
+    batch[2] = ":WAV:STOP 1400";
+    batch[3] = ":WAV:POIN 1400";
+
+    n_batch = 4;
+  }
+
+  if(tmc_write_batch(device, batch, n_batch, TMC_OPC_WAIT) != n_batch)
+  {
+    printf("Can not write to device.\n");
+
+    // nothing is known about the mode and the window anymore
+    tmc_shadow_clear(device);
+
+    return -1;
+  }
+
+  wav_raw_set = 0;
+
+  return 0;
+}
+
+
+// called between the transfers of a frame, if interactive commands are
+// waiting the frame is dropped so that they are sent without delay,
+// after SCRN_MAX_ABORTS dropped frames in a row one frame is finished
+// so that the screen keeps following a continuous drag
+int screen_thread::abort_frame()
+{
+  if(cmd_cue.peek(0) == NULL)
+  {
+    return 0;
+  }
+
+  if(abort_cnt >= SCRN_MAX_ABORTS)
+  {
+    return 0;
+  }
+
+  frame_aborted = 1;
+
+  params.result = TMC_THRD_RESULT_NONE;
+
+  params.wavebufsz = 0;
+
+  h_busy = 0;
+
+  return 1;
+}
+
+
+// splits a response to a compound query into its fields,
+// returns the number of fields
+static int split_compound_resp(char *resp, char **fields, int max_fields)
+{
+  int n=0;
+
+  char *ptr;
+
+  for(ptr=resp; (ptr != NULL) && (n < max_fields); n++)
+  {
+    fields[n] = ptr;
+
+    ptr = strchr(ptr, ';');
+    if(ptr != NULL)
+    {
+      *ptr++ = 0;
+    }
+  }
+
+  return n;
+}
+
+
+// all status queries are sent as one compound query, this saves
+// a round trip per query
 int screen_thread::get_devicestatus()
 {
-  int line;
+  int line, n, qry_cnt=4;
+
+  char qry[512],
+       *fld[STAT_QRY_MAX_FIELDS];
 
-  usleep(TMC_GDS_DELAY);
+  strlcpy(qry, ":TRIG:STAT?;:TRIG:SWE?;:ACQ:SRAT?;:ACQ:MDEP?", 512);
 
-  if(tmc_write(":TRIG:STAT?") != 11)
+  if(params.countersrc)
+  {
+    strlcat(qry, ";:MEAS:COUN:VAL?", 512);
+
+    qry_cnt++;
+  }
+
+  if(params.func_wrec_enable)
+  {
+    strlcat(qry, ";:FUNC:WREC:OPER?;:FUNC:WREP:OPER?;:FUNC:WREP:FCUR?;:FUNC:WREC:FMAX?;:FUNC:WREP:FMAX?", 512);
+
+    qry_cnt += 5;
+  }
+
+  if(tmc_write(device, qry) != (int)strlen(qry))
   {
     line = __LINE__;
     goto OUT_ERROR;
   }
 
-  if(tmc_read() < 1)
+  if(tmc_read(device) < 1)
   {
     line = __LINE__;
     goto OUT_ERROR;
   }
 
-  if(!strcmp(device->buf, "TD"))
+  n = split_compound_resp(device->buf, fld, STAT_QRY_MAX_FIELDS);
+  if(n != qry_cnt)
+  {
+    line = __LINE__;
+    goto OUT_ERROR;
+  }
+
+  if(!strcmp(fld[0], "TD"))
   {
     params.triggerstatus = 0;
   }
-  else if(!strcmp(device->buf, "WAIT"))
+  else if(!strcmp(fld[0], "WAIT"))
     {
       params.triggerstatus = 1;
     }
-    else if(!strcmp(device->buf, "RUN"))
+    else if(!strcmp(fld[0], "RUN"))
       {
         params.triggerstatus = 2;
       }
-      else if(!strcmp(device->buf, "AUTO"))
+      else if(!strcmp(fld[0], "AUTO"))
         {
           params.triggerstatus = 3;
         }
-        else if(!strcmp(device->buf, "FIN"))
+        else if(!strcmp(fld[0], "FIN"))
           {
             params.triggerstatus = 4;
           }
-          else if(!strcmp(device->buf, "STOP"))
+          else if(!strcmp(fld[0], "STOP"))
             {
               params.triggerstatus = 5;
             }
@@ -210,29 +753,15 @@ int screen_thread::get_devicestatus()
               goto OUT_ERROR;
             }
 
-  usleep(TMC_GDS_DELAY);
-
-  if(tmc_write(":TRIG:SWE?") != 10)
-  {
-    line = __LINE__;
-    goto OUT_ERROR;
-  }
-
-  if(tmc_read() < 1)
-  {
-    line = __LINE__;
-    goto OUT_ERROR;
-  }
-
-  if(!strcmp(device->buf, "AUTO"))
+  if(!strcmp(fld[1], "AUTO"))
   {
     params.triggersweep = 0;
   }
-  else if(!strcmp(device->buf, "NORM"))
+  else if(!strcmp(fld[1], "NORM"))
     {
       params.triggersweep = 1;
     }
-    else if(!strcmp(device->buf, "SING"))
+    else if(!strcmp(fld[1], "SING"))
       {
         params.triggersweep = 2;
       }
@@ -242,80 +771,26 @@ int screen_thread::get_devicestatus()
         goto OUT_ERROR;
       }
 
-  usleep(TMC_GDS_DELAY);
-
-  if(tmc_write(":ACQ:SRAT?") != 10)
-  {
-    line = __LINE__;
-    goto OUT_ERROR;
-  }
-
-  if(tmc_read() < 1)
-  {
-    line = __LINE__;
-    goto OUT_ERROR;
-  }
-
-  params.samplerate = atof(device->buf);
-
-  usleep(TMC_GDS_DELAY);
-
-  if(tmc_write(":ACQ:MDEP?") != 10)
-  {
-    line = __LINE__;
-    goto OUT_ERROR;
-  }
+  params.samplerate = atof(fld[2]);
 
-  if(tmc_read() < 1)
-  {
-    line = __LINE__;
-    goto OUT_ERROR;
-  }
+  params.memdepth = atoi(fld[3]);
 
-  params.memdepth = atoi(device->buf);
+  n = 4;
 
   if(params.countersrc)
   {
-    usleep(TMC_GDS_DELAY);
-
-    if(tmc_write(":MEAS:COUN:VAL?") != 15)
-    {
-      line = __LINE__;
-      goto OUT_ERROR;
-    }
-
-    if(tmc_read() < 1)
-    {
-      line = __LINE__;
-      goto OUT_ERROR;
-    }
-
-    params.counterfreq = atof(device->buf);
+    params.counterfreq = atof(fld[n++]);
   }
 
   if(params.func_wrec_enable)
   {
-    usleep(TMC_GDS_DELAY);
-
-    if(tmc_write(":FUNC:WREC:OPER?") != 16)
-    {
-      line = __LINE__;
-      goto OUT_ERROR;
-    }
-
-    if(tmc_read() < 1)
-    {
-      line = __LINE__;
-      goto OUT_ERROR;
-    }
-
     if(params.modelserie == 6)
     {
-      if(!strcmp(device->buf, "REC"))
+      if(!strcmp(fld[n], "REC"))
       {
         params.func_wrec_operate = 1;
       }
-      else if(!strcmp(device->buf, "STOP"))
+      else if(!strcmp(fld[n], "STOP"))
         {
           params.func_wrec_operate = 0;
         }
@@ -327,11 +802,11 @@ int screen_thread::get_devicestatus()
     }
     else
     {
-      if(!strcmp(device->buf, "RUN"))
+      if(!strcmp(fld[n], "RUN"))
       {
         params.func_wrec_operate = 1;
       }
-      else if(!strcmp(device->buf, "STOP"))
+      else if(!strcmp(fld[n], "STOP"))
         {
           params.func_wrec_operate = 0;
         }
@@ -342,29 +817,17 @@ int screen_thread::get_devicestatus()
         }
     }
 
-    usleep(TMC_GDS_DELAY);
-
-    if(tmc_write(":FUNC:WREP:OPER?") != 16)
-    {
-      line = __LINE__;
-      goto OUT_ERROR;
-    }
-
-    if(tmc_read() < 1)
-    {
-      line = __LINE__;
-      goto OUT_ERROR;
-    }
+    n++;
 
-    if(!strcmp(device->buf, "PLAY"))
+    if(!strcmp(fld[n], "PLAY"))
     {
       params.func_wplay_operate = 1;
     }
-    else if(!strcmp(device->buf, "STOP"))
+    else if(!strcmp(fld[n], "STOP"))
       {
         params.func_wplay_operate = 0;
       }
-      else if(!strcmp(device->buf, "PAUS"))
+      else if(!strcmp(fld[n], "PAUS"))
         {
           params.func_wplay_operate = 2;
         }
@@ -374,76 +837,170 @@ int screen_thread::get_devicestatus()
           goto OUT_ERROR;
         }
 
-    usleep(TMC_GDS_DELAY);
+    n++;
 
-    if(tmc_write(":FUNC:WREP:FCUR?") != 16)
-    {
-      line = __LINE__;
-      goto OUT_ERROR;
-    }
+    params.func_wplay_fcur = atoi(fld[n++]);
 
-    if(tmc_read() < 1)
-    {
-      line = __LINE__;
-      goto OUT_ERROR;
-    }
+    params.func_wrec_fmax = atoi(fld[n++]);
 
-    params.func_wplay_fcur = atoi(device->buf);
+    params.func_wrep_fmax = atoi(fld[n++]);
+  }
 
-    usleep(TMC_GDS_DELAY);
+  params.debug_str[0] = 0;
 
-    if(tmc_write(":FUNC:WREC:FMAX?") != 16)
-    {
-      line = __LINE__;
-      goto OUT_ERROR;
-    }
+  return 0;
 
-    if(tmc_read() < 1)
-    {
-      line = __LINE__;
-      goto OUT_ERROR;
-    }
+OUT_ERROR:
 
-    params.func_wrec_fmax = atoi(device->buf);
+  strlcpy(params.debug_str, device->hdrbuf, 1024);
 
-    usleep(TMC_GDS_DELAY);
+  params.error_line = line;
 
-    if(tmc_write(":FUNC:WREP:FMAX?") != 16)
+  return -1;
+}
+
+
+// everything that decides what the next frame would show, apart from
+// the samples, a change means the scope is no longer idle
+unsigned long long screen_thread::get_idle_key()
+{
+  int i;
+
+  struct
+  {
+    int chandisplay[MAX_CHNS];
+    double chanscale[MAX_CHNS];
+    int triggerstatus;
+    int triggersweep;
+    double samplerate;
+    int memdepth;
+    int math_fft;
+    int math_fft_src;
+    int math_fft_unit;
+    int math_fft_window;
+    int math_fft_avg;
+    int math_fft_avg_cnt;
+    int fftbufsz;
+    int current_screen_sf;
+    int hordivisions;
+    double timebasescale;
+    int timebasedelayenable;
+    int math_decode_display;
+    int screen_res_adaptive;
+  } key;
+
+  memset(&key, 0, sizeof(key));
+
+  for(i=0; i<MAX_CHNS; i++)
+  {
+    key.chandisplay[i] = params.chandisplay[i];
+    key.chanscale[i] = params.chanscale[i];
+  }
+
+  key.triggerstatus = params.triggerstatus;
+  key.triggersweep = params.triggersweep;
+  key.samplerate = params.samplerate;
+  key.memdepth = params.memdepth;
+  key.math_fft = params.math_fft;
+  key.math_fft_src = params.math_fft_src;
+  key.math_fft_unit = params.math_fft_unit;
+  key.math_fft_window = params.math_fft_window;
+  key.math_fft_avg = params.math_fft_avg;
+  key.math_fft_avg_cnt = params.math_fft_avg_cnt;
+  key.fftbufsz = params.fftbufsz;
+  key.current_screen_sf = params.current_screen_sf;
+  key.hordivisions = params.hordivisions;
+  key.timebasescale = params.timebasescale;
+  key.timebasedelayenable = params.timebasedelayenable;
+  key.math_decode_display = params.math_decode_display;
+  key.screen_res_adaptive = params.screen_res_adaptive;
+
+  return sconv_hash64(&key, sizeof(key), 0);
+}
+
+
+// back to full rate acquisition
+void screen_thread::reset_idle()
+{
+  idle_cnt = 0;
+
+  idle_ival = 0;
+
+  idle_t_poll = 0;
+
+  idle_key = 0;
+
+  idle_frame_hash = 0;
+}
+
+
+// returns 1 if the queued command is a plain setter that needs no response
+// and no follow-up query, so it can be sent in a batch with other setters
+int screen_thread::cue_cmd_batchable(const struct tmc_cmd *cmd)
+{
+  int len;
+
+  const struct tmc_cmd_op *op;
+
+  if(cmd->resp != NULL)
+  {
+    return 0;
+  }
+
+  op = &tmc_cmd_ops[cmd->op];
+
+  if(op->flags & TMC_OPF_SYNC)
+  {
+    return 0;
+  }
+
+  if(op->follow_up == TMC_THRD_JOB_FFTHZDIV)
+  {
+    if(params.math_fft)
     {
-      line = __LINE__;
-      goto OUT_ERROR;
+      return 0;
     }
-
-    if(tmc_read() < 1)
+  }
+  else if(op->follow_up != TMC_THRD_JOB_NONE)
     {
-      line = __LINE__;
-      goto OUT_ERROR;
+      return 0;
     }
 
-    params.func_wrep_fmax = atoi(device->buf);
+  if(op->fmt == NULL)
+  {
+    len = strlen(cmd->str);
+
+    if((len < 2) || (cmd->str[len - 1] == '?'))
+    {
+      return 0;
+    }
   }
 
-  params.debug_str[0] = 0;
+  return 1;
+}
 
-  return 0;
 
-OUT_ERROR:
+void screen_thread::acquire_frame()
+{
+  int i, j, k, n=0, chns=0, line, cmd_sent=0, follow_up, n_batch;
 
-  strlcpy(params.debug_str, device->hdrbuf, 1024);
+  long long t_frame, t_xfer, xfer_usec=0;
 
-  params.error_line = line;
+  unsigned long long key;
 
-  return -1;
-}
+  double screen_smpls;
 
+  char str[512],
+       batch_str[TMC_CMD_BATCH_SZ][TMC_CMD_STR_LEN];
 
-void screen_thread::run()
-{
-  int i, j, k, n=0, chns=0, line, cmd_sent=0;
+  const char *batch[TMC_CMD_BATCH_SZ];
+
+  struct tmc_cmd *cmd,
+                 *next_cmd;
 
-  char str[512];
+  struct fft_stage_params fft_p;
 
-  double y_incr, binsz;
+  struct frame_policy_req fpol_req;
 
   params.error_stat = 0;
 
@@ -472,40 +1029,80 @@ void screen_thread::run()
 
   h_busy = 1;
 
-  while(params.cmd_cue_idx_out != params.cmd_cue_idx_in)
+  while((cmd = cmd_cue.peek(0)) != NULL)
   {
-    usleep(TMC_GDS_DELAY);
+    // a dial burst leaves many values for the same setting, only the last one is sent
+    if(cmd_cue.superseded(0))
+    {
+      cmd_cue.pop();
 
-    tmc_write(deviceparms->cmd_cue[params.cmd_cue_idx_out]);
+      continue;
+    }
 
-    if(deviceparms->cmd_cue_resp[params.cmd_cue_idx_out] != NULL)
+    // send a run of plain setters back-to-back, confirmed with a single *OPC?
+    for(k=0, n_batch=0; (k<TMC_CMD_CUE_SZ) && (n_batch<TMC_CMD_BATCH_SZ); k++)
     {
-      usleep(TMC_GDS_DELAY);
+      next_cmd = cmd_cue.peek(k);
+
+      if((next_cmd == NULL) || (!cue_cmd_batchable(next_cmd)))
+      {
+        break;
+      }
 
-      if(tmc_read() < 1)
+      if(cmd_cue.superseded(k))
+      {
+        continue;
+      }
+
+      tmc_cmd_format(next_cmd, batch_str[n_batch], TMC_CMD_STR_LEN);
+
+      batch[n_batch] = batch_str[n_batch];
+
+      n_batch++;
+    }
+
+    if(n_batch > 1)
+    {
+      tmc_write_batch(device, batch, n_batch, TMC_OPC_WAIT);
+
+      for(j=0; j<k; j++)
+      {
+        cmd_cue.pop();
+      }
+
+      cmd_sent = 1;
+
+      continue;
+    }
+
+    tmc_cmd_format(cmd, str, 512);
+
+    tmc_write(device, str);
+
+    follow_up = tmc_cmd_ops[cmd->op].follow_up;
+
+    if(cmd->resp != NULL)
+    {
+      if(tmc_read(device) < 1)
       {
         printf("Can not read from device.\n");
         line = __LINE__;
         goto OUT_ERROR;
       }
 
-      strlcpy(deviceparms->cmd_cue_resp[params.cmd_cue_idx_out], device->buf, 128);
+      strlcpy(cmd->resp, device->buf, 128);
     }
 
-    if((!strncmp(deviceparms->cmd_cue[params.cmd_cue_idx_out], ":TLHA", 5)) ||
-       ((!strncmp(deviceparms->cmd_cue[params.cmd_cue_idx_out], ":CHAN", 5)) &&
-       (!strncmp(deviceparms->cmd_cue[params.cmd_cue_idx_out] + 6, ":SCAL ", 6))))
+    if(follow_up == TMC_THRD_JOB_TRIGEDGELEV)
     {
-      usleep(TMC_GDS_DELAY);
-
-      if(tmc_write(":TRIGger:EDGE:LEVel?") != 20)
+      if(tmc_write(device, ":TRIGger:EDGE:LEVel?") != 20)
       {
         printf("Can not write to device.\n");
         line = __LINE__;
         goto OUT_ERROR;
       }
 
-      if(tmc_read() < 1)
+      if(tmc_read(device) < 1)
       {
         printf("Can not read from device.\n");
         line = __LINE__;
@@ -514,20 +1111,20 @@ void screen_thread::run()
 
       params.triggeredgelevel = atof(device->buf);
 
+      params.trigedgelev_cnt++;
+
       params.job = TMC_THRD_JOB_TRIGEDGELEV;
     }
-    else if(!strncmp(deviceparms->cmd_cue[params.cmd_cue_idx_out], ":TIM:DEL:ENAB 1", 15))
+    else if(follow_up == TMC_THRD_JOB_TIMDELAY)
       {
-        usleep(TMC_GDS_DELAY);
-
-        if(tmc_write(":TIM:DEL:OFFS?") != 14)
+        if(tmc_write(device, ":TIM:DEL:OFFS?") != 14)
         {
           printf("Can not write to device.\n");
           line = __LINE__;
           goto OUT_ERROR;
         }
 
-        if(tmc_read() < 1)
+        if(tmc_read(device) < 1)
         {
           printf("Can not read from device.\n");
           line = __LINE__;
@@ -536,16 +1133,14 @@ void screen_thread::run()
 
         params.timebasedelayoffset = atof(device->buf);
 
-        usleep(TMC_GDS_DELAY);
-
-        if(tmc_write(":TIM:DEL:SCAL?") != 14)
+        if(tmc_write(device, ":TIM:DEL:SCAL?") != 14)
         {
           printf("Can not write to device.\n");
           line = __LINE__;
           goto OUT_ERROR;
         }
 
-        if(tmc_read() < 1)
+        if(tmc_read(device) < 1)
         {
           printf("Can not read from device.\n");
           line = __LINE__;
@@ -554,21 +1149,20 @@ void screen_thread::run()
 
         params.timebasedelayscale = atof(device->buf);
 
+        params.timdelay_cnt++;
+
         params.job = TMC_THRD_JOB_TIMDELAY;
       }
 
     if(params.math_fft)
     {
-      if((!strncmp(deviceparms->cmd_cue[params.cmd_cue_idx_out], ":TIM:SCAL ", 10)) ||
-         (!strncmp(deviceparms->cmd_cue[params.cmd_cue_idx_out], ":MATH:OPER FFT", 14)) ||
-         (!strncmp(deviceparms->cmd_cue[params.cmd_cue_idx_out], ":MATH1:OPER FFT", 15)) ||
-         (!strncmp(deviceparms->cmd_cue[params.cmd_cue_idx_out], ":CALC:MODE FFT", 14)))
+      if(follow_up == TMC_THRD_JOB_FFTHZDIV)
       {
         usleep(TMC_GDS_DELAY * 10);
 
         if(params.modelserie == 7)
         {
-          if(tmc_write(":MATH1:FFT:HSC?") != 15)
+          if(tmc_write(device, ":MATH1:FFT:HSC?") != 15)
           {
             printf("Can not write to device.\n");
             line = __LINE__;
@@ -577,7 +1171,7 @@ void screen_thread::run()
         }
         else if(params.modelserie != 1)
         {
-          if(tmc_write(":CALC:FFT:HSP?") != 14)
+          if(tmc_write(device, ":CALC:FFT:HSP?") != 14)
           {
             line = __LINE__;
             goto OUT_ERROR;
@@ -585,7 +1179,7 @@ void screen_thread::run()
         }
         else
         {
-          if(tmc_write(":MATH:FFT:HSC?") != 14)
+          if(tmc_write(device, ":MATH:FFT:HSC?") != 14)
           {
             printf("Can not write to device.\n");
             line = __LINE__;
@@ -593,7 +1187,7 @@ void screen_thread::run()
           }
         }
 
-        if(tmc_read() < 1)
+        if(tmc_read(device) < 1)
         {
           printf("Can not read from device.\n");
           line = __LINE__;
@@ -602,11 +1196,9 @@ void screen_thread::run()
 
         params.math_fft_hscale = atof(device->buf);
 
-        usleep(TMC_GDS_DELAY);
-
         if(params.modelserie == 7)
         {
-          if(tmc_write(":MATH1:FFT:HCEN?") != 16)
+          if(tmc_write(device, ":MATH1:FFT:HCEN?") != 16)
           {
             printf("Can not write to device.\n");
             line = __LINE__;
@@ -615,7 +1207,7 @@ void screen_thread::run()
         }
         else if(params.modelserie != 1)
         {
-          if(tmc_write(":CALC:FFT:HCEN?") != 15)
+          if(tmc_write(device, ":CALC:FFT:HCEN?") != 15)
           {
             line = __LINE__;
             goto OUT_ERROR;
@@ -623,7 +1215,7 @@ void screen_thread::run()
         }
         else
         {
-          if(tmc_write(":MATH:FFT:HCEN?") != 15)
+          if(tmc_write(device, ":MATH:FFT:HCEN?") != 15)
           {
             printf("Can not write to device.\n");
             line = __LINE__;
@@ -631,7 +1223,7 @@ void screen_thread::run()
           }
         }
 
-        if(tmc_read() < 1)
+        if(tmc_read(device) < 1)
         {
           printf("Can not read from device.\n");
           line = __LINE__;
@@ -640,19 +1232,21 @@ void screen_thread::run()
 
         params.math_fft_hcenter = atof(device->buf);
 
+        params.ffthzdiv_cnt++;
+
         params.job = TMC_THRD_JOB_FFTHZDIV;
       }
     }
 
-    params.cmd_cue_idx_out++;
-
-    params.cmd_cue_idx_out %= TMC_CMD_CUE_SZ;
+    cmd_cue.pop();
 
     cmd_sent = 1;
   }
 
   if(cmd_sent)
   {
+    reset_idle();
+
     h_busy = 0;
 
     params.result = TMC_THRD_RESULT_CMD;
@@ -660,6 +1254,21 @@ void screen_thread::run()
     return;
   }
 
+  t_frame = scrn_get_usec();
+
+  // the scope is idle, not even the status is queried before the interval has passed
+  if(idle_cnt >= SCRN_IDLE_FRAMES)
+  {
+    if((t_frame - idle_t_poll) < idle_ival)
+    {
+      frame_idle = 1;
+
+      h_busy = 0;
+
+      return;
+    }
+  }
+
   params.error_stat = get_devicestatus();
 
   if(params.error_stat)
@@ -669,6 +1278,26 @@ void screen_thread::run()
     return;
   }
 
+  key = get_idle_key();
+
+  // the status didn't change, the screen of the scope is still the same
+  if((idle_cnt >= SCRN_IDLE_FRAMES) && (key == idle_key))
+  {
+    idle_t_poll = t_frame;
+
+    idle_ival *= 2;
+    if(idle_ival > SCRN_IDLE_MAX_USEC)
+    {
+      idle_ival = SCRN_IDLE_MAX_USEC;
+    }
+
+    frame_idle = 1;
+
+    h_busy = 0;
+
+    return;
+  }
+
   if(!params.connected)
   {
     h_busy = 0;
@@ -695,6 +1324,42 @@ void screen_thread::run()
 
   params.result = TMC_THRD_RESULT_SCRN;
 
+  if(params.math_fft && (!last_math_fft))  // don't average with the spectra from before the FFT was switched off
+  {
+    fft.reset();
+
+    fft_last_valid = 0;
+  }
+
+  last_math_fft = params.math_fft;
+
+  // the raw samples that span the screen are used instead of the screen points when the
+  // acquisition is stopped and the link can transfer them within the frame time,
+  // the budget per channel drops when more channels are switched on
+  screen_smpls = params.samplerate * params.timebasescale * params.hordivisions;
+
+  fpol_req.chns = chns;
+  fpol_req.norm_pnts = params.hordivisions * 100;
+  fpol_req.screen_smpls = (screen_smpls > FPOL_RAW_MAX_PNTS) ? (FPOL_RAW_MAX_PNTS + 1) : screen_smpls;
+  fpol_req.raw_allowed = params.screen_res_adaptive && (params.triggerstatus == 5) &&
+                         (!params.timebasedelayenable) && (!params.math_decode_display) &&
+                         (screen_smpls <= params.memdepth) && (screen_smpls <= WAVFRM_MAX_BUFSZ);
+  fpol_req.frame_usec = params.screentimerival * 1000;
+
+  params.wave_mode = fpol_choose(&fpol, &fpol_req);
+
+  params.screen_pnts = fpol.pnts;
+
+  // the memory of a stopped scope holds the record that was centered on the
+  // timebase offset at the moment it stopped, a pan after that moves the screen
+  // over the record
+  if((params.triggerstatus != 5) || (!raw_tb_offset_valid))
+  {
+    raw_tb_offset = params.timebaseoffset;
+
+    raw_tb_offset_valid = 1;
+  }
+
 //struct waveform_preamble wfp;
 
 //  if(params.triggerstatus != 1)  // Don't download waveform data when triggerstatus is "wait"
@@ -707,11 +1372,18 @@ void screen_thread::run()
         continue;
       }
 
+      // user commands have priority over the screen refresh, the data of the
+      // channels downloaded so far is stale once the command is executed
+      if(abort_frame())
+      {
+        return;
+      }
+
 ///////////////////////////////////////////////////////////
 
-//     tmc_write(":WAV:PRE?");
+//     tmc_write(device, ":WAV:PRE?");
 //
-//     n = tmc_read();
+//     n = tmc_read(device);
 //
 //     if(n < 0)
 //     {
@@ -750,35 +1422,57 @@ void screen_thread::run()
 
       snprintf(str, 512, ":WAV:SOUR CHAN%i", i + 1);
 
-      if(tmc_write(str) != 15)
+      batch[0] = str;
+      batch[1] = ":WAV:FORM BYTE";
+
+      if(params.wave_mode == FPOL_MODE_RAW)
       {
-        printf("Can not write to device.\n");
-        line = __LINE__;
-        goto OUT_ERROR;
-      }
+        j = (params.memdepth / 2) + lround((params.timebaseoffset - raw_tb_offset) * params.samplerate) -
+            (params.screen_pnts / 2) + 1;
+
+        if(j > (params.memdepth - params.screen_pnts + 1))
+        {
+          j = params.memdepth - params.screen_pnts + 1;
+        }
 
-      if(tmc_write(":WAV:FORM BYTE") != 14)
+        if(j < 1)
+        {
+          j = 1;
+        }
+
+        snprintf(batch_str[0], TMC_CMD_STR_LEN, ":WAV:STAR %i", j);
+        snprintf(batch_str[1], TMC_CMD_STR_LEN, ":WAV:STOP %i", j + params.screen_pnts - 1);
+
+        batch[2] = ":WAV:MODE RAW";
+        batch[3] = batch_str[0];
+        batch[4] = batch_str[1];
+
+        n_batch = 5;
+
+        wav_raw_set = 1;
+      }
+      else
       {
-        printf("Can not write to device.\n");
-        line = __LINE__;
-        goto OUT_ERROR;
+        batch[2] = ":WAV:MODE NORM";
+
+        n_batch = 3;
       }
 
-      if(tmc_write(":WAV:MODE NORM") != 14)
+      if(tmc_write_batch(device, batch, n_batch, TMC_OPC_WAIT) != n_batch)
       {
         printf("Can not write to device.\n");
         line = __LINE__;
         goto OUT_ERROR;
       }
 
-      if(tmc_write(":WAV:XOR?") != 9)
+      if(tmc_write(device, ":WAV:XOR?") != 9)
       {
         printf("Can not write to device.\n");
         line = __LINE__;
         goto OUT_ERROR;
       }
 
-      if(tmc_read() < 1)
+      if(tmc_read(device) < 1)
       {
         printf("Can not read from device.\n");
         line = __LINE__;
@@ -787,14 +1481,17 @@ void screen_thread::run()
 
       params.xorigin[i] = atof(device->buf);
 
-      if(tmc_write(":WAV:DATA?") != 10)
+      t_xfer = scrn_get_usec();
+
+      if(tmc_write(device, ":WAV:DATA?") != 10)
       {
         printf("Can not write to device.\n");
         line = __LINE__;
         goto OUT_ERROR;
       }
 
-      n = tmc_read();
+      // the block is received straight into wav_rd_buf, its length is taken from the blockheader
+      n = tmc_read_block(device, (char *)wav_rd_buf, WAVFRM_MAX_BUFSZ, NULL, NULL);
 
       if(n < 0)
       {
@@ -803,6 +1500,12 @@ void screen_thread::run()
         goto OUT_ERROR;
       }
 
+      t_xfer = scrn_get_usec() - t_xfer;
+
+      xfer_usec += t_xfer;
+
+      fpol_add_transfer(&fpol, n, t_xfer, device->pace_lat_usec);
+
       if(n > WAVFRM_MAX_BUFSZ)
       {
         printf("Datablock too big for buffer.\n");
@@ -810,79 +1513,98 @@ void screen_thread::run()
         goto OUT_ERROR;
       }
 
-      if(n < 32)
+      // a plain response instead of a blockheader is left in the device buffer
+      if((n < 32) || (device->buf != (char *)wav_rd_buf))
       {
         n = 0;
       }
 
-      for(j=0; j<n; j++)
-      {
-        params.wavebuf[i][j] = (int)(((unsigned char *)device->buf)[j]) - 127;
-      }
+      sconv_u8_to_s16(params.wavebuf[i], wav_rd_buf, n, 127, 0);
 
-      if((n == (params.fftbufsz * 2)) && (params.math_fft == 1) && (i == params.math_fft_src))
+      params.wave_hash[i] = sconv_hash64(wav_rd_buf, n, 0);
+
+      if((n >= 32) && (params.math_fft == 1) && (i == params.math_fft_src))
       {
+        memset(&fft_p, 0, sizeof(fft_p));
+
         if(params.modelserie == 6)
         {
-          y_incr = params.chanscale[i] / 32.0;
+          fft_p.y_incr = params.chanscale[i] / 32.0;
         }
         else
         {
-          y_incr = params.chanscale[i] / 25.0;
+          fft_p.y_incr = params.chanscale[i] / 25.0;
         }
 
-        binsz = (double)params.current_screen_sf / (params.fftbufsz * 2.0);
-
-        for(j=0; j<n; j++)
+        fft_p.src = i;
+        fft_p.bins = params.fftbufsz;
+        fft_p.unit = params.math_fft_unit;
+        fft_p.window = params.math_fft_window;
+        fft_p.avg_mode = params.math_fft_avg;
+        fft_p.avg_cnt = params.math_fft_avg_cnt;
+        fft_p.sf = (params.wave_mode == FPOL_MODE_RAW) ? params.samplerate : params.current_screen_sf;
+        fft_p.f_span = params.current_screen_sf / 2.0;
+
+        // the transform runs in the fft stage while the next channel is downloaded,
+        // the same record with the same settings would give the same spectrum
+        if((!fft_last_valid) || (params.wave_hash[i] != fft_last_hash) ||
+           memcmp(&fft_p, &fft_last_p, sizeof(fft_p)))
         {
-          params.fftbuf_in[j] = params.wavebuf[i][j] * y_incr;
-        }
+          fft.submit(wav_rd_buf, n, &fft_p);
 
-        kiss_fftr(params.k_cfg, params.fftbuf_in, params.kiss_fftbuf);
-
-        for(k=0; k<params.fftbufsz; k++)
-        {
-          params.fftbuf_out[k] = (((params.kiss_fftbuf[k].r * params.kiss_fftbuf[k].r) +
-                     (params.kiss_fftbuf[k].i * params.kiss_fftbuf[k].i)) / params.fftbufsz);
+          fft_last_hash = params.wave_hash[i];
 
-          params.fftbuf_out[k] /= params.current_screen_sf;
+          fft_last_p = fft_p;
 
-          if(k==0)  // DC!
-          {
-            params.fftbuf_out[k] /= 2.0;
-          }
-
-          params.fftbuf_out[k] *= binsz;
-
-          if(params.math_fft_unit)  // dBm
-          {
-            if(params.fftbuf_out[k] < SPECT_LOG_MINIMUM)
-            {
-              params.fftbuf_out[k] = SPECT_LOG_MINIMUM;
-            }
-            // convert to deciBel's, not to Bel's!
-            params.fftbuf_out[k] = log10(params.fftbuf_out[k]) * 10.0;
-
-            if(params.fftbuf_out[k] < SPECT_LOG_MINIMUM_LOG)
-            {
-              params.fftbuf_out[k] = SPECT_LOG_MINIMUM_LOG;
-            }
-          }
-          else  // Vrms
-          {
-            params.fftbuf_out[k] = sqrt(params.fftbuf_out[k]);
-          }
+          fft_last_valid = 1;
         }
       }
     }
 
     params.wavebufsz = n;
+
+    fpol_add_frame(&fpol, scrn_get_usec() - t_frame, xfer_usec);
   }
   else  // triggerstatus is "wait"
   {
     params.wavebufsz = 0;
   }
 
+  // the latest spectrum, this can be the one of the previous frame when
+  // the fft stage is still busy with the record of this frame
+  if(params.math_fft == 1)
+  {
+    fft.get_spectrum(params.fftbuf_out, params.fftbufsz, &params.fftbuf_seq);
+  }
+
+  set_frame_hash();
+
+  if(abort_frame())
+  {
+    return;
+  }
+
+  // STOP, FIN and WAIT don't change the screen, once the same frame came in
+  // a few times the downloads stop until the status or the settings change,
+  // a recording that is played back changes the screen while stopped
+  if(((params.triggerstatus == 1) || (params.triggerstatus == 4) || (params.triggerstatus == 5)) &&
+     (!params.func_wrec_enable) && (key == idle_key) && (params.frame_hash == idle_frame_hash))
+  {
+    idle_cnt++;
+  }
+  else
+  {
+    idle_cnt = 0;
+  }
+
+  idle_key = key;
+
+  idle_frame_hash = params.frame_hash;
+
+  idle_t_poll = t_frame;
+
+  idle_ival = params.screentimerival * 1000LL;
+
   h_busy = 0;
 
   return;
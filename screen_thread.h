@@ -38,16 +38,35 @@
 
 #include <QObject>
 #include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QAtomicInt>
 
 #include "global.h"
 #include "utils.h"
 #include "connection.h"
 #include "tmc_dev.h"
+#include "cmd_queue.h"
+#include "sample_conv.h"
+#include "fft_stage.h"
+#include "frame_policy.h"
 
 #include "third_party/kiss_fft/kiss_fftr.h"
 
 
 
+#define SCRN_THRD_FRAMES  (3)
+
+// a stopped, finished or waiting scope that gave this many identical frames
+// is only polled for its status, the interval doubles up to SCRN_IDLE_MAX_USEC
+#define SCRN_IDLE_FRAMES    (2)
+#define SCRN_IDLE_MAX_USEC  (1000000LL)
+
+// frames that are dropped in a row for queued commands before one is finished
+#define SCRN_MAX_ABORTS  (3)
+
+
+
 class screen_thread : public QThread
 {
   Q_OBJECT
@@ -62,11 +81,22 @@ public:
   void set_device(struct tmcdev *);
 
   void set_params(struct device_settings *);
-  void get_params(struct device_settings *);
+  int get_params(struct device_settings *);
+  void set_frame_bufs(struct device_settings *);
+
+  int queue_cmd(int, int, double);
+  int queue_cmd(const char *, char *);
+
+  void wait_idle();
+  void request_quit();
+
+signals:
+
+  void frame_ready();
 
 private:
 
-  struct {
+  struct scrn_thrd_params {
     int connected;
     int modelserie;
     int chandisplay[MAX_CHNS];
@@ -81,28 +111,42 @@ private:
     short *wavebuf[MAX_CHNS];
     int error_stat;
     int error_line;
-    int cmd_cue_idx_in;
-    int cmd_cue_idx_out;
     int result;
     int job;
 
     double triggeredgelevel;
     double timebasedelayoffset;
     double timebasedelayscale;
+    int trigedgelev_cnt;  // incremented every time a job completes, a frame
+    int timdelay_cnt;     // that is skipped by the GUI doesn't lose the result
+    int ffthzdiv_cnt;
 
     int math_fft_src;
     int math_fft;
     int math_fft_unit;
     double math_fft_hscale;
     double math_fft_hcenter;
-    double *fftbuf_in;
     double *fftbuf_out;
     int fftbufsz;
-    kiss_fftr_cfg k_cfg;
-    kiss_fft_cpx *kiss_fftbuf;
+    unsigned int fftbuf_seq;
+    int math_fft_window;
+    int math_fft_avg;
+    int math_fft_avg_cnt;
 
     int current_screen_sf;
 
+    int hordivisions;
+    double timebasescale;
+    double timebaseoffset;
+    int timebasedelayenable;
+    int math_decode_display;
+    int screentimerival;
+    int screen_res_adaptive;
+    int wave_mode;        // FPOL_MODE_xxx of this frame
+    unsigned long long wave_hash[MAX_CHNS];  // hash of the bytes of every channel
+    unsigned long long frame_hash;           // changes when the frame shows something new
+    int screen_pnts;      // points per channel that span the screen width
+
     int func_wrec_enable;
     int func_wrec_fmax;
     int func_wrec_operate;
@@ -113,16 +157,80 @@ private:
     double xorigin[MAX_CHNS];
 
     char debug_str[1024];
-  } params;
+  } params, pending;
+
+  // Triple buffer: the thread fills frames[frm_back] while the GUI reads
+  // frames[frm_front], the third one holds the latest completed frame.
+  // frm_state contains the index of that frame plus SCRN_THRD_FRESH when
+  // the GUI has not picked it up yet. Both sides only swap indexes.
+  struct scrn_thrd_params frames[SCRN_THRD_FRAMES];
+
+  QAtomicInt frm_state;
+  int frm_back;
+  int frm_front;
+
+  unsigned char *wav_rd_buf;  // payload of :WAV:DATA?, received without staging
+
+  int last_trigedgelev_cnt;
+  int last_timdelay_cnt;
+  int last_ffthzdiv_cnt;
+
+  QMutex req_mutex;
+  QWaitCondition req_cond;
+  QWaitCondition idle_cond;
+  int frame_req;
+  int quit_req;
+  int busy;
+  int frame_aborted;
+  int frame_idle;
+  int pending_changed;
+  int abort_cnt;
+  int wav_raw_set;          // the device is in RAW mode with a custom STAR/STOP window
+  int raw_tb_offset_valid;
+  double raw_tb_offset;     // timebase offset of the record in the memory of a stopped scope
+
+  int idle_cnt;
+  long long idle_ival,
+            idle_t_poll;
+  unsigned long long idle_key,
+                     idle_frame_hash;
 
   struct tmcdev *device;
 
   struct device_settings *deviceparms;
 
+  cmd_queue cmd_cue;
+
+  fft_stage fft;
+  int last_math_fft;
+  int fft_last_valid;
+  unsigned long long fft_last_hash;
+  struct fft_stage_params fft_last_p;
+
+  struct frame_policy fpol;
+
   void run();
 
+  void load_params();
+
+  void acquire_frame();
+
+  void set_frame_hash();
+
+  void publish_frame();
+
+  int abort_frame();
+
+  int restore_wave_mode();
+
   int get_devicestatus();
 
+  unsigned long long get_idle_key();
+
+  void reset_idle();
+
+  int cue_cmd_batchable(const struct tmc_cmd *);
+
 };
 
 
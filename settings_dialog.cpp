@@ -44,8 +44,8 @@ UI_settings_window::UI_settings_window(QWidget *parnt)
 
   mainwindow = (UI_Mainwindow *)parnt;
 
-  setMinimumSize(500, 500);
-  setMaximumSize(500, 500);
+  setMinimumSize(500, 550);
+  setMaximumSize(500, 550);
   setWindowTitle("Settings");
   setModal(true);
 
@@ -205,12 +205,66 @@ UI_settings_window::UI_settings_window(QWidget *parnt)
     extendvertdivCheckbox->setCheckState(Qt::Unchecked);
   }
 
+  adaptresLabel = new QLabel(this);
+  adaptresLabel->setGeometry(40, 370, 120, 35);
+  adaptresLabel->setText("Adaptive screen\n resolution");
+  adaptresLabel->setToolTip("When the acquisition is stopped, download the samples of the screen\n"
+                            "instead of the screen points if the connection is fast enough");
+
+  adaptresCheckbox = new QCheckBox(this);
+  adaptresCheckbox->setGeometry(180, 370, 120, 35);
+  adaptresCheckbox->setTristate(false);
+  if(mainwindow->devparms.screen_res_adaptive)
+  {
+    adaptresCheckbox->setCheckState(Qt::Checked);
+  }
+  else
+  {
+    adaptresCheckbox->setCheckState(Qt::Unchecked);
+  }
+
+  // a session that was recorded with connection/record_file is opened as a device again
+  replayRadioButton = new QRadioButton("Replay", this);
+  replayRadioButton->setAutoExclusive(true);
+  replayRadioButton->setGeometry(40, 420, 110, 25);
+  replayRadioButton->setToolTip("Replay a recorded session instead of connecting to an instrument");
+  if(mainwindow->devparms.connectiontype == 2)
+  {
+    replayRadioButton->setChecked(true);
+  }
+
+  replayLineEdit = new QLineEdit(this);
+  replayLineEdit->setGeometry(180, 420, 240, 25);
+  replayLineEdit->setText(settings.value("connection/replay_file", "").toString());
+  replayLineEdit->setToolTip("Trace file of the recorded session");
+
+  replayButton = new QPushButton(this);
+  replayButton->setGeometry(430, 420, 30, 25);
+  replayButton->setText("...");
+
+  replayRealtimeLabel = new QLabel(this);
+  replayRealtimeLabel->setGeometry(40, 450, 120, 35);
+  replayRealtimeLabel->setText("Replay in\n real time");
+  replayRealtimeLabel->setToolTip("Reproduce the timing of the recording instead of replaying at full speed");
+
+  replayRealtimeCheckbox = new QCheckBox(this);
+  replayRealtimeCheckbox->setGeometry(180, 450, 120, 35);
+  replayRealtimeCheckbox->setTristate(false);
+  if(settings.value("connection/replay_realtime", 0).toInt())
+  {
+    replayRealtimeCheckbox->setCheckState(Qt::Checked);
+  }
+  else
+  {
+    replayRealtimeCheckbox->setCheckState(Qt::Unchecked);
+  }
+
   applyButton = new QPushButton(this);
-  applyButton->setGeometry(40, 450, 100, 25);
+  applyButton->setGeometry(40, 500, 100, 25);
   applyButton->setText("Apply");
 
   cancelButton = new QPushButton(this);
-  cancelButton->setGeometry(250, 450, 100, 25);
+  cancelButton->setGeometry(250, 500, 100, 25);
   cancelButton->setText("Cancel");
 
   strlcpy(dev_str, settings.value("connection/device").toString().toLocal8Bit().data(), 256);
@@ -226,6 +280,10 @@ UI_settings_window::UI_settings_window(QWidget *parnt)
   {
     usbRadioButton->setEnabled(false);
     lanIPRadioButton->setEnabled(false);
+    replayRadioButton->setEnabled(false);
+    replayLineEdit->setEnabled(false);
+    replayButton->setEnabled(false);
+    replayRealtimeCheckbox->setEnabled(false);
     ipSpinbox1->setEnabled(false);
     ipSpinbox2->setEnabled(false);
     ipSpinbox3->setEnabled(false);
@@ -236,6 +294,7 @@ UI_settings_window::UI_settings_window(QWidget *parnt)
   else
   {
     QObject::connect(applyButton, SIGNAL(clicked()), this, SLOT(applyButtonClicked()));
+    QObject::connect(replayButton, SIGNAL(clicked()), this, SLOT(replayButtonClicked()));
   }
 
   QObject::connect(cancelButton,          SIGNAL(clicked()),           this, SLOT(close()));
@@ -243,6 +302,7 @@ UI_settings_window::UI_settings_window(QWidget *parnt)
   QObject::connect(invScrShtCheckbox,     SIGNAL(stateChanged(int)),   this, SLOT(invScrShtCheckboxChanged(int)));
   QObject::connect(showfpsCheckbox,       SIGNAL(stateChanged(int)),   this, SLOT(showfpsCheckboxChanged(int)));
   QObject::connect(extendvertdivCheckbox, SIGNAL(stateChanged(int)),   this, SLOT(extendvertdivCheckboxChanged(int)));
+  QObject::connect(adaptresCheckbox,      SIGNAL(stateChanged(int)),   this, SLOT(adaptresCheckboxChanged(int)));
   QObject::connect(HostLineEdit,          SIGNAL(textEdited(QString)), this, SLOT(hostnamechanged(QString)));
 
   exec();
@@ -270,15 +330,32 @@ void UI_settings_window::applyButtonClicked()
 
     mainwindow->devparms.connectiontype = 0;
   }
-  else
-  {
-    settings.setValue("connection/type", "LAN");
+  else if(lanIPRadioButton->isChecked() == true)
+    {
+      settings.setValue("connection/type", "LAN");
 
-    mainwindow->devparms.connectiontype = 1;
-  }
+      mainwindow->devparms.connectiontype = 1;
+    }
+    else if(replayRadioButton->isChecked() == true)
+      {
+        settings.setValue("connection/type", "REPLAY");
+
+        mainwindow->devparms.connectiontype = 2;
+      }
 
   settings.setValue("connection/device", QString(dev_str));
 
+  settings.setValue("connection/replay_file", replayLineEdit->text());
+
+  if(replayRealtimeCheckbox->checkState() == Qt::Checked)
+  {
+    settings.setValue("connection/replay_realtime", 1);
+  }
+  else
+  {
+    settings.setValue("connection/replay_realtime", 0);
+  }
+
   snprintf(dev_str, 256, "%i.%i.%i.%i",
           ipSpinbox1->value(), ipSpinbox2->value(), ipSpinbox3->value(), ipSpinbox4->value());
 
@@ -409,6 +486,23 @@ void UI_settings_window::extendvertdivCheckboxChanged(int state)
 }
 
 
+void UI_settings_window::adaptresCheckboxChanged(int state)
+{
+  QSettings settings;
+
+  if(state == Qt::Checked)
+  {
+    mainwindow->devparms.screen_res_adaptive = 1;
+  }
+  else
+  {
+    mainwindow->devparms.screen_res_adaptive = 0;
+  }
+
+  settings.setValue("gui/adaptive_screen_res", mainwindow->devparms.screen_res_adaptive);
+}
+
+
 void UI_settings_window::hostnamechanged(QString qstr)
 {
   int i, j, len, trunc=0;
@@ -458,6 +552,21 @@ void UI_settings_window::hostnamechanged(QString qstr)
 }
 
 
+void UI_settings_window::replayButtonClicked()
+{
+  QString path;
+
+  path = QFileDialog::getOpenFileName(this, "Open trace file", replayLineEdit->text(), "All files (*)");
+
+  if(!path.isEmpty())
+  {
+    replayLineEdit->setText(path);
+
+    replayRadioButton->setChecked(true);
+  }
+}
+
+
 
 
 
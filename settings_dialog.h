@@ -57,10 +57,12 @@ public:
 private:
 
 QPushButton  *cancelButton,
-             *applyButton;
+             *applyButton,
+             *replayButton;
 
 QRadioButton *usbRadioButton,
-             *lanIPRadioButton;
+             *lanIPRadioButton,
+             *replayRadioButton;
 
 QComboBox    *comboBox1;
 
@@ -74,13 +76,18 @@ QLabel       *refreshLabel,
              *invScrShtLabel,
              *showfpsLabel,
              *extendvertdivLabel,
-             *hostnameLabel;
+             *adaptresLabel,
+             *hostnameLabel,
+             *replayRealtimeLabel;
 
 QCheckBox    *invScrShtCheckbox,
              *showfpsCheckbox,
-             *extendvertdivCheckbox;
+             *extendvertdivCheckbox,
+             *adaptresCheckbox,
+             *replayRealtimeCheckbox;
 
-QLineEdit     *HostLineEdit;
+QLineEdit     *HostLineEdit,
+              *replayLineEdit;
 
 UI_Mainwindow *mainwindow;
 
@@ -91,7 +98,9 @@ void refreshSpinboxChanged(int);
 void invScrShtCheckboxChanged(int);
 void showfpsCheckboxChanged(int);
 void extendvertdivCheckboxChanged(int);
+void adaptresCheckboxChanged(int);
 void hostnamechanged(QString);
+void replayButtonClicked();
 
 };
 
@@ -112,6 +112,49 @@ SignalCurve::SignalCurve(QWidget *w_parent) : QWidget(w_parent)
 
   device = NULL;
 
+  // black, blue, red, yellow, white
+  for(i=0; i<256; i++)
+  {
+    if(i < 64)
+    {
+      wf_lut[i] = qRgb(0, 0, i * 4);
+    }
+    else if(i < 128)
+      {
+        wf_lut[i] = qRgb((i - 64) * 4, 0, 255 - ((i - 64) * 4));
+      }
+      else if(i < 192)
+        {
+          wf_lut[i] = qRgb(255, (i - 128) * 4, 0);
+        }
+        else
+        {
+          wf_lut[i] = qRgb(255, 255, (i - 192) * 4);
+        }
+  }
+
+  wf_seq = 0;
+
+  wf_head = 0;
+
+  wf_src = -1;
+
+  wf_unit = -1;
+
+  pers_init(&pers);
+
+  memset(&bg_gkey, 0, sizeof(bg_gkey));
+
+  memset(&bg_lkey, 0, sizeof(bg_lkey));
+
+  memset(&pers_key, 0, sizeof(pers_key));
+
+  pers_frame_seq = 0;
+
+  pers_seq = 0;
+
+  memset(pers_lut_color, 0, sizeof(pers_lut_color));
+
   connect(trig_line_timer, SIGNAL(timeout()), this, SLOT(trig_line_timer_handler()));
   connect(trig_stat_timer, SIGNAL(timeout()), this, SLOT(trig_stat_timer_handler()));
 }
@@ -125,6 +168,12 @@ void SignalCurve::clear()
 }
 
 
+SignalCurve::~SignalCurve()
+{
+  pers_free(&pers);
+}
+
+
 void SignalCurve::resizeEvent(QResizeEvent *resize_event)
 {
   QWidget::resizeEvent(resize_event);
@@ -190,14 +239,14 @@ int SignalCurve::print_to_image(const char *path)
 
 void SignalCurve::drawWidget(QPainter *painter, int curve_w, int curve_h)
 {
-  int i, chn, tmp, rot=1, small_rulers, curve_w_backup, curve_h_backup, w_trace_offset,
-      chns_done;
+  int n, chn, curve_w_backup, curve_h_backup, chns_done;
 
   char str[1024];
 
   double h_step=0.0,
-         step,
-         step2;
+         px_ratio=1.0;
+
+  struct trast_trace traces[MAX_CHNS], *tr;
 
 //  clk_start = clock();
 
@@ -212,57 +261,19 @@ void SignalCurve::drawWidget(QPainter *painter, int curve_w, int curve_h)
 
   curve_h_backup = curve_h;
 
-  small_rulers = 5 * devparms->hordivisions;
-
-  painter->fillRect(0, 0, curve_w, curve_h, BackgroundColor);
-
   if((curve_w < ((bordersize * 2) + 5)) || (curve_h < ((bordersize * 2) + 5)))
   {
+    painter->fillRect(0, 0, curve_w, curve_h, BackgroundColor);
+
     paint_mutex.unlock();
     return;
   }
 
-  painter->fillRect(0, 0, curve_w, 30, QColor(32, 32, 32));
-
-  drawTopLabels(painter);
-
-  if((devparms->acquirememdepth > 1000) && !devparms->timebasedelayenable)
-  {
-    tmp = 405 - ((devparms->timebaseoffset / (devparms->acquirememdepth / devparms->samplerate)) * 233);
-  }
-  else
-  {
-    tmp = 405 - ((devparms->timebaseoffset / ((double)devparms->timebasescale * (double)devparms->hordivisions)) * 233);
-  }
-
-  if(tmp < 289)
-  {
-    tmp = 284;
-
-    rot = 2;
-  }
-  else if(tmp > 521)
-    {
-      tmp = 526;
-
-      rot = 0;
-    }
+  update_trig_stat_flash();
 
-  if((rot == 0) || (rot == 2))
-  {
-    drawSmallTriggerArrow(painter, tmp, 11, rot, QColor(255, 128, 0));
-  }
-  else
-  {
-    drawSmallTriggerArrow(painter, tmp, 16, rot, QColor(255, 128, 0));
-  }
-
-  painter->fillRect(0, curve_h - 30, curve_w, curve_h, QColor(32, 32, 32));
+  updateBackground(curve_w, curve_h, painter->font());
 
-  for(i=0; i<devparms->channel_cnt; i++)
-  {
-    drawChanLabel(painter, 8 + (i * 130), curve_h - 25, i);
-  }
+  painter->drawPixmap(0, 0, bg_pixmap);
 
   if(devparms->connected && devparms->show_fps)
   {
@@ -282,99 +293,17 @@ void SignalCurve::drawWidget(QPainter *painter, int curve_w, int curve_h)
     curve_h /= 3;
   }
 
-/////////////////////////////////// draw the rasters ///////////////////////////////////////////
-
-  painter->setPen(RasterColor);
-
-  painter->drawRect (0, 0, curve_w - 1, curve_h - 1);
-
-  if((devparms->math_fft == 0) || (devparms->math_fft_split == 0))
+  if((devparms->math_fft == 1) && (devparms->math_fft_split == 0) && devparms->math_fft_waterfall)
   {
-    if(devparms->displaygrid)
-    {
-      painter->setPen(QPen(QBrush(RasterColor, Qt::SolidPattern), tracewidth, Qt::DotLine, Qt::SquareCap, Qt::BevelJoin));
-
-      if(devparms->displaygrid == 2)
-      {
-        step = (double)curve_w / (double)devparms->hordivisions;
-
-        for(i=1; i<devparms->hordivisions; i++)
-        {
-          painter->drawLine(step * i, curve_h - 1, step * i, 0);
-        }
-
-        step = curve_h / (double)devparms->vertdivisions;
-
-        for(i=1; i<devparms->vertdivisions; i++)
-        {
-          painter->drawLine(0, step * i, curve_w - 1, step * i);
-        }
-      }
-      else
-      {
-        painter->drawLine(curve_w / 2, curve_h - 1, curve_w / 2, 0);
-
-        painter->drawLine(0, curve_h / 2, curve_w - 1, curve_h / 2);
-      }
-    }
-
-    painter->setPen(RasterColor);
-
-    step = (double)curve_w / (double)small_rulers;
-
-    for(i=1; i<small_rulers; i++)
-    {
-      step2 = step * i;
-
-      if(devparms->displaygrid)
-      {
-        painter->drawLine(step2, curve_h / 2 + 2, step2, curve_h / 2 - 2);
-      }
-
-      if(i % 5)
-      {
-        painter->drawLine(step2, curve_h - 1, step2, curve_h - 5);
-
-        painter->drawLine(step2, 0, step2, 4);
-      }
-      else
-      {
-        painter->drawLine(step2, curve_h - 1, step2, curve_h - 9);
-
-        painter->drawLine(step2, 0, step2, 8);
-      }
-    }
-
-    step = curve_h / (5.0 * devparms->vertdivisions);
-
-    for(i=1; i<(5 * devparms->vertdivisions); i++)
-    {
-      step2 = step * i;
-
-      if(devparms->displaygrid)
-      {
-        painter->drawLine(curve_w / 2 + 2, step2, curve_w / 2  - 2, step2);
-      }
-
-      if(i % 5)
-      {
-        painter->drawLine(curve_w - 1, step2, curve_w - 5, step2);
+    drawWaterfall(painter, curve_w, curve_h);
+  }
 
-        painter->drawLine(0, step2, 4, step2);
-      }
-      else
-      {
-        painter->drawLine(curve_w - 1, step2, curve_w - 9, step2);
+/////////////////////////////////// draw the rasters ///////////////////////////////////////////
 
-        painter->drawLine(0, step2, 8, step2);
-      }
-    }
-  }  // if((devparms->math_fft == 0) || (devparms->math_fft_split == 0))
-  else
+  // the rasters are part of the background, on top of the waterfall they are drawn every time
+  if((devparms->math_fft == 1) && (devparms->math_fft_split == 0) && devparms->math_fft_waterfall)
   {
-    painter->drawLine(curve_w / 2, curve_h - 1, curve_w / 2, 0);
-
-    painter->drawLine(0, curve_h / 2, curve_w - 1, curve_h / 2);
+    drawRasters(painter, curve_w, curve_h);
   }
 
 /////////////////////////////////// draw the arrows ///////////////////////////////////////////
@@ -442,9 +371,26 @@ void SignalCurve::drawWidget(QPainter *painter, int curve_w, int curve_h)
     painter->setClipping(true);
     painter->setClipRegion(QRegion(0, 0, curve_w, curve_h), Qt::ReplaceClip);
 
-    h_step = (double)curve_w / (devparms->hordivisions * 100);
+    if(devparms->screen_pnts > 0)
+    {
+      h_step = (double)curve_w / devparms->screen_pnts;
+    }
+    else
+    {
+      h_step = (double)curve_w / (devparms->hordivisions * 100);
+    }
+
+    if(devparms->display_persist)
+    {
+      drawPersistence(painter, curve_w, curve_h, h_step);
+    }
+
+    // the traces are drawn in device pixels, sharp on a HiDPI screen
+#if QT_VERSION >= 0x050600
+    px_ratio = painter->device()->devicePixelRatioF();
+#endif
 
-    for(chn=0, chns_done=0; chn<=devparms->channel_cnt; chn++)
+    for(chn=0, chns_done=0, n=0; (!devparms->display_persist) && (chn<=devparms->channel_cnt); chn++)
     {
       if(chns_done)  break;
 
@@ -462,45 +408,50 @@ void SignalCurve::drawWidget(QPainter *painter, int curve_w, int curve_h)
         continue;
       }
 
-      w_trace_offset = (curve_w / 2.0) - (((devparms->timebaseoffset - devparms->xorigin[chn]) / devparms->timebasescale) * ((double)curve_w / (double)(devparms->hordivisions)));
+      // the active channel comes last and is drawn on top
+      tr = &traces[n++];
 
-      painter->setPen(QPen(QBrush(SignalColor[chn], Qt::SolidPattern), tracewidth, Qt::SolidLine, Qt::SquareCap, Qt::BevelJoin));
+      memset(tr, 0, sizeof(struct trast_trace));
 
-      for(i=0; i<bufsize; i++)
+      tr->buf = devparms->wavebuf[chn];
+      tr->n = bufsize;
+      tr->x_off = (int)((curve_w / 2.0) - (((devparms->timebaseoffset - devparms->xorigin[chn]) / devparms->timebasescale) * ((double)curve_w / (double)(devparms->hordivisions)))) * px_ratio;
+      tr->x_step = h_step * px_ratio;
+      tr->y_off = ((curve_h / 2) - chan_tmp_y_pixel_offset[chn]) * px_ratio;
+      tr->y_step = v_sense * px_ratio;
+      tr->color = SignalColor[chn].rgb();
+      tr->width = (tracewidth * px_ratio) + 0.5;
+      tr->aa = devparms->display_aa;
+
+      if(bufsize < (curve_w / 2))
       {
-        if(bufsize < (curve_w / 2))
+        // few samples, every sample is a step
+        tr->style = TRAST_STEPS;
+      }
+      else if(devparms->displaytype)
         {
-          painter->drawLine(i * h_step + w_trace_offset,
-                            (devparms->wavebuf[chn][i] * v_sense) + (curve_h / 2) - chan_tmp_y_pixel_offset[chn],
-                            (i + 1) * h_step + w_trace_offset,
-                            (devparms->wavebuf[chn][i] * v_sense) + (curve_h / 2) - chan_tmp_y_pixel_offset[chn]);
-          if(i)
+          tr->style = TRAST_DOTS;
+
+          tr->n = bufsize - 1;
+        }
+        else if(bufsize > (curve_w * 2))
           {
-            painter->drawLine(i * h_step + w_trace_offset,
-                              (devparms->wavebuf[chn][i - 1] * v_sense) + (curve_h / 2) - chan_tmp_y_pixel_offset[chn],
-                              i * h_step + w_trace_offset,
-                              (devparms->wavebuf[chn][i] * v_sense) + (curve_h / 2) - chan_tmp_y_pixel_offset[chn]);
+            // raw samples, many per pixel, every column gets a line from the minimum to the maximum
+            tr->style = TRAST_COLUMNS;
           }
-        }
-        else
-        {
-          if(i < (bufsize - 1))
+          else
           {
-            if(devparms->displaytype)
-            {
-              painter->drawPoint(i * h_step + w_trace_offset,
-                                 (devparms->wavebuf[chn][i] * v_sense) + (curve_h / 2) - chan_tmp_y_pixel_offset[chn]);
-            }
-            else
-            {
-              painter->drawLine(i * h_step + w_trace_offset,
-                                (devparms->wavebuf[chn][i] * v_sense) + (curve_h / 2) - chan_tmp_y_pixel_offset[chn],
-                                (i + 1) * h_step + w_trace_offset,
-                                (devparms->wavebuf[chn][i + 1] * v_sense) + (curve_h / 2) - chan_tmp_y_pixel_offset[chn]);
-            }
+            tr->style = TRAST_VECTORS;
           }
-        }
-      }
+    }
+
+    // the traces are drawn by worker threads, only the lines that hold a trace are copied
+    if((!devparms->display_persist) &&
+       (!trace_rend.render((curve_w * px_ratio) + 0.5, (curve_h * px_ratio) + 0.5, px_ratio, traces, n)) &&
+       (trace_rend.get_y_lo() <= trace_rend.get_y_hi()))
+    {
+      painter->drawImage(QPointF(0, trace_rend.get_y_lo() / px_ratio), trace_rend.get_image(),
+                         QRectF(0, trace_rend.get_y_lo(), trace_rend.get_image().width(), trace_rend.get_y_hi() - trace_rend.get_y_lo() + 1));
     }
 
     painter->setClipping(false);
@@ -663,31 +614,308 @@ void SignalCurve::drawWidget(QPainter *painter, int curve_w, int curve_h)
 
         convert_to_metric_suffix(str + strlen(str), devparms->fft_voffset, 1, 1024);
 
-        strlcat(str, "V", 1024);
+        strlcat(str, "V", 1024);
+      }
+      else
+      {
+        snprintf(str, 1024, "POS: %.1fdB", devparms->fft_voffset);
+      }
+
+      paintLabel(painter, 20, curve_h * 1.85 - 50.0, 100, 20, str, QColor(128, 64, 255));
+    }
+  }
+
+//   clk_end = clock();
+//
+//   cpu_time_used += ((double) (clk_end - clk_start)) / CLOCKS_PER_SEC;
+//
+//   scr_update_cntr++;
+//
+//   if(!(scr_update_cntr % 50))
+//   {
+//     printf("CPU time used: %f\n", cpu_time_used / 50);
+//
+//     cpu_time_used = 0;
+//   }
+
+  paint_mutex.unlock();
+}
+
+
+// the grid, the rulers and the labels only change with the settings, they are drawn into
+// bg_pixmap once and the pixmap is copied on every repaint, a change of a label only
+// redraws the top and bottom bar
+void SignalCurve::updateBackground(int curve_w, int curve_h, const QFont &font)
+{
+  int i, full;
+
+  struct bg_grid_key gk;
+
+  struct bg_label_key lk;
+
+  memset(&gk, 0, sizeof(gk));
+
+  gk.bordersize = bordersize;
+  gk.tracewidth = tracewidth;
+  gk.displaygrid = devparms->displaygrid;
+  gk.hordivisions = devparms->hordivisions;
+  gk.vertdivisions = devparms->vertdivisions;
+  gk.math_fft = devparms->math_fft;
+  gk.math_fft_split = devparms->math_fft_split;
+  gk.math_fft_waterfall = devparms->math_fft_waterfall;
+  gk.background_color = BackgroundColor.rgba();
+  gk.raster_color = RasterColor.rgba();
+#if QT_VERSION >= 0x050600
+  gk.pixel_ratio = devicePixelRatioF();
+#else
+  gk.pixel_ratio = 1;
+#endif
+
+  memset(&lk, 0, sizeof(lk));
+
+  strlcpy(lk.modelname, devparms->modelname, 128);
+  lk.font_size = devparms->font_size;
+  lk.channel_cnt = devparms->channel_cnt;
+  lk.activechannel = devparms->activechannel;
+  for(i=0; i<MAX_CHNS; i++)
+  {
+    lk.chandisplay[i] = devparms->chandisplay[i];
+    lk.chanscale[i] = devparms->chanscale[i];
+    lk.chanunit[i] = devparms->chanunit[i];
+    lk.chanbwlimit[i] = devparms->chanbwlimit[i];
+    lk.chancoupling[i] = devparms->chancoupling[i];
+    lk.chaninvert[i] = devparms->chaninvert[i];
+    lk.signal_color[i] = SignalColor[i].rgba();
+  }
+  lk.triggerstatus = devparms->triggerstatus;
+  lk.trig_stat_flash = trig_stat_flash;
+  lk.triggeredgesource = devparms->triggeredgesource;
+  lk.triggeredgeslope = devparms->triggeredgeslope;
+  if((devparms->triggeredgesource >= 0) && (devparms->triggeredgesource < MAX_TRIG_SRCS))
+  {
+    lk.triggeredgelevel = devparms->triggeredgelevel[devparms->triggeredgesource];
+  }
+  lk.timebasescale = devparms->timebasescale;
+  lk.timebaseoffset = devparms->timebaseoffset;
+  lk.timebasedelayenable = devparms->timebasedelayenable;
+  lk.timebasedelayoffset = devparms->timebasedelayoffset;
+  lk.timebasedelayscale = devparms->timebasedelayscale;
+  lk.samplerate = devparms->samplerate;
+  lk.acquirememdepth = devparms->acquirememdepth;
+  lk.hordivisions = devparms->hordivisions;
+
+  if((bg_pixmap.width() != (int)(curve_w * gk.pixel_ratio + 0.5)) ||
+     (bg_pixmap.height() != (int)(curve_h * gk.pixel_ratio + 0.5)) ||
+     memcmp(&gk, &bg_gkey, sizeof(gk)))
+  {
+    // allocated in device pixels, otherwise it's scaled up and blurry on a HiDPI screen,
+    // the painter keeps working in logical coordinates
+    bg_pixmap = QPixmap((int)(curve_w * gk.pixel_ratio + 0.5), (int)(curve_h * gk.pixel_ratio + 0.5));
+#if QT_VERSION >= 0x050600
+    bg_pixmap.setDevicePixelRatio(gk.pixel_ratio);
+#endif
+
+    full = 1;
+  }
+  else if(memcmp(&lk, &bg_lkey, sizeof(lk)))
+    {
+      full = 0;
+    }
+    else
+    {
+      return;
+    }
+
+  memcpy(&bg_gkey, &gk, sizeof(gk));
+
+  memcpy(&bg_lkey, &lk, sizeof(lk));
+
+  QPainter paint(&bg_pixmap);
+#if (QT_VERSION >= 0x050000) && (QT_VERSION < 0x060000)
+  paint.setRenderHint(QPainter::Qt4CompatiblePainting, true);
+#endif
+
+  paint.setFont(font);
+
+  if(full)
+  {
+    paint.fillRect(0, 0, curve_w, curve_h, BackgroundColor);
+  }
+
+  drawBars(&paint, curve_w, curve_h);
+
+  if(!full)
+  {
+    return;
+  }
+
+  paint.translate(bordersize, bordersize);
+
+  curve_w -= (bordersize * 2);
+
+  curve_h -= (bordersize * 2);
+
+  if(devparms->math_fft && devparms->math_fft_split)
+  {
+    curve_h /= 3;
+  }
+
+  if(!((devparms->math_fft == 1) && (devparms->math_fft_split == 0) && devparms->math_fft_waterfall))
+  {
+    drawRasters(&paint, curve_w, curve_h);
+  }
+}
+
+
+// the top bar with the settings and the bottom bar with the channel labels
+void SignalCurve::drawBars(QPainter *painter, int curve_w, int curve_h)
+{
+  int i, tmp, rot=1;
+
+  painter->fillRect(0, 0, curve_w, 30, QColor(32, 32, 32));
+
+  drawTopLabels(painter);
+
+  if((devparms->acquirememdepth > 1000) && !devparms->timebasedelayenable)
+  {
+    tmp = 405 - ((devparms->timebaseoffset / (devparms->acquirememdepth / devparms->samplerate)) * 233);
+  }
+  else
+  {
+    tmp = 405 - ((devparms->timebaseoffset / ((double)devparms->timebasescale * (double)devparms->hordivisions)) * 233);
+  }
+
+  if(tmp < 289)
+  {
+    tmp = 284;
+
+    rot = 2;
+  }
+  else if(tmp > 521)
+    {
+      tmp = 526;
+
+      rot = 0;
+    }
+
+  if((rot == 0) || (rot == 2))
+  {
+    drawSmallTriggerArrow(painter, tmp, 11, rot, QColor(255, 128, 0));
+  }
+  else
+  {
+    drawSmallTriggerArrow(painter, tmp, 16, rot, QColor(255, 128, 0));
+  }
+
+  painter->fillRect(0, curve_h - 30, curve_w, curve_h, QColor(32, 32, 32));
+
+  for(i=0; i<devparms->channel_cnt; i++)
+  {
+    drawChanLabel(painter, 8 + (i * 130), curve_h - 25, i);
+  }
+}
+
+
+void SignalCurve::drawRasters(QPainter *painter, int curve_w, int curve_h)
+{
+  int i, small_rulers;
+
+  double step, step2;
+
+  small_rulers = 5 * devparms->hordivisions;
+
+  painter->setPen(RasterColor);
+
+  painter->drawRect (0, 0, curve_w - 1, curve_h - 1);
+
+  if((devparms->math_fft == 0) || (devparms->math_fft_split == 0))
+  {
+    if(devparms->displaygrid)
+    {
+      painter->setPen(QPen(QBrush(RasterColor, Qt::SolidPattern), tracewidth, Qt::DotLine, Qt::SquareCap, Qt::BevelJoin));
+
+      if(devparms->displaygrid == 2)
+      {
+        step = (double)curve_w / (double)devparms->hordivisions;
+
+        for(i=1; i<devparms->hordivisions; i++)
+        {
+          painter->drawLine(step * i, curve_h - 1, step * i, 0);
+        }
+
+        step = curve_h / (double)devparms->vertdivisions;
+
+        for(i=1; i<devparms->vertdivisions; i++)
+        {
+          painter->drawLine(0, step * i, curve_w - 1, step * i);
+        }
+      }
+      else
+      {
+        painter->drawLine(curve_w / 2, curve_h - 1, curve_w / 2, 0);
+
+        painter->drawLine(0, curve_h / 2, curve_w - 1, curve_h / 2);
+      }
+    }
+
+    painter->setPen(RasterColor);
+
+    step = (double)curve_w / (double)small_rulers;
+
+    for(i=1; i<small_rulers; i++)
+    {
+      step2 = step * i;
+
+      if(devparms->displaygrid)
+      {
+        painter->drawLine(step2, curve_h / 2 + 2, step2, curve_h / 2 - 2);
+      }
+
+      if(i % 5)
+      {
+        painter->drawLine(step2, curve_h - 1, step2, curve_h - 5);
+
+        painter->drawLine(step2, 0, step2, 4);
+      }
+      else
+      {
+        painter->drawLine(step2, curve_h - 1, step2, curve_h - 9);
+
+        painter->drawLine(step2, 0, step2, 8);
+      }
+    }
+
+    step = curve_h / (5.0 * devparms->vertdivisions);
+
+    for(i=1; i<(5 * devparms->vertdivisions); i++)
+    {
+      step2 = step * i;
+
+      if(devparms->displaygrid)
+      {
+        painter->drawLine(curve_w / 2 + 2, step2, curve_w / 2  - 2, step2);
+      }
+
+      if(i % 5)
+      {
+        painter->drawLine(curve_w - 1, step2, curve_w - 5, step2);
+
+        painter->drawLine(0, step2, 4, step2);
       }
       else
       {
-        snprintf(str, 1024, "POS: %.1fdB", devparms->fft_voffset);
-      }
+        painter->drawLine(curve_w - 1, step2, curve_w - 9, step2);
 
-      paintLabel(painter, 20, curve_h * 1.85 - 50.0, 100, 20, str, QColor(128, 64, 255));
+        painter->drawLine(0, step2, 8, step2);
+      }
     }
-  }
-
-//   clk_end = clock();
-//
-//   cpu_time_used += ((double) (clk_end - clk_start)) / CLOCKS_PER_SEC;
-//
-//   scr_update_cntr++;
-//
-//   if(!(scr_update_cntr % 50))
-//   {
-//     printf("CPU time used: %f\n", cpu_time_used / 50);
-//
-//     cpu_time_used = 0;
-//   }
+  }  // if((devparms->math_fft == 0) || (devparms->math_fft_split == 0))
+  else
+  {
+    painter->drawLine(curve_w / 2, curve_h - 1, curve_w / 2, 0);
 
-  paint_mutex.unlock();
+    painter->drawLine(0, curve_h / 2, curve_w - 1, curve_h / 2);
+  }
 }
 
 
@@ -728,6 +956,11 @@ void SignalCurve::drawFFT(QPainter *painter, int curve_h_b, int curve_w_b)
 
     curve_h *= 0.64;
 
+    if(devparms->math_fft_waterfall)
+    {
+      drawWaterfall(painter, curve_w, curve_h);
+    }
+
 /////////////////////////////////// FFT: draw the rasters ///////////////////////////////////////////
 
     painter->setPen(RasterColor);
@@ -833,32 +1066,12 @@ void SignalCurve::drawFFT(QPainter *painter, int curve_h_b, int curve_w_b)
     painter->setClipping(true);
     painter->setClipRegion(QRegion(0, 0, curve_w, curve_h), Qt::ReplaceClip);
 
-    h_step = (double)curve_w / (double)devparms->fftbufsz;
-
-    if(devparms->timebasedelayenable)
-    {
-      h_step *= (100.0 / devparms->timebasedelayscale) / devparms->math_fft_hscale;
-    }
-    else
-    {
-      h_step *= (100.0 / devparms->timebasescale) / devparms->math_fft_hscale;
-    }
-
-    if(devparms->modelserie != 1)
-    {
-      h_step /= 28.0;
-    }
-    else
-    {
-      h_step /= 24.0;
-    }
+    fft_h_mapping(curve_w, &h_step, &fft_h_offset);
 
     fft_v_sense = (double)curve_h / (-8.0 * devparms->fft_vscale);
 
     fft_v_offset = (curve_h / 2.0) + (fft_v_sense * devparms->fft_voffset);
 
-    fft_h_offset = (curve_w / 2) - ((devparms->math_fft_hcenter / devparms->math_fft_hscale) * curve_w / devparms->hordivisions);
-
 //     fft_smpls_onscreen = (double)devparms->fftbufsz * ((devparms->math_fft_hscale * devparms->hordivisions) / (double)devparms->current_screen_sf);
 
     painter->setPen(QPen(QBrush(QColor(128, 64, 255), Qt::SolidPattern), tracewidth, Qt::SolidLine, Qt::SquareCap, Qt::BevelJoin));
@@ -929,6 +1142,283 @@ void SignalCurve::drawFFT(QPainter *painter, int curve_h_b, int curve_w_b)
 }
 
 
+// pixels per fft bin and the x position of bin 0
+void SignalCurve::fft_h_mapping(int curve_w, double *h_step, double *h_offset)
+{
+  *h_step = (double)curve_w / (double)devparms->fftbufsz;
+
+  if(devparms->timebasedelayenable)
+  {
+    *h_step *= (100.0 / devparms->timebasedelayscale) / devparms->math_fft_hscale;
+  }
+  else
+  {
+    *h_step *= (100.0 / devparms->timebasescale) / devparms->math_fft_hscale;
+  }
+
+  if(devparms->modelserie != 1)
+  {
+    *h_step /= 28.0;
+  }
+  else
+  {
+    *h_step /= 24.0;
+  }
+
+  *h_offset = (curve_w / 2) - ((devparms->math_fft_hcenter / devparms->math_fft_hscale) * curve_w / devparms->hordivisions);
+}
+
+
+// the history is blitted in two parts, from the newest scanline to the end
+// of the ring and from the start of the ring to the oldest one
+void SignalCurve::drawWaterfall(QPainter *painter, int curve_w, int curve_h)
+{
+  double h_step, h_offset, row_h, top_h;
+
+  if(wf_img.isNull() || (wf_img.width() != devparms->fftbufsz) || (devparms->fftbufsz < 32))
+  {
+    return;
+  }
+
+  fft_h_mapping(curve_w, &h_step, &h_offset);
+
+  row_h = (double)curve_h / FFT_WF_ROWS;
+
+  top_h = (FFT_WF_ROWS - wf_head) * row_h;
+
+  painter->setClipping(true);
+  painter->setClipRegion(QRegion(0, 0, curve_w, curve_h), Qt::ReplaceClip);
+
+  painter->drawImage(QRectF(h_offset, 0, devparms->fftbufsz * h_step, top_h), wf_img,
+                     QRectF(0, wf_head, devparms->fftbufsz, FFT_WF_ROWS - wf_head));
+
+  if(wf_head)
+  {
+    painter->drawImage(QRectF(h_offset, top_h, devparms->fftbufsz * h_step, curve_h - top_h), wf_img,
+                       QRectF(0, 0, devparms->fftbufsz, wf_head));
+  }
+
+  painter->setClipping(false);
+}
+
+
+// adds the spectrum of a new frame to the waterfall, only one scanline is written,
+// the intensity uses the same vertical range as the fft trace
+void SignalCurve::wf_append_row()
+{
+  int i, k, bins;
+
+  unsigned int *row;
+
+  double v_lo, v_sense_wf;
+
+  if((devparms->math_fft == 0) || (devparms->math_fft_waterfall == 0))
+  {
+    return;
+  }
+
+  bins = devparms->fftbufsz;
+
+  if((bins < 32) || (devparms->fftbuf_seq == wf_seq) || (devparms->fftbuf_out == NULL))
+  {
+    return;
+  }
+
+  wf_seq = devparms->fftbuf_seq;
+
+  if((wf_img.width() != bins) || (wf_src != devparms->math_fft_src) || (wf_unit != devparms->math_fft_unit))
+  {
+    wf_img = QImage(bins, FFT_WF_ROWS, QImage::Format_RGB32);
+
+    if(wf_img.isNull())
+    {
+      return;
+    }
+
+    wf_img.fill(wf_lut[0]);
+
+    wf_head = 0;
+
+    wf_src = devparms->math_fft_src;
+
+    wf_unit = devparms->math_fft_unit;
+  }
+
+  wf_head = (wf_head + FFT_WF_ROWS - 1) % FFT_WF_ROWS;
+
+  row = (unsigned int *)wf_img.scanLine(wf_head);
+
+  v_lo = (-4.0 * devparms->fft_vscale) - devparms->fft_voffset;
+
+  v_sense_wf = 255.0 / (8.0 * devparms->fft_vscale);
+
+  for(i=0; i<bins; i++)
+  {
+    k = (devparms->fftbuf_out[i] - v_lo) * v_sense_wf;
+
+    if(k < 0)
+    {
+      k = 0;
+    }
+    else if(k > 255)
+      {
+        k = 255;
+      }
+
+    row[i] = wf_lut[k];
+  }
+}
+
+
+// every new frame is added to the intensities, with a finite grading time the old
+// frames fade with that time constant, infinite keeps counting hits per pixel
+void SignalCurve::drawPersistence(QPainter *painter, int curve_w, int curve_h, double h_step)
+{
+  int chn, w_trace_offset, weight, px_w, px_h;
+
+  double factor=1.0, tau, t, px_ratio=1.0;
+
+  const unsigned int *lut[PERS_MAX_CHNS];
+
+  if((curve_w < 1) || (curve_h < 1))
+  {
+    return;
+  }
+
+  // the intensities are kept per device pixel
+#if QT_VERSION >= 0x050600
+  px_ratio = painter->device()->devicePixelRatioF();
+#endif
+
+  px_w = (curve_w * px_ratio) + 0.5;
+
+  px_h = (curve_h * px_ratio) + 0.5;
+
+  if((pers_img.width() != px_w) || (pers_img.height() != px_h))
+  {
+    pers_img = QImage(px_w, px_h, QImage::Format_ARGB32_Premultiplied);
+
+    if(pers_img.isNull())
+    {
+      return;
+    }
+
+    if(pers_resize(&pers, px_w, px_h))
+    {
+      pers_img = QImage();
+
+      return;
+    }
+  }
+
+#if QT_VERSION >= 0x050600
+  pers_img.setDevicePixelRatio(px_ratio);
+#endif
+
+  if((pers_key.timebasescale != devparms->timebasescale) ||
+     (pers_key.timebaseoffset != devparms->timebaseoffset) ||
+     (pers_key.displaygrading != devparms->displaygrading) ||
+     (pers_key.screen_pnts != devparms->screen_pnts))
+  {
+    pers_clear(&pers, -1);
+
+    pers_key.timebasescale = devparms->timebasescale;
+    pers_key.timebaseoffset = devparms->timebaseoffset;
+    pers_key.displaygrading = devparms->displaygrading;
+    pers_key.screen_pnts = devparms->screen_pnts;
+  }
+
+  for(chn=0; chn<MAX_CHNS; chn++)
+  {
+    if((pers_key.chanscale[chn] != devparms->chanscale[chn]) ||
+       (pers_key.chanoffset[chn] != devparms->chanoffset[chn]) ||
+       (pers_key.chandisplay[chn] != devparms->chandisplay[chn]) ||
+       (pers_key.y_pixel_offset[chn] != chan_tmp_y_pixel_offset[chn]))
+    {
+      pers_clear(&pers, chn);
+
+      pers_key.chanscale[chn] = devparms->chanscale[chn];
+      pers_key.chanoffset[chn] = devparms->chanoffset[chn];
+      pers_key.chandisplay[chn] = devparms->chandisplay[chn];
+      pers_key.y_pixel_offset[chn] = chan_tmp_y_pixel_offset[chn];
+    }
+  }
+
+  if(pers_seq != pers_frame_seq)
+  {
+    pers_seq = pers_frame_seq;
+
+    if(devparms->displaygrading == 10000)
+    {
+      weight = PERS_HIT_INF;
+    }
+    else
+    {
+      weight = PERS_HIT_DECAY;
+
+      // the grading time is in units of 0.1 second, minimum is about one frame
+      tau = devparms->displaygrading ? (devparms->displaygrading / 10.0) : 0.05;
+
+      if(pers_timer.isValid())
+      {
+        t = pers_timer.restart() / 1000.0;
+
+        factor = exp(-t / tau);
+      }
+      else
+      {
+        pers_timer.start();
+
+        factor = 0.0;
+      }
+    }
+
+    for(chn=0; chn<devparms->channel_cnt; chn++)
+    {
+      if(!devparms->chandisplay[chn])
+      {
+        continue;
+      }
+
+      if(weight == PERS_HIT_DECAY)
+      {
+        pers_decay(&pers, chn, factor);
+      }
+
+      w_trace_offset = (curve_w / 2.0) - (((devparms->timebaseoffset - devparms->xorigin[chn]) / devparms->timebasescale) * ((double)curve_w / (double)(devparms->hordivisions)));
+
+      pers_add_trace(&pers, chn, devparms->wavebuf[chn], bufsize, w_trace_offset * px_ratio, h_step * px_ratio,
+                     ((curve_h / 2) - chan_tmp_y_pixel_offset[chn]) * px_ratio, v_sense * px_ratio, weight);
+    }
+  }
+
+  // dark to the trace color with a square root ramp so that rare hits stay
+  // visible, the most frequent hits turn towards white, only rebuilt when the color changes
+  for(chn=0; chn<PERS_MAX_CHNS; chn++)
+  {
+    lut[chn] = NULL;
+
+    if((chn >= devparms->channel_cnt) || (!devparms->chandisplay[chn]))
+    {
+      continue;
+    }
+
+    if(pers_lut_color[chn] != SignalColor[chn].rgb())
+    {
+      pers_color_ramp(pers_lut[chn], PERS_LUT_SZ, SignalColor[chn].rgb(), 1);
+
+      pers_lut_color[chn] = SignalColor[chn].rgb();
+    }
+
+    lut[chn] = pers_lut[chn];
+  }
+
+  pers_render(&pers, (unsigned int *)pers_img.bits(), pers_img.bytesPerLine() / 4, lut);
+
+  painter->drawImage(0, 0, pers_img);
+}
+
+
 void SignalCurve::drawCurve(struct device_settings *devp, struct tmcdev *dev)
 {
   devparms = devp;
@@ -937,6 +1427,10 @@ void SignalCurve::drawCurve(struct device_settings *devp, struct tmcdev *dev)
 
   bufsize = devparms->wavebufsz;
 
+  wf_append_row();
+
+  pers_frame_seq++;
+
   update();
 }
 
@@ -976,25 +1470,6 @@ void SignalCurve::drawTopLabels(QPainter *painter)
 
   path.addRoundedRect(80, 5, 35, 20, 3, 3);
 
-  if((devparms->triggerstatus == 1) || (devparms->triggerstatus == 3))
-  {
-    if(!trig_stat_flash)
-    {
-      trig_stat_flash = 1;
-
-      trig_stat_timer->start(1000);
-    }
-  }
-  else
-  {
-    if(trig_stat_flash)
-    {
-      trig_stat_flash = 0;
-
-      trig_stat_timer->stop();
-    }
-  }
-
   if(trig_stat_flash == 2)
   {
     painter->fillPath(path, Qt::green);
@@ -1930,9 +2405,7 @@ void SignalCurve::mouseReleaseEvent(QMouseEvent *release_event)
 
       mainwindow->statusLabel->setText(str);
 
-      snprintf(str, 512, ":TIM:DEL:OFFS %e", devparms->timebasedelayoffset);
-
-      mainwindow->set_cue_cmd(str);
+      mainwindow->set_cue_cmd(TMC_OP_TIM_DEL_OFFS, 0, devparms->timebasedelayoffset);
     }
     else
     {
@@ -1950,9 +2423,7 @@ void SignalCurve::mouseReleaseEvent(QMouseEvent *release_event)
 
       mainwindow->statusLabel->setText(str);
 
-      snprintf(str, 512, ":TIM:OFFS %e", devparms->timebaseoffset);
-
-      mainwindow->set_cue_cmd(str);
+      mainwindow->set_cue_cmd(TMC_OP_TIM_OFFS, 0, devparms->timebaseoffset);
     }
   }
   else if(trig_level_arrow_moving)
@@ -1992,9 +2463,7 @@ void SignalCurve::mouseReleaseEvent(QMouseEvent *release_event)
 
       mainwindow->statusLabel->setText(str);
 
-      snprintf(str, 512, ":TRIGger:EDGE:LEVel %e", devparms->triggeredgelevel[devparms->triggeredgesource]);
-
-      mainwindow->set_cue_cmd(str);
+      mainwindow->set_cue_cmd(TMC_OP_TRIG_EDGE_LEV, devparms->triggeredgesource, devparms->triggeredgelevel[devparms->triggeredgesource]);
 
       trig_line_timer->start(1300);
     }
@@ -2038,9 +2507,7 @@ void SignalCurve::mouseReleaseEvent(QMouseEvent *release_event)
 
           mainwindow->statusLabel->setText(str);
 
-          snprintf(str, 512, ":CHAN%i:OFFS %e", chn + 1, devparms->chanoffset[chn]);
-
-          mainwindow->set_cue_cmd(str);
+          mainwindow->set_cue_cmd(TMC_OP_CHAN_OFFS, chn, devparms->chanoffset[chn]);
 
           devparms->activechannel = chn;
 
@@ -2229,6 +2696,30 @@ void SignalCurve::setTrigLineVisible(void)
 }
 
 
+// WAIT and AUTO flash, this runs on every repaint, also when the labels come from bg_pixmap
+void SignalCurve::update_trig_stat_flash()
+{
+  if((devparms->triggerstatus == 1) || (devparms->triggerstatus == 3))
+  {
+    if(!trig_stat_flash)
+    {
+      trig_stat_flash = 1;
+
+      trig_stat_timer->start(1000);
+    }
+  }
+  else
+  {
+    if(trig_stat_flash)
+    {
+      trig_stat_flash = 0;
+
+      trig_stat_timer->stop();
+    }
+  }
+}
+
+
 void SignalCurve::trig_stat_timer_handler()
 {
   if(!trig_stat_flash)
@@ -43,6 +43,10 @@
 #include <QFont>
 #include <QTimer>
 #include <QMutex>
+#include <QImage>
+#include <QPixmap>
+#include <QElapsedTimer>
+#include <QPoint>
 
 #include <stdio.h>
 #include <stdlib.h>
@@ -54,6 +58,8 @@
 #include "connection.h"
 #include "tmc_dev.h"
 #include "utils.h"
+#include "persist.h"
+#include "trace_render.h"
 
 
 
@@ -66,6 +72,7 @@ class SignalCurve: public QWidget
 
 public:
   SignalCurve(QWidget *parent=0);
+  ~SignalCurve();
 
   QSize sizeHint() const {return minimumSizeHint(); }
   QSize minimumSizeHint() const {return QSize(30,10); }
@@ -149,7 +156,87 @@ private:
 
   double cpu_time_used;
 
+  QImage wf_img;          // waterfall history, one scanline per spectrum, used as a ring
+
+  unsigned int wf_lut[256],
+               wf_seq;
+
+  int wf_head,            // scanline of the newest spectrum
+      wf_src,
+      wf_unit;
+
+  struct persist_buf pers;  // intensity per pixel of every channel
+
+  QImage pers_img;
+
+  trace_render trace_rend;   // draws the traces of the channels in parallel
+
+  QPixmap bg_pixmap;        // background, bars, labels and rasters, see updateBackground()
+
+  struct bg_grid_key {
+    int bordersize;
+    int tracewidth;
+    int displaygrid;
+    int hordivisions;
+    int vertdivisions;
+    int math_fft;
+    int math_fft_split;
+    int math_fft_waterfall;
+    QRgb background_color;
+    QRgb raster_color;
+    double pixel_ratio;
+  } bg_gkey;                // bg_pixmap is redrawn when one of these changes
+
+  struct bg_label_key {
+    char modelname[128];
+    int font_size;
+    int channel_cnt;
+    int activechannel;
+    int chandisplay[MAX_CHNS];
+    double chanscale[MAX_CHNS];
+    int chanunit[MAX_CHNS];
+    int chanbwlimit[MAX_CHNS];
+    int chancoupling[MAX_CHNS];
+    int chaninvert[MAX_CHNS];
+    QRgb signal_color[MAX_CHNS];
+    int triggerstatus;
+    int trig_stat_flash;
+    int triggeredgesource;
+    int triggeredgeslope;
+    double triggeredgelevel;
+    double timebasescale;
+    double timebaseoffset;
+    int timebasedelayenable;
+    double timebasedelayoffset;
+    double timebasedelayscale;
+    double samplerate;
+    int acquirememdepth;
+    int hordivisions;
+  } bg_lkey;                // only the bars are redrawn when one of these changes
+
+  QElapsedTimer pers_timer;
+
+  unsigned int pers_lut[MAX_CHNS][PERS_LUT_SZ],
+               pers_lut_color[MAX_CHNS],  // the color pers_lut was built for, 0 when it wasn't built
+               pers_frame_seq,  // incremented for every new frame
+               pers_seq;        // the frame that was added last
+
+  struct {
+    double timebasescale;
+    double timebaseoffset;
+    double chanscale[MAX_CHNS];
+    double chanoffset[MAX_CHNS];
+    int chandisplay[MAX_CHNS];
+    int y_pixel_offset[MAX_CHNS];
+    int displaygrading;
+    int screen_pnts;
+  } pers_key;               // the intensities are cleared when one of these changes
+
   void drawWidget(QPainter *, int, int);
+  void updateBackground(int, int, const QFont &);
+  void drawBars(QPainter *, int, int);
+  void drawRasters(QPainter *, int, int);
+  void update_trig_stat_flash();
   void drawArrow(QPainter *, int, int, int, QColor, char);
   void drawSmallTriggerArrow(QPainter *, int, int, int, QColor);
   void drawTrigCenterArrow(QPainter *, int, int);
@@ -159,6 +246,10 @@ private:
   void paintCounterLabel(QPainter *, int, int);
   void paintPlaybackLabel(QPainter *, int, int);
   void drawFFT(QPainter *, int, int);
+  void fft_h_mapping(int, double *, double *);
+  void drawWaterfall(QPainter *, int, int);
+  void wf_append_row();
+  void drawPersistence(QPainter *, int, int, double);
   void drawfpsLabel(QPainter *, int, int);
   void draw_decoder(QPainter *, int, int);
   int ascii_decode_control_char(char, char *, int);
@@ -90,14 +90,10 @@ void UI_Mainwindow::adjdial_timer_handler()
 
     if((devparms.modelserie == 2) || (devparms.modelserie == 6))
     {
-      usleep(20000);
-
       set_cue_cmd(":DISP:CLE");
     }
     else
     {
-      usleep(20000);
-
       set_cue_cmd(":CLE");
     }
   }
@@ -123,31 +119,20 @@ void UI_Mainwindow::adjdial_timer_handler()
 
 void UI_Mainwindow::scrn_timer_handler()
 {
-  if(pthread_mutex_trylock(&devparms.mutexx))
-  {
-    return;
-  }
-
   scrn_thread->set_params(&devparms);
-
-  scrn_thread->start();
 }
 
 
 void UI_Mainwindow::horPosDial_timer_handler()
 {
-  char str[512];
-
   if(devparms.timebasedelayenable)
   {
-    snprintf(str, 512, ":TIM:DEL:OFFS %e", devparms.timebasedelayoffset);
+    set_cue_cmd(TMC_OP_TIM_DEL_OFFS, 0, devparms.timebasedelayoffset);
   }
   else
   {
-    snprintf(str, 512, ":TIM:OFFS %e", devparms.timebaseoffset);
+    set_cue_cmd(TMC_OP_TIM_OFFS, 0, devparms.timebaseoffset);
   }
-
-  set_cue_cmd(str);
 }
 
 
@@ -155,8 +140,6 @@ void UI_Mainwindow::trigAdjDial_timer_handler()
 {
   int chn;
 
-  char str[512];
-
   chn = devparms.triggeredgesource;
 
   if((chn < 0) || (chn > 3))
@@ -164,9 +147,7 @@ void UI_Mainwindow::trigAdjDial_timer_handler()
     return;
   }
 
-  snprintf(str, 512, ":TRIGger:EDGE:LEVel %e", devparms.triggeredgelevel[chn]);
-
-  set_cue_cmd(str);
+  set_cue_cmd(TMC_OP_TRIG_EDGE_LEV, chn, devparms.triggeredgelevel[chn]);
 }
 
 
@@ -174,8 +155,6 @@ void UI_Mainwindow::vertOffsDial_timer_handler()
 {
   int chn;
 
-  char str[512];
-
   if(devparms.activechannel < 0)
   {
     return;
@@ -183,26 +162,20 @@ void UI_Mainwindow::vertOffsDial_timer_handler()
 
   chn = devparms.activechannel;
 
-  snprintf(str, 512, ":CHAN%i:OFFS %e", chn + 1, devparms.chanoffset[chn]);
-
-  set_cue_cmd(str);
+  set_cue_cmd(TMC_OP_CHAN_OFFS, chn, devparms.chanoffset[chn]);
 }
 
 
 void UI_Mainwindow::horScaleDial_timer_handler()
 {
-  char str[512];
-
   if(devparms.timebasedelayenable)
   {
-    snprintf(str, 512, ":TIM:DEL:SCAL %e", devparms.timebasedelayscale);
+    set_cue_cmd(TMC_OP_TIM_DEL_SCAL, 0, devparms.timebasedelayscale);
   }
   else
   {
-    snprintf(str, 512, ":TIM:SCAL %e", devparms.timebasescale);
+    set_cue_cmd(TMC_OP_TIM_SCAL, 0, devparms.timebasescale);
   }
-
-  set_cue_cmd(str);
 }
 
 
@@ -210,8 +183,6 @@ void UI_Mainwindow::vertScaleDial_timer_handler()
 {
   int chn;
 
-  char str[512];
-
   if(devparms.activechannel < 0)
   {
     return;
@@ -219,9 +190,7 @@ void UI_Mainwindow::vertScaleDial_timer_handler()
 
   chn = devparms.activechannel;
 
-  snprintf(str, 512, ":CHAN%i:SCAL %e", chn + 1, devparms.chanscale[chn]);
-
-  set_cue_cmd(str);
+  set_cue_cmd(TMC_OP_CHAN_SCAL, chn, devparms.chanscale[chn]);
 }
 
 
@@ -32,6 +32,7 @@
 #include <unistd.h>
 #include <stdio.h>
 #include <errno.h>
+#include <time.h>
 
 #include "tmc_dev.h"
 #include "utils.h"
@@ -42,7 +43,6 @@
 #include <tmc.h>
 #endif
 
-#define MAX_CMD_LEN     (255)
 #define MAX_RESP_LEN    (1024 * 1024 * 2)
 
 
@@ -68,6 +68,8 @@ struct tmcdev * tmcdev_open(const char *device)
 
   dev->buf = dev->hdrbuf;
 
+  dev->type = TMC_TYPE_USB;
+
   dev->fd = open(device, O_RDWR);
 
   if(dev->fd == -1)
@@ -98,112 +100,25 @@ void tmcdev_close(struct tmcdev *dev)
 }
 
 
-int tmcdev_write(struct tmcdev *dev, const char *cmd)
+int tmcdev_send(struct tmcdev *dev, const char *str)
 {
-  int i, n, len, qry=0;
-
-  char buf[MAX_CMD_LEN + 16],
-       str[256];
-
   if(dev == NULL)
   {
     return -1;
   }
 
-  len = strlen(cmd);
-
-  if(len > MAX_CMD_LEN)
-  {
-    printf("tmcdev error: command too long\n");
-
-    return -1;
-  }
-
-  if(len < 2)
-  {
-    printf("tmcdev error: command too short\n");
-
-    return -1;
-  }
-
-  if(cmd[len - 1] == '?')
-  {
-    qry = 1;
-  }
-
-  strlcpy(buf, cmd, MAX_CMD_LEN + 16);
-
-  strlcat(buf, "\n", MAX_CMD_LEN + 16);
-
-  if(!(!strncmp(buf, ":TRIG:STAT?", 11) ||  /* don't print these commands to the console */
-       !strncmp(buf, ":TRIG:SWE?", 10) ||   /* because they are used repeatedly */
-       !strncmp(buf, ":WAV:DATA?", 10) ||
-       !strncmp(buf, ":WAV:MODE NORM", 14) ||
-       !strncmp(buf, ":WAV:FORM BYTE", 14) ||
-       !strncmp(buf, ":WAV:SOUR CHAN", 14) ||
-       !strncmp(buf, ":TRIG:SWE?", 10) ||
-       !strncmp(buf, ":ACQ:SRAT?", 10) ||
-       !strncmp(buf, ":ACQ:MDEP?", 10) ||
-       !strncmp(buf, ":MEAS:COUN:VAL?", 15) ||
-       !strncmp(buf, ":FUNC:WREC:OPER?", 16) ||
-       !strncmp(buf, ":FUNC:WREP:OPER?", 16) ||
-       !strncmp(buf, ":FUNC:WREP:FMAX?", 16) ||
-       !strncmp(buf, ":FUNC:WREC:FMAX?", 16) ||
-       !strncmp(buf, ":FUNC:WREP:FCUR?", 16) ||
-       !strncmp(buf, ":WAV:XOR?", 9)))
-  {
-    printf("tmc_dev write: %s", buf);
-  }
-
-  if((!strncmp(buf, "*RST", 4)) || (!strncmp(buf, ":AUT", 4)))
-  {
-    qry = 1;
-  }
+  return write(dev->fd, str, strlen(str));
+}
 
-  n = write(dev->fd, buf, strlen(buf));
 
-  if(n != (len + 1))
+int tmcdev_recv(struct tmcdev *dev, char *buf, int sz)
+{
+  if(dev == NULL)
   {
-    printf("tmcdev error: device write error");
-
     return -1;
   }
 
-  if(!qry)
-  {
-    for(i=0; i<20; i++)
-    {
-      usleep(25000);
-
-      n = write(dev->fd, "*OPC?\n", 6);
-
-      if(n < 0)
-      {
-        printf("tmcdev error: device write error");
-
-        return -1;
-      }
-
-      n = read(dev->fd, str, 128);
-
-      if(n < 0)
-      {
-        printf("tmcdev error: device read error");
-
-        return -1;
-      }
-
-      if(n == 2)
-      {
-        if(str[0] == '1')
-        {
-          break;
-        }
-      }
-    }
-  }
-
-  return len;
+  return read(dev->fd, buf, sz);
 }
 
 
@@ -231,6 +146,8 @@ int tmcdev_read(struct tmcdev *dev)
 
   dev->hdrbuf[0] = 0;
 
+  dev->buf = dev->hdrbuf;
+
   dev->sz = 0;
 
   size = read(dev->fd, dev->hdrbuf, MAX_RESP_LEN);
@@ -303,3 +220,38 @@ int tmcdev_read(struct tmcdev *dev)
 
   return dev->sz;
 }
+
+
+/*
+ * The usbtmc driver delivers the response in transfer sized chunks,
+ * so the response is read into the internal buffer first and the
+ * payload is copied into the destination buffer afterwards.
+ */
+int tmcdev_read_block(struct tmcdev *dev, char *dest, int destsz,
+                      void (*progress)(int, int, void *), void *progress_data)
+{
+  int n;
+
+  n = tmcdev_read(dev);
+
+  if((n < 0) || (dest == NULL))
+  {
+    return n;
+  }
+
+  if(n > destsz)
+  {
+    return -3;
+  }
+
+  memcpy(dest, dev->buf, n);
+
+  dev->buf = dest;
+
+  if(progress != NULL)
+  {
+    progress(n, n, progress_data);
+  }
+
+  return n;
+}
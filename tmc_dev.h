@@ -30,25 +30,58 @@
 #define TMC_DEV_H
 
 
+#include <stdio.h>
+
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
 
+#define TMC_TYPE_USB  (0)
+#define TMC_TYPE_LAN  (1)
+#define TMC_TYPE_REPLAY  (2)  /* serves the responses from a recorded trace file */
+
+#define TMC_OPC_WAIT  (0)  /* confirm the command(s) with a trailing *OPC? */
+#define TMC_OPC_NONE  (1)  /* fire and forget, don't wait for completion */
+
+#define TMC_SHADOW_CNT      (3)   /* :WAV:SOUR, :WAV:FORM and :WAV:MODE */
+#define TMC_SHADOW_VAL_LEN  (16)
+
+
 struct tmcdev
 {
-  int fd;
+  int type;  /* TMC_TYPE_USB, TMC_TYPE_LAN or TMC_TYPE_REPLAY */
+  int fd;    /* usbtmc device file or TCP socket */
   char *hdrbuf;
   char *buf;
   int sz;
+  int cmd_usec;  /* time in microseconds the device needed to complete the last write */
+  FILE *trace;  /* trace file being recorded, or the trace file being replayed */
+  long long trace_t0;  /* start of the recording, or position of the first record when replaying */
+  int trace_realtime;  /* replay: reproduce the recorded timing */
+  long long trace_t_base;     /* replay: monotonic time of the start of the recording */
+  long long trace_usec_last;  /* replay: recorded start of the last replayed call, -1 before the first one */
+  char shadow[TMC_SHADOW_CNT][TMC_SHADOW_VAL_LEN];  /* last value set, empty when unknown */
+  int pace_usec;        /* gap between the end of an exchange and the next command, 0 is no pacing */
+  int pace_floor_usec;  /* smaller gaps caused errors in this session */
+  int pace_ok_cnt;      /* error free exchanges since the gap was changed */
+  int pace_err_cnt;     /* failed exchanges in this session */
+  int pace_lat_usec;    /* average response time of a read */
+  long long pace_t_last;  /* end of the last exchange */
 };
 
 
 struct tmcdev * tmcdev_open(const char *);
 void tmcdev_close(struct tmcdev *);
-int tmcdev_write(struct tmcdev *, const char *);
+/* writes a string as is, returns the number of bytes written or -1 in case of an error */
+int tmcdev_send(struct tmcdev *, const char *);
+/* one read from the device, returns the number of bytes received or -1 in case of an error */
+int tmcdev_recv(struct tmcdev *, char *, int);
 int tmcdev_read(struct tmcdev *);
+/* reads a response, the payload of a blockheader response is stored in the destination buffer */
+/* the callback (if not NULL) is called with the number of payload bytes received so far and the total size */
+int tmcdev_read_block(struct tmcdev *, char *, int, void (*)(int, int, void *), void *);
 
 
 #ifdef __cplusplus
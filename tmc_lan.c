@@ -54,22 +54,30 @@
 
 #define TMC_TCP_PORT   (5555)
 
-#define MAX_CMD_LEN     (255)
 #define MAX_RESP_LEN    (1024 * 1024 * 2)
 
 
-int sockfd;
+#define TMC_RECV_CHUNK_SZ  (256 * 1024)
 
-struct sockaddr_in inet_address;
 
-struct timeval timeout;
+/*
+ * All connection state lives in struct tmcdev, there are no globals,
+ * so several instruments can be driven at the same time,
+ * each connection from its own thread.
+ */
 
-fd_set tcp_fds;  /* filedescriptor pool */
 
+static void tmclan_init_select(struct tmcdev *tmc_device, fd_set *tcp_fds, struct timeval *tv_timeout)
+{
+  FD_ZERO(tcp_fds);                   /* clear file descriptor pool     */
+  FD_SET(tmc_device->fd, tcp_fds);    /* add our filedescriptor to pool */
 
+  tv_timeout->tv_sec = TMC_LAN_TIMEOUT;
+  tv_timeout->tv_usec = 0;
+}
 
 
-static int tmclan_send(const char *str)
+int tmclan_send(struct tmcdev *tmc_device, const char *str)
 {
   int len;
 
@@ -77,17 +85,15 @@ static int tmclan_send(const char *str)
 
   struct timeval temp_timeout;
 
-  memcpy(&temp_tcp_fds, &tcp_fds, sizeof(fd_set));  /* because select overwrites the arguments */
-
-  memcpy(&temp_timeout, &timeout, sizeof(struct timeval));
+  tmclan_init_select(tmc_device, &temp_tcp_fds, &temp_timeout);  /* because select overwrites the arguments */
 
   len = strlen(str);
 
-  if(select(sockfd + 1, 0, &temp_tcp_fds, 0, &temp_timeout) != -1)
+  if(select(tmc_device->fd + 1, 0, &temp_tcp_fds, 0, &temp_timeout) != -1)
   {
-    if(FD_ISSET(sockfd, &temp_tcp_fds))  /* check if our file descriptor is set */
+    if(FD_ISSET(tmc_device->fd, &temp_tcp_fds))  /* check if our file descriptor is set */
     {
-      len = send(sockfd, str, len, MSG_NOSIGNAL);
+      len = send(tmc_device->fd, str, len, MSG_NOSIGNAL);
       if(len == -1)
       {
         perror("*** error *** send()");
@@ -105,21 +111,40 @@ static int tmclan_send(const char *str)
 }
 
 
-static int tmclan_recv(char *buf, int sz)
+int tmclan_recv(struct tmcdev *tmc_device, char *buf, int sz)
 {
   fd_set temp_tcp_fds;
 
   struct timeval temp_timeout;
 
-  memcpy(&temp_tcp_fds, &tcp_fds, sizeof(fd_set));  /* because select overwrites the arguments */
+  tmclan_init_select(tmc_device, &temp_tcp_fds, &temp_timeout);  /* because select overwrites the arguments */
 
-  memcpy(&temp_timeout, &timeout, sizeof(struct timeval));
+  if(select(tmc_device->fd + 1, &temp_tcp_fds, 0, 0, &temp_timeout) != -1)
+  {
+    if(FD_ISSET(tmc_device->fd, &temp_tcp_fds))  /* check if our file descriptor is set */
+    {
+      return recv(tmc_device->fd, buf, sz, MSG_NOSIGNAL);
+    }
+  }
 
-  if(select(sockfd + 1, &temp_tcp_fds, 0, 0, &temp_timeout) != -1)
+  return -1;
+}
+
+
+/* blocks until sz bytes are received, a timeout or an error occurs */
+static int tmclan_recv_all(struct tmcdev *tmc_device, char *buf, int sz)
+{
+  fd_set temp_tcp_fds;
+
+  struct timeval temp_timeout;
+
+  tmclan_init_select(tmc_device, &temp_tcp_fds, &temp_timeout);  /* because select overwrites the arguments */
+
+  if(select(tmc_device->fd + 1, &temp_tcp_fds, 0, 0, &temp_timeout) != -1)
   {
-    if(FD_ISSET(sockfd, &temp_tcp_fds))  /* check if our file descriptor is set */
+    if(FD_ISSET(tmc_device->fd, &temp_tcp_fds))  /* check if our file descriptor is set */
     {
-      return recv(sockfd, buf, sz, MSG_NOSIGNAL);
+      return recv(tmc_device->fd, buf, sz, MSG_WAITALL | MSG_NOSIGNAL);  /* SO_RCVTIMEO limits the wait */
     }
   }
 
@@ -129,10 +154,14 @@ static int tmclan_recv(char *buf, int sz)
 
 struct tmcdev * tmclan_open(const char *host_or_ip)
 {
+  int sockfd;
+
   char ip_address[256]={""};
 
   struct tmcdev *tmc_device;
 
+  struct sockaddr_in inet_address;
+
   struct addrinfo *addr_result, *res;
 
   struct sockaddr_in *ipv4_addr;
@@ -183,26 +212,34 @@ struct tmcdev * tmclan_open(const char *host_or_ip)
 
   if(setsockopt(sockfd, IPPROTO_TCP, TCP_NODELAY, (void *)&tcp_nodelay, sizeof tcp_nodelay) == -1)
   {
+    close(sockfd);
     return NULL;
   }
 
-  FD_ZERO(&tcp_fds);         /* clear file descriptor pool     */
-  FD_SET(sockfd, &tcp_fds);  /* add our filedescriptor to pool */
+  struct timeval rcv_timeout;  /* used by the blocking MSG_WAITALL receives */
+
+  rcv_timeout.tv_sec = TMC_LAN_TIMEOUT;
+  rcv_timeout.tv_usec = 0;
 
-  timeout.tv_sec = TMC_LAN_TIMEOUT;
-  timeout.tv_usec = 0;
+  if(setsockopt(sockfd, SOL_SOCKET, SO_RCVTIMEO, (void *)&rcv_timeout, sizeof rcv_timeout) == -1)
+  {
+    close(sockfd);
+    return NULL;
+  }
 
   memset(&inet_address, 0, sizeof(struct sockaddr_in));
 
   inet_address.sin_family = AF_INET;
   if(inet_aton(ip_address, &inet_address.sin_addr) == 0)
   {
+    close(sockfd);
     return NULL;
   }
   inet_address.sin_port = htons(TMC_TCP_PORT);
 
   if(connect(sockfd, (struct sockaddr *) &inet_address, sizeof(struct sockaddr)) < 0)
   {
+    close(sockfd);
     return NULL;
   }
 
@@ -226,20 +263,24 @@ struct tmcdev * tmclan_open(const char *host_or_ip)
 
   tmc_device->buf = tmc_device->hdrbuf;
 
+  tmc_device->fd = sockfd;
+
+  tmc_device->type = TMC_TYPE_LAN;
+
   return tmc_device;
 }
 
 
 void tmclan_close(struct tmcdev *tmc_device)
 {
-  if(sockfd != -1)
-  {
-    close(sockfd);
-    sockfd = -1;
-  }
-
   if(tmc_device != NULL)
   {
+    if(tmc_device->fd != -1)
+    {
+      close(tmc_device->fd);
+      tmc_device->fd = -1;
+    }
+
     free(tmc_device->hdrbuf);
 
     free(tmc_device);
@@ -249,142 +290,117 @@ void tmclan_close(struct tmcdev *tmc_device)
 }
 
 
-int tmclan_write(struct tmcdev *tmc_device __attribute__ ((unused)), const char *cmd)
+/*
+ * TMC Blockheader ::= #NXXXXXX: is used to describe
+ * the length of the data stream, wherein, # is the start denoter of
+ * the data stream; N is less than or equal to 9; the N figures
+ * followed N represents the length of the data stream in bytes.
+ * For example, #9001152054. Wherein, N is 9 and 001152054
+ * represents that the data stream contains 1152054 bytes
+ * effective data.
+ */
+int tmclan_read(struct tmcdev *tmc_device)
 {
-  int i, n, len, qry=0;
+  return tmclan_read_block(tmc_device, NULL, 0, NULL, NULL);
+}
 
-  char buf[MAX_CMD_LEN + 16],
-       str[256];
 
-  if(sockfd == -1)
-  {
-    return -1;
-  }
+/*
+ * Length-driven reader. The blockheader is decoded from the first bytes,
+ * after that exactly the remaining payload is received, straight into dest.
+ * Binary data that contains 0x0A does not end the transfer prematurely.
+ * If dest is NULL, the payload is received into the internal buffer.
+ * progress (if not NULL) is called after every chunk with the number of
+ * payload bytes received so far and the total payload size.
+ * After return, tmc_device->buf points to the payload.
+ */
+int tmclan_read_block(struct tmcdev *tmc_device, char *dest, int destsz,
+                      void (*progress)(int, int, void *), void *progress_data)
+{
+  int n, size, size2, len, got, chunk, term=0;
 
-  len = strlen(cmd);
+  char blockhdr[32],
+       *target,
+       trail[8];
 
-  if(len > MAX_CMD_LEN)
+  if((tmc_device == NULL) || (tmc_device->fd == -1))
   {
-    printf("tmc_lan error: command too long\n");
-
     return -1;
   }
 
-  if(len < 2)
-  {
-    printf("tmc_lan error: command too short\n");
+  tmc_device->hdrbuf[0] = 0;
 
-    return -1;
-  }
+  tmc_device->buf = tmc_device->hdrbuf;
 
-  if(cmd[len - 1] == '?')
-  {
-    qry = 1;
-  }
+  tmc_device->sz = 0;
 
-  strlcpy(buf, cmd, MAX_CMD_LEN + 16);
-
-  strlcat(buf, "\n", MAX_CMD_LEN + 16);
-
-  if(!(!strncmp(buf, ":TRIG:STAT?", 11) ||  /* don't print these commands to the console */
-      !strncmp(buf, ":TRIG:SWE?", 10) ||    /* because they are used repeatedly */
-      !strncmp(buf, ":WAV:DATA?", 10) ||
-      !strncmp(buf, ":WAV:MODE NORM", 14) ||
-      !strncmp(buf, ":WAV:FORM BYTE", 14) ||
-      !strncmp(buf, ":WAV:SOUR CHAN", 14) ||
-      !strncmp(buf, ":TRIG:SWE?", 10) ||
-      !strncmp(buf, ":ACQ:SRAT?", 10) ||
-      !strncmp(buf, ":ACQ:MDEP?", 10) ||
-      !strncmp(buf, ":MEAS:COUN:VAL?", 15) ||
-      !strncmp(buf, ":FUNC:WREC:OPER?", 16) ||
-      !strncmp(buf, ":FUNC:WREP:OPER?", 16) ||
-      !strncmp(buf, ":FUNC:WREP:FMAX?", 16) ||
-      !strncmp(buf, ":FUNC:WREC:FMAX?", 16) ||
-      !strncmp(buf, ":FUNC:WREP:FCUR?", 16) ||
-      !strncmp(buf, ":WAV:XOR?", 9)))
-  {
-    printf("tmc_lan write: %s", buf);
-  }
+  /* when the payload goes to a separate destination, read "#N" first and then */
+  /* exactly N digits, so that no payload (or what follows it) is staged */
+  n = tmclan_recv(tmc_device, tmc_device->hdrbuf, (dest != NULL) ? 2 : MAX_RESP_LEN);
 
-  if((!strncmp(buf, "*RST", 4)) || (!strncmp(buf, ":AUT", 4)))
+  if(n < 1)
   {
-    qry = 1;
+    return -2;
   }
 
-  n = tmclan_send(buf);
-
-  if(n != (len + 1))
-  {
-    printf("tmclan error: device write error");
-
-    return -1;
-  }
+  size = n;
 
-  if(!qry)
+  /* a plain response can be a single newline, only a blockheader needs two bytes */
+  if(tmc_device->hdrbuf[0] != '#')
   {
-    for(i=0; i<20; i++)
+    while(tmc_device->hdrbuf[size - 1] != '\n')
     {
-      usleep(25000);
+      n = tmclan_recv(tmc_device, tmc_device->hdrbuf + size, MAX_RESP_LEN - size);
 
-      if(tmclan_send("*OPC?\n") != 6)
+      if(n < 1)
       {
-        printf("tmclan error: device write error");
-
-        return -1;
+        return -2;
       }
 
-      n = tmclan_recv(str, 128);
+      size += n;
 
-      if(n < 0)
+      if(size >= MAX_RESP_LEN)
       {
-        printf("tmclan error: device read error");
+        tmc_device->hdrbuf[0] = 0;
 
-        return -1;
+        return -3;
       }
+    }
 
-      if(n == 2)
-      {
-        if(str[0] == '1')
-        {
-          break;
-        }
-      }
+    tmc_device->hdrbuf[size] = 0;
+
+    if(tmc_device->hdrbuf[size - 1] == '\n')
+    {
+      tmc_device->hdrbuf[--size] = 0;
     }
+
+    tmc_device->sz = size;
+
+    return tmc_device->sz;
   }
 
-  return len;
-}
+  while(size < 2)
+  {
+    n = tmclan_recv(tmc_device, tmc_device->hdrbuf + size, (dest != NULL) ? (2 - size) : (MAX_RESP_LEN - size));
 
+    if(n < 1)
+    {
+      return -2;
+    }
 
-/*
- * TMC Blockheader ::= #NXXXXXX: is used to describe
- * the length of the data stream, wherein, # is the start denoter of
- * the data stream; N is less than or equal to 9; the N figures
- * followed N represents the length of the data stream in bytes.
- * For example, #9001152054. Wherein, N is 9 and 001152054
- * represents that the data stream contains 1152054 bytes
- * effective data.
- */
-int tmclan_read(struct tmcdev *tmc_device)
-{
-  int n, size, size2, len;
+    size += n;
+  }
 
-  char blockhdr[32];
+  len = tmc_device->hdrbuf[1] - '0';
 
-  if(sockfd == -1)
+  if((len < 1) || (len > 9))
   {
     return -1;
   }
 
-  tmc_device->hdrbuf[0] = 0;
-
-  tmc_device->sz = 0;
-
-  size = 0;
-
-  while(1)
+  while(size < (len + 2))
   {
-    n = tmclan_recv(tmc_device->hdrbuf + size, MAX_RESP_LEN - size);
+    n = tmclan_recv(tmc_device, tmc_device->hdrbuf + size, (dest != NULL) ? (len + 2 - size) : (MAX_RESP_LEN - size));
 
     if(n < 1)
     {
@@ -392,63 +408,83 @@ int tmclan_read(struct tmcdev *tmc_device)
     }
 
     size += n;
-
-    if(tmc_device->hdrbuf[size - 1] == '\n')
-    {
-      break;
-    }
   }
 
-  if((size < 2) || (size > MAX_RESP_LEN))
-  {
-    tmc_device->hdrbuf[0] = 0;
-
-    tmc_device->buf[0] = 0;
+  memcpy(blockhdr, tmc_device->hdrbuf, len + 2);
 
-    return -3;
-  }
+  blockhdr[len + 2] = 0;
 
-  tmc_device->hdrbuf[size] = 0;
+  size2 = atoi(blockhdr + 2);
 
-  if(tmc_device->hdrbuf[0] != '#')
+  if(dest != NULL)
   {
-    if(tmc_device->hdrbuf[size - 1] == '\n')
+    if(size2 > destsz)
     {
-      tmc_device->hdrbuf[--size] = 0;
+      return -3;
     }
 
-    tmc_device->buf = tmc_device->hdrbuf;
-
-    tmc_device->sz = size;
+    target = dest;
 
-    return tmc_device->sz;
+    /* only the header was received */
+    got = 0;
   }
+  else
+  {
+    if(size2 > (MAX_RESP_LEN - len - 2))
+    {
+      return -3;
+    }
 
-  strncpy(blockhdr, tmc_device->hdrbuf, 16);
+    target = tmc_device->hdrbuf + len + 2;
 
-  len = blockhdr[1] - '0';
+    got = size - len - 2;
 
-  if((len < 1) || (len > 9))
-  {
-    blockhdr[31] = 0;
+    if(got > size2)
+    {
+      term = 1;
 
-    return -1;
+      got = size2;
+    }
   }
 
-  blockhdr[len + 2] = 0;
+  while(got < size2)
+  {
+    chunk = size2 - got;
 
-  size2 = atoi(blockhdr + 2);
+    if(chunk > TMC_RECV_CHUNK_SZ)
+    {
+      chunk = TMC_RECV_CHUNK_SZ;
+    }
+
+    n = tmclan_recv_all(tmc_device, target + got, chunk);
+
+    if(n < 1)
+    {
+      return -2;
+    }
+
+    got += n;
 
-  size--;  // remove the last character
+    if(progress != NULL)
+    {
+      progress(got, size2, progress_data);
+    }
+  }
 
-  if(size < size2)
+  if(!term)  /* consume the terminating newline */
   {
-    blockhdr[31] = 0;
+    if(tmclan_recv(tmc_device, trail, 1) != 1)
+    {
+      return -2;
+    }
+  }
 
-    return -1;
+  if(dest == NULL)
+  {
+    target[size2] = 0;
   }
 
-  tmc_device->buf = tmc_device->hdrbuf + len + 2;
+  tmc_device->buf = target;
 
   tmc_device->sz = size2;
 
@@ -466,4 +502,3 @@ int tmclan_read(struct tmcdev *tmc_device)
 
 
 
-
@@ -37,8 +37,10 @@ extern "C" {
 
 struct tmcdev * tmclan_open(const char *);
 void tmclan_close(struct tmcdev *);
-int tmclan_write(struct tmcdev *, const char *);
+int tmclan_send(struct tmcdev *, const char *);
+int tmclan_recv(struct tmcdev *, char *, int);
 int tmclan_read(struct tmcdev *);
+int tmclan_read_block(struct tmcdev *, char *, int, void (*)(int, int, void *), void *);
 
 
 #ifdef __cplusplus
@@ -0,0 +1,560 @@
+/*
+***************************************************************************
+*
+* Author: Teunis van Beelen
+*
+* Copyright (C) 2015 - 2024 Teunis van Beelen
+*
+* Email: teuniz@protonmail.com
+*
+***************************************************************************
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+***************************************************************************
+*/
+
+
+
+
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "trace_raster.h"
+#include "sample_conv.h"
+
+
+#define TRAST_FRAC  (16)  /* fractional bits of the line stepping */
+
+#define TRAST_FILL_MIN  (16)  /* shorter spans are filled inline, the call of the kernel costs more */
+
+
+
+/* x * a / 255 for the four bytes of x, two bytes per multiplication */
+static inline unsigned int trast_byte_mul(unsigned int x, unsigned int a)
+{
+  unsigned int rb, ag;
+
+  rb = ((x & 0x00ff00ff) * a) + 0x00800080;
+  rb = ((rb + ((rb >> 8) & 0x00ff00ff)) >> 8) & 0x00ff00ff;
+
+  ag = (((x >> 8) & 0x00ff00ff) * a) + 0x00800080;
+  ag = (ag + ((ag >> 8) & 0x00ff00ff)) & 0xff00ff00;
+
+  return rb | ag;
+}
+
+
+static void trast_touch(struct trast_layer *ly, int y1, int y2)
+{
+  if(y1 < 0)
+  {
+    y1 = 0;
+  }
+
+  if(y2 >= ly->h)
+  {
+    y2 = ly->h - 1;
+  }
+
+  if(y1 > y2)
+  {
+    return;
+  }
+
+  if(y1 < ly->y_lo)
+  {
+    ly->y_lo = y1;
+  }
+
+  if(y2 > ly->y_hi)
+  {
+    ly->y_hi = y2;
+  }
+}
+
+
+/* the rectangle x1 - x2, y1 - y2, edges included, the rows must have been touched */
+static void trast_rect(struct trast_layer *ly, int x1, int y1, int x2, int y2, unsigned int color)
+{
+  int x, y, w;
+
+  unsigned int *p;
+
+  w = ly->w;
+
+  if(x1 < 0)
+  {
+    x1 = 0;
+  }
+
+  if(x2 >= w)
+  {
+    x2 = w - 1;
+  }
+
+  if(y1 < 0)
+  {
+    y1 = 0;
+  }
+
+  if(y2 >= ly->h)
+  {
+    y2 = ly->h - 1;
+  }
+
+  if((x1 > x2) || (y1 > y2))
+  {
+    return;
+  }
+
+  if((x2 - x1) >= TRAST_FILL_MIN)
+  {
+    for(y=y1; y<=y2; y++)
+    {
+      sconv_fill_u32(ly->px + (y * w) + x1, x2 - x1 + 1, color);
+    }
+
+    return;
+  }
+
+  for(y=y1; y<=y2; y++)
+  {
+    p = ly->px + (y * w);
+
+    for(x=x1; x<=x2; x++)
+    {
+      p[x] = color;
+    }
+  }
+}
+
+
+/* one pixel, pw pixels wide */
+static inline void trast_plot(struct trast_layer *ly, int x, int y, int pw, unsigned int color)
+{
+  if(pw == 1)
+  {
+    if(((unsigned int)x < (unsigned int)ly->w) && ((unsigned int)y < (unsigned int)ly->h))
+    {
+      ly->px[(y * ly->w) + x] = color;
+    }
+
+    return;
+  }
+
+  trast_rect(ly, x - (pw / 2), y - (pw / 2), x - (pw / 2) + pw - 1, y - (pw / 2) + pw - 1, color);
+}
+
+
+/* one pixel with a coverage of a / 255, source over */
+static inline void trast_blend(struct trast_layer *ly, int x, int y, unsigned int color, unsigned int a)
+{
+  unsigned int *p;
+
+  if((!a) || ((unsigned int)x >= (unsigned int)ly->w) || ((unsigned int)y >= (unsigned int)ly->h))
+  {
+    return;
+  }
+
+  if(a < 255)
+  {
+    color = trast_byte_mul(color, a);
+  }
+
+  p = ly->px + (y * ly->w) + x;
+
+  *p = color + trast_byte_mul(*p, 255 - (color >> 24));
+}
+
+
+/* a line from a to b, both ends included, with square caps */
+static void trast_line(struct trast_layer *ly, int xa, int ya, int xb, int yb, int pw, int aa, unsigned int color)
+{
+  int x, y, lo, hi, hw, tmp;
+
+  long long d, f;
+
+  hw = pw / 2;
+
+  if((ya == yb) || (xa == xb))
+  {
+    if(xa > xb)
+    {
+      tmp = xa;
+      xa = xb;
+      xb = tmp;
+    }
+
+    if(ya > yb)
+    {
+      tmp = ya;
+      ya = yb;
+      yb = tmp;
+    }
+
+    trast_touch(ly, ya - hw, yb - hw + pw - 1);
+
+    trast_rect(ly, xa - hw, ya - hw, xb - hw + pw - 1, yb - hw + pw - 1, color);
+
+    return;
+  }
+
+  /* nothing to draw when both ends lie on the same side outside the layer */
+  if(((xa < -pw) && (xb < -pw)) || ((xa >= (ly->w + pw)) && (xb >= (ly->w + pw))) ||
+     ((ya < -pw) && (yb < -pw)) || ((ya >= (ly->h + pw)) && (yb >= (ly->h + pw))))
+  {
+    return;
+  }
+
+  if(ya < yb)
+  {
+    trast_touch(ly, ya - hw, yb - hw + pw);
+  }
+  else
+  {
+    trast_touch(ly, yb - hw, ya - hw + pw);
+  }
+
+  if(pw > 1)
+  {
+    aa = 0;
+  }
+
+  if(abs(xb - xa) >= abs(yb - ya))
+  {
+    if(xa > xb)
+    {
+      tmp = xa;
+      xa = xb;
+      xb = tmp;
+
+      tmp = ya;
+      ya = yb;
+      yb = tmp;
+    }
+
+    d = ((long long)(yb - ya) << TRAST_FRAC) / (xb - xa);
+
+    /* the columns outside the layer are skipped, the stepping starts at the first visible one */
+    lo = (xa < -pw) ? -pw : xa;
+
+    hi = (xb > (ly->w + pw)) ? (ly->w + pw) : xb;
+
+    f = ((long long)ya << TRAST_FRAC) + ((lo - xa) * d);
+
+    if(aa)
+    {
+      for(x=lo; x<=hi; x++, f+=d)
+      {
+        y = f >> TRAST_FRAC;
+
+        tmp = (f >> (TRAST_FRAC - 8)) & 255;
+
+        trast_blend(ly, x, y, color, 255 - tmp);
+
+        trast_blend(ly, x, y + 1, color, tmp);
+      }
+    }
+    else
+    {
+      f += 1 << (TRAST_FRAC - 1);
+
+      for(x=lo; x<=hi; x++, f+=d)
+      {
+        trast_plot(ly, x, f >> TRAST_FRAC, pw, color);
+      }
+    }
+  }
+  else
+  {
+    if(ya > yb)
+    {
+      tmp = xa;
+      xa = xb;
+      xb = tmp;
+
+      tmp = ya;
+      ya = yb;
+      yb = tmp;
+    }
+
+    d = ((long long)(xb - xa) << TRAST_FRAC) / (yb - ya);
+
+    lo = (ya < -pw) ? -pw : ya;
+
+    hi = (yb > (ly->h + pw)) ? (ly->h + pw) : yb;
+
+    f = ((long long)xa << TRAST_FRAC) + ((lo - ya) * d);
+
+    if(aa)
+    {
+      for(y=lo; y<=hi; y++, f+=d)
+      {
+        x = f >> TRAST_FRAC;
+
+        tmp = (f >> (TRAST_FRAC - 8)) & 255;
+
+        trast_blend(ly, x, y, color, 255 - tmp);
+
+        trast_blend(ly, x + 1, y, color, tmp);
+      }
+    }
+    else
+    {
+      f += 1 << (TRAST_FRAC - 1);
+
+      for(y=lo; y<=hi; y++, f+=d)
+      {
+        trast_plot(ly, f >> TRAST_FRAC, y, pw, color);
+      }
+    }
+  }
+}
+
+
+void trast_init(struct trast_layer *ly)
+{
+  memset(ly, 0, sizeof(struct trast_layer));
+
+  ly->y_lo = 0;
+  ly->y_hi = -1;
+}
+
+
+void trast_free(struct trast_layer *ly)
+{
+  free(ly->px);
+
+  trast_init(ly);
+}
+
+
+int trast_resize(struct trast_layer *ly, int w, int h)
+{
+  unsigned int *p;
+
+  if((w < 1) || (h < 1))
+  {
+    return -1;
+  }
+
+  if((w * h) > ly->sz)
+  {
+    p = (unsigned int *)realloc(ly->px, w * h * sizeof(unsigned int));
+    if(p == NULL)
+    {
+      ly->w = 0;
+      ly->h = 0;
+
+      return -1;
+    }
+
+    ly->px = p;
+
+    ly->sz = w * h;
+  }
+
+  if((w != ly->w) || (h != ly->h))
+  {
+    ly->w = w;
+    ly->h = h;
+
+    memset(ly->px, 0, w * h * sizeof(unsigned int));
+
+    ly->y_lo = h;
+    ly->y_hi = -1;
+  }
+
+  return 0;
+}
+
+
+void trast_clear(struct trast_layer *ly)
+{
+  if(ly->y_lo <= ly->y_hi)
+  {
+    memset(ly->px + (ly->y_lo * ly->w), 0, (ly->y_hi - ly->y_lo + 1) * ly->w * sizeof(unsigned int));
+  }
+
+  ly->y_lo = ly->h;
+  ly->y_hi = -1;
+}
+
+
+void trast_draw(struct trast_layer *ly, const struct trast_trace *tr)
+{
+  int i, x, y, x_prev=0, y_prev=0, pw, col, col_valid, s_min=0, s_max=0;
+
+  const short *buf;
+
+  if((ly->px == NULL) || (!ly->w) || (tr->n < 1))
+  {
+    return;
+  }
+
+  pw = (tr->width > 1) ? tr->width : 1;
+
+  buf = tr->buf;
+
+  if(tr->style == TRAST_SPANS)
+  {
+    for(i=0; i<tr->n; i++)
+    {
+      trast_line(ly, tr->x0 + i, tr->y1[i], tr->x0 + i, tr->y2[i], pw, 0, tr->color);
+    }
+  }
+  else if(tr->style == TRAST_COLUMNS)
+    {
+      col = 0;
+
+      col_valid = 0;
+
+      for(i=0; i<tr->n; i++)
+      {
+        x = (i * tr->x_step) + tr->x_off;
+
+        if((!col_valid) || (x != col))
+        {
+          if(col_valid)
+          {
+            trast_line(ly, col, (s_min * tr->y_step) + tr->y_off, col, (s_max * tr->y_step) + tr->y_off, pw, 0, tr->color);
+          }
+
+          col = x;
+
+          col_valid = 1;
+
+          s_min = buf[i];
+
+          s_max = s_min;
+        }
+        else if(buf[i] < s_min)
+          {
+            s_min = buf[i];
+          }
+          else if(buf[i] > s_max)
+            {
+              s_max = buf[i];
+            }
+      }
+
+      if(col_valid)
+      {
+        trast_line(ly, col, (s_min * tr->y_step) + tr->y_off, col, (s_max * tr->y_step) + tr->y_off, pw, 0, tr->color);
+      }
+    }
+    else if(tr->style == TRAST_STEPS)
+      {
+        for(i=0; i<tr->n; i++)
+        {
+          x = (i * tr->x_step) + tr->x_off;
+
+          y = (buf[i] * tr->y_step) + tr->y_off;
+
+          if(i)
+          {
+            trast_line(ly, x, y_prev, x, y, pw, 0, tr->color);
+          }
+
+          trast_line(ly, x, y, ((i + 1) * tr->x_step) + tr->x_off, y, pw, 0, tr->color);
+
+          y_prev = y;
+        }
+      }
+      else if(tr->style == TRAST_DOTS)
+        {
+          for(i=0; i<tr->n; i++)
+          {
+            x = (i * tr->x_step) + tr->x_off;
+
+            y = (buf[i] * tr->y_step) + tr->y_off;
+
+            trast_touch(ly, y - (pw / 2), y - (pw / 2) + pw - 1);
+
+            trast_plot(ly, x, y, pw, tr->color);
+          }
+        }
+        else
+        {
+          for(i=0; i<tr->n; i++)
+          {
+            x = (i * tr->x_step) + tr->x_off;
+
+            y = (buf[i] * tr->y_step) + tr->y_off;
+
+            if(i)
+            {
+              trast_line(ly, x_prev, y_prev, x, y, pw, tr->aa, tr->color);
+            }
+            else if(tr->n == 1)
+              {
+                trast_line(ly, x, y, x, y, pw, 0, tr->color);
+              }
+
+            x_prev = x;
+
+            y_prev = y;
+          }
+        }
+}
+
+
+void trast_composite(unsigned int *dest, int stride, const struct trast_layer * const *ly, int cnt, int y_first, int y_last)
+{
+  int i, y, w, first;
+
+  unsigned int *d;
+
+  const unsigned int *s;
+
+  if(cnt < 1)
+  {
+    return;
+  }
+
+  w = ly[0]->w;
+
+  for(y=y_first; y<y_last; y++)
+  {
+    d = dest + (y * stride);
+
+    for(i=0, first=1; i<cnt; i++)
+    {
+      if((y < ly[i]->y_lo) || (y > ly[i]->y_hi))
+      {
+        continue;
+      }
+
+      s = ly[i]->px + (y * w);
+
+      if(first)
+      {
+        memcpy(d, s, w * sizeof(unsigned int));
+
+        first = 0;
+
+        continue;
+      }
+
+      sconv_argb_over(d, s, w);
+    }
+
+    if(first)
+    {
+      memset(d, 0, w * sizeof(unsigned int));
+    }
+  }
+}
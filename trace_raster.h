@@ -0,0 +1,109 @@
+/*
+***************************************************************************
+*
+* Author: Teunis van Beelen
+*
+* Copyright (C) 2015 - 2024 Teunis van Beelen
+*
+* Email: teuniz@protonmail.com
+*
+***************************************************************************
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+***************************************************************************
+*/
+
+
+
+
+
+#ifndef TRACE_RASTER_H
+#define TRACE_RASTER_H
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/*
+ * Software rasterizer for the traces. Every trace is drawn into a layer of
+ * its own, an ARGB32 premultiplied buffer that is transparent where nothing
+ * was drawn, so the layers of the channels can be drawn in parallel. The
+ * layers are composited in drawing order at the end. Lines are plain DDA
+ * lines or, with anti-aliasing, Wu lines. Horizontal and vertical lines,
+ * the bulk of a trace, are filled as spans. The span fills and the
+ * compositing use the SSE2/AVX2 kernels of sample_conv.c.
+ */
+
+#define TRAST_STEPS    (0)  /* every sample is a horizontal step, vertical lines join the steps */
+#define TRAST_VECTORS  (1)  /* a line from sample to sample */
+#define TRAST_DOTS     (2)  /* a dot per sample */
+#define TRAST_COLUMNS  (3)  /* many samples per column, a vertical line from the minimum to the maximum */
+#define TRAST_SPANS    (4)  /* the vertical lines y1[i] - y2[i] at x0 + i, prepared by the caller */
+
+
+struct trast_trace
+{
+  const short *buf;     /* samples, not used by TRAST_SPANS */
+  int n;                /* samples or spans */
+  double x_off;         /* x = x_off + (i * x_step), y = y_off + (buf[i] * y_step) */
+  double x_step;
+  double y_off;
+  double y_step;
+  const int *y1;        /* TRAST_SPANS */
+  const int *y2;
+  int x0;
+  int style;
+  unsigned int color;   /* ARGB32, opaque */
+  int width;            /* pen width in pixels, 0 draws one pixel wide like 1 */
+  int aa;               /* anti-aliased sloped lines, only used with a width of one pixel */
+};
+
+
+struct trast_layer
+{
+  unsigned int *px;     /* w * h, line by line */
+  int w;
+  int h;
+  int sz;               /* allocated pixels */
+  int y_lo;             /* lines that were drawn into since the last clear, */
+  int y_hi;             /* the layer is empty when y_lo > y_hi */
+};
+
+
+void trast_init(struct trast_layer *);
+
+void trast_free(struct trast_layer *);
+
+/* sets the size of the layer, it is cleared when the size changes, returns 0 on success */
+int trast_resize(struct trast_layer *, int, int);
+
+/* clears the lines that were drawn into */
+void trast_clear(struct trast_layer *);
+
+/* draws a trace into the layer */
+void trast_draw(struct trast_layer *, const struct trast_trace *);
+
+/* composites the lines [y_first, y_last) of cnt layers of equal size in order, source over,
+   into an ARGB32 premultiplied image, the lines of the image are overwritten, stride is in pixels */
+void trast_composite(unsigned int *, int, const struct trast_layer * const *, int, int, int);
+
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif
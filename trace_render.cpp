@@ -0,0 +1,244 @@
+/*
+***************************************************************************
+*
+* Author: Teunis van Beelen
+*
+* Copyright (C) 2015 - 2024 Teunis van Beelen
+*
+* Email: teuniz@protonmail.com
+*
+***************************************************************************
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+***************************************************************************
+*/
+
+
+
+
+
+#include "trace_render.h"
+
+
+
+// takes work items of the current phase until there are none left
+static void trend_run_items(void *data)
+{
+  int k, y1, y2;
+
+  struct trace_render_job *job = (struct trace_render_job *)data;
+
+  if(job->phase == TREND_PHASE_DRAW)
+  {
+    while((k = job->item_next.fetchAndAddOrdered(1)) < job->cnt)
+    {
+      trast_clear(job->layer[k]);
+
+      trast_draw(job->layer[k], &job->trace[k]);
+    }
+
+    return;
+  }
+
+  while((k = job->item_next.fetchAndAddOrdered(1)) < job->bands)
+  {
+    y1 = job->y_first + (k * TREND_BAND_LINES);
+
+    y2 = y1 + TREND_BAND_LINES;
+    if(y2 > job->y_last)
+    {
+      y2 = job->y_last;
+    }
+
+    trast_composite(job->dest, job->stride, job->layer, job->cnt, y1, y2);
+  }
+}
+
+
+trace_render::trace_render()
+{
+  int i;
+
+  for(i=0; i<MAX_CHNS; i++)
+  {
+    trast_init(&layers[i]);
+
+    job.layer[i] = &layers[i];
+  }
+
+  memset(job.trace, 0, sizeof(job.trace));
+  job.cnt = 0;
+  job.phase = TREND_PHASE_DRAW;
+  job.dest = NULL;
+  job.stride = 0;
+  job.y_first = 0;
+  job.y_last = 0;
+  job.bands = 0;
+
+  y_lo = 0;
+  y_hi = -1;
+}
+
+
+trace_render::~trace_render()
+{
+  int i;
+
+  for(i=0; i<MAX_CHNS; i++)
+  {
+    trast_free(&layers[i]);
+  }
+}
+
+
+// runs a phase of the job on thread_cnt threads of the pool and waits for them
+void trace_render::run_job(int phase, int thread_cnt)
+{
+  job.phase = phase;
+
+  job.item_next.storeRelease(0);
+
+  pool.run(trend_run_items, &job, thread_cnt);
+}
+
+
+int trace_render::render(int w, int h, double ratio, const struct trast_trace *traces, int cnt)
+{
+  int i, samples, cores, y_first, y_last;
+
+  if((w < 1) || (h < 1) || (cnt < 0) || (cnt > MAX_CHNS))
+  {
+    return -1;
+  }
+
+  if((img.width() != w) || (img.height() != h))
+  {
+    img = QImage(w, h, QImage::Format_ARGB32_Premultiplied);
+
+    if(img.isNull())
+    {
+      return -1;
+    }
+
+    img.fill(0);
+
+    y_lo = 0;
+    y_hi = -1;
+  }
+
+#if QT_VERSION >= 0x050600
+  img.setDevicePixelRatio(ratio);
+#else
+  (void)ratio;
+#endif
+
+  for(i=0, samples=0; i<cnt; i++)
+  {
+    if(trast_resize(&layers[i], w, h))
+    {
+      return -1;
+    }
+
+    job.trace[i] = traces[i];
+
+    samples += traces[i].n;
+  }
+
+  job.cnt = cnt;
+
+  cores = QThread::idealThreadCount();
+
+  // one worker per trace
+  run_job(TREND_PHASE_DRAW, (samples >= TREND_MT_MIN_SAMPLES) ? ((cnt < cores) ? cnt : cores) : 1);
+
+  // the lines of the last frame are cleared together with the new ones
+  y_first = y_lo;
+  y_last = y_hi;
+
+  y_lo = h;
+  y_hi = -1;
+
+  for(i=0; i<cnt; i++)
+  {
+    if(layers[i].y_lo < y_lo)
+    {
+      y_lo = layers[i].y_lo;
+    }
+
+    if(layers[i].y_hi > y_hi)
+    {
+      y_hi = layers[i].y_hi;
+    }
+  }
+
+  if(y_first > y_last)
+  {
+    y_first = y_lo;
+    y_last = y_hi;
+  }
+  else if(y_lo <= y_hi)
+    {
+      if(y_lo < y_first)
+      {
+        y_first = y_lo;
+      }
+
+      if(y_hi > y_last)
+      {
+        y_last = y_hi;
+      }
+    }
+
+  if(y_first > y_last)
+  {
+    return 0;
+  }
+
+  if(!cnt)
+  {
+    memset(img.scanLine(y_first), 0, (y_last - y_first + 1) * img.bytesPerLine());
+
+    return 0;
+  }
+
+  job.dest = (unsigned int *)img.bits();
+  job.stride = img.bytesPerLine() / 4;
+  job.y_first = y_first;
+  job.y_last = y_last + 1;
+  job.bands = (job.y_last - job.y_first + TREND_BAND_LINES - 1) / TREND_BAND_LINES;
+
+  // bands of lines, all the cores share them
+  run_job(TREND_PHASE_COMPOSITE, (((job.y_last - job.y_first) * w) >= TREND_MT_MIN_PIXELS) ? ((job.bands < cores) ? job.bands : cores) : 1);
+
+  return 0;
+}
+
+
+const QImage & trace_render::get_image()
+{
+  return img;
+}
+
+
+int trace_render::get_y_lo()
+{
+  return y_lo;
+}
+
+
+int trace_render::get_y_hi()
+{
+  return y_hi;
+}
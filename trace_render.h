@@ -0,0 +1,116 @@
+/*
+***************************************************************************
+*
+* Author: Teunis van Beelen
+*
+* Copyright (C) 2015 - 2024 Teunis van Beelen
+*
+* Email: teuniz@protonmail.com
+*
+***************************************************************************
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+***************************************************************************
+*/
+
+
+
+
+
+#ifndef DEF_TRACE_RENDER_H
+#define DEF_TRACE_RENDER_H
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <QThread>
+#include <QAtomicInt>
+#include <QImage>
+
+#include "global.h"
+#include "trace_raster.h"
+#include "work_pool.h"
+
+
+#define TREND_BAND_LINES  (32)  /* lines per work item of the composite */
+
+/* less work than this is done by the calling thread, starting the workers would cost more */
+#define TREND_MT_MIN_SAMPLES  (16384)
+#define TREND_MT_MIN_PIXELS   (65536)
+
+
+#define TREND_PHASE_DRAW       (0)
+#define TREND_PHASE_COMPOSITE  (1)
+
+
+struct trace_render_job
+{
+  struct trast_layer *layer[MAX_CHNS];
+  struct trast_trace trace[MAX_CHNS];
+  int cnt;
+  int phase;
+  unsigned int *dest;
+  int stride;
+  int y_first;            /* lines of dest that are composited */
+  int y_last;
+  int bands;
+  QAtomicInt item_next;
+};
+
+
+/*
+ * Draws the traces of up to MAX_CHNS channels into an ARGB32 premultiplied
+ * image without QPainter. Every trace is drawn by a worker of its own into
+ * its own layer, then the workers composite bands of lines of the layers
+ * into the image. The caller only has to copy the lines that hold a trace
+ * onto the widget. The image is in device pixels, the traces too.
+ */
+class trace_render
+{
+public:
+
+  trace_render();
+  ~trace_render();
+
+  /* draws cnt traces in order, the last one on top, into an image of w x h device pixels
+     with the device pixel ratio set, returns 0 on success */
+  int render(int, int, double, const struct trast_trace *, int);
+
+  const QImage & get_image();
+
+  /* lines of the image that hold a trace, y_lo > y_hi when there are none */
+  int get_y_lo();
+  int get_y_hi();
+
+private:
+
+  work_pool pool;
+
+  struct trast_layer layers[MAX_CHNS];
+
+  struct trace_render_job job;
+
+  QImage img;
+
+  int y_lo,
+      y_hi;
+
+  void run_job(int, int);
+};
+
+
+#endif
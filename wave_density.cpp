@@ -0,0 +1,531 @@
+/*
+***************************************************************************
+*
+* Author: Teunis van Beelen
+*
+* Copyright (C) 2015 - 2024 Teunis van Beelen
+*
+* Email: teuniz@protonmail.com
+*
+***************************************************************************
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+***************************************************************************
+*/
+
+
+
+
+
+#include "wave_density.h"
+
+
+
+/* the highest color index whose threshold is reached, a table for the
+   common small counts, a search without branches for the others */
+static inline int wdens_index(const struct wave_density_job *job, unsigned int hits)
+{
+  int i, step;
+
+  if(hits < WDENS_SMALL_HITS)
+  {
+    return job->idx_small[hits];
+  }
+
+  for(i=0, step=WDENS_LUT_SZ/2; step; step>>=1)
+  {
+    i += (job->thr[i + step] <= hits) ? step : 0;
+  }
+
+  return i;
+}
+
+
+// counts the hits of a channel in a chunk of columns
+static void wdens_bin(struct wave_density_job *job, int k)
+{
+  int x, y, x0, x1, w, h, chn;
+
+  long long s, s0, s1, n;
+
+  unsigned int *hits, *p;
+
+  const int *row;
+
+  const short *buf;
+
+  struct wdens_level *lvl;
+
+  lvl = job->lvl;
+
+  chn = job->chns[k / job->chunks];
+
+  w = lvl->key.w;
+
+  h = lvl->key.h;
+
+  n = lvl->key.n;
+
+  x0 = job->col_lo + ((k % job->chunks) * WDENS_CHUNK_COLS);
+
+  x1 = x0 + WDENS_CHUNK_COLS;
+  if(x1 > job->col_hi)
+  {
+    x1 = job->col_hi;
+  }
+
+  hits = lvl->hits[chn];
+
+  row = lvl->row[chn] + 32768;
+
+  buf = lvl->key.buf[chn];
+
+  for(y=0; y<h; y++)
+  {
+    memset(hits + (y * w) + x0, 0, (x1 - x0) * sizeof(unsigned int));
+  }
+
+  for(x=x0; x<x1; x++)
+  {
+    s0 = (lvl->col_first + x) * lvl->key.spc;
+
+    s1 = (lvl->col_first + x + 1) * lvl->key.spc;
+
+    if(s0 < 0)
+    {
+      s0 = 0;
+    }
+
+    if(s1 > n)
+    {
+      s1 = n;
+    }
+
+    p = hits + x;
+
+    for(s=s0; s<s1; s++)
+    {
+      y = row[buf[s]];
+
+      if(y >= 0)
+      {
+        p[y]++;
+      }
+    }
+  }
+}
+
+
+// the colors of a band of lines, the channels are added
+static void wdens_render(struct wave_density_job *job, int k)
+{
+  int i, x, x0, y, y1, y2, w, h, n;
+
+  unsigned int c, *d, pix[PERS_RENDER_CHUNK];
+
+  const unsigned int *hits, *lut;
+
+  struct wdens_level *lvl;
+
+  lvl = job->lvl;
+
+  w = lvl->key.w;
+
+  h = lvl->key.h;
+
+  y1 = k * WDENS_BAND_LINES;
+
+  y2 = y1 + WDENS_BAND_LINES;
+  if(y2 > h)
+  {
+    y2 = h;
+  }
+
+  for(y=y1; y<y2; y++)
+  {
+    d = job->dest + (y * job->stride);
+
+    if(!job->chn_cnt)
+    {
+      memset(d, 0, w * sizeof(unsigned int));
+
+      continue;
+    }
+
+    for(i=0; i<job->chn_cnt; i++)
+    {
+      hits = lvl->hits[job->chns[i]] + (y * w);
+
+      lut = job->lut[job->chns[i]];
+
+      if(!i)
+      {
+        for(x=0; x<w; x++)
+        {
+          c = hits[x];
+
+          d[x] = c ? lut[wdens_index(job, c)] : 0;
+        }
+      }
+      else
+      {
+        for(x0=0; x0<w; x0+=PERS_RENDER_CHUNK)
+        {
+          n = ((w - x0) < PERS_RENDER_CHUNK) ? (w - x0) : PERS_RENDER_CHUNK;
+
+          for(x=0; x<n; x++)
+          {
+            c = hits[x0 + x];
+
+            pix[x] = c ? lut[wdens_index(job, c)] : 0;
+          }
+
+          sconv_argb_adds(d + x0, pix, n);
+        }
+      }
+    }
+  }
+}
+
+
+// takes work items of the current phase until there are none left
+static void wdens_run_items(void *data)
+{
+  int k;
+
+  struct wave_density_job *job = (struct wave_density_job *)data;
+
+  if(job->phase == WDENS_PHASE_BIN)
+  {
+    while((k = job->item_next.fetchAndAddOrdered(1)) < (job->chn_cnt * job->chunks))
+    {
+      wdens_bin(job, k);
+    }
+
+    return;
+  }
+
+  while((k = job->item_next.fetchAndAddOrdered(1)) < job->bands)
+  {
+    wdens_render(job, k);
+  }
+}
+
+
+wave_density::wave_density()
+{
+  memset(levels, 0, sizeof(levels));
+
+  job.lvl = NULL;
+  memset(job.chns, 0, sizeof(job.chns));
+  job.chn_cnt = 0;
+  job.col_lo = 0;
+  job.col_hi = 0;
+  job.chunks = 0;
+  job.phase = WDENS_PHASE_BIN;
+  job.dest = NULL;
+  job.stride = 0;
+  job.bands = 0;
+
+  stamp = 0;
+}
+
+
+wave_density::~wave_density()
+{
+  int i, chn;
+
+  for(i=0; i<WDENS_LEVELS; i++)
+  {
+    for(chn=0; chn<MAX_CHNS; chn++)
+    {
+      free(levels[i].hits[chn]);
+      free(levels[i].row[chn]);
+    }
+  }
+}
+
+
+// the level with the same key, or the least recently used one prepared for the key
+struct wdens_level * wave_density::get_level(const struct wdens_key *key)
+{
+  int i, chn, v, sz;
+
+  double y;
+
+  unsigned int *p;
+
+  struct wdens_level *lvl;
+
+  for(i=0; i<WDENS_LEVELS; i++)
+  {
+    if(levels[i].stamp && (!memcmp(&levels[i].key, key, sizeof(struct wdens_key))))
+    {
+      levels[i].stamp = ++stamp;
+
+      return &levels[i];
+    }
+  }
+
+  lvl = &levels[0];
+
+  for(i=1; i<WDENS_LEVELS; i++)
+  {
+    if(levels[i].stamp < lvl->stamp)
+    {
+      lvl = &levels[i];
+    }
+  }
+
+  lvl->stamp = 0;
+
+  lvl->valid = 0;
+
+  sz = key->w * key->h;
+
+  for(chn=0; chn<MAX_CHNS; chn++)
+  {
+    if(key->buf[chn] == NULL)
+    {
+      continue;
+    }
+
+    if(sz > lvl->sz[chn])
+    {
+      p = (unsigned int *)realloc(lvl->hits[chn], sz * sizeof(unsigned int));
+      if(p == NULL)
+      {
+        return NULL;
+      }
+
+      lvl->hits[chn] = p;
+
+      lvl->sz[chn] = sz;
+    }
+
+    if(lvl->row[chn] == NULL)
+    {
+      lvl->row[chn] = (int *)malloc(65536 * sizeof(int));
+      if(lvl->row[chn] == NULL)
+      {
+        return NULL;
+      }
+    }
+
+    // truncated like the lines of the envelope
+    for(v=0; v<65536; v++)
+    {
+      y = key->y_off[chn] + ((v - 32768) * key->y_step[chn]);
+
+      lvl->row[chn][v] = ((y > -1.0) && (y < key->h)) ? ((int)y * key->w) : -1;
+    }
+  }
+
+  memcpy(&lvl->key, key, sizeof(struct wdens_key));
+
+  lvl->stamp = ++stamp;
+
+  return lvl;
+}
+
+
+void wave_density::run_job(int phase, int thread_cnt)
+{
+  job.phase = phase;
+
+  job.item_next.storeRelease(0);
+
+  pool.run(wdens_run_items, &job, thread_cnt);
+}
+
+
+int wave_density::render(const struct wdens_view *view)
+{
+  int i, chn, y, w, h, col_first, shift, cores, items;
+
+  unsigned int *hits;
+
+  double l;
+
+  struct wdens_key key;
+
+  struct wdens_level *lvl;
+
+  w = view->w;
+
+  h = view->h;
+
+  if((w < 1) || (h < 1) || (view->n < 1) || (view->spc < 1.0))
+  {
+    return -1;
+  }
+
+  if((img.width() != w) || (img.height() != h))
+  {
+    img = QImage(w, h, QImage::Format_ARGB32_Premultiplied);
+
+    if(img.isNull())
+    {
+      return -1;
+    }
+  }
+
+#if QT_VERSION >= 0x050600
+  img.setDevicePixelRatio(view->pixel_ratio);
+#endif
+
+  memset(&key, 0, sizeof(struct wdens_key));
+
+  for(chn=0; chn<MAX_CHNS; chn++)
+  {
+    key.buf[chn] = view->buf[chn];
+
+    if(view->buf[chn] != NULL)
+    {
+      key.y_off[chn] = view->y_off[chn];
+      key.y_step[chn] = view->y_step[chn];
+    }
+  }
+  key.n = view->n;
+  key.spc = view->spc;
+  key.w = w;
+  key.h = h;
+
+  lvl = get_level(&key);
+  if(lvl == NULL)
+  {
+    return -1;
+  }
+
+  job.lvl = lvl;
+
+  job.chn_cnt = 0;
+
+  for(chn=0; chn<MAX_CHNS; chn++)
+  {
+    if(view->buf[chn] != NULL)
+    {
+      job.chns[job.chn_cnt++] = chn;
+    }
+  }
+
+  // the columns are fixed to the samples, panning moves the columns that stay in view
+  col_first = view->sample_start / view->spc;
+
+  shift = col_first - lvl->col_first;
+
+  if((!lvl->valid) || (shift >= w) || (shift <= -w))
+  {
+    job.col_lo = 0;
+    job.col_hi = w;
+  }
+  else if(shift > 0)
+    {
+      for(i=0; i<job.chn_cnt; i++)
+      {
+        hits = lvl->hits[job.chns[i]];
+
+        for(y=0; y<h; y++)
+        {
+          memmove(hits + (y * w), hits + (y * w) + shift, (w - shift) * sizeof(unsigned int));
+        }
+      }
+
+      job.col_lo = w - shift;
+      job.col_hi = w;
+    }
+    else if(shift < 0)
+      {
+        for(i=0; i<job.chn_cnt; i++)
+        {
+          hits = lvl->hits[job.chns[i]];
+
+          for(y=0; y<h; y++)
+          {
+            memmove(hits + (y * w) - shift, hits + (y * w), (w + shift) * sizeof(unsigned int));
+          }
+        }
+
+        job.col_lo = 0;
+        job.col_hi = -shift;
+      }
+      else
+      {
+        job.col_lo = 0;
+        job.col_hi = 0;
+      }
+
+  lvl->col_first = col_first;
+
+  lvl->valid = 1;
+
+  cores = QThread::idealThreadCount();
+
+  if((job.col_hi > job.col_lo) && job.chn_cnt)
+  {
+    job.chunks = (job.col_hi - job.col_lo + WDENS_CHUNK_COLS - 1) / WDENS_CHUNK_COLS;
+
+    items = job.chn_cnt * job.chunks;
+
+    run_job(WDENS_PHASE_BIN, (((job.col_hi - job.col_lo) * view->spc * job.chn_cnt) >= WDENS_MT_MIN_SAMPLES) ? ((items < cores) ? items : cores) : 1);
+  }
+
+  // logarithmic ramp, the last index is reached when all samples of a column hit the same pixel
+  l = log(1.0 + ceil(view->spc));
+
+  job.thr[0] = 0;
+
+  job.thr[1] = 1;
+
+  for(i=2; i<WDENS_LUT_SZ; i++)
+  {
+    job.thr[i] = ceil(exp(((i - 0.5) / (WDENS_LUT_SZ - 1)) * l) - 1.0);
+
+    if(job.thr[i] < job.thr[i - 1])
+    {
+      job.thr[i] = job.thr[i - 1];
+    }
+  }
+
+  for(i=0, y=0; i<WDENS_SMALL_HITS; i++)
+  {
+    while((y < (WDENS_LUT_SZ - 1)) && (job.thr[y + 1] <= (unsigned int)i))
+    {
+      y++;
+    }
+
+    job.idx_small[i] = y;
+  }
+
+  // the ramp of the persistence, the index is already logarithmic
+  for(i=0; i<job.chn_cnt; i++)
+  {
+    pers_color_ramp(job.lut[job.chns[i]], WDENS_LUT_SZ, view->color[job.chns[i]], 0);
+  }
+
+  job.dest = (unsigned int *)img.bits();
+  job.stride = img.bytesPerLine() / 4;
+  job.bands = (h + WDENS_BAND_LINES - 1) / WDENS_BAND_LINES;
+
+  run_job(WDENS_PHASE_RENDER, ((w * h) >= WDENS_MT_MIN_SAMPLES) ? ((job.bands < cores) ? job.bands : cores) : 1);
+
+  return 0;
+}
+
+
+const QImage & wave_density::get_image()
+{
+  return img;
+}
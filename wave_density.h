@@ -0,0 +1,164 @@
+/*
+***************************************************************************
+*
+* Author: Teunis van Beelen
+*
+* Copyright (C) 2015 - 2024 Teunis van Beelen
+*
+* Email: teuniz@protonmail.com
+*
+***************************************************************************
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+***************************************************************************
+*/
+
+
+
+
+
+#ifndef DEF_WAVE_DENSITY_H
+#define DEF_WAVE_DENSITY_H
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include <QThread>
+#include <QAtomicInt>
+#include <QImage>
+
+#include "global.h"
+#include "persist.h"
+#include "sample_conv.h"
+#include "work_pool.h"
+
+#define WDENS_LEVELS       (3)   /* zoom levels that are kept */
+#define WDENS_CHUNK_COLS  (64)   /* columns per work item of the binning */
+#define WDENS_BAND_LINES  (32)   /* lines per work item of the render */
+#define WDENS_LUT_SZ     (256)   /* colors per channel, index 0 is a pixel without hits */
+#define WDENS_SMALL_HITS (4096)  /* the color index of less hits is looked up directly */
+
+/* less samples than this are binned by the calling thread */
+#define WDENS_MT_MIN_SAMPLES  (65536)
+
+#define WDENS_PHASE_BIN     (0)
+#define WDENS_PHASE_RENDER  (1)
+
+
+/* what the view shows, column x holds the samples [(c * spc), ((c + 1) * spc)) with
+   c = x + (sample_start / spc), every sample gives a hit on y = y_off + (sample * y_step),
+   the columns and lines are device pixels */
+struct wdens_view
+{
+  const short *buf[MAX_CHNS];  /* NULL for the channels that are not shown */
+  int n;                       /* samples per channel */
+  int sample_start;
+  double spc;                  /* samples per column */
+  int w;
+  int h;
+  double y_off[MAX_CHNS];
+  double y_step[MAX_CHNS];
+  unsigned int color[MAX_CHNS];  /* ARGB32, opaque */
+  double pixel_ratio;          /* device pixels per logical pixel, set on the image */
+};
+
+
+/* a level is reused while all of these are the same, compared with memcmp */
+struct wdens_key
+{
+  const short *buf[MAX_CHNS];
+  int n;
+  double spc;
+  int w;
+  int h;
+  double y_off[MAX_CHNS];
+  double y_step[MAX_CHNS];
+};
+
+
+struct wdens_level
+{
+  struct wdens_key key;
+  unsigned int *hits[MAX_CHNS];  /* w * h, line by line */
+  int *row[MAX_CHNS];            /* offset of the line of every sample value, -1 outside the plot */
+  int sz[MAX_CHNS];              /* allocated pixels per channel */
+  int col_first;                 /* column of the samples that is at x = 0 */
+  int valid;                     /* 0 when no column has been binned yet */
+  unsigned int stamp;            /* the least recently used level is replaced */
+};
+
+
+struct wave_density_job
+{
+  struct wdens_level *lvl;
+  int chns[MAX_CHNS];            /* channels to bin */
+  int chn_cnt;
+  int col_lo;                    /* columns [col_lo, col_hi) of the view are binned */
+  int col_hi;
+  int chunks;                    /* work items per channel */
+  int phase;
+  unsigned int *dest;
+  int stride;
+  int bands;
+  unsigned int thr[WDENS_LUT_SZ];          /* least hits of every color index */
+  unsigned char idx_small[WDENS_SMALL_HITS];
+  unsigned int lut[MAX_CHNS][WDENS_LUT_SZ];
+  QAtomicInt item_next;
+};
+
+
+/*
+ * Density view of a deep memory record. The samples of a column are not
+ * drawn as a line but counted per pixel, the number of hits is shown
+ * through a logarithmic color ramp, so the distribution of the signal
+ * within a column stays visible. The counts of the last WDENS_LEVELS zoom
+ * levels are kept. Panning moves the columns that stay in view and only
+ * bins the new ones. Binning and rendering are split into work items that
+ * are shared by one worker per core.
+ */
+class wave_density
+{
+public:
+
+  wave_density();
+  ~wave_density();
+
+  /* bins and renders the view, returns 0 on success */
+  int render(const struct wdens_view *);
+
+  const QImage & get_image();
+
+private:
+
+  work_pool pool;
+
+  struct wdens_level levels[WDENS_LEVELS];
+
+  struct wave_density_job job;
+
+  unsigned int stamp;
+
+  QImage img;
+
+  struct wdens_level * get_level(const struct wdens_key *);
+
+  void run_job(int, int);
+};
+
+
+#endif
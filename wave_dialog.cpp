@@ -75,6 +75,8 @@ UI_wave_window::UI_wave_window(struct device_settings *p_devparms, short *wbuf[M
     mainwindow->serial_decoder(devparms);
   }
 
+  psd_window = NULL;
+
   wavcurve = new WaveCurve;
   wavcurve->setBackgroundColor(Qt::black);
   wavcurve->setSignalColor1(Qt::yellow);
@@ -85,6 +87,14 @@ UI_wave_window::UI_wave_window(struct device_settings *p_devparms, short *wbuf[M
   wavcurve->setBorderSize(40);
   wavcurve->setDeviceParameters(devparms);
 
+  // the envelopes are built in the background, the view scans the samples until they are ready
+  lod = new wave_lod;
+  connect(lod, SIGNAL(build_done()), wavcurve, SLOT(update()));
+  lod->start(devparms->wavebuf, devparms->wavebufsz);
+  wavcurve->setLod(lod);
+
+  density = new wave_density;
+
   wavslider = new QSlider;
   wavslider->setOrientation(Qt::Horizontal);
   set_wavslider();
@@ -98,6 +108,18 @@ UI_wave_window::UI_wave_window(struct device_settings *p_devparms, short *wbuf[M
   savemenu->addAction("Save to EDF file", this, SLOT(save_wi_buffer_to_edf()));
   menubar->addMenu(savemenu);
 
+  viewmenu = new QMenu(this);
+  viewmenu->setTitle("View");
+  density_act = viewmenu->addAction("Density", this, SLOT(toggle_density()));
+  density_act->setCheckable(true);
+  density_act->setChecked(false);
+  menubar->addMenu(viewmenu);
+
+  analysismenu = new QMenu(this);
+  analysismenu->setTitle("Analysis");
+  analysismenu->addAction("Spectrum (Welch)", this, SLOT(show_psd_window()));
+  menubar->addMenu(analysismenu);
+
   helpmenu = new QMenu(this);
   helpmenu->setTitle("Help");
   helpmenu->addAction("How to operate", mainwindow, SLOT(helpButtonClicked()));
@@ -159,6 +181,13 @@ UI_wave_window::~UI_wave_window()
 {
   int i;
 
+  // the workers of the spectrum and the envelopes read the buffers, they must be stopped first
+  delete psd_window;
+
+  delete lod;
+
+  delete density;
+
   for(i=0; i<MAX_CHNS; i++)
   {
     free(devparms->wavebuf[i]);
@@ -174,6 +203,37 @@ void UI_wave_window::save_wi_buffer_to_edf()
 }
 
 
+// with many samples per column the hits per pixel are shown instead of the envelope
+void UI_wave_window::toggle_density()
+{
+  if(density_act->isChecked())
+  {
+    wavcurve->setDensity(density);
+  }
+  else
+  {
+    wavcurve->setDensity(NULL);
+  }
+
+  wavcurve->update();
+}
+
+
+void UI_wave_window::show_psd_window()
+{
+  if(psd_window == NULL)
+  {
+    psd_window = new UI_psd_window(devparms, this);
+  }
+  else
+  {
+    psd_window->show();
+
+    psd_window->raise();
+  }
+}
+
+
 void UI_wave_window::wavslider_value_changed(int val)
 {
   devparms->wave_mem_view_sample_start = val;
@@ -38,12 +38,17 @@
 #include "mainwindow.h"
 #include "global.h"
 #include "wave_view.h"
+#include "psd_dialog.h"
+#include "wave_lod.h"
+#include "wave_density.h"
 
 
 class UI_Mainwindow;
 
 class WaveCurve;
 
+class UI_psd_window;
+
 
 class UI_wave_window : public QDialog
 {
@@ -65,15 +70,24 @@ UI_Mainwindow *mainwindow;
 QMenuBar     *menubar;
 
 QMenu        *savemenu,
+             *viewmenu,
+             *analysismenu,
              *helpmenu;
 
 QGridLayout *g_layout;
 
 WaveCurve *wavcurve;
 
+UI_psd_window *psd_window;
+
+wave_lod *lod;
+
+wave_density *density;
+
 QSlider *wavslider;
 
-QAction *former_page_act,
+QAction *density_act,
+        *former_page_act,
         *shift_page_left_act,
         *shift_page_right_act,
         *next_page_act,
@@ -97,6 +111,10 @@ void center_trigger();
 
 void save_wi_buffer_to_edf();
 
+void show_psd_window();
+
+void toggle_density();
+
 };
 
 
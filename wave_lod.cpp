@@ -0,0 +1,411 @@
+/*
+***************************************************************************
+*
+* Author: Teunis van Beelen
+*
+* Copyright (C) 2015 - 2024 Teunis van Beelen
+*
+* Email: teuniz@protonmail.com
+*
+***************************************************************************
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+***************************************************************************
+*/
+
+
+
+
+#include "wave_lod.h"
+
+
+
+// buckets [first, last) of dest from the buckets of the level below
+static void wlod_merge(const struct wave_lod_level *src, struct wave_lod_level *dest, int first, int last)
+{
+  int i, j, j_end;
+
+  short mn, mx;
+
+  for(i=first; i<last; i++)
+  {
+    j = i << WLOD_FACTOR_LOG2;
+
+    j_end = j + (1 << WLOD_FACTOR_LOG2);
+    if(j_end > src->n)
+    {
+      j_end = src->n;
+    }
+
+    mn = src->min[j];
+    mx = src->max[j];
+
+    for(j++; j<j_end; j++)
+    {
+      if(src->min[j] < mn)
+      {
+        mn = src->min[j];
+      }
+
+      if(src->max[j] > mx)
+      {
+        mx = src->max[j];
+      }
+    }
+
+    dest->min[i] = mn;
+    dest->max[i] = mx;
+  }
+}
+
+
+wave_lod_worker::wave_lod_worker()
+{
+  job = NULL;
+}
+
+
+wave_lod_worker::~wave_lod_worker()
+{
+  wait();
+}
+
+
+void wave_lod_worker::prepare(struct wave_lod_job *p_job)
+{
+  job = p_job;
+}
+
+
+void wave_lod_worker::run()
+{
+  int i, k, chn, lv, first, last, cnt, shift, total;
+
+  long long sum;
+
+  const short *src;
+
+  struct wave_lod_level *lvl;
+
+  total = job->chn_cnt * job->chunks;
+
+  while(!job->abort_req.loadAcquire())
+  {
+    k = job->item_next.fetchAndAddOrdered(1);
+    if(k >= total)
+    {
+      break;
+    }
+
+    chn = job->chns[k / job->chunks];
+
+    lvl = job->lvl[chn];
+
+    src = job->buf[chn];
+
+    first = (k % job->chunks) * WLOD_CHUNK_BUCKETS;
+
+    last = first + WLOD_CHUNK_BUCKETS;
+    if(last > lvl[0].n)
+    {
+      last = lvl[0].n;
+    }
+
+    for(i=first; i<last; i++)
+    {
+      cnt = job->n - (i * WLOD_BUCKET);
+      if(cnt > WLOD_BUCKET)
+      {
+        cnt = WLOD_BUCKET;
+      }
+
+      sconv_s16_minmax_sum(src + (i * WLOD_BUCKET), cnt, &lvl[0].min[i], &lvl[0].max[i], &sum);
+    }
+
+    // the levels above that still fit in this item, the item is aligned to their buckets
+    for(lv=1; (lv<=WLOD_CHUNK_LEVELS) && (lv<job->levels); lv++)
+    {
+      shift = lv * WLOD_FACTOR_LOG2;
+
+      wlod_merge(&lvl[lv - 1], &lvl[lv], first >> shift, (last + (1 << shift) - 1) >> shift);
+    }
+
+    if(job->items_done.fetchAndAddOrdered(1) == (total - 1))
+    {
+      job->lod->finish_build();
+    }
+  }
+}
+
+
+wave_lod::wave_lod()
+{
+  int i;
+
+  for(i=0; i<WLOD_MAX_THREADS; i++)
+  {
+    workers[i] = NULL;
+  }
+
+  thread_cnt = 0;
+
+  memset(job.buf, 0, sizeof(job.buf));
+  memset(job.chns, 0, sizeof(job.chns));
+  memset(job.lvl, 0, sizeof(job.lvl));
+  job.n = 0;
+  job.chn_cnt = 0;
+  job.chunks = 0;
+  job.levels = 0;
+  job.lod = this;
+}
+
+
+wave_lod::~wave_lod()
+{
+  int i;
+
+  abort();
+
+  for(i=0; i<WLOD_MAX_THREADS; i++)
+  {
+    delete workers[i];
+  }
+
+  free_levels();
+}
+
+
+void wave_lod::free_levels()
+{
+  int chn, lv;
+
+  for(chn=0; chn<MAX_CHNS; chn++)
+  {
+    for(lv=0; lv<WLOD_MAX_LEVELS; lv++)
+    {
+      free(job.lvl[chn][lv].min);
+      free(job.lvl[chn][lv].max);
+    }
+  }
+
+  memset(job.lvl, 0, sizeof(job.lvl));
+
+  job.levels = 0;
+}
+
+
+int wave_lod::start(short * const *buf, int n)
+{
+  int i, chn, lv, bucket, buckets;
+
+  abort();
+
+  ready.storeRelease(0);
+
+  free_levels();
+
+  thread_cnt = 0;
+
+  job.n = n;
+  job.chn_cnt = 0;
+
+  for(chn=0; chn<MAX_CHNS; chn++)
+  {
+    job.buf[chn] = buf[chn];
+
+    if(buf[chn] != NULL)
+    {
+      job.chns[job.chn_cnt++] = chn;
+    }
+  }
+
+  if((!job.chn_cnt) || (n < (WLOD_BUCKET * 2)))
+  {
+    return -1;
+  }
+
+  // a level is only useful as long as a view can contain more than one of its buckets
+  for(lv=0, bucket=WLOD_BUCKET; (lv<WLOD_MAX_LEVELS) && (bucket<n); lv++, bucket<<=WLOD_FACTOR_LOG2)
+  {
+    buckets = ((long long)n + bucket - 1) / bucket;
+
+    for(i=0; i<job.chn_cnt; i++)
+    {
+      chn = job.chns[i];
+
+      job.lvl[chn][lv].min = (short *)malloc(buckets * sizeof(short));
+      job.lvl[chn][lv].max = (short *)malloc(buckets * sizeof(short));
+      if((job.lvl[chn][lv].min == NULL) || (job.lvl[chn][lv].max == NULL))
+      {
+        free_levels();
+
+        return -1;
+      }
+
+      job.lvl[chn][lv].n = buckets;
+      job.lvl[chn][lv].bucket = bucket;
+    }
+
+    job.levels = lv + 1;
+
+    if(bucket > (0x7fffffff >> WLOD_FACTOR_LOG2))
+    {
+      break;
+    }
+  }
+
+  job.chunks = (job.lvl[job.chns[0]][0].n + WLOD_CHUNK_BUCKETS - 1) / WLOD_CHUNK_BUCKETS;
+  job.item_next.storeRelease(0);
+  job.items_done.storeRelease(0);
+  job.abort_req.storeRelease(0);
+
+  thread_cnt = QThread::idealThreadCount();
+
+  if(thread_cnt > WLOD_MAX_THREADS)
+  {
+    thread_cnt = WLOD_MAX_THREADS;
+  }
+
+  if(thread_cnt > (job.chn_cnt * job.chunks))
+  {
+    thread_cnt = job.chn_cnt * job.chunks;
+  }
+
+  if(thread_cnt < 1)
+  {
+    thread_cnt = 1;
+  }
+
+  for(i=0; i<thread_cnt; i++)
+  {
+    if(workers[i] == NULL)
+    {
+      workers[i] = new wave_lod_worker;
+    }
+
+    workers[i]->prepare(&job);
+  }
+
+  for(i=0; i<thread_cnt; i++)
+  {
+    workers[i]->start();
+  }
+
+  return 0;
+}
+
+
+void wave_lod::finish_build()
+{
+  int i, chn, lv;
+
+  for(i=0; i<job.chn_cnt; i++)
+  {
+    chn = job.chns[i];
+
+    for(lv=WLOD_CHUNK_LEVELS+1; lv<job.levels; lv++)
+    {
+      wlod_merge(&job.lvl[chn][lv - 1], &job.lvl[chn][lv], 0, job.lvl[chn][lv].n);
+    }
+  }
+
+  ready.storeRelease(1);
+
+  emit build_done();
+}
+
+
+void wave_lod::abort()
+{
+  int i;
+
+  job.abort_req.storeRelease(1);
+
+  for(i=0; i<WLOD_MAX_THREADS; i++)
+  {
+    if(workers[i] != NULL)
+    {
+      workers[i]->wait();
+    }
+  }
+}
+
+
+int wave_lod::is_ready()
+{
+  return ready.loadAcquire();
+}
+
+
+// the edges are rounded outwards to whole buckets, a range holds at least
+// four buckets of the level that is used so the error stays below a quarter
+void wave_lod::get_minmax(int chn, int start, int end, short *min, short *max)
+{
+  int i, lv, first, last;
+
+  long long sum;
+
+  struct wave_lod_level *lvl;
+
+  if(job.buf[chn] == NULL)
+  {
+    *min = 0;
+    *max = 0;
+
+    return;
+  }
+
+  if((!ready.loadAcquire()) || ((end - start) < (WLOD_BUCKET << WLOD_FACTOR_LOG2)))
+  {
+    sconv_s16_minmax_sum(job.buf[chn] + start, end - start, min, max, &sum);
+
+    return;
+  }
+
+  for(lv=job.levels-1; lv>0; lv--)
+  {
+    if((job.lvl[chn][lv].bucket << WLOD_FACTOR_LOG2) <= (end - start))
+    {
+      break;
+    }
+  }
+
+  lvl = &job.lvl[chn][lv];
+
+  first = start / lvl->bucket;
+
+  last = (end + lvl->bucket - 1) / lvl->bucket;
+  if(last > lvl->n)
+  {
+    last = lvl->n;
+  }
+
+  *min = lvl->min[first];
+  *max = lvl->max[first];
+
+  for(i=first+1; i<last; i++)
+  {
+    if(lvl->min[i] < *min)
+    {
+      *min = lvl->min[i];
+    }
+
+    if(lvl->max[i] > *max)
+    {
+      *max = lvl->max[i];
+    }
+  }
+}
+
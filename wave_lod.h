@@ -0,0 +1,158 @@
+/*
+***************************************************************************
+*
+* Author: Teunis van Beelen
+*
+* Copyright (C) 2015 - 2024 Teunis van Beelen
+*
+* Email: teuniz@protonmail.com
+*
+***************************************************************************
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+***************************************************************************
+*/
+
+
+
+
+#ifndef DEF_WAVE_LOD_H
+#define DEF_WAVE_LOD_H
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <QObject>
+#include <QThread>
+#include <QAtomicInt>
+
+#include "global.h"
+#include "sample_conv.h"
+
+
+#define WLOD_MAX_THREADS  (64)
+
+#define WLOD_BUCKET      (64)  /* samples per bucket of the first level */
+#define WLOD_FACTOR_LOG2  (2)  /* four buckets of a level make one of the next */
+#define WLOD_MAX_LEVELS  (16)
+
+/* a work item is this many buckets of the first level, the levels
+   up to WLOD_CHUNK_LEVELS lie entirely inside the item */
+#define WLOD_CHUNK_LEVELS   (7)
+#define WLOD_CHUNK_BUCKETS  (1 << (WLOD_CHUNK_LEVELS * WLOD_FACTOR_LOG2))
+
+
+struct wave_lod_level
+{
+  short *min;
+  short *max;
+  int n;        /* buckets */
+  int bucket;   /* samples per bucket */
+};
+
+
+class wave_lod;
+
+
+/* shared, read-only during a build except for the atomics */
+struct wave_lod_job
+{
+  const short *buf[MAX_CHNS];
+  int n;
+  int chns[MAX_CHNS];     /* channels to build */
+  int chn_cnt;
+  int chunks;             /* work items per channel */
+  int levels;
+  struct wave_lod_level lvl[MAX_CHNS][WLOD_MAX_LEVELS];
+  wave_lod *lod;
+  QAtomicInt item_next;
+  QAtomicInt items_done;
+  QAtomicInt abort_req;
+};
+
+
+class wave_lod_worker : public QThread
+{
+public:
+
+  wave_lod_worker();
+  ~wave_lod_worker();
+
+  void prepare(struct wave_lod_job *);
+
+private:
+
+  struct wave_lod_job *job;
+
+  void run();
+};
+
+
+/*
+ * Min/max envelope pyramid of the channels of a deep memory record.
+ * The first level holds the minimum and maximum of every WLOD_BUCKET
+ * samples, every next level merges four buckets of the level below.
+ * A view picks the coarsest level whose bucket still fits in a pixel
+ * column, so a repaint costs the same at any memory depth. The levels
+ * are built by one worker per core, until they are ready the samples
+ * are scanned directly.
+ */
+class wave_lod : public QObject
+{
+  Q_OBJECT
+
+public:
+
+  wave_lod();
+  ~wave_lod();
+
+  /* buf[chn] is NULL for the channels that are not used, the buffers
+     must stay valid until the build is finished or aborted */
+  int start(short * const *, int);
+
+  /* stops the workers and waits for them */
+  void abort();
+
+  int is_ready();
+
+  /* minimum and maximum of the samples [start, end) of a channel, n must be > 0 */
+  void get_minmax(int, int, int, short *, short *);
+
+  /* called by the worker that finishes the last work item */
+  void finish_build();
+
+signals:
+
+  void build_done();
+
+private:
+
+  wave_lod_worker *workers[WLOD_MAX_THREADS];
+
+  int thread_cnt;
+
+  struct wave_lod_job job;
+
+  QAtomicInt ready;
+
+  void free_levels();
+};
+
+
+#endif
+
+
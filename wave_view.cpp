@@ -64,26 +64,36 @@ WaveCurve::WaveCurve(QWidget *w_parent) : QWidget(w_parent)
   old_w = 10000;
 
   devparms = NULL;
+
+  lod = NULL;
+
+  density = NULL;
+
+  memset(&bg_gkey, 0, sizeof(bg_gkey));
+
+  memset(&bg_lkey, 0, sizeof(bg_lkey));
 }
 
 
 void WaveCurve::paintEvent(QPaintEvent *)
 {
-  int i, chn,
-      small_rulers,
+  int n, chn,
+      dens_mode,
       h_trace_offset,
       w_trace_offset,
       curve_w,
       curve_h,
       sample_range,
       sample_start,
-      sample_end,
-      t_pos;
+      sample_end;
 
   double h_step=0.0,
          samples_per_div,
-         step,
-         step2;
+         px_ratio=1.0;
+
+  struct trast_trace traces[MAX_CHNS], *tr;
+
+  struct wdens_view dview;
 
   if(devparms == NULL)
   {
@@ -107,31 +117,18 @@ void WaveCurve::paintEvent(QPaintEvent *)
 
   bufsize = devparms->wavebufsz;
 
-  small_rulers = 5 * devparms->hordivisions;
-
-  painter->fillRect(0, 0, curve_w, curve_h, BackgroundColor);
-
   if((curve_w < ((bordersize * 2) + 5)) || (curve_h < ((bordersize * 2) + 5)))
   {
+    painter->fillRect(0, 0, curve_w, curve_h, BackgroundColor);
+
     return;
   }
 
-  painter->fillRect(0, 0, curve_w, 30, QColor(32, 32, 32));
-
   samples_per_div = devparms->samplerate * devparms->timebasescale;
 
-  drawTopLabels(painter);
-
-  t_pos = 408 - ((devparms->timebaseoffset / ((double)devparms->acquirememdepth / devparms->samplerate)) * 233);
-
-  drawSmallTriggerArrow(painter, t_pos, 16, 1, QColor(255, 128, 0));
-
-  painter->fillRect(0, curve_h - 30, curve_w, curve_h, QColor(32, 32, 32));
+  updateBackground(curve_w, curve_h);
 
-  for(i=0; i<devparms->channel_cnt; i++)
-  {
-    drawChanLabel(painter, 8 + (i * 130), curve_h - 25, i);
-  }
+  painter->drawPixmap(0, 0, bg_pixmap);
 
 /////////////////////////////////// translate coordinates, draw and fill a rectangle ///////////////////////////////////////////
 
@@ -141,101 +138,6 @@ void WaveCurve::paintEvent(QPaintEvent *)
 
   curve_h -= (bordersize * 2);
 
-/////////////////////////////////// draw the rasters ///////////////////////////////////////////
-
-  painter->setPen(RasterColor);
-
-  painter->drawRect (0, 0, curve_w - 1, curve_h - 1);
-
-  if((devparms->math_fft == 0) || (devparms->math_fft_split == 0))
-  {
-    if(devparms->displaygrid)
-    {
-      painter->setPen(QPen(QBrush(RasterColor, Qt::SolidPattern), tracewidth, Qt::DotLine, Qt::SquareCap, Qt::BevelJoin));
-
-      if(devparms->displaygrid == 2)
-      {
-        step = (double)curve_w / (double)devparms->hordivisions;
-
-        for(i=1; i<devparms->hordivisions; i++)
-        {
-          painter->drawLine(step * i, curve_h - 1, step * i, 0);
-        }
-
-        step = curve_h / (double)devparms->vertdivisions;
-
-        for(i=1; i<devparms->vertdivisions; i++)
-        {
-          painter->drawLine(0, step * i, curve_w - 1, step * i);
-        }
-      }
-      else
-      {
-        painter->drawLine(curve_w / 2, curve_h - 1, curve_w / 2, 0);
-
-        painter->drawLine(0, curve_h / 2, curve_w - 1, curve_h / 2);
-      }
-    }
-
-    painter->setPen(RasterColor);
-
-    step = (double)curve_w / (double)small_rulers;
-
-    for(i=1; i<small_rulers; i++)
-    {
-      step2 = step * i;
-
-      if(devparms->displaygrid)
-      {
-        painter->drawLine(step2, curve_h / 2 + 2, step2, curve_h / 2 - 2);
-      }
-
-      if(i % 5)
-      {
-        painter->drawLine(step2, curve_h - 1, step2, curve_h - 5);
-
-        painter->drawLine(step2, 0, step2, 4);
-      }
-      else
-      {
-        painter->drawLine(step2, curve_h - 1, step2, curve_h - 9);
-
-        painter->drawLine(step2, 0, step2, 8);
-      }
-    }
-
-    step = curve_h / (5.0 * devparms->vertdivisions);
-
-    for(i=1; i<(5 * devparms->vertdivisions); i++)
-    {
-      step2 = step * i;
-
-      if(devparms->displaygrid)
-      {
-        painter->drawLine(curve_w / 2 + 2, step2, curve_w / 2  - 2, step2);
-      }
-
-      if(i % 5)
-      {
-        painter->drawLine(curve_w - 1, step2, curve_w - 5, step2);
-
-        painter->drawLine(0, step2, 4, step2);
-      }
-      else
-      {
-        painter->drawLine(curve_w - 1, step2, curve_w - 9, step2);
-
-        painter->drawLine(0, step2, 8, step2);
-      }
-    }
-  }
-  else
-  {
-    painter->drawLine(curve_w / 2, curve_h - 1, curve_w / 2, 0);
-
-    painter->drawLine(0, curve_h / 2, curve_w - 1, curve_h / 2);
-  }
-
 /////////////////////////////////// draw the arrows ///////////////////////////////////////////
 
   drawTrigCenterArrow(painter, curve_w / 2, 0);
@@ -299,7 +201,28 @@ void WaveCurve::paintEvent(QPaintEvent *)
 //       }
 //     }
 
-    for(chn=0; chn<devparms->channel_cnt; chn++)
+    // the traces are drawn in device pixels, sharp on a HiDPI screen
+#if QT_VERSION >= 0x050600
+    px_ratio = painter->device()->devicePixelRatioF();
+#endif
+
+    // many samples per column, the density mode counts them per pixel instead of drawing the envelope,
+    // the dot display shows the samples themselves
+    dens_mode = (density != NULL) && (!devparms->displaytype) && (sample_range > (curve_w * 2));
+
+    if(dens_mode)
+    {
+      memset(&dview, 0, sizeof(struct wdens_view));
+
+      dview.n = bufsize;
+      dview.sample_start = sample_start;
+      dview.spc = 1.0 / (h_step * px_ratio);
+      dview.w = (curve_w * px_ratio) + 0.5;
+      dview.h = (curve_h * px_ratio) + 0.5;
+      dview.pixel_ratio = px_ratio;
+    }
+
+    for(chn=0, n=0; chn<devparms->channel_cnt; chn++)
     {
       if(!devparms->chandisplay[chn])
       {
@@ -312,52 +235,75 @@ void WaveCurve::paintEvent(QPaintEvent *)
 
       h_trace_offset += devparms->yor[chn] * v_sense;
 
-      painter->setPen(QPen(QBrush(SignalColor[chn], Qt::SolidPattern), tracewidth, Qt::SolidLine, Qt::SquareCap, Qt::BevelJoin));
+      if(dens_mode)
+      {
+        dview.buf[chn] = devparms->wavebuf[chn];
+        dview.y_off[chn] = h_trace_offset * px_ratio;
+        dview.y_step[chn] = v_sense * px_ratio;
+        dview.color[chn] = SignalColor[chn].rgb();
+
+        continue;
+      }
 
-      for(i=0; i<sample_range; i++)
+      tr = &traces[n++];
+
+      memset(tr, 0, sizeof(struct trast_trace));
+
+      tr->buf = devparms->wavebuf[chn] + sample_start;
+      tr->n = sample_range;
+      tr->x_off = w_trace_offset * px_ratio;
+      tr->x_step = h_step * px_ratio;
+      tr->y_off = h_trace_offset * px_ratio;
+      tr->y_step = v_sense * px_ratio;
+      tr->color = SignalColor[chn].rgb();
+      tr->width = (tracewidth * px_ratio) + 0.5;
+      tr->aa = devparms->display_aa;
+
+      if(devparms->displaytype)
       {
-        if(sample_range < (curve_w / 2))
+        tr->style = TRAST_DOTS;
+
+        if(tr->n > (bufsize - 1))
         {
-          if(devparms->displaytype)
+          tr->n = bufsize - 1;
+        }
+      }
+      else if(sample_range > (curve_w * 2))
+        {
+          buildEnvelope(tr, chn, sample_start, sample_end, (curve_w * px_ratio) + 0.5);
+        }
+        else if(sample_range < (curve_w / 2))
           {
-            painter->drawPoint(i * h_step + w_trace_offset,
-                               (devparms->wavebuf[chn][i + sample_start] * v_sense) + h_trace_offset);
+            tr->style = TRAST_STEPS;
           }
           else
           {
-            painter->drawLine(i * h_step + w_trace_offset,
-                              (devparms->wavebuf[chn][i + sample_start] * v_sense) + h_trace_offset,
-                              (i + 1) * h_step + w_trace_offset,
-                              (devparms->wavebuf[chn][i + sample_start] * v_sense) + h_trace_offset);
-            if(i)
-            {
-              painter->drawLine(i * h_step + w_trace_offset,
-                                (devparms->wavebuf[chn][i - 1 + sample_start] * v_sense) + h_trace_offset,
-                                i * h_step + w_trace_offset,
-                                (devparms->wavebuf[chn][i + sample_start] * v_sense) + h_trace_offset);
-            }
-          }
-        }
-        else
-        {
-          if(i < (bufsize - 1))
-          {
-            if(devparms->displaytype)
-            {
-              painter->drawPoint(i * h_step + w_trace_offset,
-                                 (devparms->wavebuf[chn][i + sample_start] * v_sense) + h_trace_offset);
-            }
-            else
+            // the line of the last sample goes to the first one after the view
+            tr->style = TRAST_VECTORS;
+
+            tr->n = sample_range + 1;
+
+            if((sample_start + tr->n) > bufsize)
             {
-              painter->drawLine(i * h_step + w_trace_offset,
-                                (devparms->wavebuf[chn][i + sample_start] * v_sense) + h_trace_offset,
-                                (i + 1) * h_step + w_trace_offset,
-                                (devparms->wavebuf[chn][i + 1 + sample_start] * v_sense) + h_trace_offset);
+              tr->n = bufsize - sample_start;
             }
           }
-        }
+    }
+
+    if(dens_mode)
+    {
+      if(!density->render(&dview))
+      {
+        painter->drawImage(0, 0, density->get_image());
       }
     }
+    else if((!trace_rend.render((curve_w * px_ratio) + 0.5, (curve_h * px_ratio) + 0.5, px_ratio, traces, n)) &&
+            (trace_rend.get_y_lo() <= trace_rend.get_y_hi()))
+      {
+        // the traces are drawn by worker threads, only the lines that hold a trace are copied
+        painter->drawImage(QPointF(0, trace_rend.get_y_lo() / px_ratio), trace_rend.get_image(),
+                           QRectF(0, trace_rend.get_y_lo(), trace_rend.get_image().width(), trace_rend.get_y_hi() - trace_rend.get_y_lo() + 1));
+      }
 
     painter->setClipping(false);
   }
@@ -417,6 +363,341 @@ void WaveCurve::setDeviceParameters(struct device_settings *devp)
 }
 
 
+void WaveCurve::setLod(wave_lod *p_lod)
+{
+  lod = p_lod;
+}
+
+
+// NULL draws the traces
+void WaveCurve::setDensity(wave_density *p_density)
+{
+  density = p_density;
+}
+
+
+// many samples per column, every column gets one line from the minimum to the maximum,
+// the envelope pyramid makes this independent of the number of samples in view
+// the columns of the envelope are device pixels, the scale and the offsets are taken from the trace
+void WaveCurve::buildEnvelope(struct trast_trace *tr, int chn, int sample_start, int sample_end, int curve_w)
+{
+  int x, n, s0, s1, y_top, y_bot, prev_top=0, prev_bot=0, *top, *bot;
+
+  double h_step;
+
+  h_step = tr->x_step;
+
+  short s_min, s_max;
+
+  long long sum;
+
+  if(env_top[chn].size() < curve_w)
+  {
+    env_top[chn].resize(curve_w);
+
+    env_bot[chn].resize(curve_w);
+  }
+
+  top = env_top[chn].data();
+
+  bot = env_bot[chn].data();
+
+  for(x=0, n=0; x<curve_w; x++)
+  {
+    s0 = sample_start + (x / h_step);
+
+    if(s0 >= sample_end)
+    {
+      break;
+    }
+
+    s1 = sample_start + ((x + 1) / h_step);
+
+    if(s1 > sample_end)
+    {
+      s1 = sample_end;
+    }
+
+    if(s1 <= s0)
+    {
+      s1 = s0 + 1;
+    }
+
+    if(lod != NULL)
+    {
+      lod->get_minmax(chn, s0, s1, &s_min, &s_max);
+    }
+    else
+    {
+      sconv_s16_minmax_sum(devparms->wavebuf[chn] + s0, s1 - s0, &s_min, &s_max, &sum);
+    }
+
+    y_top = (s_max * tr->y_step) + tr->y_off;
+
+    y_bot = (s_min * tr->y_step) + tr->y_off;
+
+    // the line of a column starts where the one of the previous column ends, no gaps on steep edges
+    if(n)
+    {
+      top[n] = (y_top > prev_bot) ? prev_bot : y_top;
+
+      bot[n] = (y_bot < prev_top) ? prev_top : y_bot;
+    }
+    else
+    {
+      top[n] = y_top;
+
+      bot[n] = y_bot;
+    }
+
+    prev_top = y_top;
+
+    prev_bot = y_bot;
+
+    n++;
+  }
+
+  tr->style = TRAST_SPANS;
+  tr->n = n;
+  tr->x0 = 0;
+  tr->y1 = top;
+  tr->y2 = bot;
+}
+
+
+// the grid, the rulers and the labels only change with the settings and the
+// position in the memory, they are drawn into bg_pixmap that is copied on
+// every repaint, panning and zooming only redraw the top and bottom bar
+void WaveCurve::updateBackground(int curve_w, int curve_h)
+{
+  int i, full;
+
+  struct bg_grid_key gk;
+
+  struct bg_label_key lk;
+
+  memset(&gk, 0, sizeof(gk));
+
+  gk.bordersize = bordersize;
+  gk.tracewidth = tracewidth;
+  gk.displaygrid = devparms->displaygrid;
+  gk.hordivisions = devparms->hordivisions;
+  gk.vertdivisions = devparms->vertdivisions;
+  gk.math_fft = devparms->math_fft;
+  gk.math_fft_split = devparms->math_fft_split;
+  gk.background_color = BackgroundColor.rgba();
+  gk.raster_color = RasterColor.rgba();
+#if QT_VERSION >= 0x050600
+  gk.pixel_ratio = devicePixelRatioF();
+#else
+  gk.pixel_ratio = 1;
+#endif
+
+  memset(&lk, 0, sizeof(lk));
+
+  strlcpy(lk.modelname, devparms->modelname, 128);
+  lk.font_size = devparms->font_size;
+  lk.channel_cnt = devparms->channel_cnt;
+  for(i=0; i<MAX_CHNS; i++)
+  {
+    lk.chandisplay[i] = devparms->chandisplay[i];
+    lk.chanscale[i] = devparms->chanscale[i];
+    lk.chanunit[i] = devparms->chanunit[i];
+    lk.chanbwlimit[i] = devparms->chanbwlimit[i];
+    lk.chancoupling[i] = devparms->chancoupling[i];
+    lk.chaninvert[i] = devparms->chaninvert[i];
+    lk.signal_color[i] = SignalColor[i].rgba();
+  }
+  lk.triggerstatus = devparms->triggerstatus;
+  lk.triggeredgesource = devparms->triggeredgesource;
+  lk.triggeredgeslope = devparms->triggeredgeslope;
+  if((devparms->triggeredgesource >= 0) && (devparms->triggeredgesource < MAX_TRIG_SRCS))
+  {
+    lk.triggeredgelevel = devparms->triggeredgelevel[devparms->triggeredgesource];
+  }
+  lk.timebasescale = devparms->timebasescale;
+  lk.timebaseoffset = devparms->timebaseoffset;
+  lk.samplerate = devparms->samplerate;
+  lk.acquirememdepth = devparms->acquirememdepth;
+  lk.hordivisions = devparms->hordivisions;
+  lk.viewer_center_position = devparms->viewer_center_position;
+
+  if((bg_pixmap.width() != (int)(curve_w * gk.pixel_ratio + 0.5)) ||
+     (bg_pixmap.height() != (int)(curve_h * gk.pixel_ratio + 0.5)) ||
+     memcmp(&gk, &bg_gkey, sizeof(gk)))
+  {
+    // allocated in device pixels, otherwise it's scaled up and blurry on a HiDPI screen,
+    // the painter keeps working in logical coordinates
+    bg_pixmap = QPixmap((int)(curve_w * gk.pixel_ratio + 0.5), (int)(curve_h * gk.pixel_ratio + 0.5));
+#if QT_VERSION >= 0x050600
+    bg_pixmap.setDevicePixelRatio(gk.pixel_ratio);
+#endif
+
+    full = 1;
+  }
+  else if(memcmp(&lk, &bg_lkey, sizeof(lk)))
+    {
+      full = 0;
+    }
+    else
+    {
+      return;
+    }
+
+  memcpy(&bg_gkey, &gk, sizeof(gk));
+
+  memcpy(&bg_lkey, &lk, sizeof(lk));
+
+  QPainter paint(&bg_pixmap);
+#if (QT_VERSION >= 0x050000) && (QT_VERSION < 0x060000)
+  paint.setRenderHint(QPainter::Qt4CompatiblePainting, true);
+#endif
+
+  paint.setFont(smallfont);
+
+  if(full)
+  {
+    paint.fillRect(0, 0, curve_w, curve_h, BackgroundColor);
+  }
+
+  drawBars(&paint, curve_w, curve_h);
+
+  if(!full)
+  {
+    return;
+  }
+
+  paint.translate(bordersize, bordersize);
+
+  drawRasters(&paint, curve_w - (bordersize * 2), curve_h - (bordersize * 2));
+}
+
+
+// the top bar with the settings and the bottom bar with the channel labels
+void WaveCurve::drawBars(QPainter *painter, int curve_w, int curve_h)
+{
+  int i, t_pos;
+
+  painter->fillRect(0, 0, curve_w, 30, QColor(32, 32, 32));
+
+  drawTopLabels(painter);
+
+  t_pos = 408 - ((devparms->timebaseoffset / ((double)devparms->acquirememdepth / devparms->samplerate)) * 233);
+
+  drawSmallTriggerArrow(painter, t_pos, 16, 1, QColor(255, 128, 0));
+
+  painter->fillRect(0, curve_h - 30, curve_w, curve_h, QColor(32, 32, 32));
+
+  for(i=0; i<devparms->channel_cnt; i++)
+  {
+    drawChanLabel(painter, 8 + (i * 130), curve_h - 25, i);
+  }
+}
+
+
+void WaveCurve::drawRasters(QPainter *painter, int curve_w, int curve_h)
+{
+  int i, small_rulers;
+
+  double step, step2;
+
+  small_rulers = 5 * devparms->hordivisions;
+
+  painter->setPen(RasterColor);
+
+  painter->drawRect (0, 0, curve_w - 1, curve_h - 1);
+
+  if((devparms->math_fft == 0) || (devparms->math_fft_split == 0))
+  {
+    if(devparms->displaygrid)
+    {
+      painter->setPen(QPen(QBrush(RasterColor, Qt::SolidPattern), tracewidth, Qt::DotLine, Qt::SquareCap, Qt::BevelJoin));
+
+      if(devparms->displaygrid == 2)
+      {
+        step = (double)curve_w / (double)devparms->hordivisions;
+
+        for(i=1; i<devparms->hordivisions; i++)
+        {
+          painter->drawLine(step * i, curve_h - 1, step * i, 0);
+        }
+
+        step = curve_h / (double)devparms->vertdivisions;
+
+        for(i=1; i<devparms->vertdivisions; i++)
+        {
+          painter->drawLine(0, step * i, curve_w - 1, step * i);
+        }
+      }
+      else
+      {
+        painter->drawLine(curve_w / 2, curve_h - 1, curve_w / 2, 0);
+
+        painter->drawLine(0, curve_h / 2, curve_w - 1, curve_h / 2);
+      }
+    }
+
+    painter->setPen(RasterColor);
+
+    step = (double)curve_w / (double)small_rulers;
+
+    for(i=1; i<small_rulers; i++)
+    {
+      step2 = step * i;
+
+      if(devparms->displaygrid)
+      {
+        painter->drawLine(step2, curve_h / 2 + 2, step2, curve_h / 2 - 2);
+      }
+
+      if(i % 5)
+      {
+        painter->drawLine(step2, curve_h - 1, step2, curve_h - 5);
+
+        painter->drawLine(step2, 0, step2, 4);
+      }
+      else
+      {
+        painter->drawLine(step2, curve_h - 1, step2, curve_h - 9);
+
+        painter->drawLine(step2, 0, step2, 8);
+      }
+    }
+
+    step = curve_h / (5.0 * devparms->vertdivisions);
+
+    for(i=1; i<(5 * devparms->vertdivisions); i++)
+    {
+      step2 = step * i;
+
+      if(devparms->displaygrid)
+      {
+        painter->drawLine(curve_w / 2 + 2, step2, curve_w / 2  - 2, step2);
+      }
+
+      if(i % 5)
+      {
+        painter->drawLine(curve_w - 1, step2, curve_w - 5, step2);
+
+        painter->drawLine(0, step2, 4, step2);
+      }
+      else
+      {
+        painter->drawLine(curve_w - 1, step2, curve_w - 9, step2);
+
+        painter->drawLine(0, step2, 8, step2);
+      }
+    }
+  }
+  else
+  {
+    painter->drawLine(curve_w / 2, curve_h - 1, curve_w / 2, 0);
+
+    painter->drawLine(0, curve_h / 2, curve_w - 1, curve_h / 2);
+  }
+}
+
+
 void WaveCurve::drawTopLabels(QPainter *painter)
 {
   int i;
@@ -33,6 +33,9 @@
 
 #include "qt_headers.h"
 
+#include <QVector>
+#include <QPixmap>
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -40,6 +43,9 @@
 #include "global.h"
 #include "utils.h"
 #include "wave_dialog.h"
+#include "wave_lod.h"
+#include "trace_render.h"
+#include "wave_density.h"
 
 
 class UI_wave_window;
@@ -65,6 +71,8 @@ public:
   void setTextColor(QColor);
   void setBorderSize(int);
   void setDeviceParameters(struct device_settings *);
+  void setLod(wave_lod *);
+  void setDensity(wave_density *);
 
 
 private slots:
@@ -108,6 +116,59 @@ private:
 
   UI_wave_window *wavedialog;
 
+  wave_lod *lod;
+
+  wave_density *density;
+
+  QVector<int> env_top[MAX_CHNS],  // the vertical line of every column, reused between repaints
+               env_bot[MAX_CHNS];
+
+  trace_render trace_rend;   // draws the traces of the channels in parallel
+
+  void buildEnvelope(struct trast_trace *, int, int, int, int);
+
+  QPixmap bg_pixmap;        // background, bars, labels and rasters, see updateBackground()
+
+  struct bg_grid_key {
+    int bordersize;
+    int tracewidth;
+    int displaygrid;
+    int hordivisions;
+    int vertdivisions;
+    int math_fft;
+    int math_fft_split;
+    QRgb background_color;
+    QRgb raster_color;
+    double pixel_ratio;
+  } bg_gkey;                // bg_pixmap is redrawn when one of these changes
+
+  struct bg_label_key {
+    char modelname[128];
+    int font_size;
+    int channel_cnt;
+    int chandisplay[MAX_CHNS];
+    double chanscale[MAX_CHNS];
+    int chanunit[MAX_CHNS];
+    int chanbwlimit[MAX_CHNS];
+    int chancoupling[MAX_CHNS];
+    int chaninvert[MAX_CHNS];
+    QRgb signal_color[MAX_CHNS];
+    int triggerstatus;
+    int triggeredgesource;
+    int triggeredgeslope;
+    double triggeredgelevel;
+    double timebasescale;
+    double timebaseoffset;
+    double samplerate;
+    int acquirememdepth;
+    int hordivisions;
+    double viewer_center_position;
+  } bg_lkey;                // only the bars are redrawn when one of these changes
+
+  void updateBackground(int, int);
+  void drawBars(QPainter *, int, int);
+  void drawRasters(QPainter *, int, int);
+
 protected:
   void paintEvent(QPaintEvent *);
   void mousePressEvent(QMouseEvent *);
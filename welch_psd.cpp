@@ -0,0 +1,504 @@
+/*
+***************************************************************************
+*
+* Author: Teunis van Beelen
+*
+* Copyright (C) 2015 - 2024 Teunis van Beelen
+*
+* Email: teuniz@protonmail.com
+*
+***************************************************************************
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+***************************************************************************
+*/
+
+
+
+#include "welch_psd.h"
+
+
+#define WELCH_LOG_MINIMUM      (1e-20)
+#define WELCH_LOG_MINIMUM_LOG  (-200)
+
+
+
+welch_worker::welch_worker()
+{
+  job = NULL;
+
+  cfg = NULL;
+  cfg_nfft = 0;
+
+  in = NULL;
+  out = NULL;
+
+  acc = NULL;
+  acc_cnt = 0;
+}
+
+
+welch_worker::~welch_worker()
+{
+  wait();
+
+  free(cfg);
+  free(in);
+  free(out);
+  free(acc);
+}
+
+
+// allocates the plan and buffers for the segment length of the job, returns 0 on success
+int welch_worker::prepare(struct welch_job *p_job)
+{
+  int half;
+
+  double *tmp_in, *tmp_acc;
+
+  kiss_fft_cpx *tmp_out;
+
+  job = p_job;
+
+  half = job->nfft / 2;
+
+  if(cfg_nfft != job->nfft)
+  {
+    free(cfg);
+
+    cfg_nfft = 0;
+
+    cfg = kiss_fftr_alloc(job->nfft, 0, NULL, NULL);
+    if(cfg == NULL)
+    {
+      return -1;
+    }
+
+    tmp_in = (double *)realloc(in, job->nfft * sizeof(double));
+    if(tmp_in == NULL)
+    {
+      return -1;
+    }
+
+    in = tmp_in;
+
+    tmp_out = (kiss_fft_cpx *)realloc(out, (half + 1) * sizeof(kiss_fft_cpx));
+    if(tmp_out == NULL)
+    {
+      return -1;
+    }
+
+    out = tmp_out;
+
+    tmp_acc = (double *)realloc(acc, (half + 1) * sizeof(double));
+    if(tmp_acc == NULL)
+    {
+      return -1;
+    }
+
+    acc = tmp_acc;
+
+    cfg_nfft = job->nfft;
+  }
+
+  mtx.lock();
+
+  memset(acc, 0, (half + 1) * sizeof(double));
+
+  acc_cnt = 0;
+
+  mtx.unlock();
+
+  return 0;
+}
+
+
+int welch_worker::add_to(double *dest, int bins)
+{
+  int i, cnt;
+
+  mtx.lock();
+
+  if(acc_cnt)
+  {
+    for(i=0; i<bins; i++)
+    {
+      dest[i] += acc[i];
+    }
+  }
+
+  cnt = acc_cnt;
+
+  mtx.unlock();
+
+  return cnt;
+}
+
+
+void welch_worker::run()
+{
+  int i, k, idx, half;
+
+  const short *src;
+
+  half = job->nfft / 2;
+
+  while(!job->abort_req.loadAcquire())
+  {
+    k = job->seg_next.fetchAndAddOrdered(1);
+    if(k >= job->nseg)
+    {
+      break;
+    }
+
+    idx = ((long long)k * job->stride) % job->nseg;
+
+    src = job->buf + ((long long)idx * job->hop);
+
+    for(i=0; i<job->nfft; i++)
+    {
+      in[i] = src[i] * job->win[i];
+    }
+
+    kiss_fftr(cfg, in, out);
+
+    for(i=0; i<=half; i++)
+    {
+      in[i] = (out[i].r * out[i].r) + (out[i].i * out[i].i);
+    }
+
+    // the lock is only held for the accumulation, a preview never waits for an FFT
+    mtx.lock();
+
+    for(i=0; i<=half; i++)
+    {
+      acc[i] += in[i];
+    }
+
+    acc_cnt++;
+
+    mtx.unlock();
+  }
+}
+
+
+
+welch_psd::welch_psd()
+{
+  int i;
+
+  for(i=0; i<WELCH_MAX_THREADS; i++)
+  {
+    workers[i] = NULL;
+  }
+
+  thread_cnt = 0;
+
+  job.buf = NULL;
+  job.nfft = 0;
+  job.hop = 0;
+  job.nseg = 0;
+  job.stride = 1;
+  job.win = NULL;
+  job.y_incr = 0;
+
+  memset(&params, 0, sizeof(params));
+
+  win = NULL;
+  win_sum = 0;
+  win_sum_sq = 0;
+
+  bins = 0;
+}
+
+
+welch_psd::~welch_psd()
+{
+  int i;
+
+  abort();
+
+  for(i=0; i<WELCH_MAX_THREADS; i++)
+  {
+    delete workers[i];
+  }
+
+  free(win);
+}
+
+
+static int welch_gcd(int a, int b)
+{
+  int tmp;
+
+  while(b)
+  {
+    tmp = a % b;
+
+    a = b;
+
+    b = tmp;
+  }
+
+  return a;
+}
+
+
+int welch_psd::start(const short *buf, int n, const struct welch_psd_params *p)
+{
+  int i, stride;
+
+  double *tmp;
+
+  abort();
+
+  bins = 0;
+
+  thread_cnt = 0;
+
+  if((buf == NULL) || (p->nfft < WELCH_MIN_NFFT) || (p->nfft > WELCH_MAX_NFFT) ||
+     (p->nfft & (p->nfft - 1)) || (n < p->nfft) || (p->sf <= 0) ||
+     (p->overlap < 0) || (p->overlap > 90))
+  {
+    return -1;
+  }
+
+  params = *p;
+
+  tmp = (double *)realloc(win, p->nfft * sizeof(double));
+  if(tmp == NULL)
+  {
+    return -1;
+  }
+
+  win = tmp;
+
+  win_sum = fft_window_fill(win, p->nfft, p->window);
+
+  win_sum_sq = 0;
+
+  for(i=0; i<p->nfft; i++)
+  {
+    win_sum_sq += win[i] * win[i];
+  }
+
+  job.buf = buf;
+  job.nfft = p->nfft;
+  job.hop = ((long long)p->nfft * (100 - p->overlap)) / 100;
+  if(job.hop < 1)
+  {
+    job.hop = 1;
+  }
+  job.nseg = ((n - p->nfft) / job.hop) + 1;
+  job.win = win;
+  job.y_incr = p->y_incr;
+  job.seg_next.storeRelease(0);
+  job.abort_req.storeRelease(0);
+
+  // a stride coprime to the number of segments visits every segment once,
+  // near the golden ratio consecutive segments end up far apart
+  stride = job.nseg * 0.618;
+  if(stride < 1)
+  {
+    stride = 1;
+  }
+
+  while(welch_gcd(job.nseg, stride) != 1)
+  {
+    stride++;
+  }
+
+  job.stride = stride;
+
+  thread_cnt = QThread::idealThreadCount();
+
+  if(thread_cnt > WELCH_MAX_THREADS)
+  {
+    thread_cnt = WELCH_MAX_THREADS;
+  }
+
+  if(thread_cnt > job.nseg)
+  {
+    thread_cnt = job.nseg;
+  }
+
+  if(thread_cnt < 1)
+  {
+    thread_cnt = 1;
+  }
+
+  for(i=0; i<thread_cnt; i++)
+  {
+    if(workers[i] == NULL)
+    {
+      workers[i] = new welch_worker;
+    }
+
+    if(workers[i]->prepare(&job))
+    {
+      thread_cnt = 0;
+
+      return -1;
+    }
+  }
+
+  bins = (p->nfft / 2) + 1;
+
+  for(i=0; i<thread_cnt; i++)
+  {
+    workers[i]->start();
+  }
+
+  return 0;
+}
+
+
+void welch_psd::abort()
+{
+  int i;
+
+  job.abort_req.storeRelease(1);
+
+  for(i=0; i<WELCH_MAX_THREADS; i++)
+  {
+    if(workers[i] != NULL)
+    {
+      workers[i]->wait();
+    }
+  }
+}
+
+
+int welch_psd::is_busy()
+{
+  int i;
+
+  for(i=0; i<thread_cnt; i++)
+  {
+    if(workers[i]->isRunning())
+    {
+      return 1;
+    }
+  }
+
+  return 0;
+}
+
+
+int welch_psd::get_bins()
+{
+  return bins;
+}
+
+
+double welch_psd::get_rbw()
+{
+  if((bins < 1) || (win_sum <= 0))
+  {
+    return 0;
+  }
+
+  return (params.sf * win_sum_sq) / (win_sum * win_sum);
+}
+
+
+int welch_psd::get_thread_cnt()
+{
+  return thread_cnt;
+}
+
+
+int welch_psd::get_psd(double *dest, int dest_bins, int unit, int *done, int *total)
+{
+  int i, cnt=0;
+
+  double norm, offs=0;
+
+  if((bins < 1) || (dest_bins < bins))
+  {
+    return -1;
+  }
+
+  memset(dest, 0, bins * sizeof(double));
+
+  for(i=0; i<thread_cnt; i++)
+  {
+    cnt += workers[i]->add_to(dest, bins);
+  }
+
+  if(done != NULL)
+  {
+    *done = cnt;
+  }
+
+  if(total != NULL)
+  {
+    *total = job.nseg;
+  }
+
+  if(cnt < 1)
+  {
+    return -1;
+  }
+
+  if(unit == WELCH_UNIT_DBV_HZ)
+  {
+    norm = (2.0 * params.y_incr * params.y_incr) / (params.sf * win_sum_sq * cnt);
+  }
+  else  // Vrms^2 per bin, corrected for the coherent gain of the window
+  {
+    norm = (2.0 * params.y_incr * params.y_incr) / (win_sum * win_sum * cnt);
+
+    if(unit == WELCH_UNIT_DBUV)
+    {
+      offs = 120;
+    }
+  }
+
+  for(i=0; i<bins; i++)
+  {
+    dest[i] *= norm;
+  }
+
+  dest[0] /= 2.0;  // DC!
+
+  dest[bins - 1] /= 2.0;  // Nyquist
+
+  for(i=0; i<bins; i++)
+  {
+    if(dest[i] < WELCH_LOG_MINIMUM)
+    {
+      dest[i] = WELCH_LOG_MINIMUM;
+    }
+  }
+
+  // convert to deciBel's, not to Bel's!
+  for(i=0; i<bins; i++)
+  {
+    dest[i] = (log10(dest[i]) * 10.0) + offs;
+  }
+
+  for(i=0; i<bins; i++)
+  {
+    if(dest[i] < (WELCH_LOG_MINIMUM_LOG + offs))
+    {
+      dest[i] = WELCH_LOG_MINIMUM_LOG + offs;
+    }
+  }
+
+  return bins;
+}
+
+
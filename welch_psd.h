@@ -0,0 +1,169 @@
+/*
+***************************************************************************
+*
+* Author: Teunis van Beelen
+*
+* Copyright (C) 2015 - 2024 Teunis van Beelen
+*
+* Email: teuniz@protonmail.com
+*
+***************************************************************************
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+***************************************************************************
+*/
+
+
+
+#ifndef DEF_WELCH_PSD_H
+#define DEF_WELCH_PSD_H
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include <QThread>
+#include <QMutex>
+#include <QAtomicInt>
+
+#include "global.h"
+#include "fft_stage.h"
+
+#include "third_party/kiss_fft/kiss_fftr.h"
+
+
+#define WELCH_MAX_THREADS  (64)
+
+#define WELCH_MIN_NFFT  (256)
+#define WELCH_MAX_NFFT  (1 << 20)
+
+#define WELCH_UNIT_DBV     (0)  /* rms level of a sine in one bin */
+#define WELCH_UNIT_DBUV    (1)  /* same, relative to 1 uV, for EMI work */
+#define WELCH_UNIT_DBV_HZ  (2)  /* power spectral density, V^2 / Hz */
+
+
+struct welch_psd_params
+{
+  int nfft;           /* segment length, power of two */
+  int overlap;        /* percent, 0 to 90 */
+  int window;         /* FFT_WIN_xxx */
+  double y_incr;      /* volts per count */
+  double sf;          /* samplerate of the record */
+};
+
+
+/* shared, read-only during a run except for the atomics */
+struct welch_job
+{
+  const short *buf;
+  int nfft;
+  int hop;
+  int nseg;
+  int stride;
+  const double *win;
+  double y_incr;
+  QAtomicInt seg_next;
+  QAtomicInt abort_req;
+};
+
+
+class welch_worker : public QThread
+{
+public:
+
+  welch_worker();
+  ~welch_worker();
+
+  int prepare(struct welch_job *);
+
+  /* adds the accumulated periodograms to dest, returns the number of segments */
+  int add_to(double *, int);
+
+private:
+
+  struct welch_job *job;
+
+  kiss_fftr_cfg cfg;
+  int cfg_nfft;
+
+  double *in;
+  kiss_fft_cpx *out;
+
+  QMutex mtx;
+
+  /* protected by mtx */
+  double *acc;
+  int acc_cnt;
+
+  void run();
+};
+
+
+/*
+ * Averaged periodogram (Welch) of a deep memory record. The segments
+ * are handed out to one worker per core, every worker has its own plan
+ * and accumulator. The segments are visited in a scattered order so a
+ * spectrum that is read while the workers are still busy already covers
+ * the whole record, it only has a higher variance.
+ */
+class welch_psd
+{
+public:
+
+  welch_psd();
+  ~welch_psd();
+
+  /* the record must stay valid until the run is finished or aborted */
+  int start(const short *, int, const struct welch_psd_params *);
+
+  /* stops the workers and waits for them */
+  void abort();
+
+  int is_busy();
+
+  /* number of bins, from 0 to sf / 2 */
+  int get_bins();
+
+  /* equivalent noise bandwidth of one bin in Hz */
+  double get_rbw();
+
+  int get_thread_cnt();
+
+  /* merges what is done so far, returns the number of bins or -1 when there is nothing yet */
+  int get_psd(double *, int, int, int *, int *);
+
+private:
+
+  welch_worker *workers[WELCH_MAX_THREADS];
+
+  int thread_cnt;
+
+  struct welch_job job;
+
+  struct welch_psd_params params;
+
+  double *win;
+  double win_sum;
+  double win_sum_sq;
+
+  int bins;
+};
+
+
+#endif
+
+
@@ -0,0 +1,195 @@
+/*
+***************************************************************************
+*
+* Author: Teunis van Beelen
+*
+* Copyright (C) 2015 - 2024 Teunis van Beelen
+*
+* Email: teuniz@protonmail.com
+*
+***************************************************************************
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+***************************************************************************
+*/
+
+
+
+
+
+
+#include "work_pool.h"
+
+
+
+work_pool_thread::work_pool_thread(work_pool *p_pool, int p_idx, unsigned int p_cycle)
+{
+  pool = p_pool;
+
+  idx = p_idx;
+
+  cycle = p_cycle;
+}
+
+
+void work_pool_thread::run()
+{
+  pool->thread_main(idx, cycle);
+}
+
+
+work_pool::work_pool()
+{
+  int i;
+
+  for(i=0; i<(WPOOL_MAX_THREADS - 1); i++)
+  {
+    threads[i] = NULL;
+  }
+
+  func = NULL;
+  data = NULL;
+  cycle = 0;
+  active = 0;
+  busy = 0;
+  quit = 0;
+}
+
+
+work_pool::~work_pool()
+{
+  int i;
+
+  mutex.lock();
+
+  quit = 1;
+
+  cond_work.wakeAll();
+
+  mutex.unlock();
+
+  for(i=0; i<(WPOOL_MAX_THREADS - 1); i++)
+  {
+    if(threads[i] != NULL)
+    {
+      threads[i]->wait();
+
+      delete threads[i];
+    }
+  }
+}
+
+
+// a thread parks here between the jobs, seen is the last job it has woken up for,
+// the threads that are not needed for a job only take note of it
+void work_pool::thread_main(int idx, unsigned int seen)
+{
+  void (*p_func)(void *);
+
+  void *p_data;
+
+  mutex.lock();
+
+  while(1)
+  {
+    while((cycle == seen) && (!quit))
+    {
+      cond_work.wait(&mutex);
+    }
+
+    if(quit)
+    {
+      break;
+    }
+
+    seen = cycle;
+
+    if(idx >= active)
+    {
+      continue;
+    }
+
+    p_func = func;
+
+    p_data = data;
+
+    mutex.unlock();
+
+    p_func(p_data);
+
+    mutex.lock();
+
+    busy--;
+
+    if(!busy)
+    {
+      cond_done.wakeAll();
+    }
+  }
+
+  mutex.unlock();
+}
+
+
+void work_pool::run(void (*p_func)(void *), void *p_data, int thread_cnt)
+{
+  int i;
+
+  if(thread_cnt > WPOOL_MAX_THREADS)
+  {
+    thread_cnt = WPOOL_MAX_THREADS;
+  }
+
+  if(thread_cnt < 2)
+  {
+    p_func(p_data);
+
+    return;
+  }
+
+  mutex.lock();
+
+  // the threads are started when they are needed for the first time, they wait for the next cycle
+  for(i=0; i<(thread_cnt - 1); i++)
+  {
+    if(threads[i] == NULL)
+    {
+      threads[i] = new work_pool_thread(this, i, cycle);
+
+      threads[i]->start();
+    }
+  }
+
+  func = p_func;
+  data = p_data;
+  active = thread_cnt - 1;
+  busy = active;
+  cycle++;
+
+  cond_work.wakeAll();
+
+  mutex.unlock();
+
+  p_func(p_data);
+
+  mutex.lock();
+
+  while(busy)
+  {
+    cond_done.wait(&mutex);
+  }
+
+  mutex.unlock();
+}
@@ -0,0 +1,114 @@
+/*
+***************************************************************************
+*
+* Author: Teunis van Beelen
+*
+* Copyright (C) 2015 - 2024 Teunis van Beelen
+*
+* Email: teuniz@protonmail.com
+*
+***************************************************************************
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+***************************************************************************
+*/
+
+
+
+
+
+
+#ifndef DEF_WORK_POOL_H
+#define DEF_WORK_POOL_H
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+
+
+#define WPOOL_MAX_THREADS  (64)
+
+
+class work_pool;
+
+
+class work_pool_thread : public QThread
+{
+public:
+
+  work_pool_thread(work_pool *, int, unsigned int);
+
+private:
+
+  work_pool *pool;
+
+  int idx;
+
+  unsigned int cycle;
+
+  void run();
+};
+
+
+/*
+ * Threads that are started once and then park on a wait condition between
+ * the jobs, so a job that runs on every repaint doesn't pay the start-up of
+ * its threads every time. run() wakes the threads it needs, the calling
+ * thread takes part in the work, and returns when all of them are done.
+ * The function is called on every thread with the same data, the threads
+ * share the work through the data, e.g. with an atomic work item counter.
+ */
+class work_pool
+{
+public:
+
+  work_pool();
+  ~work_pool();
+
+  /* calls func(data) on thread_cnt threads including the calling one and waits for them,
+     with less than two only the calling thread runs it */
+  void run(void (*)(void *), void *, int);
+
+private:
+
+  work_pool_thread *threads[WPOOL_MAX_THREADS - 1];
+
+  QMutex mutex;
+
+  QWaitCondition cond_work,
+                 cond_done;
+
+  void (*func)(void *);
+
+  void *data;
+
+  unsigned int cycle;  /* incremented for every job, a thread runs a job once */
+
+  int active,          /* threads that take part in the current job */
+      busy,            /* threads that are not done with the current job */
+      quit;
+
+  void thread_main(int, unsigned int);
+
+  friend class work_pool_thread;
+};
+
+
+#endif